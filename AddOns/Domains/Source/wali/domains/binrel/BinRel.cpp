@@ -1091,14 +1091,25 @@ binrel_t BinRel::Compose( binrel_t that ) const
   if (that->isOne())
     return new BinRel(*this);
 
+  return ComposeShifted(RightShift(that));
+}
+
+bdd BinRel::RightShift( binrel_t that ) const
+{
+  if(!isTensored)
+    return bdd_replace(that->rel, con->baseRightShift.get());
+  else
+    return bdd_replace(that->rel, con->tensorRightShift.get());
+}
+
+binrel_t BinRel::ComposeShifted( bdd shifted_that ) const
+{
   bdd c;
   if(!isTensored){
-    bdd temp1 = bdd_replace(that->rel, con->baseRightShift.get());
-    bdd temp2 = bdd_relprod(rel, temp1, con->baseSecBddContextSet);
+    bdd temp2 = bdd_relprod(rel, shifted_that, con->baseSecBddContextSet);
     c = bdd_replace(temp2, con->baseRestore.get());
   }else{
-    bdd temp1 = bdd_replace(that->rel, con->tensorRightShift.get());
-    bdd temp2 = bdd_relprod(rel, temp1, con->tensorSecBddContextSet);
+    bdd temp2 = bdd_relprod(rel, shifted_that, con->tensorSecBddContextSet);
     c = bdd_replace(temp2, con->tensorRestore.get());
   }
 
@@ -1359,6 +1370,66 @@ wali::sem_elem_t BinRel::extend(wali::SemElem* se)
   return Compose(that);
 }
 
+bool BinRel::hasBatchOperations() const
+{
+  return true;
+}
+
+void BinRel::extendMany(wali::SemElem * const * lhs, wali::SemElem * const * rhs,
+                        size_t n, wali::sem_elem_t * out)
+{
+  // The shift of the last right operand, which the next operation
+  // reuses if it has the same one
+  wali::SemElem * shifted_from = NULL;
+  bdd shifted;
+  for (size_t i = 0; i < n; ++i) {
+    binrel_t a( convert(lhs[i]) );
+    binrel_t b( convert(rhs[i]) );
+    if (a->isTensored != b->isTensored || a->con != b->con
+        || a->isZero() || b->isZero() || a->isOne() || b->isOne())
+    {
+      // Compose reports or short-cuts these
+      out[i] = a->Compose(b);
+      continue;
+    }
+#ifdef BINREL_STATS
+    con->numCompose++;
+#endif
+    if (rhs[i] != shifted_from) {
+      shifted = a->RightShift(b);
+      shifted_from = rhs[i];
+    }
+    out[i] = a->ComposeShifted(shifted);
+  }
+}
+
+wali::sem_elem_t BinRel::combineMany(wali::SemElem * const * ses, size_t n)
+{
+  bdd r = rel;
+  for (size_t i = 0; i < n; ++i) {
+    binrel_t that( convert(ses[i]) );
+#ifndef BINREL_HASTY
+    if(isTensored != that->isTensored || con != that->con){
+      // Let Union report it
+      return Union(that);
+    }
+#endif
+#ifdef BINREL_STATS
+    con->numUnion++;
+#endif
+    r = r | that->rel;
+  }
+  if (r == rel)
+    return this;
+
+  // Keep zero/one unique
+  binrel_t ret = new BinRel(con, r, isTensored);
+  if(ret->isOne())
+    return static_cast<BinRel*>(ret->one().get_ptr());
+  //can't be zero.
+  return ret;
+}
+
 bool BinRel::equal(wali::SemElem* se) const 
 {
   binrel_t that( convert(se) );
@@ -445,6 +445,15 @@ namespace wali
           /** @return [this]->Compose( cast<BinRel*>(se) ) */
           sem_elem_t extend(SemElem* se);
 
+          /** Batched combines and extends. Consecutive extends with the
+           *  same right operand share its shift into the second
+           *  vocabulary, and combineMany ORs all the BDDs before making a
+           *  BinRel. @see SemElem::extendMany */
+          bool hasBatchOperations() const;
+          void extendMany(SemElem * const * lhs, SemElem * const * rhs,
+                          size_t n, sem_elem_t * out);
+          sem_elem_t combineMany(SemElem * const * ses, size_t n);
+
           sem_elem_t star();
 
 
@@ -491,6 +500,13 @@ namespace wali
           // Printing functions
           //static void printHandler(FILE *o, int var);
         protected:
+          /** The bdd of this composed with that, given that's bdd already
+           *  shifted into the second vocabulary */
+          binrel_t ComposeShifted( bdd shifted_that ) const;
+
+          /** that's bdd shifted into the second vocabulary */
+          bdd RightShift( binrel_t that ) const;
+
           //This has to be a raw/weak pointer.
           //BddContext caches some BinRel objects. It is not BinRel's responsibility to
           //manage memory for BddContext. 
@@ -0,0 +1,121 @@
+#ifndef WALI_DOMAINS_DETAILS_BIT_WORDS_HPP
+#define WALI_DOMAINS_DETAILS_BIT_WORDS_HPP
+
+// Word-parallel kernels over arrays of 64-bit words, shared by the
+// bit-vector domains (genkill::BitVectorSet and BoolMatrix).
+
+#include <boost/cstdint.hpp>
+
+#include <cstddef>
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#  define WALI_BIT_WORDS_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define WALI_BIT_WORDS_SSE2 1
+#endif
+
+namespace wali {
+  namespace domains {
+    namespace details {
+
+      typedef boost::uint64_t Word;
+
+      // The kernels below combine n words of a and b into out (which may
+      // be a or b). With AVX2 ('scons avx2=1') they work 256 bits at a
+      // time, with SSE2 (any x86-64) 128, and otherwise a word at a time.
+
+#if WALI_BIT_WORDS_AVX2
+      enum { WORDS_PER_VECTOR = 4 };
+      typedef __m256i Vector;
+      inline Vector load(Word const * p) { return _mm256_loadu_si256(reinterpret_cast<Vector const *>(p)); }
+      inline void store(Word * p, Vector v) { _mm256_storeu_si256(reinterpret_cast<Vector *>(p), v); }
+      inline Vector vor(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+      inline Vector vand(Vector a, Vector b) { return _mm256_and_si256(a, b); }
+      inline Vector vandnot(Vector a, Vector b) { return _mm256_andnot_si256(b, a); }
+      inline bool vequal(Vector a, Vector b) {
+        Vector x = _mm256_xor_si256(a, b);
+        return _mm256_testz_si256(x, x) != 0;
+      }
+#elif WALI_BIT_WORDS_SSE2
+      enum { WORDS_PER_VECTOR = 2 };
+      typedef __m128i Vector;
+      inline Vector load(Word const * p) { return _mm_loadu_si128(reinterpret_cast<Vector const *>(p)); }
+      inline void store(Word * p, Vector v) { _mm_storeu_si128(reinterpret_cast<Vector *>(p), v); }
+      inline Vector vor(Vector a, Vector b) { return _mm_or_si128(a, b); }
+      inline Vector vand(Vector a, Vector b) { return _mm_and_si128(a, b); }
+      inline Vector vandnot(Vector a, Vector b) { return _mm_andnot_si128(b, a); }
+      inline bool vequal(Vector a, Vector b) {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xFFFF;
+      }
+#else
+      enum { WORDS_PER_VECTOR = 1 };
+      typedef Word Vector;
+      inline Vector load(Word const * p) { return *p; }
+      inline void store(Word * p, Vector v) { *p = v; }
+      inline Vector vor(Vector a, Vector b) { return a | b; }
+      inline Vector vand(Vector a, Vector b) { return a & b; }
+      inline Vector vandnot(Vector a, Vector b) { return a & ~b; }
+      inline bool vequal(Vector a, Vector b) { return a == b; }
+#endif
+
+      /// out = a | b
+      inline void union_words(Word * out, Word const * a, Word const * b, size_t n) {
+        size_t i = 0;
+        for (; i + WORDS_PER_VECTOR <= n; i += WORDS_PER_VECTOR) {
+          store(out + i, vor(load(a + i), load(b + i)));
+        }
+        for (; i < n; ++i) {
+          out[i] = a[i] | b[i];
+        }
+      }
+
+      /// out = a & b
+      inline void intersect_words(Word * out, Word const * a, Word const * b, size_t n) {
+        size_t i = 0;
+        for (; i + WORDS_PER_VECTOR <= n; i += WORDS_PER_VECTOR) {
+          store(out + i, vand(load(a + i), load(b + i)));
+        }
+        for (; i < n; ++i) {
+          out[i] = a[i] & b[i];
+        }
+      }
+
+      /// out = a & ~b
+      inline void diff_words(Word * out, Word const * a, Word const * b, size_t n) {
+        size_t i = 0;
+        for (; i + WORDS_PER_VECTOR <= n; i += WORDS_PER_VECTOR) {
+          store(out + i, vandnot(load(a + i), load(b + i)));
+        }
+        for (; i < n; ++i) {
+          out[i] = a[i] & ~b[i];
+        }
+      }
+
+      inline bool equal_words(Word const * a, Word const * b, size_t n) {
+        size_t i = 0;
+        for (; i + WORDS_PER_VECTOR <= n; i += WORDS_PER_VECTOR) {
+          if (!vequal(load(a + i), load(b + i))) {
+            return false;
+          }
+        }
+        for (; i < n; ++i) {
+          if (a[i] != b[i]) {
+            return false;
+          }
+        }
+        return true;
+      }
+
+    } // namespace details
+  }
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif
@@ -0,0 +1,309 @@
+#ifndef WALI_DOMAINS_GENKILL_BIT_VECTOR_SET
+#define WALI_DOMAINS_GENKILL_BIT_VECTOR_SET
+
+#include "wali/Countable.hpp"
+#include "wali/ref_ptr.hpp"
+#include "wali/domains/details/BitWords.hpp"
+
+#include <boost/cstdint.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace wali {
+  namespace domains {
+    namespace genkill {
+
+      namespace details {
+
+        using wali::domains::details::Word;
+        using wali::domains::details::union_words;
+        using wali::domains::details::intersect_words;
+        using wali::domains::details::diff_words;
+        using wali::domains::details::equal_words;
+
+        /// The words of a BitVectorSet whose universe does not fit inline.
+        /// They are shared by copies of the set, and not changed while
+        /// they are.
+        class Words : public wali::Countable
+        {
+        public:
+          explicit Words(size_t n) : bits(n, 0) {}
+
+          std::vector<Word> bits;
+        };
+
+      } // namespace details
+
+
+      /// BitVectorSet is a Set for GenKillTransformer_T (see
+      /// GenKillXformerTemplate.hpp) over a fixed universe {0, ..., n-1}:
+      /// a bit vector of n bits, so that Union, Diff, Intersect, and Eq are
+      /// a pass over n/64 words instead of a merge of two sorted
+      /// containers that allocates a node per element.
+      ///
+      /// The universe size is shared by all the sets with the same Tag
+      /// (use a different Tag for each analysis), and must be set with
+      /// setUniverseSize before any of them is made; GenKillTransformer_T
+      /// keeps sets in its one and bottom.
+      ///
+      /// Over universes of up to INLINE_BITS elements, the words are stored
+      /// inline, and copying a set allocates nothing. Over larger ones,
+      /// they are on the heap and shared (reference counted) between
+      /// copies; in particular, the kill and gen sets of
+      /// GenKillTransformer_T's one and bottom share the words of
+      /// EmptySet() and UniverseSet(), as does the union of a set with
+      /// itself.
+      template <typename Tag = void>
+      class BitVectorSet
+      {
+      public:
+        typedef details::Word Word;
+
+        enum {
+          WORD_BITS = 64,
+          INLINE_WORDS = 4,
+          INLINE_BITS = INLINE_WORDS * WORD_BITS
+        };
+
+        /// Sets the size of the universe. Sets made before are no longer
+        /// valid.
+        static void setUniverseSize(size_t n)
+        {
+          universeBits() = n;
+          shared().empty = BitVectorSet();
+          shared().universe = makeUniverse();
+        }
+
+        static size_t universeSize()
+        {
+          return universeBits();
+        }
+
+        /// The empty set
+        BitVectorSet()
+        {
+          if (numWords() > INLINE_WORDS) {
+            heap = new details::Words(numWords());
+          }
+          else {
+            std::memset(inline_words, 0, sizeof(inline_words));
+          }
+        }
+
+        BitVectorSet(BitVectorSet const & other)
+          : heap(other.heap)
+        {
+          if (heap.get_ptr() == NULL) {
+            std::memcpy(inline_words, other.inline_words, sizeof(inline_words));
+          }
+        }
+
+        BitVectorSet & operator=(BitVectorSet const & other)
+        {
+          heap = other.heap;
+          if (heap.get_ptr() == NULL) {
+            std::memcpy(inline_words, other.inline_words, sizeof(inline_words));
+          }
+          return *this;
+        }
+
+
+        static BitVectorSet const & EmptySet()
+        {
+          return shared().empty;
+        }
+
+        static BitVectorSet const & UniverseSet()
+        {
+          return shared().universe;
+        }
+
+
+        static bool Eq(BitVectorSet const & x, BitVectorSet const & y)
+        {
+          if (x.heap.get_ptr() != NULL && x.heap == y.heap) {
+            return true;
+          }
+          return details::equal_words(x.data(), y.data(), numWords());
+        }
+
+        static BitVectorSet Diff(BitVectorSet const & x, BitVectorSet const & y,
+                                 bool normalizing = false)
+        {
+          (void) normalizing;
+          if (x.heap.get_ptr() != NULL && x.heap == y.heap) {
+            return EmptySet();
+          }
+          BitVectorSet ret(Uninitialized);
+          details::diff_words(ret.data(), x.data(), y.data(), numWords());
+          return ret;
+        }
+
+        static BitVectorSet Union(BitVectorSet const & x, BitVectorSet const & y)
+        {
+          if (x.heap.get_ptr() != NULL && x.heap == y.heap) {
+            return x;
+          }
+          BitVectorSet ret(Uninitialized);
+          details::union_words(ret.data(), x.data(), y.data(), numWords());
+          return ret;
+        }
+
+        static BitVectorSet Intersect(BitVectorSet const & x, BitVectorSet const & y)
+        {
+          if (x.heap.get_ptr() != NULL && x.heap == y.heap) {
+            return x;
+          }
+          BitVectorSet ret(Uninitialized);
+          details::intersect_words(ret.data(), x.data(), y.data(), numWords());
+          return ret;
+        }
+
+
+        bool contains(size_t i) const
+        {
+          assert(i < universeSize());
+          return (data()[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+        }
+
+        void insert(size_t i)
+        {
+          assert(i < universeSize());
+          unshare();
+          data()[i / WORD_BITS] |= Word(1) << (i % WORD_BITS);
+        }
+
+        void erase(size_t i)
+        {
+          assert(i < universeSize());
+          unshare();
+          data()[i / WORD_BITS] &= ~(Word(1) << (i % WORD_BITS));
+        }
+
+        /// The number of elements
+        size_t size() const
+        {
+          size_t count = 0;
+          Word const * w = data();
+          for (size_t i = 0; i < numWords(); ++i) {
+            for (Word word = w[i]; word; word &= word - 1) {
+              ++count;
+            }
+          }
+          return count;
+        }
+
+        bool empty() const
+        {
+          return Eq(*this, EmptySet());
+        }
+
+
+        /// Prints the elements in increasing order, like
+        /// SortedContainerSetAdapter
+        std::ostream &
+        print(std::ostream & o) const
+        {
+          o << "{";
+          for (size_t i = 0; i < universeSize(); ++i) {
+            if (contains(i)) {
+              o << i << ", ";
+            }
+          }
+          o << "}";
+          return o;
+        }
+
+      private:
+        enum UninitializedTag { Uninitialized };
+
+        /// A set whose words are about to be overwritten
+        explicit BitVectorSet(UninitializedTag)
+        {
+          if (numWords() > INLINE_WORDS) {
+            heap = new details::Words(numWords());
+          }
+        }
+
+        static size_t numWords()
+        {
+          return (universeSize() + WORD_BITS - 1) / WORD_BITS;
+        }
+
+        Word * data()
+        {
+          return heap.get_ptr() != NULL ? &heap->bits[0] : inline_words;
+        }
+
+        Word const * data() const
+        {
+          return heap.get_ptr() != NULL ? &heap->bits[0] : inline_words;
+        }
+
+        /// Gives this set words of its own before it changes them
+        void unshare()
+        {
+          if (heap.get_ptr() != NULL && heap->count > 1) {
+            ref_ptr<details::Words> copy = new details::Words(numWords());
+            copy->bits = heap->bits;
+            heap = copy;
+          }
+        }
+
+        static BitVectorSet makeUniverse()
+        {
+          BitVectorSet u;
+          Word * w = u.data();
+          size_t n = universeSize();
+          for (size_t i = 0; i < n / WORD_BITS; ++i) {
+            w[i] = ~Word(0);
+          }
+          if (n % WORD_BITS != 0) {
+            w[n / WORD_BITS] = (Word(1) << (n % WORD_BITS)) - 1;
+          }
+          return u;
+        }
+
+        // These use method-static variables to avoid problems with
+        // static-initialization order
+
+        static size_t & universeBits()
+        {
+          static size_t bits = 0;
+          return bits;
+        }
+
+        struct Shared
+        {
+          Shared() : universe(makeUniverse()) {}
+
+          BitVectorSet empty;
+          BitVectorSet universe;
+        };
+
+        static Shared & shared()
+        {
+          static Shared s;
+          return s;
+        }
+
+        wali::ref_ptr<details::Words> heap;
+        Word inline_words[INLINE_WORDS];
+      };
+
+    } // namespace genkill
+  }
+}
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif /* WALI_DOMAINS_GENKILL_BIT_VECTOR_SET */
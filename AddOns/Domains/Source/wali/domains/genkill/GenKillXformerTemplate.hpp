@@ -7,6 +7,8 @@
 #include <climits>
 #include <cassert>
 
+#include <boost/scoped_ptr.hpp>
+
 #include "wali/SemElem.hpp"
 
 /*!
@@ -26,9 +28,6 @@ class Set {
         // Only Set constructor GenKillTransformer_T invokes
         Set( const Set& );
 
-        // not needed by GenKillTransformer_T but a good idea
-        Set& operator=( const Set& );
-
         static bool Eq( const Set& x, const Set& y );
 
         static Set Diff( const Set& x, const Set& y,
@@ -236,6 +235,49 @@ public: // methods
       return makeGenKillTransformer_T( temp_k,temp_g );
   }
 
+  // The solvers batch combines for us (see SemElem::combineMany)
+  bool hasBatchOperations() const
+  {
+      return true;
+  }
+
+  // Combines this with all of ys, building only the final transformer
+  wali::sem_elem_t
+  combineMany( wali::SemElem * const * ys, size_t n )
+  {
+      // Start from the first operand that is not zero
+      wali::SemElem* start = this;
+      size_t i = 0;
+      while( start->equal(zero()) && i < n ) {
+          start = ys[i++];
+      }
+      if( start->equal(bottom()) ) {
+          return bottom();
+      }
+
+      const GenKillTransformer_T* first = dynamic_cast<GenKillTransformer_T*>(start);
+      // Set need not be assignable, so each step builds fresh sets
+      boost::scoped_ptr<Set> temp_k( new Set(first->kill) );
+      boost::scoped_ptr<Set> temp_g( new Set(first->gen) );
+      bool changed = false;
+      for( ; i < n; ++i ) {
+          if( ys[i]->equal(zero()) ) {
+              continue;
+          }
+          if( ys[i]->equal(bottom()) ) {
+              return bottom();
+          }
+          const GenKillTransformer_T* y = dynamic_cast<GenKillTransformer_T*>(ys[i]);
+          temp_k.reset( new Set(Set::Intersect(*temp_k, y->kill)) );
+          temp_g.reset( new Set(Set::Union(*temp_g, y->gen)) );
+          changed = true;
+      }
+      if( !changed ) {
+          return start; // the only operand that is not zero (or zero)
+      }
+      return makeGenKillTransformer_T( *temp_k,*temp_g );
+  }
+
   wali::sem_elem_t
   quasiOne() const
   {
@@ -1,6 +1,7 @@
 #include "Matrix.hpp"
 #include <wali/Common.hpp>
 #include <boost/numeric/ublas/io.hpp>
+#include <algorithm>
 #include <ostream>
 
 using namespace boost::numeric::ublas;
@@ -8,69 +9,209 @@ using namespace boost::numeric::ublas;
 namespace wali {
   namespace domains {
 
+    namespace {
+      // At least one word per row, so that m_bits is never empty and
+      // &m_bits[0] is always good
+      size_t
+      words_for(size_t bits)
+      {
+        return std::max<size_t>(1, (bits + 63) / 64);
+      }
+
+      size_t
+      words_for(size_t rows, size_t cols)
+      {
+        return std::max<size_t>(1, rows) * words_for(cols);
+      }
+
+      // Below this many rows on the left, building the Four Russians
+      // tables costs more than ORing in one row per set bit
+      size_t const FOUR_RUSSIANS_MIN_ROWS = 32;
+    }
+
+
+    BoolMatrix::BoolMatrix(size_t rows, size_t cols)
+      : m_rows(rows)
+      , m_cols(cols)
+      , m_row_words(words_for(cols))
+      , m_bits(words_for(rows, cols), 0)
+    {}
+
+
     BoolMatrix::BoolMatrix(BackingMatrix const & m)
-      : m_matrix(m)
+      : m_rows(m.size1())
+      , m_cols(m.size2())
+      , m_row_words(words_for(m_cols))
+      , m_bits(words_for(m_rows, m_cols), 0)
+      , m_matrix(new BackingMatrix(m))
+    {
+      for (size_t r=0; r<m_rows; ++r) {
+        for (size_t c=0; c<m_cols; ++c) {
+          if (m(r, c)) {
+            set(r, c);
+          }
+        }
+      }
+    }
+
+
+    BoolMatrix::BoolMatrix(BoolMatrix const & that)
+      : SemElem(that)
+      , m_rows(that.m_rows)
+      , m_cols(that.m_cols)
+      , m_row_words(that.m_row_words)
+      , m_bits(that.m_bits)
     {}
 
 
     BoolMatrix::BackingMatrix const &
     BoolMatrix::matrix() const
     {
-      return m_matrix;
+      util::LockGuard guard(m_matrix_lock);
+      if (!m_matrix) {
+        BackingMatrix * m = new BackingMatrix(m_rows, m_cols);
+        for (size_t r=0; r<m_rows; ++r) {
+          for (size_t c=0; c<m_cols; ++c) {
+            (*m)(r, c) = get(r, c);
+          }
+        }
+        m_matrix.reset(m);
+      }
+      return *m_matrix;
+    }
+
+
+    bool
+    BoolMatrix::get(size_t r, size_t c) const
+    {
+      return ((row(r)[c / 64] >> (c % 64)) & 1) != 0;
+    }
+
+
+    void
+    BoolMatrix::set(size_t r, size_t c)
+    {
+      row(r)[c / 64] |= Word(1) << (c % 64);
     }
 
 
     BoolMatrix*
     BoolMatrix::zero_raw() const
     {
-      zero_matrix<value_type> m(m_matrix.size1(), m_matrix.size2());
-      return new BoolMatrix(m);
+      return new BoolMatrix(m_rows, m_cols);
     }
 
 
     BoolMatrix*
     BoolMatrix::one_raw() const
     {
-      identity_matrix<value_type> m(m_matrix.size1(), m_matrix.size2());
-      return new BoolMatrix(m);
+      BoolMatrix * m = new BoolMatrix(m_rows, m_cols);
+      for (size_t i=0; i<m_rows && i<m_cols; ++i) {
+        m->set(i, i);
+      }
+      return m;
     }
 
 
     BoolMatrix*
     BoolMatrix::extend_raw(BoolMatrix * that) const
     {
-      return new BoolMatrix(prod(this->matrix(), that->matrix()));
+      fast_assert(this->m_cols == that->m_rows);
+
+      size_t const words = that->m_row_words;
+      BoolMatrix * result = new BoolMatrix(this->m_rows, that->m_cols);
+
+      if (m_rows < FOUR_RUSSIANS_MIN_ROWS) {
+        for (size_t r=0; r<m_rows; ++r) {
+          Word * out = result->row(r);
+          for (size_t k=0; k<m_cols; ++k) {
+            if (get(r, k)) {
+              details::union_words(out, out, that->row(k), words);
+            }
+          }
+        }
+        return result;
+      }
+
+      // table[j] is the OR of the rows k0+i of 'that' for each bit i set
+      // in j; each entry is one more row ORed into an earlier one
+      std::vector<Word> table(256 * words, 0);
+      for (size_t k0=0; k0<m_cols; k0+=8) {
+        size_t const group = std::min<size_t>(8, m_cols - k0);
+        for (size_t j=1; j < (size_t(1) << group); ++j) {
+          size_t low = 0;
+          while (((j >> low) & 1) == 0) {
+            ++low;
+          }
+          details::union_words(&table[j * words],
+                               &table[(j & (j - 1)) * words],
+                               that->row(k0 + low),
+                               words);
+        }
+
+        for (size_t r=0; r<m_rows; ++r) {
+          size_t const index = (row(r)[k0 / 64] >> (k0 % 64)) & 0xff;
+          if (index != 0) {
+            Word * out = result->row(r);
+            details::union_words(out, out, &table[index * words], words);
+          }
+        }
+      }
+      return result;
     }
 
 
     BoolMatrix*
     BoolMatrix::combine_raw(BoolMatrix * that) const
     {
-      return new BoolMatrix(this->matrix() + that->matrix());
+      fast_assert(this->m_rows == that->m_rows);
+      fast_assert(this->m_cols == that->m_cols);
+
+      BoolMatrix * result = new BoolMatrix(m_rows, m_cols);
+      details::union_words(&result->m_bits[0], &this->m_bits[0],
+                           &that->m_bits[0], m_bits.size());
+      return result;
     }
 
 
     bool
     BoolMatrix::equal(BoolMatrix * that) const
     {
-      fast_assert(this->matrix().size1() == that->matrix().size1());
-      fast_assert(this->matrix().size2() == that->matrix().size2());
+      fast_assert(this->m_rows == that->m_rows);
+      fast_assert(this->m_cols == that->m_cols);
 
-      if (this->matrix().size1() != that->matrix().size1()
-          || this->matrix().size2() != that->matrix().size2())
+      if (this->m_rows != that->m_rows
+          || this->m_cols != that->m_cols)
       {
         return false;
       }
 
-      for (size_t row=0; row<matrix().size1(); ++row) {
-        for (size_t col=0; col<matrix().size2(); ++col) {
-          if (this->matrix()(row, col) != that->matrix()(row, col)) {
-            return false;
+      return details::equal_words(&this->m_bits[0], &that->m_bits[0],
+                                  m_bits.size());
+    }
+
+
+    BoolMatrix*
+    BoolMatrix::star_raw() const
+    {
+      fast_assert(m_rows == m_cols);
+
+      // Warshall's algorithm, a row at a time: once paths through
+      // 0..k-1 are in, any row that reaches k reaches all that k does
+      BoolMatrix * result = new BoolMatrix(*this);
+      for (size_t i=0; i<m_rows; ++i) {
+        result->set(i, i);
+      }
+      for (size_t k=0; k<m_rows; ++k) {
+        Word const * via = result->row(k);
+        for (size_t r=0; r<m_rows; ++r) {
+          if (r != k && result->get(r, k)) {
+            Word * out = result->row(r);
+            details::union_words(out, out, via, m_row_words);
           }
         }
       }
-
-      return true;
+      return result;
     }
 
 
@@ -116,6 +257,36 @@ namespace wali {
       return equal(down(se));
     }
 
+
+    sem_elem_t
+    BoolMatrix::star()
+    {
+      return star_raw();
+    }
+
+
+    bool
+    BoolMatrix::hasBatchOperations() const
+    {
+      return true;
+    }
+
+
+    sem_elem_t
+    BoolMatrix::combineMany(SemElem * const * ses, size_t n)
+    {
+      BoolMatrix * result = new BoolMatrix(*this);
+      for (size_t i=0; i<n; ++i) {
+        BoolMatrix const * that = down(ses[i]);
+        fast_assert(result->m_rows == that->m_rows);
+        fast_assert(result->m_cols == that->m_cols);
+        details::union_words(&result->m_bits[0], &result->m_bits[0],
+                             &that->m_bits[0], m_bits.size());
+      }
+      return result;
+    }
+
+
     BoolMatrix*
     BoolMatrix::down(SemElem* se) const
     {
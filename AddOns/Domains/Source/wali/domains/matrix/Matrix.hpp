@@ -8,12 +8,28 @@
 // version isn't dumb.
 #include <boost/container/vector.hpp>
 #include <boost/numeric/ublas/matrix.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <wali/SemElem.hpp>
+#include <wali/util/Threads.hpp>
+#include <wali/domains/details/BitWords.hpp>
 
 namespace wali {
   namespace domains {
 
+    /// A boolean matrix, as a relation: extend is the matrix product
+    /// (relational composition), combine is element-wise OR, and star is
+    /// the reflexive-transitive closure.
+    ///
+    /// The matrix is kept bit-packed, each row a run of 64-bit words, so
+    /// that OR and equality are word-parallel passes (see
+    /// details/BitWords.hpp) and the product uses the "Four Russians"
+    /// method: for each group of eight rows of the right-hand side, a
+    /// table of all 256 ORs of them is built once, and then each row of
+    /// the result takes one table entry per group instead of eight rows.
+    /// The ublas BackingMatrix is still what BoolMatrix is built from and
+    /// what matrix() returns; it is made from the bits the first time it
+    /// is asked for.
     class BoolMatrix
       : public SemElem
     {
@@ -26,6 +42,8 @@ namespace wali {
 
       BoolMatrix(BackingMatrix const & mat);
 
+      BoolMatrix(BoolMatrix const & that);
+
       BackingMatrix const &
       matrix() const;
 
@@ -44,6 +62,12 @@ namespace wali {
       bool
       equal(BoolMatrix * rhs) const;
 
+      BoolMatrix *
+      star_raw() const;
+
+      bool
+      get(size_t row, size_t col) const;
+
       std::ostream &
       print(std::ostream & stream) const;
 
@@ -54,11 +78,43 @@ namespace wali {
       virtual sem_elem_t extend(SemElem * se);
       virtual sem_elem_t combine(SemElem * se);
       virtual bool equal(SemElem * se) const;
+      virtual sem_elem_t star();
+
+      // Combines several matrices into one result instead of allocating
+      // one for each step
+      virtual bool hasBatchOperations() const;
+      virtual sem_elem_t combineMany(SemElem * const * ses, size_t n);
 
     private:
+      typedef details::Word Word;
+
+      /// An all-false matrix
+      BoolMatrix(size_t rows, size_t cols);
+
+      BoolMatrix & operator=(BoolMatrix const &);
+
       BoolMatrix* down(SemElem* se) const;
 
-      BackingMatrix m_matrix;
+      Word * row(size_t r) {
+        return &m_bits[r * m_row_words];
+      }
+
+      Word const * row(size_t r) const {
+        return &m_bits[r * m_row_words];
+      }
+
+      void set(size_t row, size_t col);
+
+      size_t m_rows, m_cols;
+
+      /// Words per row; bits past m_cols are always clear
+      size_t m_row_words;
+
+      std::vector<Word> m_bits;
+
+      /// matrix(), once it has been asked for
+      mutable boost::scoped_ptr<BackingMatrix> m_matrix;
+      mutable util::Mutex m_matrix_lock;
     };
 
   }
@@ -455,6 +455,18 @@ namespace opennwa
     Trans const & _private_get_transition_storage_() const  {
       return trans;
     }
+
+    /// @brief Returns the transitions in a compact, read-only form
+    ///
+    /// The states and symbols are numbered densely, and the transitions
+    /// are indexed by source, by target, and (for returns) by call
+    /// predecessor in flat arrays; see details::CompactTransitionStorage.
+    /// Algorithms that walk a large, unchanging NWA many times can use
+    /// this instead of the query functions. It is built on the first call
+    /// and again on the first call after the transitions change.
+    details::CompactTransitionStorageRefPtr getCompactTransitions() const {
+      return trans.getCompact();
+    }
       
 
     /**
@@ -767,6 +779,7 @@ namespace opennwa
     // {{{ Deprecated construction functions (& private cheater functions)
     void _private_star_( Nwa const & first );
     void _private_determinize_( Nwa const & nondet );
+    void _private_determinize_bit_matrix_( Nwa const & nondet, unsigned threads = 1 );
     void _private_intersect_( Nwa const & first, Nwa const & second );
     // }}}
       
@@ -0,0 +1,294 @@
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "opennwa/NwaBinary.hpp"
+#include "opennwa/Nwa.hpp"
+
+namespace opennwa {
+
+  using wali::util::BadImageException;
+  using wali::util::BinaryImageWriter;
+
+  typedef NwaImage::Index Index;
+  typedef details::TransitionStorage Trans;
+
+  char const * const NwaImage::MAGIC = "WNWA";
+  const Index NwaImage::VERSION;
+
+
+  namespace {
+
+    /// Numbers keys in the order they are first asked for, adding their
+    /// names to the string table of 'out'
+    class Numbering
+    {
+    public:
+      Numbering(BinaryImageWriter & o, std::vector<Index> & n)
+        : out(o)
+        , names(n)
+      {}
+
+      Index operator()(wali::Key key)
+      {
+        std::map<wali::Key, Index>::const_iterator it = ids.find(key);
+        if (it != ids.end()) {
+          return it->second;
+        }
+        Index id = static_cast<Index>(names.size());
+        names.push_back(out.addKey(key));
+        ids[key] = id;
+        return id;
+      }
+
+    private:
+      BinaryImageWriter & out;
+      std::vector<Index> & names;
+      std::map<wali::Key, Index> ids;
+    };
+
+
+    /// Lays out 'edges', given as (source, fields...) with 'width' words
+    /// after the source, as CSR arrays over 'n' sources
+    void
+    writeEdges(std::vector<Index> const & edges, size_t width, size_t n,
+               std::vector<Index> & offsets, std::vector<Index> & out)
+    {
+      size_t stride = width + 1;
+      offsets.assign(n + 1, 0);
+      for (size_t i = 0; i < edges.size(); i += stride) {
+        offsets[edges[i] + 1]++;
+      }
+      for (size_t s = 0; s < n; ++s) {
+        offsets[s + 1] += offsets[s];
+      }
+      std::vector<Index> next(offsets.begin(), offsets.end() - 1);
+      out.resize(edges.size() / stride * width);
+      for (size_t i = 0; i < edges.size(); i += stride) {
+        Index at = next[edges[i]]++;
+        std::copy(edges.begin() + i + 1, edges.begin() + i + stride, out.begin() + at * width);
+      }
+    }
+
+
+    void
+    checkOffsets(Index const * offsets, size_t size, size_t n, size_t edges)
+    {
+      if (size != n + 1 || offsets[0] != 0 || offsets[n] != edges) {
+        throw BadImageException("NWA image has bad transition offsets");
+      }
+      for (size_t s = 0; s < n; ++s) {
+        if (offsets[s] > offsets[s + 1]) {
+          throw BadImageException("NWA image has bad transition offsets");
+        }
+      }
+    }
+
+
+    void
+    checkIndex(Index i, size_t n)
+    {
+      if (i >= n) {
+        throw BadImageException("NWA image refers to a state or symbol it does not have");
+      }
+    }
+
+  }
+
+
+  void
+  write_nwa_binary(Nwa const & nwa, std::ostream & os)
+  {
+    BinaryImageWriter out(NwaImage::MAGIC, NwaImage::VERSION, NwaImage::NUM_SECTIONS);
+
+    Numbering states(out, out.section(NwaImage::STATES));
+    Numbering symbols(out, out.section(NwaImage::SYMBOLS));
+
+    for (Nwa::StateIterator it = nwa.beginStates(); it != nwa.endStates(); ++it) {
+      states(*it);
+    }
+    for (Nwa::StateIterator it = nwa.beginInitialStates(); it != nwa.endInitialStates(); ++it) {
+      out.section(NwaImage::INITIAL).push_back(states(*it));
+    }
+    for (Nwa::StateIterator it = nwa.beginFinalStates(); it != nwa.endFinalStates(); ++it) {
+      out.section(NwaImage::FINAL).push_back(states(*it));
+    }
+    for (Nwa::SymbolIterator it = nwa.beginSymbols(); it != nwa.endSymbols(); ++it) {
+      symbols(*it);
+    }
+
+    // Each transition as its source followed by the rest of its fields
+    std::vector<Index> internals, calls, returns;
+    for (Nwa::InternalIterator it = nwa.beginInternalTrans(); it != nwa.endInternalTrans(); ++it) {
+      internals.push_back(states(Trans::getSource(*it)));
+      internals.push_back(symbols(Trans::getInternalSym(*it)));
+      internals.push_back(states(Trans::getTarget(*it)));
+    }
+    for (Nwa::CallIterator it = nwa.beginCallTrans(); it != nwa.endCallTrans(); ++it) {
+      calls.push_back(states(Trans::getCallSite(*it)));
+      calls.push_back(symbols(Trans::getCallSym(*it)));
+      calls.push_back(states(Trans::getEntry(*it)));
+    }
+    for (Nwa::ReturnIterator it = nwa.beginReturnTrans(); it != nwa.endReturnTrans(); ++it) {
+      returns.push_back(states(Trans::getExit(*it)));
+      returns.push_back(states(Trans::getCallSite(*it)));
+      returns.push_back(symbols(Trans::getReturnSym(*it)));
+      returns.push_back(states(Trans::getReturnSite(*it)));
+    }
+
+    size_t n = out.section(NwaImage::STATES).size();
+    writeEdges(internals, 2, n, out.section(NwaImage::INTERNAL_OFFSETS), out.section(NwaImage::INTERNALS));
+    writeEdges(calls, 2, n, out.section(NwaImage::CALL_OFFSETS), out.section(NwaImage::CALLS));
+    writeEdges(returns, 3, n, out.section(NwaImage::RETURN_OFFSETS), out.section(NwaImage::RETURNS));
+
+    out.write(os);
+  }
+
+
+  NwaRefPtr
+  read_nwa_binary(std::istream & is)
+  {
+    return NwaImage(is).toNwa();
+  }
+
+
+  NwaImage::NwaImage(std::string const & path)
+    : image(path, MAGIC, VERSION)
+  {
+    check();
+  }
+
+
+  NwaImage::NwaImage(std::istream & is)
+    : image(is, MAGIC, VERSION)
+  {
+    check();
+  }
+
+
+  /// Checks the shape of the image: everything but the transitions
+  /// themselves, which addTo checks as it goes
+  void
+  NwaImage::check() const
+  {
+    if (image.numSections() != NUM_SECTIONS) {
+      throw BadImageException("NWA image has the wrong number of sections");
+    }
+
+    size_t n = numStates();
+    Index const names[] = { STATES, SYMBOLS };
+    for (size_t s = 0; s < 2; ++s) {
+      Range<Index> ids = words(names[s]);
+      for (Range<Index>::const_iterator it = ids.begin(); it != ids.end(); ++it) {
+        checkIndex(*it, image.numStrings());
+      }
+    }
+    Index const sets[] = { INITIAL, FINAL };
+    for (size_t s = 0; s < 2; ++s) {
+      Range<Index> ids = words(sets[s]);
+      for (Range<Index>::const_iterator it = ids.begin(); it != ids.end(); ++it) {
+        checkIndex(*it, n);
+      }
+    }
+
+    if (image.sectionSize(INTERNALS) % 2 != 0
+        || image.sectionSize(CALLS) % 2 != 0
+        || image.sectionSize(RETURNS) % 3 != 0)
+    {
+      throw BadImageException("NWA image has a partial transition");
+    }
+    checkOffsets(image.section(INTERNAL_OFFSETS), image.sectionSize(INTERNAL_OFFSETS),
+                 n, image.sectionSize(INTERNALS) / 2);
+    checkOffsets(image.section(CALL_OFFSETS), image.sectionSize(CALL_OFFSETS),
+                 n, image.sectionSize(CALLS) / 2);
+    checkOffsets(image.section(RETURN_OFFSETS), image.sectionSize(RETURN_OFFSETS),
+                 n, image.sectionSize(RETURNS) / 3);
+  }
+
+
+  NwaImage::Range<NwaImage::Edge>
+  NwaImage::internalsFrom(Index source) const
+  {
+    assert(source < numStates());
+    return edges<Edge>(INTERNAL_OFFSETS, INTERNALS, source);
+  }
+
+
+  NwaImage::Range<NwaImage::Edge>
+  NwaImage::callsFrom(Index callSite) const
+  {
+    assert(callSite < numStates());
+    return edges<Edge>(CALL_OFFSETS, CALLS, callSite);
+  }
+
+
+  NwaImage::Range<NwaImage::ReturnEdge>
+  NwaImage::returnsFromExit(Index exit) const
+  {
+    assert(exit < numStates());
+    return edges<ReturnEdge>(RETURN_OFFSETS, RETURNS, exit);
+  }
+
+
+  void
+  NwaImage::addTo(Nwa & nwa) const
+  {
+    size_t n = numStates();
+    size_t m = numSymbols();
+
+    for (Index q = 0; q < n; ++q) {
+      nwa.addState(state(q));
+    }
+    Range<Index> initial = initialStates();
+    for (Range<Index>::const_iterator it = initial.begin(); it != initial.end(); ++it) {
+      nwa.addInitialState(state(*it));
+    }
+    Range<Index> final = finalStates();
+    for (Range<Index>::const_iterator it = final.begin(); it != final.end(); ++it) {
+      nwa.addFinalState(state(*it));
+    }
+    for (Index s = 0; s < m; ++s) {
+      nwa.addSymbol(symbol(s));
+    }
+
+    for (Index q = 0; q < n; ++q) {
+      Range<Edge> internals = internalsFrom(q);
+      for (Range<Edge>::const_iterator it = internals.begin(); it != internals.end(); ++it) {
+        checkIndex(it->symbol, m);
+        checkIndex(it->target, n);
+        nwa.addInternalTrans(state(q), symbol(it->symbol), state(it->target));
+      }
+      Range<Edge> calls = callsFrom(q);
+      for (Range<Edge>::const_iterator it = calls.begin(); it != calls.end(); ++it) {
+        checkIndex(it->symbol, m);
+        checkIndex(it->target, n);
+        nwa.addCallTrans(state(q), symbol(it->symbol), state(it->target));
+      }
+      Range<ReturnEdge> returns = returnsFromExit(q);
+      for (Range<ReturnEdge>::const_iterator it = returns.begin(); it != returns.end(); ++it) {
+        checkIndex(it->pred, n);
+        checkIndex(it->symbol, m);
+        checkIndex(it->returnSite, n);
+        nwa.addReturnTrans(state(q), state(it->pred), symbol(it->symbol), state(it->returnSite));
+      }
+    }
+  }
+
+
+  NwaRefPtr
+  NwaImage::toNwa() const
+  {
+    NwaRefPtr nwa = new Nwa();
+    addTo(*nwa);
+    return nwa;
+  }
+
+}
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,149 @@
+#ifndef NWA_BINARY_HPP
+#define NWA_BINARY_HPP
+
+#include <iosfwd>
+#include <string>
+
+#include "opennwa/Nwa.hpp"
+#include "wali/util/BinaryImage.hpp"
+
+namespace opennwa {
+
+  /// Writes 'nwa' to 'os' in the binary format that NwaImage reads. The
+  /// states and symbols are written by name, as Nwa::print would, so
+  /// reading the NWA back gives the same automaton as reading its text
+  /// with read_nwa. Client information is not written.
+  extern void write_nwa_binary(Nwa const & nwa, std::ostream & os);
+
+  /// Reads an NWA written by write_nwa_binary from 'is'
+  extern NwaRefPtr read_nwa_binary(std::istream & is);
+
+
+  /**
+   *
+   * An NWA in the binary format of write_nwa_binary. The states and
+   * symbols are numbered densely, their names are kept in a string
+   * table, and the transitions are in flat (CSR) arrays: those leaving
+   * state i are between the offsets of i and i+1, and returns are
+   * indexed by their exit. Opening an image from a file maps it into
+   * memory, so nothing is parsed or copied up front, and a state's or
+   * symbol's name is turned into a Key only when it is first asked for.
+   * A program can thus open a large NWA and look at part of it, or run
+   * over its arrays directly, without paying for getKey on every name.
+   *
+   * Like the BinaryImage it is built on, an NwaImage is not thread safe.
+   *
+   */
+  class NwaImage
+  {
+  public:
+    typedef wali::util::BinaryImage::Word Index;
+
+    struct Edge
+    {
+      Index symbol;
+      Index target;
+    };
+
+    struct ReturnEdge
+    {
+      Index pred;
+      Index symbol;
+      Index returnSite;
+    };
+
+    template< typename T >
+    class Range
+    {
+    public:
+      typedef T const * const_iterator;
+
+      Range(T const * b, T const * e) : first(b), last(e) {}
+
+      const_iterator begin() const { return first; }
+      const_iterator end() const { return last; }
+      size_t size() const { return last - first; }
+      bool empty() const { return first == last; }
+
+    private:
+      T const * first;
+      T const * last;
+    };
+
+    /// Maps the file at 'path'. Throws wali::util::BadImageException if
+    /// it is not an NWA image.
+    explicit NwaImage(std::string const & path);
+
+    /// Reads the rest of 'is'
+    explicit NwaImage(std::istream & is);
+
+    size_t numStates() const { return image.sectionSize(STATES); }
+    size_t numSymbols() const { return image.sectionSize(SYMBOLS); }
+
+    State state(Index i) const { return image.key(image.section(STATES)[i]); }
+    Symbol symbol(Index i) const { return image.key(image.section(SYMBOLS)[i]); }
+
+    char const * stateName(Index i) const { return image.string(image.section(STATES)[i]); }
+    char const * symbolName(Index i) const { return image.string(image.section(SYMBOLS)[i]); }
+
+    Range<Index> initialStates() const { return words(INITIAL); }
+    Range<Index> finalStates() const { return words(FINAL); }
+
+    Range<Edge> internalsFrom(Index source) const;
+    Range<Edge> callsFrom(Index callSite) const;
+    Range<ReturnEdge> returnsFromExit(Index exit) const;
+
+    /// Adds the states, symbols, and transitions of the image to 'nwa'
+    void addTo(Nwa & nwa) const;
+
+    NwaRefPtr toNwa() const;
+
+    bool isMapped() const { return image.isMapped(); }
+
+    enum {
+      STATES = wali::util::BinaryImageWriter::FIRST_SECTION,
+      INITIAL,
+      FINAL,
+      SYMBOLS,
+      INTERNAL_OFFSETS,
+      INTERNALS,
+      CALL_OFFSETS,
+      CALLS,
+      RETURN_OFFSETS,
+      RETURNS,
+      NUM_SECTIONS
+    };
+
+    static char const * const MAGIC;
+    static const Index VERSION = 1;
+
+  private:
+    Range<Index> words(Index section) const
+    {
+      Index const * w = image.section(section);
+      return Range<Index>(w, w + image.sectionSize(section));
+    }
+
+    template< typename E >
+    Range<E> edges(Index offsets, Index section, Index source) const
+    {
+      Index const * o = image.section(offsets);
+      E const * e = reinterpret_cast<E const *>(image.section(section));
+      return Range<E>(e + o[source], e + o[source + 1]);
+    }
+
+    void check() const;
+
+    wali::util::BinaryImage image;
+  };
+
+}
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif
@@ -0,0 +1,414 @@
+#ifndef RELATION_OPS_BITSET_HPP
+#define RELATION_OPS_BITSET_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace wali {
+  namespace relations {
+
+    /// This class represents a binary relation on the numbers 0..n-1 as an
+    /// n-by-n bit matrix, with a row of machine words for each left-hand
+    /// element. Unlike with the std::set and BuDDy relations, the client
+    /// numbers the elements densely (determinize numbers the states of the
+    /// NWA).
+    ///
+    /// The operations below work on a whole row of words at a time, so
+    /// their inner loops are ORs and ANDs over arrays that the compiler can
+    /// vectorize.
+    class BitMatrixRelation
+    {
+    public:
+      typedef unsigned long Word;
+      enum { WORD_BITS = sizeof(Word) * CHAR_BIT };
+
+      explicit BitMatrixRelation(size_t n = 0)
+        : n(n)
+        , stride(wordsFor(n))
+        , bits(n * stride, 0)
+      {}
+
+      /// The number of words needed for a row of n bits
+      static size_t wordsFor(size_t n) {
+        return (n + WORD_BITS - 1) / WORD_BITS;
+      }
+
+      /// The position of the lowest bit set in 'word', which must not be 0
+      static size_t lowestBit(Word word) {
+        assert(word != 0);
+#ifdef __GNUC__
+        return static_cast<size_t>(__builtin_ctzl(word));
+#else
+        size_t bit = 0;
+        while (!(word & 1)) {
+          word >>= 1;
+          ++bit;
+        }
+        return bit;
+#endif
+      }
+
+      /// The number of elements the relation is over
+      size_t domainSize() const { return n; }
+
+      /// The number of words in each row
+      size_t rowWords() const { return stride; }
+
+      Word * row(size_t i) { return &bits[i * stride]; }
+      Word const * row(size_t i) const { return &bits[i * stride]; }
+
+      bool insert(std::pair<size_t, size_t> const & p) {
+        assert(p.first < n && p.second < n);
+        Word & word = bits[p.first * stride + p.second / WORD_BITS];
+        Word mask = Word(1) << (p.second % WORD_BITS);
+        bool added = !(word & mask);
+        word |= mask;
+        return added;
+      }
+
+      bool contains(size_t i, size_t j) const {
+        return (bits[i * stride + j / WORD_BITS] >> (j % WORD_BITS)) & 1;
+      }
+
+      bool empty() const {
+        for (size_t w = 0; w < bits.size(); ++w) {
+          if (bits[w]) return false;
+        }
+        return true;
+      }
+
+      /// The number of pairs in the relation
+      size_t size() const {
+        size_t count = 0;
+        for (size_t w = 0; w < bits.size(); ++w) {
+          for (Word word = bits[w]; word; word &= word - 1) {
+            ++count;
+          }
+        }
+        return count;
+      }
+
+      /// Calls f(i, j) for each pair (i, j) in the relation, in
+      /// lexicographic order (the order of a std::set of pairs)
+      template<typename Function>
+      void for_each(Function & f) const {
+        for (size_t i = 0; i < n; ++i) {
+          Word const * r = row(i);
+          for (size_t w = 0; w < stride; ++w) {
+            for (Word word = r[w]; word; word &= word - 1) {
+              f(i, w * WORD_BITS + lowestBit(word));
+            }
+          }
+        }
+      }
+
+      /// A hash of the pairs in the relation (FNV-1a over the words)
+      size_t hash() const {
+        size_t h = static_cast<size_t>(2166136261u);
+        for (size_t w = 0; w < bits.size(); ++w) {
+          h = (h ^ static_cast<size_t>(bits[w] ^ (bits[w] >> 31))) * static_cast<size_t>(16777619u);
+        }
+        return h ^ n;
+      }
+
+      bool operator==(BitMatrixRelation const & other) const {
+        return n == other.n && bits == other.bits;
+      }
+
+      bool operator!=(BitMatrixRelation const & other) const {
+        return !(*this == other);
+      }
+
+      bool operator<(BitMatrixRelation const & other) const {
+        return n < other.n || (n == other.n && bits < other.bits);
+      }
+
+    private:
+      size_t n;
+      size_t stride;
+      std::vector<Word> bits;
+    };
+
+
+    /// This class represents a return transition relation with the symbol
+    /// projected out, over the same numbering as BitMatrixRelation. It
+    /// holds a row of return sites for each (exit, call predecessor) pair
+    /// that has a return.
+    class BitMatrixReturnRelation
+    {
+    public:
+      typedef BitMatrixRelation::Word Word;
+
+      explicit BitMatrixReturnRelation(size_t n = 0)
+        : n(n)
+        , stride(BitMatrixRelation::wordsFor(n))
+      {}
+
+      size_t domainSize() const { return n; }
+
+      void insert(size_t exit, size_t pred, size_t ret) {
+        assert(exit < n && pred < n && ret < n);
+        Word * sites = returnSites(exit, pred);
+        sites[ret / BitMatrixRelation::WORD_BITS] |= Word(1) << (ret % BitMatrixRelation::WORD_BITS);
+      }
+
+      /// The number of (exit, call predecessor) pairs with a return
+      size_t numKeys() const { return keys.size(); }
+
+      /// The k'th (exit, call predecessor) pair
+      std::pair<size_t, size_t> const & key(size_t k) const { return keys[k]; }
+
+      Word * returnSites(size_t k) { return &bits[k * stride]; }
+      Word const * returnSites(size_t k) const { return &bits[k * stride]; }
+
+      /// The row of return sites of (exit, pred), added empty if there is
+      /// none yet
+      Word * returnSites(size_t exit, size_t pred) {
+        std::pair<size_t, size_t> key(exit, pred);
+        std::map<std::pair<size_t, size_t>, size_t>::const_iterator found = index.find(key);
+        if (found == index.end()) {
+          found = index.insert(std::make_pair(key, keys.size())).first;
+          keys.push_back(key);
+          bits.resize(bits.size() + stride, 0);
+        }
+        return returnSites(found->second);
+      }
+
+    private:
+      size_t n;
+      size_t stride;
+      std::vector<std::pair<size_t, size_t> > keys;
+      std::map<std::pair<size_t, size_t>, size_t> index;   // key -> k
+      std::vector<Word> bits;
+    };
+
+
+    /// out |= the rows of 'r' for the elements in 'row'
+    inline void
+    or_rows(BitMatrixRelation::Word * out,
+            BitMatrixRelation::Word const * row,
+            BitMatrixRelation const & r)
+    {
+      typedef BitMatrixRelation::Word Word;
+      size_t const stride = r.rowWords();
+      for (size_t w = 0; w < stride; ++w) {
+        for (Word word = row[w]; word; word &= word - 1) {
+          Word const * other = r.row(w * BitMatrixRelation::WORD_BITS + BitMatrixRelation::lowestBit(word));
+          for (size_t v = 0; v < stride; ++v) {
+            out[v] |= other[v];
+          }
+        }
+      }
+    }
+
+
+    /// Composes two binary relations
+    ///
+    /// { (x,z) | (x,y) \in r1,  (y,z) \in r2}
+    ///
+    /// Parameters:
+    ///   out_result: The relational composition of r1 and r2
+    ///   r1:         relation 1
+    ///   r2:         relation 2
+    inline void
+    compose(BitMatrixRelation & out_result,
+            BitMatrixRelation const & r1,
+            BitMatrixRelation const & r2)
+    {
+      assert(r1.domainSize() == r2.domainSize());
+      if (out_result.domainSize() != r1.domainSize()) {
+        out_result = BitMatrixRelation(r1.domainSize());
+      }
+      for (size_t x = 0; x < r1.domainSize(); ++x) {
+        or_rows(out_result.row(x), r1.row(x), r2);
+      }
+    }
+
+
+    /// Composes a return relation with a binary relation on the return
+    /// sites
+    ///
+    /// { (exit, pred, z) | (exit, pred, ret) \in delta_r, (ret, z) \in r }
+    inline void
+    compose(BitMatrixReturnRelation & out_result,
+            BitMatrixReturnRelation const & delta_r,
+            BitMatrixRelation const & r)
+    {
+      assert(delta_r.domainSize() == r.domainSize());
+      for (size_t k = 0; k < delta_r.numKeys(); ++k) {
+        std::pair<size_t, size_t> const & key = delta_r.key(k);
+        or_rows(out_result.returnSites(key.first, key.second), delta_r.returnSites(k), r);
+      }
+    }
+
+
+    /// The relation from the call predecessors through 'r_exit' and a
+    /// return to the return sites; merge composes this with r_call
+    ///
+    /// {(q1, q') | (q1,q2) \in r_exit, (q2,q1,q') \in delta}
+    ///
+    /// Parameters:
+    ///   out_result: The relation through the returns
+    ///   r_exit:     The relation at the exit node
+    ///   delta_r:    The return transition relation with the alphabet
+    ///               symbol projected out
+    inline void
+    returns_through(BitMatrixRelation & out_result,
+                    BitMatrixRelation const & r_exit,
+                    BitMatrixReturnRelation const & delta_r)
+    {
+      typedef BitMatrixRelation::Word Word;
+      if (out_result.domainSize() != r_exit.domainSize()) {
+        out_result = BitMatrixRelation(r_exit.domainSize());
+      }
+      for (size_t k = 0; k < delta_r.numKeys(); ++k) {
+        size_t exit = delta_r.key(k).first;
+        size_t pred = delta_r.key(k).second;
+        if (r_exit.contains(pred, exit)) {
+          Word * out = out_result.row(pred);
+          Word const * sites = delta_r.returnSites(k);
+          for (size_t w = 0; w < out_result.rowWords(); ++w) {
+            out[w] |= sites[w];
+          }
+        }
+      }
+    }
+
+
+    /// Performs the sort of merge required for NWA return edges
+    ///
+    /// {(q, q') | (q,q1) \in r_call, (q1,q2) \in r_exit, (q2,q1,q') \in delta}
+    ///
+    /// Parameters:
+    ///   out_result: The relational composition of R1 and R2
+    ///   r_exit:     The relation at the exit node
+    ///   r_call:     The relation at the call node
+    ///   delta_r:    The return transition relation with the alphabet
+    ///               symbol projected out
+    inline void
+    merge(BitMatrixRelation & out_result,
+          BitMatrixRelation const & r_exit,
+          BitMatrixRelation const & r_call,
+          BitMatrixReturnRelation const & delta_r)
+    {
+      BitMatrixRelation temp(r_exit.domainSize());
+      returns_through(temp, r_exit, delta_r);
+      compose(out_result, r_call, temp);
+    }
+
+
+    /// Constructs the transitive closure of a relation, with a pair (p,p)
+    /// for each p in a pair of r, like the std::set version
+    ///
+    /// Parameters:
+    ///   out_result: The transitive closure of r
+    ///   r:          The source relation
+    inline void
+    transitive_closure(BitMatrixRelation & out_result,
+                       BitMatrixRelation const & r)
+    {
+      size_t const n = r.domainSize();
+      BitMatrixRelation closure = r;
+      for (size_t i = 0; i < n; ++i) {
+        BitMatrixRelation::Word const * row = r.row(i);
+        for (size_t w = 0; w < r.rowWords(); ++w) {
+          for (BitMatrixRelation::Word word = row[w]; word; word &= word - 1) {
+            size_t j = w * BitMatrixRelation::WORD_BITS + BitMatrixRelation::lowestBit(word);
+            closure.insert(std::make_pair(i, i));
+            closure.insert(std::make_pair(j, j));
+          }
+        }
+      }
+
+      // Warshall's algorithm, a row at a time
+      for (size_t k = 0; k < n; ++k) {
+        BitMatrixRelation::Word const * through = closure.row(k);
+        for (size_t i = 0; i < n; ++i) {
+          if (i != k && closure.contains(i, k)) {
+            BitMatrixRelation::Word * row = closure.row(i);
+            for (size_t w = 0; w < closure.rowWords(); ++w) {
+              row[w] |= through[w];
+            }
+          }
+        }
+      }
+
+      if (out_result.domainSize() != n) {
+        out_result = BitMatrixRelation(n);
+      }
+      for (size_t i = 0; i < n; ++i) {
+        BitMatrixRelation::Word * row = out_result.row(i);
+        BitMatrixRelation::Word const * from = closure.row(i);
+        for (size_t w = 0; w < closure.rowWords(); ++w) {
+          row[w] |= from[w];
+        }
+      }
+    }
+
+
+    /// Returns the intersection of two binary relations on states
+    ///
+    /// Parameters:
+    ///   out_result: The intersection of r1 and r2
+    ///   r1:         One binary relation on states
+    ///   r2:         Another binary relation on states
+    inline void
+    intersect(BitMatrixRelation & out_result,
+              BitMatrixRelation const & r1,
+              BitMatrixRelation const & r2)
+    {
+      assert(r1.domainSize() == r2.domainSize());
+      if (out_result.domainSize() != r1.domainSize()) {
+        out_result = BitMatrixRelation(r1.domainSize());
+      }
+      for (size_t i = 0; i < r1.domainSize(); ++i) {
+        BitMatrixRelation::Word * row = out_result.row(i);
+        BitMatrixRelation::Word const * row1 = r1.row(i);
+        BitMatrixRelation::Word const * row2 = r2.row(i);
+        for (size_t w = 0; w < r1.rowWords(); ++w) {
+          row[w] |= row1[w] & row2[w];
+        }
+      }
+    }
+
+
+    /// Returns the union of two binary relations on states
+    ///
+    /// Parameters:
+    ///   out_result: The union of r1 and r2
+    ///   r1:         One binary relation on states
+    ///   r2:         Another binary relation on states
+    inline void
+    union_(BitMatrixRelation & out_result,
+           BitMatrixRelation const & r1,
+           BitMatrixRelation const & r2)
+    {
+      assert(r1.domainSize() == r2.domainSize());
+      if (out_result.domainSize() != r1.domainSize()) {
+        out_result = BitMatrixRelation(r1.domainSize());
+      }
+      for (size_t i = 0; i < r1.domainSize(); ++i) {
+        BitMatrixRelation::Word * row = out_result.row(i);
+        BitMatrixRelation::Word const * row1 = r1.row(i);
+        BitMatrixRelation::Word const * row2 = r2.row(i);
+        for (size_t w = 0; w < r1.rowWords(); ++w) {
+          row[w] |= row1[w] | row2[w];
+        }
+      }
+    }
+  } // namespace relations
+} // namespace wali
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif
@@ -1,3 +1,6 @@
+#ifndef WALI_NWA_CONSTRUCT_DETERMINIZE_HPP
+#define WALI_NWA_CONSTRUCT_DETERMINIZE_HPP
+
 #include "opennwa/NwaFwd.hpp"
 
 namespace opennwa
@@ -5,7 +8,31 @@ namespace opennwa
   namespace construct
   {
 
-    extern void determinize(Nwa & out, Nwa const & source);
+    /// @brief How determinize represents the binary relations on states
+    /// that make up the states of the deterministic NWA
+    enum DeterminizeRelations {
+      /// Bit matrices if the NWA has at most BIT_MATRIX_MAX_STATES
+      /// states, sets otherwise
+      RelationsByStateCount,
+
+      /// std::sets of pairs of states (or BDDs, if built with USE_BUDDY).
+      /// The size of a relation is proportional to its number of pairs.
+      RelationsAsSets,
+
+      /// n-by-n bit matrices over the n states of the NWA
+      /// (wali::relations::BitMatrixRelation). Composing and merging work
+      /// a machine word at a time, but every relation takes n*n bits
+      /// however few pairs it has.
+      RelationsAsBitMatrices
+    };
+
+    /// The most states for which RelationsByStateCount uses bit matrices
+    const unsigned int BIT_MATRIX_MAX_STATES = 512;
+
+
+    extern void determinize(Nwa & out, Nwa const & source,
+                            DeterminizeRelations how = RelationsByStateCount,
+                            unsigned threads = 1);
 
 
     /**
@@ -15,12 +42,21 @@ namespace opennwa
      * This method constructs a deterministic NWA that is equivalent to the given NWA.
      * Note: The resulting NWA is guaranteed to be deterministic.
      *
+     * With bit matrices, the states of the deterministic NWA found in one
+     * round are expanded concurrently on up to 'threads' threads (0 means
+     * as many as the hardware has; without 'scons threads=1', one). The
+     * result is the same NWA, with the same keys, for any number of
+     * threads. With sets, 'threads' is ignored.
+     *
      * @param - nondet: the NWA to determinize
-     * @param - stuck: dummy parameter
+     * @param - how: the representation of the relations on states
+     * @param - threads: the number of threads to use with bit matrices
      * @return the NWA resulting from determinizing the given NWA
      *
      */
-    extern NwaRefPtr determinize( Nwa const & nondet );
+    extern NwaRefPtr determinize( Nwa const & nondet,
+                                  DeterminizeRelations how = RelationsByStateCount,
+                                  unsigned threads = 1 );
 
       
   }
@@ -33,3 +69,4 @@ namespace opennwa
 //   c-basic-offset: 2
 // End:
 
+#endif
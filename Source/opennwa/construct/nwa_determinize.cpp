@@ -1,21 +1,39 @@
 #include "opennwa/Nwa.hpp"
 #include "opennwa/construct/determinize.hpp"
+#include "opennwa/RelationOpsBitset.hpp"
+
+#include "wali/util/Threads.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <typeinfo>
 
 namespace opennwa
 {
   namespace construct
   {
       
-    void determinize(Nwa & out, Nwa const & source)
+    void determinize(Nwa & out, Nwa const & source, DeterminizeRelations how, unsigned threads)
     {
-      out._private_determinize_(source);
+      if (how == RelationsByStateCount) {
+        how = (source.sizeStates() <= BIT_MATRIX_MAX_STATES
+               ? RelationsAsBitMatrices
+               : RelationsAsSets);
+      }
+
+      if (how == RelationsAsBitMatrices) {
+        out._private_determinize_bit_matrix_(source, threads);
+      }
+      else {
+        out._private_determinize_(source);
+      }
     }
 
 
-    NwaRefPtr determinize( Nwa const & nondet )
+    NwaRefPtr determinize( Nwa const & nondet, DeterminizeRelations how, unsigned threads )
     {
       NwaRefPtr nwa( new Nwa());
-      determinize(*nwa, nondet);
+      determinize(*nwa, nondet, how, threads);
       return nwa;
     }
 
@@ -416,6 +434,521 @@ namespace opennwa
 #undef DECLARE
   }
 
+
+  namespace
+  {
+    using wali::relations::BitMatrixRelation;
+    using wali::relations::BitMatrixReturnRelation;
+
+    /// A state of the deterministic NWA: a relation on the (densely
+    /// numbered) states of the nondeterministic one
+    struct MacroState
+    {
+      explicit MacroState(BitMatrixRelation const & relation)
+        : relation(relation)
+        , key(wali::WALI_BAD_KEY)
+        , order(0)
+      {}
+
+      BitMatrixRelation relation;
+      State key;
+      size_t order;     // the position in the order macro-states were found
+    };
+
+
+    /// The macro-states found so far, in a hash set that several threads
+    /// can add to at once. The set is split into shards by hash, each
+    /// with its own lock.
+    class MacroStateTable
+    {
+    public:
+      /// Returns the macro-state for R, adding it if it is new
+      MacroState * intern(BitMatrixRelation const & R)
+      {
+        size_t hash = R.hash();
+        Shard & shard = shards[hash % NUM_SHARDS];
+        wali::util::LockGuard guard(shard.lock);
+
+        typedef std::multimap<size_t, MacroState*>::const_iterator Iterator;
+        std::pair<Iterator, Iterator> range = shard.byHash.equal_range(hash);
+        for (Iterator it = range.first; it != range.second; ++it) {
+          if (it->second->relation == R) {
+            return it->second;
+          }
+        }
+
+        shard.entries.push_back(MacroState(R));
+        MacroState * added = &shard.entries.back();
+        shard.byHash.insert(std::make_pair(hash, added));
+        shard.added.push_back(added);
+        return added;
+      }
+
+      /// Moves the macro-states added since the last call to 'out'. No
+      /// other thread may be using the table.
+      void takeAdded(std::vector<MacroState*> & out)
+      {
+        for (size_t s = 0; s < NUM_SHARDS; ++s) {
+          out.insert(out.end(), shards[s].added.begin(), shards[s].added.end());
+          shards[s].added.clear();
+        }
+      }
+
+    private:
+      enum { NUM_SHARDS = 64 };
+
+      struct Shard
+      {
+        wali::util::Mutex lock;
+        std::multimap<size_t, MacroState*> byHash;
+        std::deque<MacroState> entries;     // deque: pointers stay valid
+        std::vector<MacroState*> added;
+      };
+
+      Shard shards[NUM_SHARDS];
+    };
+
+
+    bool
+    compareRelations(MacroState const * left, MacroState const * right)
+    {
+      return left->relation < right->relation;
+    }
+
+
+    /// Writes the pairs of a relation the way makeKey does, with the
+    /// dense numbers mapped back to states
+    struct KeyWriter
+    {
+      KeyWriter(std::vector<State> const & stateOf, std::ostream & os)
+        : stateOf(stateOf), os(os)
+      {}
+
+      void operator()(size_t i, size_t j) {
+        os << "<" << stateOf[i] << "," << stateOf[j] << ">";
+      }
+
+      std::vector<State> const & stateOf;
+      std::ostream & os;
+    };
+
+
+    /// Writes the name of each new macro-state (the same string makeKey
+    /// gives the std::set relation)
+    struct NameMacroStates
+    {
+      NameMacroStates(std::vector<MacroState*> const & added,
+                      std::vector<State> const & stateOf,
+                      std::vector<std::string> & names)
+        : added(added), stateOf(stateOf), names(names)
+      {}
+
+      void operator()(size_t i) {
+        std::stringstream ss;
+        KeyWriter writer(stateOf, ss);
+        ss << "{";
+        added[i]->relation.for_each(writer);
+        ss << "}";
+        names[i] = ss.str();
+      }
+
+      std::vector<MacroState*> const & added;
+      std::vector<State> const & stateOf;
+      std::vector<std::string> & names;
+    };
+
+
+    /// Names the macro-states added to 'table' since the last call, in
+    /// the order of their relations, and appends them to 'visited' and
+    /// 'out'
+    void
+    nameAdded(MacroStateTable & table,
+              std::vector<State> const & stateOf,
+              unsigned threads,
+              std::vector<MacroState*> & visited,
+              std::vector<MacroState*> & out)
+    {
+      size_t start = out.size();
+      table.takeAdded(out);
+      std::sort(out.begin() + start, out.end(), compareRelations);
+
+      std::vector<MacroState*> added(out.begin() + start, out.end());
+      std::vector<std::string> names(added.size());
+      NameMacroStates namer(added, stateOf, names);
+      wali::util::parallel_for(threads, added.size(), namer);
+
+      for( size_t i = 0; i < added.size(); ++i ) {
+        added[i]->key = getKey(names[i]);
+        added[i]->order = visited.size();
+        visited.push_back(added[i]);
+      }
+    }
+
+
+    /// Inserts the pairs of a relation into a BinaryRelation, with the
+    /// dense numbers mapped back to states
+    struct PairInserter
+    {
+      PairInserter(std::vector<State> const & stateOf, Nwa::BinaryRelation & out)
+        : stateOf(stateOf), out(out)
+      {}
+
+      void operator()(size_t i, size_t j) {
+        out.insert(std::make_pair(stateOf[i], stateOf[j]));
+      }
+
+      std::vector<State> const & stateOf;
+      Nwa::BinaryRelation & out;
+    };
+
+
+    /// Computes the targets of the transitions out of each macro-state in
+    /// the frontier. For frontier[i] and each symbol, in order, successors[i]
+    /// gets the target of the internal transition, then the return sites
+    /// with frontier[i] as the exit and each macro-state found no later than
+    /// it as the call predecessor, then those with the roles swapped. (The
+    /// call targets do not depend on the macro-state.)
+    struct ExpandFrontier
+    {
+      ExpandFrontier(std::vector<MacroState*> const & frontier,
+                     std::vector<MacroState*> const & visited,
+                     std::vector<BitMatrixRelation> const & internals,
+                     std::vector<BitMatrixReturnRelation> const & returns,
+                     MacroStateTable & table,
+                     std::vector<std::vector<MacroState*> > & successors)
+        : frontier(frontier), visited(visited), internals(internals)
+        , returns(returns), table(table), successors(successors)
+      {}
+
+      void operator()(size_t i) {
+        MacroState const & R = *frontier[i];
+        size_t const n = R.relation.domainSize();
+        std::vector<MacroState*> & out = successors[i];
+        out.reserve(internals.size() * (2 * R.order + 3));
+
+        for (size_t s = 0; s < internals.size(); ++s) {
+          BitMatrixRelation Ri(n);
+          compose(Ri, R.relation, internals[s]);
+          out.push_back(table.intern(Ri));
+
+          // With R as the exit, merge's first step is the same for every
+          // call predecessor
+          BitMatrixRelation throughR(n);
+          returns_through(throughR, R.relation, returns[s]);
+          for (size_t v = 0; v <= R.order; ++v) {
+            BitMatrixRelation Rr(n);
+            compose(Rr, visited[v]->relation, throughR);
+            out.push_back(table.intern(Rr));
+          }
+          for (size_t v = 0; v <= R.order; ++v) {
+            BitMatrixRelation Rr(n);
+            merge(Rr, visited[v]->relation, R.relation, returns[s]);
+            out.push_back(table.intern(Rr));
+          }
+        }
+      }
+
+      std::vector<MacroState*> const & frontier;
+      std::vector<MacroState*> const & visited;
+      std::vector<BitMatrixRelation> const & internals;
+      std::vector<BitMatrixReturnRelation> const & returns;
+      MacroStateTable & table;
+      std::vector<std::vector<MacroState*> > & successors;
+    };
+  }
+
+
+  /**
+   *
+   * @brief constructs a deterministic NWA that is equivalent to the given
+   * NWA, representing the relations as bit matrices
+   *
+   * This is the same construction as _private_determinize_, with the
+   * states of 'nondet' numbered densely and each relation stored as a
+   * wali::relations::BitMatrixRelation. It gives the same NWA, with the
+   * same state keys (with USE_BUDDY, the keys are not the BDD's).
+   *
+   * Because (R;I);close = R;(I;close), each symbol's internal and return
+   * relations are composed with the epsilon closure once, up front, and
+   * the target of a call (which does not depend on R) is computed once per
+   * symbol instead of once per state.
+   *
+   * The macro-states are explored a frontier at a time: the ones found in
+   * one round are expanded in the next, on up to 'threads' threads
+   * (clamped as by util::effective_threads), and the transitions they make
+   * are then added on this thread in order. New macro-states are named in
+   * the order of their relations, so the keys the NWA gets do not depend
+   * on the number of threads. The client info callbacks are called on
+   * this thread, but in a different order than _private_determinize_
+   * calls them.
+   *
+   * @param - nondet: the NWA to determinize
+   * @param - threads: the number of threads to expand macro-states on
+   *
+   */
+    
+  void Nwa::_private_determinize_bit_matrix_( Nwa const & nondet, unsigned threads )
+  {
+#ifdef USE_BUDDY
+    wali::relations::buddyInit();
+#  define DECLARE(type, name)  type name(nondet.largestState())
+#else
+#  define DECLARE(type, name)  type name
+#endif
+
+    clear();
+
+    using namespace wali::relations;
+
+    // Number the states in increasing order, so the pairs of a relation
+    // come out in the same order as from a std::set
+    std::vector<State> stateOf(nondet.beginStates(), nondet.endStates());
+    std::map<State, size_t> number;
+    for( size_t i = 0; i < stateOf.size(); ++i ) {
+      number[stateOf[i]] = i;
+    }
+    size_t const n = stateOf.size();
+
+    // Only a subclass can override the client info callbacks; don't
+    // convert the relations to BinaryRelations for the ones that do nothing
+    bool const callbacks = (typeid(*this) != typeid(Nwa));
+
+    // The epsilon closure
+    BitMatrixRelation epsilons(n);
+    for( Internals::const_iterator it = nondet.trans.getInternals().begin();
+         it != nondet.trans.getInternals().end(); ++it )
+    {
+      if( it->second == EPSILON ) {
+        epsilons.insert(std::make_pair(number[it->first], number[it->third]));
+      }
+    }
+    BitMatrixRelation close(n);
+    transitive_closure(close, epsilons);
+    for( size_t i = 0; i < n; ++i ) {
+      close.insert(std::make_pair(i, i));
+    }
+
+    // The transitions of each symbol, with WILD matching every symbol
+    std::vector<Symbol> symbols;
+    for( SymbolIterator it = nondet.beginSymbols(); it != nondet.endSymbols(); it++ ) {
+      if( *it == EPSILON || *it == WILD ) continue;
+      symbols.push_back(*it);
+    }
+
+    std::vector<BitMatrixRelation> internals(symbols.size(), BitMatrixRelation(n));
+    std::vector<BitMatrixRelation> calls(symbols.size(), BitMatrixRelation(n));
+    std::vector<BitMatrixReturnRelation> returns(symbols.size(), BitMatrixReturnRelation(n));
+
+    for( Internals::const_iterator it = nondet.trans.getInternals().begin();
+         it != nondet.trans.getInternals().end(); ++it )
+    {
+      if( it->second == EPSILON ) continue;
+      std::pair<size_t, size_t> edge(number[it->first], number[it->third]);
+      for( size_t s = 0; s < symbols.size(); ++s ) {
+        if( it->second == WILD || it->second == symbols[s] ) {
+          internals[s].insert(edge);
+        }
+      }
+    }
+    for( Calls::const_iterator it = nondet.trans.getCalls().begin();
+         it != nondet.trans.getCalls().end(); ++it )
+    {
+      std::pair<size_t, size_t> edge(number[it->first], number[it->third]);
+      for( size_t s = 0; s < symbols.size(); ++s ) {
+        if( it->second == WILD || it->second == symbols[s] ) {
+          calls[s].insert(edge);
+        }
+      }
+    }
+    for( Returns::const_iterator it = nondet.trans.getReturns().begin();
+         it != nondet.trans.getReturns().end(); ++it )
+    {
+      for( size_t s = 0; s < symbols.size(); ++s ) {
+        if( it->third == WILD || it->third == symbols[s] ) {
+          returns[s].insert(number[it->first], number[it->second], number[it->fourth]);
+        }
+      }
+    }
+
+    // Fold in the closure: R;(I;close), the call target I;close, and the
+    // return sites ;close
+    for( size_t s = 0; s < symbols.size(); ++s ) {
+      BitMatrixRelation internalsThenClose(n), callsThenClose(n);
+      BitMatrixReturnRelation returnsThenClose(n);
+      compose(internalsThenClose, internals[s], close);
+      compose(callsThenClose, calls[s], close);
+      compose(returnsThenClose, returns[s], close);
+      std::swap(internals[s], internalsThenClose);
+      std::swap(calls[s], callsThenClose);
+      std::swap(returns[s], returnsThenClose);
+    }
+
+    // R0 = Epsilon Closure( Q0 x Q0 )
+    BitMatrixRelation q0crossQ0(n), R0(n);
+    for( StateIterator initial1 = nondet.beginInitialStates();
+         initial1 != nondet.endInitialStates(); ++initial1 )
+    {
+      for( StateIterator initial2 = nondet.beginInitialStates();
+           initial2 != nondet.endInitialStates(); ++initial2 )
+      {
+        q0crossQ0.insert(std::make_pair(number[*initial1], number[*initial2]));
+      }
+    }
+    compose(R0, q0crossQ0, close);
+
+    MacroStateTable table;
+    MacroState * r0 = table.intern(R0);
+    std::vector<MacroState*> callTargets;
+    for( size_t s = 0; s < symbols.size(); ++s ) {
+      callTargets.push_back(table.intern(calls[s]));
+    }
+
+    std::vector<MacroState*> visited;
+    std::vector<MacroState*> frontier;
+    std::vector<MacroState*> found;
+    std::vector<std::vector<MacroState*> > successors;
+
+    nameAdded(table, stateOf, threads, visited, frontier);
+    for( size_t i = 0; i < frontier.size(); ++i ) {
+      addState(frontier[i]->key);
+    }
+    addInitialState(r0->key);
+    if( callbacks ) {
+      DECLARE(BinaryRelation, R0set);
+      PairInserter inserter(stateOf, R0set);
+      R0.for_each(inserter);
+
+      ClientInfoRefPtr CI;
+      mergeClientInfo(nondet,R0set,r0->key,CI);
+      states.setClientInfo(r0->key,CI);
+    }
+
+    while( !frontier.empty() )
+    {
+      successors.assign(frontier.size(), std::vector<MacroState*>());
+      ExpandFrontier expand(frontier, visited, internals, returns, table, successors);
+      wali::util::parallel_for(threads, frontier.size(), expand);
+
+      // The macro-states found in this round make up the next frontier
+      found.clear();
+      nameAdded(table, stateOf, threads, visited, found);
+      for( size_t i = 0; i < found.size(); ++i ) {
+        addState(found[i]->key);
+      }
+
+      // Add the transitions, in the same order as the sequential
+      // construction would for each macro-state
+      for( size_t i = 0; i < frontier.size(); ++i )
+      {
+        MacroState const & R = *frontier[i];
+        State r = R.key;
+        std::vector<MacroState*>::const_iterator next = successors[i].begin();
+
+        DECLARE(BinaryRelation, Rset);
+        if( callbacks ) {
+          PairInserter inserter(stateOf, Rset);
+          R.relation.for_each(inserter);
+        }
+
+        for( size_t s = 0; s < symbols.size(); ++s )
+        {
+          Symbol sym = symbols[s];
+
+          //Process internal transitions.
+          MacroState const * ri = *next++;
+          addInternalTrans(r,sym,ri->key);
+          if( callbacks ) {
+            DECLARE(BinaryRelation, Riset);
+            PairInserter inserter(stateOf, Riset);
+            ri->relation.for_each(inserter);
+
+            ClientInfoRefPtr riCI;
+            mergeClientInfoInternal(nondet,Rset,Riset,r,sym,ri->key,riCI);
+            states.setClientInfo(ri->key,riCI);
+          }
+
+          //Process call transitions.
+          MacroState const * rc = callTargets[s];
+          addCallTrans(r,sym,rc->key);
+          if( callbacks ) {
+            DECLARE(BinaryRelation, Rcset);
+            PairInserter inserter(stateOf, Rcset);
+            rc->relation.for_each(inserter);
+
+            ClientInfoRefPtr rcCI;
+            mergeClientInfoCall(nondet,Rset,Rcset,r,sym,rc->key,rcCI);
+            states.setClientInfo(rc->key,rcCI);
+          }
+
+          //Process return transitions, first with each possible call
+          //predecessor, then with each possible exit point.
+          for( size_t v = 0; v <= R.order; ++v )
+          {
+            MacroState const * rr = *next++;
+            addReturnTrans(r,visited[v]->key,sym,rr->key);
+            if( callbacks ) {
+              DECLARE(BinaryRelation, Rcallset);
+              DECLARE(BinaryRelation, Rrset);
+              PairInserter callInserter(stateOf, Rcallset);
+              PairInserter retInserter(stateOf, Rrset);
+              visited[v]->relation.for_each(callInserter);
+              rr->relation.for_each(retInserter);
+
+              ClientInfoRefPtr rrCI;
+              mergeClientInfoReturn(nondet,Rset,Rcallset,Rrset,r,visited[v]->key,sym,rr->key,rrCI);
+              states.setClientInfo(rr->key,rrCI);
+            }
+          }
+          for( size_t v = 0; v <= R.order; ++v )
+          {
+            MacroState const * rr = *next++;
+            addReturnTrans(visited[v]->key,r,sym,rr->key);
+            if( callbacks ) {
+              DECLARE(BinaryRelation, Rrset);
+              PairInserter inserter(stateOf, Rrset);
+              rr->relation.for_each(inserter);
+
+              ClientInfoRefPtr rrCI;
+              mergeClientInfo(nondet,Rrset,rr->key,rrCI);
+              states.setClientInfo(rr->key,rrCI);
+            }
+          }
+        }
+        assert(next == successors[i].end());
+        std::vector<MacroState*>().swap(successors[i]);
+      }
+
+      frontier.swap(found);
+    }
+
+    //A state is final if its relation has a pair (q,fin) for a final
+    //state fin.
+    std::vector<BitMatrixRelation::Word> finalColumns(BitMatrixRelation::wordsFor(n), 0);
+    for( StateIterator fit = nondet.beginFinalStates(); fit != nondet.endFinalStates(); fit++ )
+    {
+      size_t f = number[*fit];
+      finalColumns[f / BitMatrixRelation::WORD_BITS] |= BitMatrixRelation::Word(1) << (f % BitMatrixRelation::WORD_BITS);
+    }
+    for( size_t v = 0; v < visited.size(); ++v )
+    {
+      BitMatrixRelation const & R = visited[v]->relation;
+      bool final = false;
+      for( size_t i = 0; i < n && !final; ++i ) {
+        BitMatrixRelation::Word const * row = R.row(i);
+        for( size_t w = 0; w < finalColumns.size(); ++w ) {
+          if( row[w] & finalColumns[w] ) {
+            final = true;
+            break;
+          }
+        }
+      }
+      if( final ) {
+        addFinalState(visited[v]->key);
+      }
+    }
+#undef DECLARE
+  }
+
 #ifdef USE_BUDDY
     
   State NWA::makeKey(
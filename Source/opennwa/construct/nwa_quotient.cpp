@@ -19,9 +19,9 @@ namespace opennwa
       //Clear all states(except the stuck state) and transitions from this machine.
       out.clear();
 
-      // Map from the representative of an equivalence class of states of "nwa" NWA
-      // to the corresponding state in "out" NWA.
-      std::map<State, State> repKeyMap;  
+      // Map from each state of "nwa" NWA to the state of its equivalence class
+      // in "out" NWA.
+      std::map<State, State> stateMap;
 
       // For each equivalence class in the given partition...
       for (wali::util::DisjointSets<State>::const_iterator outer_iter = partition.begin(); 
@@ -45,40 +45,42 @@ namespace opennwa
 	// Set client info.
 	out.setClientInfo(resSt, resCI);
 
-	// Map the representative of the equivalence class in "nwa" to the new state in "out".
-	repKeyMap[ partition.representative( *(equivalenceClass.begin()) ) ] = resSt;
+	// Map the states of the equivalence class in "nwa" to the new state in "out".
+	for (std::set<State>::const_iterator it = equivalenceClass.begin(); it != equivalenceClass.end(); ++it) {
+	  stateMap[*it] = resSt;
+	}
       }
 
       // Add initial states
       for (StateIterator sit = nwa.beginInitialStates(); sit != nwa.endInitialStates(); sit++) { 
-	out.addInitialState( repKeyMap[ partition.representative(*sit) ] );
+	out.addInitialState( stateMap[ *sit ] );
       }
 
       // Add final states
       for (StateIterator sit = nwa.beginFinalStates(); sit != nwa.endFinalStates(); sit++) { 
-	out.addFinalState( repKeyMap[ partition.representative(*sit) ] );
+	out.addFinalState( stateMap[ *sit ] );
       }
 
       //Add internal transitions
       for (InternalIterator iit = nwa.beginInternalTrans(); iit != nwa.endInternalTrans(); iit++ ) { 
-	out.addInternalTrans( repKeyMap[ partition.representative( iit->first ) ], 
+	out.addInternalTrans( stateMap[ iit->first ], 
 			      iit->second, 
-			      repKeyMap[ partition.representative( iit->third) ] );
+			      stateMap[ iit->third ] );
       }
 
       //Add call transitions
       for (CallIterator cit = nwa.beginCallTrans(); cit != nwa.endCallTrans(); cit++) {   
-	out.addCallTrans( repKeyMap[ partition.representative( cit->first ) ], 
+	out.addCallTrans( stateMap[ cit->first ], 
 			  cit->second, 
-			  repKeyMap[ partition.representative( cit->third) ] );
+			  stateMap[ cit->third ] );
       }
 
       //Add return transitions
       for (ReturnIterator rit = nwa.beginReturnTrans(); rit != nwa.endReturnTrans(); rit++) {   
-	out.addReturnTrans( repKeyMap[ partition.representative( rit->first ) ], 
-			    repKeyMap[ partition.representative(rit->second) ], 
+	out.addReturnTrans( stateMap[ rit->first ], 
+			    stateMap[ rit->second ], 
 			    rit->third, 
-			    repKeyMap[ partition.representative( rit->fourth) ] );
+			    stateMap[ rit->fourth ] );
       }
 
       return;
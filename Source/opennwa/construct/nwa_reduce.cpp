@@ -0,0 +1,448 @@
+#include "opennwa/Nwa.hpp"
+#include "opennwa/construct/reduce.hpp"
+#include "opennwa/construct/quotient.hpp"
+#include "opennwa/RelationOpsBitset.hpp"
+
+#include "wali/util/details/PartitionRefinement.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace opennwa
+{
+  namespace construct
+  {
+    namespace
+    {
+      typedef details::CompactTransitionStorage::Index Index;
+      typedef wali::util::details::RefinementEdge RefinementEdge;
+      typedef wali::relations::BitMatrixRelation BitMatrixRelation;
+
+      enum TransKind { INTERNAL, CALL, RETURN };
+
+      /// A transition between dense state numbers. 'from' is the source,
+      /// call site, or exit, and 'pred' is the call predecessor of a
+      /// return (0 for the others).
+      struct Trans
+      {
+        Index kind;
+        Index from;
+        Index pred;
+        Index symbol;
+        Index to;
+
+        bool operator<(Trans const & other) const {
+          if (kind != other.kind) return kind < other.kind;
+          if (from != other.from) return from < other.from;
+          if (pred != other.pred) return pred < other.pred;
+          if (symbol != other.symbol) return symbol < other.symbol;
+          return to < other.to;
+        }
+
+        bool operator==(Trans const & other) const {
+          return !(*this < other) && !(other < *this);
+        }
+      };
+
+      enum MoveKind { INTERNAL_MOVE, CALL_MOVE, EXIT_MOVE, PRED_MOVE };
+
+      /// A transition seen as an edge of a labeled transition system. A
+      /// return transition (x, p, a, r) is two moves: one from the exit x
+      /// labeled (a, p), and one from the call predecessor p labeled
+      /// (a, x). 'other' is the p or x (0 for internals and calls).
+      struct Move
+      {
+        Index source;
+        Index kind;
+        Index symbol;
+        Index other;
+        Index target;
+
+        bool sameLabel(Move const & m) const {
+          return kind == m.kind && symbol == m.symbol && other == m.other;
+        }
+      };
+
+      struct ByLabelThenTarget
+      {
+        bool operator()(Move const & a, Move const & b) const {
+          if (a.kind != b.kind) return a.kind < b.kind;
+          if (a.symbol != b.symbol) return a.symbol < b.symbol;
+          if (a.other != b.other) return a.other < b.other;
+          if (a.target != b.target) return a.target < b.target;
+          return a.source < b.source;
+        }
+      };
+
+
+      /// An NWA with its states numbered densely
+      struct DenseNwa
+      {
+        Index numStates;
+        std::vector<bool> final;
+        std::vector<Trans> trans;    // sorted, without duplicates
+
+        /// The moves of the transitions
+        std::vector<Move> moves() const
+        {
+          std::vector<Move> result;
+          result.reserve(trans.size() + trans.size() / 2);
+          for (std::vector<Trans>::const_iterator t = trans.begin(); t != trans.end(); ++t) {
+            if (t->kind == RETURN) {
+              Move exit = { t->from, EXIT_MOVE, t->symbol, t->pred, t->to };
+              Move pred = { t->pred, PRED_MOVE, t->symbol, t->from, t->to };
+              result.push_back(exit);
+              result.push_back(pred);
+            }
+            else {
+              Move move = { t->from, t->kind == CALL ? CALL_MOVE : INTERNAL_MOVE, t->symbol, 0, t->to };
+              result.push_back(move);
+            }
+          }
+          return result;
+        }
+
+        /// The NWA whose states are the classes of this one's
+        DenseNwa quotient(std::vector<Index> const & classes, Index num_classes) const
+        {
+          DenseNwa result;
+          result.numStates = num_classes;
+          result.final.assign(num_classes, false);
+          for (Index q = 0; q < numStates; ++q) {
+            if (final[q]) {
+              result.final[classes[q]] = true;
+            }
+          }
+          result.trans.reserve(trans.size());
+          for (std::vector<Trans>::const_iterator t = trans.begin(); t != trans.end(); ++t) {
+            Trans merged = *t;
+            merged.from = classes[t->from];
+            merged.to = classes[t->to];
+            if (t->kind == RETURN) {
+              merged.pred = classes[t->pred];
+            }
+            result.trans.push_back(merged);
+          }
+          std::sort(result.trans.begin(), result.trans.end());
+          result.trans.erase(std::unique(result.trans.begin(), result.trans.end()),
+                             result.trans.end());
+          return result;
+        }
+      };
+
+
+      /// Numbers the states of 'nwa': first those on some transition, in
+      /// the order of its compact transitions, and then the others
+      DenseNwa
+      denseNwa(Nwa const & nwa, std::vector<State> & states)
+      {
+        details::CompactTransitionStorageRefPtr compact = nwa.getCompactTransitions();
+
+        states.clear();
+        states.reserve(nwa.sizeStates());
+        for (Index q = 0; q < compact->numStates(); ++q) {
+          states.push_back(compact->state(q));
+        }
+        for (Nwa::StateIterator it = nwa.beginStates(); it != nwa.endStates(); ++it) {
+          if (compact->stateIndex(*it) == details::CompactTransitionStorage::NONE) {
+            states.push_back(*it);
+          }
+        }
+
+        DenseNwa dense;
+        dense.numStates = static_cast<Index>(states.size());
+        dense.final.resize(states.size());
+        for (Index q = 0; q < dense.numStates; ++q) {
+          dense.final[q] = nwa.isFinalState(states[q]);
+        }
+
+        dense.trans.reserve(compact->size());
+        details::CompactTransitionStorage::Edges internals = compact->internals();
+        for (details::CompactTransitionStorage::Edges::const_iterator e = internals.begin(); e != internals.end(); ++e) {
+          Trans t = { INTERNAL, e->source, 0, e->symbol, e->target };
+          dense.trans.push_back(t);
+        }
+        details::CompactTransitionStorage::Edges calls = compact->calls();
+        for (details::CompactTransitionStorage::Edges::const_iterator e = calls.begin(); e != calls.end(); ++e) {
+          Trans t = { CALL, e->source, 0, e->symbol, e->target };
+          dense.trans.push_back(t);
+        }
+        details::CompactTransitionStorage::ReturnEdges returns = compact->returns();
+        for (details::CompactTransitionStorage::ReturnEdges::const_iterator e = returns.begin(); e != returns.end(); ++e) {
+          Trans t = { RETURN, e->exit, e->pred, e->symbol, e->returnSite };
+          dense.trans.push_back(t);
+        }
+        std::sort(dense.trans.begin(), dense.trans.end());
+        return dense;
+      }
+
+
+      /// The number of classes in a dense numbering of classes
+      Index
+      countClasses(std::vector<Index> const & classes)
+      {
+        Index count = 0;
+        for (std::vector<Index>::const_iterator c = classes.begin(); c != classes.end(); ++c) {
+          count = std::max(count, *c + 1);
+        }
+        return count;
+      }
+
+
+      /// The classes of bisimilar states of 'nwa', numbered densely
+      ///
+      /// Each distinct (label, target) of a move becomes a node of its own
+      /// between the source and the target, in a class of its label, so
+      /// that the stable partition of the unlabeled graph is the
+      /// bisimulation of the labeled one.
+      std::vector<Index>
+      bisimulationClasses(DenseNwa const & nwa)
+      {
+        std::vector<Move> moves = nwa.moves();
+        std::sort(moves.begin(), moves.end(), ByLabelThenTarget());
+
+        // Classes 0 and 1 are the non-final and final states
+        std::vector<Index> initial(nwa.numStates);
+        for (Index q = 0; q < nwa.numStates; ++q) {
+          initial[q] = nwa.final[q] ? 1 : 0;
+        }
+
+        std::vector<RefinementEdge> edges;
+        edges.reserve(2 * moves.size());
+        Index label = 1;
+        Index middle = 0;
+        for (size_t i = 0; i < moves.size(); ++i) {
+          bool new_label = (i == 0 || !moves[i].sameLabel(moves[i - 1]));
+          if (new_label) {
+            ++label;
+          }
+          if (new_label || moves[i].target != moves[i - 1].target) {
+            middle = static_cast<Index>(initial.size());
+            initial.push_back(label);
+            edges.push_back(RefinementEdge(middle, moves[i].target));
+          }
+          edges.push_back(RefinementEdge(moves[i].source, middle));
+        }
+
+        std::vector<Index> classes =
+          wali::util::details::coarsest_stable_partition(initial.size(), edges, initial);
+
+        // The states come first, and are never in a class with the other
+        // nodes, so their classes are numbered 0, 1, ...
+        classes.resize(nwa.numStates);
+        return classes;
+      }
+
+
+      /// A move with its label numbered densely
+      struct LabeledMove
+      {
+        Index source;
+        Index label;
+        Index target;
+
+        bool operator<(LabeledMove const & other) const {
+          if (source != other.source) return source < other.source;
+          if (label != other.label) return label < other.label;
+          return target < other.target;
+        }
+      };
+
+
+      /// The classes of states of 'nwa' that simulate each other,
+      /// numbered densely
+      ///
+      /// Starts from the relation "q is final if p is", and removes (p, q)
+      /// while p has a move to some t that q has no move with the same
+      /// label to match, to a state that simulates t. The relation is a
+      /// bit matrix, and a state's row is checked again whenever the row
+      /// of one of its successors loses a bit.
+      std::vector<Index>
+      simulationClasses(DenseNwa const & nwa)
+      {
+        Index const n = nwa.numStates;
+
+        std::vector<Move> moves = nwa.moves();
+        std::sort(moves.begin(), moves.end(), ByLabelThenTarget());
+        std::vector<LabeledMove> out(moves.size());
+        Index label = 0;
+        for (size_t i = 0; i < moves.size(); ++i) {
+          if (i > 0 && !moves[i].sameLabel(moves[i - 1])) {
+            ++label;
+          }
+          out[i].source = moves[i].source;
+          out[i].label = label;
+          out[i].target = moves[i].target;
+        }
+        std::sort(out.begin(), out.end());
+
+        // Moves and predecessors by state, in CSR form
+        std::vector<Index> out_begin(n + 1, 0);
+        std::vector<Index> pred_begin(n + 1, 0);
+        for (size_t i = 0; i < out.size(); ++i) {
+          out_begin[out[i].source + 1]++;
+          pred_begin[out[i].target + 1]++;
+        }
+        for (Index q = 0; q < n; ++q) {
+          out_begin[q + 1] += out_begin[q];
+          pred_begin[q + 1] += pred_begin[q];
+        }
+        std::vector<Index> preds(out.size());
+        {
+          std::vector<Index> next(pred_begin.begin(), pred_begin.end() - 1);
+          for (size_t i = 0; i < out.size(); ++i) {
+            preds[next[out[i].target]++] = out[i].source;
+          }
+        }
+
+        // sim.contains(p, q) when q simulates p
+        BitMatrixRelation sim(n);
+        for (Index p = 0; p < n; ++p) {
+          for (Index q = 0; q < n; ++q) {
+            if (!nwa.final[p] || nwa.final[q]) {
+              sim.insert(std::make_pair(p, q));
+            }
+          }
+        }
+
+        std::vector<Index> worklist;
+        std::vector<bool> queued(n, true);
+        for (Index p = n; p > 0; --p) {
+          worklist.push_back(p - 1);
+        }
+
+        while (!worklist.empty()) {
+          Index p = worklist.back();
+          worklist.pop_back();
+          queued[p] = false;
+
+          bool changed = false;
+          BitMatrixRelation::Word * row = sim.row(p);
+          for (Index m = out_begin[p]; m < out_begin[p + 1]; ++m) {
+            LabeledMove const & move = out[m];
+            for (size_t w = 0; w < sim.rowWords(); ++w) {
+              for (BitMatrixRelation::Word word = row[w]; word; word &= word - 1) {
+                size_t bit = BitMatrixRelation::lowestBit(word);
+                Index q = static_cast<Index>(w * BitMatrixRelation::WORD_BITS + bit);
+
+                // Does q have a move with the same label to a state that
+                // simulates move.target?
+                LabeledMove first = { q, move.label, 0 };
+                LabeledMove const * it = std::lower_bound(&out[0] + out_begin[q],
+                                                          &out[0] + out_begin[q + 1], first);
+                bool matched = false;
+                for (; it != &out[0] + out_begin[q + 1] && it->label == move.label; ++it) {
+                  if (sim.contains(move.target, it->target)) {
+                    matched = true;
+                    break;
+                  }
+                }
+                if (!matched) {
+                  row[w] &= ~(BitMatrixRelation::Word(1) << bit);
+                  changed = true;
+                }
+              }
+            }
+          }
+
+          if (changed) {
+            for (Index i = pred_begin[p]; i < pred_begin[p + 1]; ++i) {
+              if (!queued[preds[i]]) {
+                queued[preds[i]] = true;
+                worklist.push_back(preds[i]);
+              }
+            }
+          }
+        }
+
+        Index const NONE = ~0u;
+        std::vector<Index> classes(n, NONE);
+        Index num_classes = 0;
+        for (Index p = 0; p < n; ++p) {
+          if (classes[p] != NONE) {
+            continue;
+          }
+          classes[p] = num_classes;
+          for (Index q = p + 1; q < n; ++q) {
+            if (classes[q] == NONE && sim.contains(p, q) && sim.contains(q, p)) {
+              classes[q] = num_classes;
+            }
+          }
+          ++num_classes;
+        }
+        return classes;
+      }
+    }
+
+
+    wali::util::DisjointSets<State> reductionPartition( Nwa const & nwa, Reduction how )
+    {
+      std::vector<State> states;
+      DenseNwa dense = denseNwa(nwa, states);
+
+      // The class of each state of 'nwa' in 'dense', which is quotiented
+      // until merging call predecessors and exits (which label the moves
+      // of returns) allows no more merges
+      std::vector<Index> classes(states.size());
+      for (Index q = 0; q < classes.size(); ++q) {
+        classes[q] = q;
+      }
+
+      while (true) {
+        std::vector<Index> merged = bisimulationClasses(dense);
+        Index num_classes = countClasses(merged);
+        if (num_classes == dense.numStates) {
+          break;
+        }
+        for (Index q = 0; q < classes.size(); ++q) {
+          classes[q] = merged[classes[q]];
+        }
+        dense = dense.quotient(merged, num_classes);
+      }
+
+      if (how == ReduceBySimulation && dense.numStates <= SIMULATION_MAX_STATES) {
+        std::vector<Index> merged = simulationClasses(dense);
+        for (Index q = 0; q < classes.size(); ++q) {
+          classes[q] = merged[classes[q]];
+        }
+      }
+
+      // Merge each state with the first state of its class
+      wali::util::DisjointSets<State> partition;
+      std::vector<State> first(states.size(), wali::WALI_BAD_KEY);
+      for (Index q = 0; q < states.size(); ++q) {
+        partition.insert(states[q]);
+        if (first[classes[q]] == wali::WALI_BAD_KEY) {
+          first[classes[q]] = states[q];
+        }
+        else {
+          partition.merge_sets(first[classes[q]], states[q]);
+        }
+      }
+      return partition;
+    }
+
+
+    void reduce( Nwa & out, Nwa const & nwa, Reduction how )
+    {
+      quotient(out, nwa, reductionPartition(nwa, how));
+    }
+
+
+    NwaRefPtr reduce( Nwa const & nwa, Reduction how )
+    {
+      NwaRefPtr out(new Nwa());
+      reduce(*out, nwa, how);
+      return out;
+    }
+
+  } // end 'namespace construct'
+
+} // end 'namespace opennwa'
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,92 @@
+#ifndef WALI_NWA_CONSTRUCT_REDUCE_HPP
+#define WALI_NWA_CONSTRUCT_REDUCE_HPP
+
+#include "opennwa/NwaFwd.hpp"
+#include <wali/util/DisjointSets.hpp>
+
+namespace opennwa
+{
+  namespace construct
+  {
+
+    /// @brief Which states reduce merges
+    enum Reduction {
+      /// States that are forward bisimilar: both final or both not, and
+      /// each internal, call, and return transition of one is matched by
+      /// a transition of the other on the same symbol to a bisimilar
+      /// state. Return transitions are matched with the same call
+      /// predecessor (for an exit) or the same exit (for a call
+      /// predecessor), so copies of a procedure whose exits return only
+      /// to different copies of a call site are kept apart.
+      ReduceByBisimulation,
+
+      /// States that simulate each other, after merging bisimilar states.
+      /// This merges at least as much as ReduceByBisimulation, but takes
+      /// time and space quadratic in the number of states, so it is only
+      /// done if there are at most SIMULATION_MAX_STATES of them once
+      /// bisimilar states are merged.
+      ReduceBySimulation
+    };
+
+    /// The most states (after merging bisimilar ones) for which
+    /// ReduceBySimulation computes the simulation
+    const unsigned int SIMULATION_MAX_STATES = 4096;
+
+
+    /**
+     *
+     * @brief returns the classes of states of the given NWA that reduce merges
+     *
+     * Merging each class (with quotient) gives an NWA that accepts the same
+     * language. Bisimilar states are found with Paige-Tarjan partition
+     * refinement (wali::util::details::coarsest_stable_partition), in
+     * O(m log n) time for m transitions and n states, which is repeated
+     * until merging call predecessors and exits merges nothing more.
+     * Epsilon and wild transitions are matched only by transitions on the
+     * same symbol.
+     *
+     * @param - nwa: the NWA whose states to partition
+     * @param - how: which states to merge
+     * @return - a partition of all the states of the NWA
+     *
+     */
+    extern wali::util::DisjointSets<State> reductionPartition( Nwa const & nwa,
+                                                               Reduction how = ReduceByBisimulation );
+
+
+    /**
+     *
+     * @brief constructs an NWA that accepts the same language as the given NWA,
+     * with equivalent states merged
+     *
+     * @param - out: the reduced NWA
+     * @param - nwa: the NWA to reduce
+     * @param - how: which states to merge
+     *
+     */
+    extern void reduce( Nwa & out, Nwa const & nwa, Reduction how = ReduceByBisimulation );
+
+
+    /**
+     *
+     * @brief constructs an NWA that accepts the same language as the given NWA,
+     * with equivalent states merged
+     *
+     * @param - nwa: the NWA to reduce
+     * @param - how: which states to merge
+     * @return - the reduced NWA
+     *
+     */
+    extern NwaRefPtr reduce( Nwa const & nwa, Reduction how = ReduceByBisimulation );
+
+  }
+}
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif
@@ -0,0 +1,159 @@
+#include "opennwa/details/CompactTransitionStorage.hpp"
+#include "opennwa/details/TransitionStorage.hpp"
+
+#include <algorithm>
+
+namespace opennwa
+{
+  namespace details
+  {
+    typedef CompactTransitionStorage::Index Index;
+
+    const Index CompactTransitionStorage::NONE;
+
+    namespace
+    {
+      template< typename Key >
+      void sortUnique( std::vector<Key> & keys )
+      {
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+      }
+
+      template< typename Key >
+      Index find( std::vector<Key> const & keys, Key key )
+      {
+        typename std::vector<Key>::const_iterator it =
+          std::lower_bound(keys.begin(), keys.end(), key);
+        if( it == keys.end() || *it != key ) {
+          return CompactTransitionStorage::NONE;
+        }
+        return static_cast<Index>(it - keys.begin());
+      }
+
+      /// Fills 'offsets' (of size n+1) so that the edges whose 'field' is
+      /// s are counted between offsets[s] and offsets[s+1]. If 'positions'
+      /// is given, it gets the positions of those edges, in order.
+      template< typename E >
+      void buildIndex( std::vector<E> const & edges, Index E::* field, size_t n,
+                       std::vector<Index> & offsets, std::vector<Index> * positions )
+      {
+        offsets.assign(n + 1, 0);
+        for( size_t i = 0 ; i < edges.size() ; i++ ) {
+          offsets[edges[i].*field + 1]++;
+        }
+        for( size_t s = 0 ; s < n ; s++ ) {
+          offsets[s + 1] += offsets[s];
+        }
+        if( positions ) {
+          std::vector<Index> next(offsets.begin(), offsets.end() - 1);
+          positions->resize(edges.size());
+          for( size_t i = 0 ; i < edges.size() ; i++ ) {
+            (*positions)[next[edges[i].*field]++] = static_cast<Index>(i);
+          }
+        }
+      }
+
+      template< typename T >
+      size_t bytes( std::vector<T> const & v )
+      {
+        return v.capacity() * sizeof(T);
+      }
+    }
+
+
+    CompactTransitionStorage::CompactTransitionStorage( TransitionStorage const & trans )
+    {
+      typedef TransitionStorage Trans;
+
+      // Number the states and symbols
+      for( Trans::CallIterator it = trans.beginCall(); it != trans.endCall(); ++it ) {
+        states.push_back(Trans::getCallSite(*it));
+        states.push_back(Trans::getEntry(*it));
+        symbols.push_back(Trans::getCallSym(*it));
+      }
+      for( Trans::InternalIterator it = trans.beginInternal(); it != trans.endInternal(); ++it ) {
+        states.push_back(Trans::getSource(*it));
+        states.push_back(Trans::getTarget(*it));
+        symbols.push_back(Trans::getInternalSym(*it));
+      }
+      for( Trans::ReturnIterator it = trans.beginReturn(); it != trans.endReturn(); ++it ) {
+        states.push_back(Trans::getExit(*it));
+        states.push_back(Trans::getCallSite(*it));
+        states.push_back(Trans::getReturnSite(*it));
+        symbols.push_back(Trans::getReturnSym(*it));
+      }
+      sortUnique(states);
+      sortUnique(symbols);
+      std::vector<State>(states).swap(states);
+      std::vector<Symbol>(symbols).swap(symbols);
+
+      size_t n = states.size();
+
+      // The sets are ordered by source first, and the numbering keeps
+      // the order of the keys, so the arrays come out sorted by source.
+      internal_edges.reserve(trans.sizeInternal());
+      for( Trans::InternalIterator it = trans.beginInternal(); it != trans.endInternal(); ++it ) {
+        Edge e = { stateIndex(Trans::getSource(*it)),
+                   symbolIndex(Trans::getInternalSym(*it)),
+                   stateIndex(Trans::getTarget(*it)) };
+        internal_edges.push_back(e);
+      }
+      buildIndex(internal_edges, &Edge::source, n, internal_from, 0);
+      buildIndex(internal_edges, &Edge::target, n, internal_to, &internal_to_pos);
+
+      call_edges.reserve(trans.sizeCall());
+      for( Trans::CallIterator it = trans.beginCall(); it != trans.endCall(); ++it ) {
+        Edge e = { stateIndex(Trans::getCallSite(*it)),
+                   symbolIndex(Trans::getCallSym(*it)),
+                   stateIndex(Trans::getEntry(*it)) };
+        call_edges.push_back(e);
+      }
+      buildIndex(call_edges, &Edge::source, n, call_from, 0);
+      buildIndex(call_edges, &Edge::target, n, call_to, &call_to_pos);
+
+      return_edges.reserve(trans.sizeReturn());
+      for( Trans::ReturnIterator it = trans.beginReturn(); it != trans.endReturn(); ++it ) {
+        ReturnEdge e = { stateIndex(Trans::getExit(*it)),
+                         stateIndex(Trans::getCallSite(*it)),
+                         symbolIndex(Trans::getReturnSym(*it)),
+                         stateIndex(Trans::getReturnSite(*it)) };
+        return_edges.push_back(e);
+      }
+      buildIndex(return_edges, &ReturnEdge::exit, n, return_exit, 0);
+      buildIndex(return_edges, &ReturnEdge::pred, n, return_pred, &return_pred_pos);
+      buildIndex(return_edges, &ReturnEdge::returnSite, n, return_to, &return_to_pos);
+    }
+
+
+    Index CompactTransitionStorage::stateIndex( State st ) const
+    {
+      return find(states, st);
+    }
+
+    Index CompactTransitionStorage::symbolIndex( Symbol sym ) const
+    {
+      return find(symbols, sym);
+    }
+
+    size_t CompactTransitionStorage::memoryUsage() const
+    {
+      return sizeof(*this)
+        + bytes(states) + bytes(symbols)
+        + bytes(internal_edges) + bytes(internal_from)
+        + bytes(internal_to) + bytes(internal_to_pos)
+        + bytes(call_edges) + bytes(call_from)
+        + bytes(call_to) + bytes(call_to_pos)
+        + bytes(return_edges) + bytes(return_exit)
+        + bytes(return_pred) + bytes(return_pred_pos)
+        + bytes(return_to) + bytes(return_to_pos);
+    }
+
+  }
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,223 @@
+#ifndef wali_nwa_CompactTransitionStorage_GUARD
+#define wali_nwa_CompactTransitionStorage_GUARD 1
+
+#include "opennwa/NwaFwd.hpp"
+
+// ::wali
+#include "wali/Countable.hpp"
+
+// std::c++
+#include <vector>
+
+namespace opennwa
+{
+  namespace details
+  {
+    class TransitionStorage;
+
+    /**
+     *
+     * A read-only copy of the transitions in a TransitionStorage, laid out
+     * for fast traversal of large automata.
+     *
+     * The states and symbols that appear on some transition are numbered
+     * densely (in increasing order of their keys), and each kind of
+     * transition is stored once, in an array sorted by its source (call
+     * site for calls, exit for returns), in compressed sparse row (CSR)
+     * form: the transitions leaving state number 's' are those between
+     * offsets[s] and offsets[s+1]. The other indexes (by target, by entry,
+     * by call predecessor, and by return site) are CSR arrays of positions
+     * in those arrays.
+     *
+     * That takes 16 bytes per internal or call transition and 28 per
+     * return, against a few hundred for the std::sets and maps of
+     * TransitionStorage and TransitionInfo.
+     *
+     * Get one from Nwa::getCompactTransitions(), which builds it on first
+     * use and again after the transitions change, or by constructing one
+     * from a TransitionStorage.
+     *
+     */
+    class CompactTransitionStorage : public wali::Countable
+    {
+    public:
+      /// Dense number of a state or symbol
+      typedef unsigned int Index;
+
+      /// Returned by stateIndex() and symbolIndex() for a key that is on
+      /// no transition
+      static const Index NONE = ~0u;
+
+      /// An internal transition (source, symbol, target), or a call
+      /// transition (call site, symbol, entry)
+      struct Edge
+      {
+        Index source;
+        Index symbol;
+        Index target;
+      };
+
+      struct ReturnEdge
+      {
+        Index exit;
+        Index pred;
+        Index symbol;
+        Index returnSite;
+      };
+
+      /// A [begin, end) range of array elements
+      template< typename T >
+      class Range
+      {
+      public:
+        typedef T const * const_iterator;
+
+        Range( T const * b, T const * e ) : first(b), last(e) {}
+
+        const_iterator begin() const { return first; }
+        const_iterator end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        bool empty() const { return first == last; }
+
+      private:
+        T const * first;
+        T const * last;
+      };
+
+      typedef Range<Edge> Edges;
+      typedef Range<ReturnEdge> ReturnEdges;
+
+      /// Positions in the array of internals(), calls(), or returns()
+      typedef Range<Index> Positions;
+
+      explicit CompactTransitionStorage( TransitionStorage const & trans );
+
+      //
+      // Numbering
+      //
+
+      size_t numStates() const { return states.size(); }
+      size_t numSymbols() const { return symbols.size(); }
+
+      State state( Index i ) const { return states[i]; }
+      Symbol symbol( Index i ) const { return symbols[i]; }
+
+      /// The number of 'st', or NONE if no transition mentions it
+      Index stateIndex( State st ) const;
+
+      /// The number of 'sym', or NONE if no transition is labeled with it
+      Index symbolIndex( Symbol sym ) const;
+
+      //
+      // All transitions, sorted by source
+      //
+
+      Edges internals() const { return range(internal_edges, 0, internal_edges.size()); }
+      Edges calls() const { return range(call_edges, 0, call_edges.size()); }
+      ReturnEdges returns() const { return range(return_edges, 0, return_edges.size()); }
+
+      Edge const & internalAt( Index pos ) const { return internal_edges[pos]; }
+      Edge const & callAt( Index pos ) const { return call_edges[pos]; }
+      ReturnEdge const & returnAt( Index pos ) const { return return_edges[pos]; }
+
+      //
+      // Transitions by state. The argument is a state number, and must
+      // be less than numStates().
+      //
+
+      /// Internal transitions leaving 'source'
+      Edges internalsFrom( Index source ) const
+      {
+        return range(internal_edges, internal_from[source], internal_from[source + 1]);
+      }
+
+      /// Positions of the internal transitions entering 'target'
+      Positions internalsTo( Index target ) const
+      {
+        return range(internal_to_pos, internal_to[target], internal_to[target + 1]);
+      }
+
+      /// Call transitions leaving 'callSite'
+      Edges callsFrom( Index callSite ) const
+      {
+        return range(call_edges, call_from[callSite], call_from[callSite + 1]);
+      }
+
+      /// Positions of the call transitions entering 'entry'
+      Positions callsTo( Index entry ) const
+      {
+        return range(call_to_pos, call_to[entry], call_to[entry + 1]);
+      }
+
+      /// Return transitions leaving 'exit'
+      ReturnEdges returnsFromExit( Index exit ) const
+      {
+        return range(return_edges, return_exit[exit], return_exit[exit + 1]);
+      }
+
+      /// Positions of the return transitions whose call predecessor is 'pred'
+      Positions returnsFromPred( Index pred ) const
+      {
+        return range(return_pred_pos, return_pred[pred], return_pred[pred + 1]);
+      }
+
+      /// Positions of the return transitions entering 'returnSite'
+      Positions returnsTo( Index returnSite ) const
+      {
+        return range(return_to_pos, return_to[returnSite], return_to[returnSite + 1]);
+      }
+
+      //
+      // Sizes
+      //
+
+      size_t sizeInternal() const { return internal_edges.size(); }
+      size_t sizeCall() const { return call_edges.size(); }
+      size_t sizeReturn() const { return return_edges.size(); }
+      size_t size() const { return sizeInternal() + sizeCall() + sizeReturn(); }
+
+      /// Bytes used by this object and its arrays
+      size_t memoryUsage() const;
+
+    private:
+      template< typename T >
+      static Range<T> range( std::vector<T> const & v, size_t b, size_t e )
+      {
+        T const * base = v.empty() ? 0 : &v[0];
+        return Range<T>(base + b, base + e);
+      }
+
+      std::vector<State> states;
+      std::vector<Symbol> symbols;
+
+      std::vector<Edge> internal_edges;
+      std::vector<Index> internal_from;
+      std::vector<Index> internal_to;
+      std::vector<Index> internal_to_pos;
+
+      std::vector<Edge> call_edges;
+      std::vector<Index> call_from;
+      std::vector<Index> call_to;
+      std::vector<Index> call_to_pos;
+
+      std::vector<ReturnEdge> return_edges;
+      std::vector<Index> return_exit;
+      std::vector<Index> return_pred;
+      std::vector<Index> return_pred_pos;
+      std::vector<Index> return_to;
+      std::vector<Index> return_to_pos;
+    };
+
+    typedef ref_ptr<CompactTransitionStorage> CompactTransitionStorageRefPtr;
+
+  }
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+
+#endif
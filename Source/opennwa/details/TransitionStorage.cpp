@@ -6,6 +6,30 @@ namespace opennwa
 {
   namespace details
   {
+    namespace
+    {
+      /// Removes 'trans' from the set for 'key', and the set if it is
+      /// then empty
+      template< typename Map, typename Trans >
+      void eraseFromIndex( Map & index, Symbol key, Trans const & trans )
+      {
+        typename Map::iterator it = index.find(key);
+        if( it != index.end() ) {
+          it->second.erase(trans);
+          if( it->second.empty() ) {
+            index.erase(it);
+          }
+        }
+      }
+
+      template< typename Map >
+      typename Map::mapped_type const & lookupIndex( Map const & index, Symbol key,
+                                                     typename Map::mapped_type const & empty )
+      {
+        typename Map::const_iterator it = index.find(key);
+        return it == index.end() ? empty : it->second;
+      }
+    }
     
     //
     // Methods
@@ -24,6 +48,10 @@ namespace opennwa
       returnTrans = other.returnTrans;
       
       T_info = other.T_info;
+      symCalls = other.symCalls;
+      symInternals = other.symInternals;
+      symReturns = other.symReturns;
+      compact = other.compact;
       return *this;
     }
    
@@ -168,11 +196,10 @@ namespace opennwa
     TransitionStorage::States TransitionStorage::getReturnSites( State exit, State callSite ) const
     {
       States returns;
-      const Info::Returns & pred = T_info.predTrans(callSite);
-      for( Info::ReturnIterator it = pred.begin(); it != pred.end(); it++ )
+      std::pair<ReturnIterator, ReturnIterator> range = getTransExitPred(exit, callSite);
+      for( ReturnIterator it = range.first; it != range.second; it++ )
       {
-        if( getExit(*it) == exit )
-          returns.insert(getReturnSite(*it));
+        returns.insert(getReturnSite(*it));
       }
       return returns;
     }
@@ -401,6 +428,10 @@ namespace opennwa
       returnTrans.clear();
       
       T_info.clearMaps();
+      symCalls.clear();
+      symInternals.clear();
+      symReturns.clear();
+      changed();
     }
     
     /**
@@ -439,6 +470,82 @@ namespace opennwa
       return returnTrans;
     }
 
+    /**
+     *
+     * @brief get a compact, read-only copy of these transitions
+     *
+     * @return a compact copy of the transitions
+     *
+     */
+    CompactTransitionStorageRefPtr TransitionStorage::getCompact() const
+    {
+      if( compact == NULL ) {
+        compact = new CompactTransitionStorage(*this);
+      }
+      return compact;
+    }
+
+    /**
+     *
+     * @brief get the call transitions labeled with the given symbol
+     *
+     * @param - sym: the symbol of the desired transitions
+     * @return the call transitions labeled with 'sym'
+     *
+     */
+    const TransitionStorage::Calls & TransitionStorage::getCallsWithSym( Symbol sym ) const
+    {
+      return lookupIndex(symCalls, sym, Info::emptyCalls());
+    }
+
+    /**
+     *
+     * @brief get the internal transitions labeled with the given symbol
+     *
+     * @param - sym: the symbol of the desired transitions
+     * @return the internal transitions labeled with 'sym'
+     *
+     */
+    const TransitionStorage::Internals & TransitionStorage::getInternalsWithSym( Symbol sym ) const
+    {
+      return lookupIndex(symInternals, sym, Info::emptyInternals());
+    }
+
+    /**
+     *
+     * @brief get the return transitions labeled with the given symbol
+     *
+     * @param - sym: the symbol of the desired transitions
+     * @return the return transitions labeled with 'sym'
+     *
+     */
+    const TransitionStorage::Returns & TransitionStorage::getReturnsWithSym( Symbol sym ) const
+    {
+      return lookupIndex(symReturns, sym, Info::emptyReturns());
+    }
+
+    /**
+     *
+     * @brief get the return transitions with the given exit and call
+     *        predecessor
+     *
+     * @param - exit: the exit of the desired transitions
+     * @param - pred: the call predecessor of the desired transitions
+     * @return the [begin, end) range of the matching return transitions
+     *
+     */
+    std::pair<TransitionStorage::ReturnIterator, TransitionStorage::ReturnIterator>
+    TransitionStorage::getTransExitPred( State exit, State pred ) const
+    {
+      // Keys are unsigned, so 0 is the smallest symbol and return site
+      ReturnIterator first = returnTrans.lower_bound(Return(exit, pred, 0, 0));
+      ReturnIterator last = first;
+      while( last != returnTrans.end() && getExit(*last) == exit && getCallSite(*last) == pred ) {
+        ++last;
+      }
+      return std::make_pair(first, last);
+    }
+
     /**
      *
      * @brief add a call transition to the NWA
@@ -469,6 +576,8 @@ namespace opennwa
 
       if (added) {
         T_info.addCall(addTrans);
+        symCalls[getCallSym(addTrans)].insert(addTrans);
+        changed();
       }
 
       return added;
@@ -504,6 +613,8 @@ namespace opennwa
 
       if(added) {
         T_info.addIntra(addTrans);
+        symInternals[getInternalSym(addTrans)].insert(addTrans);
+        changed();
       }
 
       return added;
@@ -540,6 +651,8 @@ namespace opennwa
 
       if (added) {
         T_info.addRet(addTrans);
+        symReturns[getReturnSym(addTrans)].insert(addTrans);
+        changed();
       }
 
       return added;
@@ -609,6 +722,8 @@ namespace opennwa
       size_t erased = callTrans.erase(removeTrans);
       if (erased > 0) {
         T_info.removeCall(removeTrans);
+        eraseFromIndex(symCalls, getCallSym(removeTrans), removeTrans);
+        changed();
       }
 
       return erased > 0;
@@ -645,6 +760,8 @@ namespace opennwa
       size_t erased = internalTrans.erase(removeTrans);
       if (erased > 0) {
         T_info.removeIntra(removeTrans);
+        eraseFromIndex(symInternals, getInternalSym(removeTrans), removeTrans);
+        changed();
       }
 
       return erased > 0;
@@ -682,6 +799,8 @@ namespace opennwa
       size_t erased = returnTrans.erase(removeTrans);
       if (erased > 0) {
         T_info.removeRet(removeTrans);
+        eraseFromIndex(symReturns, getReturnSym(removeTrans), removeTrans);
+        changed();
       }
 
       return erased > 0;
@@ -1435,14 +1554,8 @@ namespace opennwa
      */
     bool TransitionStorage::removeCallTransSym( Symbol sym )
     {
-      Calls removeTrans;
-
       //Find transitions to remove.
-      for( CallIterator cit = callTrans.begin(); cit != callTrans.end(); cit++ )
-      {
-        if( getCallSym(*cit) == sym )
-          removeTrans.insert(*cit);
-      }
+      Calls removeTrans = getCallsWithSym(sym);
 
       //Remove transitions.
       for( CallIterator rit = removeTrans.begin(); rit != removeTrans.end(); rit++ )
@@ -1463,14 +1576,8 @@ namespace opennwa
      */
     bool TransitionStorage::removeInternalTransSym( Symbol sym )
     {
-      Internals removeTrans;
-
       //Find transitions to remove.
-      for( InternalIterator iit = internalTrans.begin(); iit != internalTrans.end(); iit++ )
-      {
-        if( getInternalSym(*iit) == sym )
-          removeTrans.insert(*iit);
-      }
+      Internals removeTrans = getInternalsWithSym(sym);
 
       //Remove transitions.
       for( InternalIterator rit = removeTrans.begin(); rit != removeTrans.end(); rit++ )
@@ -1491,14 +1598,8 @@ namespace opennwa
      */
     bool TransitionStorage::removeReturnTransSym( Symbol sym )
     {
-      Returns removeTrans;
-
       //Find transitions to remove.
-      for( ReturnIterator rit = returnTrans.begin(); rit != returnTrans.end(); rit++ )
-      {
-        if( getReturnSym(*rit) == sym )
-          removeTrans.insert(*rit);
-      }
+      Returns removeTrans = getReturnsWithSym(sym);
 
       //Remove transitions.
       for( ReturnIterator rit = removeTrans.begin(); rit != removeTrans.end(); rit++ )
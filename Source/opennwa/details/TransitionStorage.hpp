@@ -13,9 +13,11 @@
 #include "wali/KeyContainer.hpp"
 #include "opennwa/details/StateStorage.hpp"
 #include "opennwa/details/TransitionInfo.hpp"
+#include "opennwa/details/CompactTransitionStorage.hpp"
 
 // std::c++
 #include <iostream>
+#include <map>
 #include <set>
 #include <assert.h>
 
@@ -640,6 +642,69 @@ namespace opennwa
        *
        */
       const Returns & getReturns() const;
+
+      /**
+       *
+       * @brief get a compact, read-only copy of these transitions
+       *
+       * This method returns the transitions as a CompactTransitionStorage.
+       * It is built the first time it is asked for, and kept until the
+       * transitions change; a copy obtained earlier stays valid (and
+       * unchanged) after that.
+       *
+       * @return a compact copy of the transitions
+       *
+       */
+      CompactTransitionStorageRefPtr getCompact() const;
+
+      /**
+       *
+       * @brief get the call transitions labeled with the given symbol
+       *
+       * This method provides access to the call transitions labeled with
+       * 'sym', without looking at any others.
+       *
+       * @param - sym: the symbol of the desired transitions
+       * @return the call transitions labeled with 'sym'
+       *
+       */
+      const Calls & getCallsWithSym( Symbol sym ) const;
+
+      /**
+       *
+       * @brief get the internal transitions labeled with the given symbol
+       *
+       * @param - sym: the symbol of the desired transitions
+       * @return the internal transitions labeled with 'sym'
+       *
+       */
+      const Internals & getInternalsWithSym( Symbol sym ) const;
+
+      /**
+       *
+       * @brief get the return transitions labeled with the given symbol
+       *
+       * @param - sym: the symbol of the desired transitions
+       * @return the return transitions labeled with 'sym'
+       *
+       */
+      const Returns & getReturnsWithSym( Symbol sym ) const;
+
+      /**
+       *
+       * @brief get the return transitions with the given exit and call
+       *        predecessor
+       *
+       * The return transitions are ordered by exit and then by call
+       * predecessor, so those for one (exit, call predecessor) pair form
+       * a contiguous range, which this method finds in logarithmic time.
+       *
+       * @param - exit: the exit of the desired transitions
+       * @param - pred: the call predecessor of the desired transitions
+       * @return the [begin, end) range of the matching return transitions
+       *
+       */
+      std::pair<ReturnIterator, ReturnIterator> getTransExitPred( State exit, State pred ) const;
       
       /**
        *
@@ -1556,6 +1621,18 @@ namespace opennwa
       Returns returnTrans;
         
       Info T_info;
+
+      // Transitions by symbol. (The returns are already ordered by exit
+      // and call predecessor, so that pair needs no index.)
+      std::map<Symbol,Calls> symCalls;
+      std::map<Symbol,Internals> symInternals;
+      std::map<Symbol,Returns> symReturns;
+
+    private:
+      /// Drops the compact copy after the transitions change
+      void changed( ) { compact = NULL; }
+
+      mutable CompactTransitionStorageRefPtr compact;
     };
 
 
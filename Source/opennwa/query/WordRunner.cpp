@@ -0,0 +1,283 @@
+#include "opennwa/Nwa.hpp"
+#include "opennwa/query/WordRunner.hpp"
+
+#include <algorithm>
+
+namespace opennwa {
+  namespace query {
+
+    const WordRunner::Index WordRunner::BOTTOM;
+
+
+    WordRunner::WordRunner(Nwa const & nwa)
+      : trans(nwa.getCompactTransitions())
+      , epsilon(trans->symbolIndex(EPSILON))
+      , initialFinal(false)
+      , atStart(true)
+    {
+      size_t n = trans->numStates();
+      initial.resize(n, false);
+      final.resize(n, false);
+
+      for (Nwa::StateIterator st = nwa.beginFinalStates(); st != nwa.endFinalStates(); ++st) {
+        Index i = trans->stateIndex(*st);
+        if (i != Transitions::NONE) {
+          final[i] = true;
+        }
+      }
+      for (Nwa::StateIterator st = nwa.beginInitialStates(); st != nwa.endInitialStates(); ++st) {
+        Index i = trans->stateIndex(*st);
+        if (i != Transitions::NONE) {
+          initial[i] = true;
+        }
+        else if (nwa.isFinalState(*st)) {
+          initialFinal = true;
+        }
+      }
+
+      // Epsilon closures are computed as the states are reached
+      if (epsilon != Transitions::NONE) {
+        closure.resize(n);
+        closed.resize(n, false);
+        seen.resize(n, Transitions::NONE);
+      }
+
+      reset();
+    }
+
+
+    void
+    WordRunner::reset()
+    {
+      next.clear();
+      for (Index q = 0; q < initial.size(); ++q) {
+        if (initial[q]) {
+          next.push_back(Config(q, BOTTOM));
+        }
+      }
+      advance();
+      atStart = true;
+    }
+
+
+    void
+    WordRunner::feedInternal(Symbol sym)
+    {
+      next.clear();
+      Index s = trans->symbolIndex(sym);
+      if (s != Transitions::NONE) {
+        for (std::vector<Config>::const_iterator c = configs.begin(); c != configs.end(); ++c) {
+          Transitions::Edges out = trans->internalsFrom(c->state);
+          for (Transitions::Edges::const_iterator it = out.begin(); it != out.end(); ++it) {
+            if (it->symbol == s) {
+              next.push_back(Config(it->target, c->stack));
+            }
+          }
+        }
+      }
+      advance();
+    }
+
+
+    void
+    WordRunner::feedCall(Symbol sym)
+    {
+      next.clear();
+      Index s = trans->symbolIndex(sym);
+      if (s != Transitions::NONE) {
+        for (std::vector<Config>::const_iterator c = configs.begin(); c != configs.end(); ++c) {
+          Transitions::Edges out = trans->callsFrom(c->state);
+          for (Transitions::Edges::const_iterator it = out.begin(); it != out.end(); ++it) {
+            if (it->symbol == s) {
+              next.push_back(Config(it->target, push(c->state, c->stack)));
+            }
+          }
+        }
+      }
+      advance();
+    }
+
+
+    void
+    WordRunner::feedReturn(Symbol sym)
+    {
+      next.clear();
+      Index s = trans->symbolIndex(sym);
+      if (s != Transitions::NONE) {
+        for (std::vector<Config>::const_iterator c = configs.begin(); c != configs.end(); ++c) {
+          Transitions::ReturnEdges out = trans->returnsFromExit(c->state);
+          for (Transitions::ReturnEdges::const_iterator it = out.begin(); it != out.end(); ++it) {
+            if (it->symbol != s) {
+              continue;
+            }
+            // With an empty stack, the return is pending, and its call
+            // predecessor can be any initial state
+            if (c->stack == BOTTOM) {
+              if (initial[it->pred]) {
+                next.push_back(Config(it->returnSite, BOTTOM));
+              }
+            }
+            else if (nodes[c->stack].pred == it->pred) {
+              next.push_back(Config(it->returnSite, nodes[c->stack].below));
+            }
+          }
+        }
+      }
+      advance();
+    }
+
+
+    void
+    WordRunner::feed(NestedWord const & word)
+    {
+      for (NestedWord::const_iterator pos = word.begin(); pos != word.end(); ++pos) {
+        switch (pos->type) {
+          case NestedWord::Position::InternalType:
+            feedInternal(pos->symbol);
+            break;
+          case NestedWord::Position::CallType:
+            feedCall(pos->symbol);
+            break;
+          case NestedWord::Position::ReturnType:
+            feedReturn(pos->symbol);
+            break;
+        }
+      }
+    }
+
+
+    bool
+    WordRunner::accepting() const
+    {
+      if (atStart && initialFinal) {
+        return true;
+      }
+      for (std::vector<Config>::const_iterator c = configs.begin(); c != configs.end(); ++c) {
+        if (final[c->state]) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+
+    /// Closes 'next' under epsilon moves and makes it the current set of
+    /// configurations
+    void
+    WordRunner::advance()
+    {
+      size_t stepped = next.size();
+      for (size_t i = 0; i < stepped; ++i) {
+        std::vector<Index> const & reach = closureOf(next[i].state);
+        for (size_t j = 1; j < reach.size(); ++j) {
+          next.push_back(Config(reach[j], next[i].stack));
+        }
+      }
+      std::sort(next.begin(), next.end());
+      next.erase(std::unique(next.begin(), next.end()), next.end());
+
+      for (std::vector<Config>::const_iterator c = next.begin(); c != next.end(); ++c) {
+        retain(c->stack);
+      }
+      for (std::vector<Config>::const_iterator c = configs.begin(); c != configs.end(); ++c) {
+        release(c->stack);
+      }
+      configs.swap(next);
+      atStart = false;
+    }
+
+
+    /// The states q reaches by epsilon moves, q first, or nothing if it
+    /// has none. Each state's closure is computed the first time the
+    /// state is reached, so a run only pays for the states it visits.
+    std::vector<WordRunner::Index> const &
+    WordRunner::closureOf(Index q)
+    {
+      static std::vector<Index> const none;
+      if (epsilon == Transitions::NONE) {
+        return none;
+      }
+      std::vector<Index> & reach = closure[q];
+      if (closed[q]) {
+        return reach;
+      }
+      closed[q] = true;
+
+      reach.push_back(q);
+      seen[q] = q;
+      for (size_t i = 0; i < reach.size(); ++i) {
+        Transitions::Edges out = trans->internalsFrom(reach[i]);
+        for (Transitions::Edges::const_iterator it = out.begin(); it != out.end(); ++it) {
+          if (it->symbol == epsilon && seen[it->target] != q) {
+            seen[it->target] = q;
+            reach.push_back(it->target);
+          }
+        }
+      }
+      if (reach.size() == 1) {
+        reach.clear();
+      }
+      return reach;
+    }
+
+
+    /// The stack with 'pred' on top of 'below'. A new node has no
+    /// references of its own until a configuration retains it.
+    WordRunner::Index
+    WordRunner::push(Index pred, Index below)
+    {
+      wali::KeyPair key(pred, below);
+      NodeIdMap::const_iterator found = nodeIds.find(key);
+      if (found != nodeIds.end()) {
+        return found->second;
+      }
+
+      Index id;
+      if (freeNodes.empty()) {
+        id = static_cast<Index>(nodes.size());
+        nodes.push_back(StackNode());
+      }
+      else {
+        id = freeNodes.back();
+        freeNodes.pop_back();
+      }
+      StackNode & node = nodes[id];
+      node.pred = pred;
+      node.below = below;
+      node.refs = 0;
+      retain(below);
+      nodeIds.insert(key, id);
+      return id;
+    }
+
+
+    void
+    WordRunner::retain(Index node)
+    {
+      if (node != BOTTOM) {
+        ++nodes[node].refs;
+      }
+    }
+
+
+    /// Drops a reference to 'node', reclaiming it (and the nodes below it
+    /// that nothing else uses) when none are left
+    void
+    WordRunner::release(Index node)
+    {
+      while (node != BOTTOM && --nodes[node].refs == 0) {
+        nodeIds.erase(wali::KeyPair(nodes[node].pred, nodes[node].below));
+        freeNodes.push_back(node);
+        node = nodes[node].below;
+      }
+    }
+
+  }
+}
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,133 @@
+#ifndef wali_nwa_query_WORD_RUNNER_HPP
+#define wali_nwa_query_WORD_RUNNER_HPP
+
+#include "opennwa/NwaFwd.hpp"
+#include "opennwa/NestedWord.hpp"
+#include "opennwa/details/CompactTransitionStorage.hpp"
+
+#include "wali/KeyContainer.hpp"
+#include "wali/OpenHashMap.hpp"
+
+#include <vector>
+
+namespace opennwa
+{
+  namespace query
+  {
+
+    /**
+     *
+     * Runs an NWA on a nested word one position at a time, for words too
+     * long to build as a NestedWord first (e.g. call/return traces read
+     * from a log). After each feed, accepting() tells whether the word
+     * read so far is in the language, with the same answer as
+     * languageContains (Nwa::isMemberNondet) would give.
+     *
+     * The runner keeps the set of configurations the NWA can be in. The
+     * stacks of call predecessors share their common suffixes: a stack
+     * is a node holding its top and a link to the stack below, and equal
+     * stacks are the same node (hash-consing, through a hash table keyed
+     * on the top and the node below), so a call, a return, or a
+     * comparison of two configurations takes expected constant time
+     * however deep the stack is. Nodes no configuration uses any more
+     * are reclaimed.
+     *
+     * A transition is taken only on its own symbol, as in isMemberNondet.
+     * The NWA must not change while the runner is in use.
+     *
+     */
+    class WordRunner
+    {
+    public:
+      explicit WordRunner(Nwa const & nwa);
+
+      /// Goes back to the start of the word
+      void reset();
+
+      void feedInternal(Symbol sym);
+      void feedCall(Symbol sym);
+      void feedReturn(Symbol sym);
+
+      /// Feeds each position of 'word' in turn
+      void feed(NestedWord const & word);
+
+      /// Whether the NWA accepts the word fed so far
+      bool accepting() const;
+
+      /// Whether the NWA has no run on the word fed so far, so that no
+      /// longer word will be accepted either
+      bool stuck() const { return configs.empty() && !atStart; }
+
+      /// The number of (state, stack) configurations the NWA can be in
+      size_t numConfigurations() const { return configs.size(); }
+
+      /// The number of distinct stack nodes in use
+      size_t numStackNodes() const { return nodeIds.size(); }
+
+    private:
+      typedef opennwa::details::CompactTransitionStorage Transitions;
+      typedef Transitions::Index Index;
+
+      /// The empty stack
+      static const Index BOTTOM = ~0u;
+
+      struct StackNode
+      {
+        Index pred;       // the call predecessor on top
+        Index below;
+        size_t refs;      // configurations and nodes directly above
+      };
+
+      struct Config
+      {
+        Config(Index s, Index st) : state(s), stack(st) {}
+
+        bool operator<(Config const & other) const
+        {
+          return state < other.state || (state == other.state && stack < other.stack);
+        }
+
+        bool operator==(Config const & other) const
+        {
+          return state == other.state && stack == other.stack;
+        }
+
+        Index state;
+        Index stack;
+      };
+
+      Index push(Index pred, Index below);
+      void retain(Index node);
+      void release(Index node);
+      void advance();
+      std::vector<Index> const & closureOf(Index q);
+
+      opennwa::details::CompactTransitionStorageRefPtr trans;
+      std::vector<bool> initial;
+      std::vector<bool> final;
+      std::vector<std::vector<Index> > closure;   // by state, if it has epsilon moves
+      std::vector<bool> closed;                   // by state, whether closure is computed
+      std::vector<Index> seen;                    // scratch for closureOf
+      Index epsilon;                              // EPSILON's number, or NONE
+      bool initialFinal;                          // some initial state that has no transitions is final
+
+      std::vector<Config> configs;
+      std::vector<Config> next;
+      bool atStart;
+
+      std::vector<StackNode> nodes;
+      std::vector<Index> freeNodes;
+      typedef wali::HotHashMap<wali::KeyPair, Index>::type NodeIdMap;
+      NodeIdMap nodeIds;                          // (pred, below) -> node
+    };
+
+  }
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif
@@ -35,12 +35,11 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Calls & call = trans.getCalls();
+      const Calls & call = trans.getCallsWithSym(symbol);
       StateSet calls;
       for( CallIterator it = call.begin(); it != call.end(); it++ )
       {
-        if( symbol == Trans::getCallSym(*it) )
-          calls.insert( Trans::getCallSite(*it) );
+        calls.insert( Trans::getCallSite(*it) );
       }
       return calls;
     }
@@ -238,12 +237,11 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Calls & ent = trans.getCalls();
+      const Calls & ent = trans.getCallsWithSym(symbol);
       StateSet entries;
       for( CallIterator it = ent.begin(); it != ent.end(); it++ )
       {
-        if( symbol == Trans::getCallSym(*it) )
-          entries.insert( Trans::getEntry(*it) );
+        entries.insert( Trans::getEntry(*it) );
       }
       return entries;
     }
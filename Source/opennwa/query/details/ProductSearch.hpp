@@ -0,0 +1,504 @@
+#ifndef wali_nwa_query_details_PRODUCT_SEARCH_HPP
+#define wali_nwa_query_details_PRODUCT_SEARCH_HPP
+
+#include "opennwa/Nwa.hpp"
+#include "opennwa/NestedWord.hpp"
+
+#include <deque>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace opennwa
+{
+  namespace query
+  {
+    namespace details
+    {
+
+      /// Whether a transition on 'trans_sym' can read 'sym'
+      inline bool
+      symbolMatches(Symbol trans_sym, Symbol sym)
+      {
+        return trans_sym == sym || trans_sym == WILD;
+      }
+
+      /// The symbols of either NWA, except EPSILON and WILD, in order
+      inline std::vector<Symbol>
+      concreteSymbols(Nwa const & first, Nwa const & second)
+      {
+        std::set<Symbol> symbols(first.beginSymbols(), first.endSymbols());
+        symbols.insert(second.beginSymbols(), second.endSymbols());
+        symbols.erase(EPSILON);
+        symbols.erase(WILD);
+        return std::vector<Symbol>(symbols.begin(), symbols.end());
+      }
+
+
+      /**
+       *
+       * A search for a nested word that takes the product of an NWA (the
+       * "left" one) with some other automaton (the "right" one) to a
+       * target state, building the product only as it is reached and
+       * stopping at the first target.
+       *
+       * The search computes summaries, as the NWA-to-WPDS conversions and
+       * poststar do: the product states reached inside a call are kept in
+       * a context for the entry state the call reached, and each exit state
+       * of a context is matched with each call site into it, whichever of
+       * the two is found first. Pending returns (from the outermost
+       * context) may use any initial state of the left NWA as the call
+       * predecessor, as in languageContains and languageIsEmpty.
+       *
+       * Epsilon internal transitions of the left NWA move only its
+       * component. A WILD transition of the left NWA reads each symbol of
+       * 'alphabet'.
+       *
+       * A target must be final in the left NWA, so product states whose
+       * left state cannot reach a final state at all (following every
+       * transition, as if calls and returns were internals) are not built.
+       *
+       * 'Right' supplies the other component of a product state:
+       *
+       *   typedef ... Value;     // less-than comparable
+       *   static const bool pruneSubsumed;
+       *   void initial(std::vector<Value> & out);
+       *   void epsilon(Value const & v, std::vector<Value> & out);
+       *   void internal(Value const & v, Symbol sym, std::vector<Value> & out);
+       *   void call(Value const & v, Symbol sym, std::vector<Value> & out);
+       *   void matchedReturn(Value const & exit, Value const & call, Symbol sym,
+       *                      std::vector<Value> & out);
+       *   void pendingReturn(Value const & exit, Symbol sym, std::vector<Value> & out);
+       *   bool isTarget(bool leftFinal, Value const & v);  // false unless leftFinal
+       *   bool subsumes(Value const & a, Value const & b);
+       *
+       * Each of the step functions appends the values the right automaton
+       * can move to. If pruneSubsumed is true, a product state is dropped
+       * when another one in its context with the same left state has a
+       * value that subsumes it (and the ones it subsumes are dropped),
+       * which is only sound if every step is monotone with respect to
+       * subsumes() and isTarget() is downward closed. Otherwise product
+       * states are just not visited twice.
+       *
+       */
+      template<typename Right>
+      class ProductSearch
+      {
+      public:
+        typedef typename Right::Value Value;
+
+        ProductSearch(Nwa const & left, Right & right, std::vector<Symbol> const & alphabet)
+          : left(left)
+          , right(right)
+          , alphabet(alphabet)
+          , found(0)
+        {
+          for (Nwa::InternalIterator it = left.beginInternalTrans(); it != left.endInternalTrans(); ++it) {
+            internalsFrom[it->first].push_back(Out(it->second, it->third));
+          }
+          for (Nwa::CallIterator it = left.beginCallTrans(); it != left.endCallTrans(); ++it) {
+            callsFrom[it->first].push_back(Out(it->second, it->third));
+          }
+          for (Nwa::ReturnIterator it = left.beginReturnTrans(); it != left.endReturnTrans(); ++it) {
+            returnsFrom[it->first][it->second].push_back(Out(it->third, it->fourth));
+            exitsOf[it->second].insert(it->first);
+          }
+          findUseful();
+        }
+
+        /// Returns a word that leads from an initial product state to a
+        /// target, or NULL if there is none
+        NestedWordRefPtr run()
+        {
+          contexts.push_back(Context(0, EPSILON));
+
+          std::vector<Value> starts;
+          right.initial(starts);
+          for (Nwa::StateIterator st = left.beginInitialStates(); st != left.endInitialStates(); ++st) {
+            for (size_t i = 0; i < starts.size(); ++i) {
+              if (add(Node(0, *st, starts[i], START, 0, 0, EPSILON, EPSILON))) {
+                return word();
+              }
+            }
+          }
+
+          while (!worklist.empty()) {
+            size_t n = worklist.front();
+            worklist.pop_front();
+            if (nodes[n].live && process(n)) {
+              return word();
+            }
+          }
+          return NULL;
+        }
+
+        /// The number of product states built
+        size_t numProductStates() const { return nodes.size(); }
+
+        /// The number of calling contexts, counting the outermost one
+        size_t numContexts() const { return contexts.size(); }
+
+      private:
+        /// How a product state was first reached
+        enum How { START, INTERNAL, EPSILON_MOVE, MATCHED_RETURN, PENDING_RETURN };
+
+        struct Node
+        {
+          Node(size_t c, State s, Value const & v, How h, size_t p, size_t o,
+               Symbol sym, Symbol call_sym)
+            : context(c), state(s), value(v), how(h), parent(p), other(o)
+            , symbol(sym), callSymbol(call_sym), live(true)
+          {}
+
+          size_t context;
+          State state;
+          Value value;
+          How how;
+          size_t parent;      // the node this one steps from (the call site, for MATCHED_RETURN)
+          size_t other;       // the exit node, for MATCHED_RETURN
+          Symbol symbol;
+          Symbol callSymbol;  // for MATCHED_RETURN
+          bool live;          // false once a node that subsumes it is added
+        };
+
+        typedef std::pair<size_t, Symbol> CallSite;
+
+        /// The product states reached inside calls to one product entry
+        /// state. Context 0 is the outermost one.
+        struct Context
+        {
+          Context(size_t c, Symbol sym) : caller(c), callSymbol(sym) {}
+
+          size_t caller;                  // the first call site that reached it
+          Symbol callSymbol;
+          std::map<State, std::vector<CallSite> > callSites;  // by state
+          std::map<State, std::vector<size_t> > exits;        // processed nodes, by state
+          std::map<State, std::vector<size_t> > antichain;
+          std::set<std::pair<State, Value> > seen;
+        };
+
+        typedef std::map<std::pair<State, Value>, size_t> ContextMap;
+
+        typedef std::pair<Symbol, State> Out;
+        typedef std::vector<Out> Outs;
+        typedef std::map<State, Outs> OutMap;
+        typedef std::map<State, OutMap> ReturnMap;   // exit -> call predecessor -> outs
+
+        static Outs const & outgoing(OutMap const & outs, State state)
+        {
+          static Outs const none;
+          typename OutMap::const_iterator found = outs.find(state);
+          return found == outs.end() ? none : found->second;
+        }
+
+        /// The symbols a transition of the left NWA on 'sym' can read
+        std::vector<Symbol> concrete(Symbol sym) const
+        {
+          if (sym == WILD) {
+            return alphabet;
+          }
+          return std::vector<Symbol>(1, sym);
+        }
+
+        /// Finds the states of the left NWA that can reach a final state
+        void findUseful()
+        {
+          std::map<State, std::vector<State> > preds;
+          for (Nwa::InternalIterator it = left.beginInternalTrans(); it != left.endInternalTrans(); ++it) {
+            preds[it->third].push_back(it->first);
+          }
+          for (Nwa::CallIterator it = left.beginCallTrans(); it != left.endCallTrans(); ++it) {
+            preds[it->third].push_back(it->first);
+          }
+          for (Nwa::ReturnIterator it = left.beginReturnTrans(); it != left.endReturnTrans(); ++it) {
+            preds[it->fourth].push_back(it->first);
+          }
+
+          std::vector<State> todo(left.beginFinalStates(), left.endFinalStates());
+          useful.insert(todo.begin(), todo.end());
+          while (!todo.empty()) {
+            State st = todo.back();
+            todo.pop_back();
+            std::map<State, std::vector<State> >::const_iterator from = preds.find(st);
+            if (from == preds.end()) {
+              continue;
+            }
+            for (size_t i = 0; i < from->second.size(); ++i) {
+              if (useful.insert(from->second[i]).second) {
+                todo.push_back(from->second[i]);
+              }
+            }
+          }
+        }
+
+        /// Adds 'node' unless it was seen (or is subsumed) already, or
+        /// cannot lead to a target. Returns true if the node is a target.
+        bool add(Node const & node)
+        {
+          if (useful.count(node.state) == 0) {
+            return false;
+          }
+          Context & context = contexts[node.context];
+          if (Right::pruneSubsumed) {
+            std::vector<size_t> & same = context.antichain[node.state];
+            for (size_t i = 0; i < same.size(); ++i) {
+              if (right.subsumes(nodes[same[i]].value, node.value)) {
+                return false;
+              }
+            }
+            size_t kept = 0;
+            for (size_t i = 0; i < same.size(); ++i) {
+              if (right.subsumes(node.value, nodes[same[i]].value)) {
+                nodes[same[i]].live = false;
+              }
+              else {
+                same[kept++] = same[i];
+              }
+            }
+            same.resize(kept);
+            same.push_back(nodes.size());
+          }
+          else if (!context.seen.insert(std::make_pair(node.state, node.value)).second) {
+            return false;
+          }
+
+          size_t n = nodes.size();
+          nodes.push_back(node);
+          worklist.push_back(n);
+
+          if (right.isTarget(left.isFinalState(node.state), node.value)) {
+            found = n;
+            return true;
+          }
+          return false;
+        }
+
+        bool process(size_t n)
+        {
+          // Copy what we need: 'nodes' grows as we go
+          size_t context = nodes[n].context;
+          State state = nodes[n].state;
+          Value value = nodes[n].value;
+          std::vector<Value> next;
+
+          right.epsilon(value, next);
+          for (size_t j = 0; j < next.size(); ++j) {
+            if (add(Node(context, state, next[j], EPSILON_MOVE, n, 0, EPSILON, EPSILON))) {
+              return true;
+            }
+          }
+
+          Outs const & ints = outgoing(internalsFrom, state);
+          for (typename Outs::const_iterator it = ints.begin(); it != ints.end(); ++it) {
+            if (it->first == EPSILON) {
+              if (add(Node(context, it->second, value, EPSILON_MOVE, n, 0, EPSILON, EPSILON))) {
+                return true;
+              }
+              continue;
+            }
+            std::vector<Symbol> syms = concrete(it->first);
+            for (size_t i = 0; i < syms.size(); ++i) {
+              next.clear();
+              right.internal(value, syms[i], next);
+              for (size_t j = 0; j < next.size(); ++j) {
+                if (add(Node(context, it->second, next[j], INTERNAL, n, 0, syms[i], EPSILON))) {
+                  return true;
+                }
+              }
+            }
+          }
+
+          Outs const & calls = outgoing(callsFrom, state);
+          for (typename Outs::const_iterator it = calls.begin(); it != calls.end(); ++it) {
+            std::vector<Symbol> syms = concrete(it->first);
+            for (size_t i = 0; i < syms.size(); ++i) {
+              next.clear();
+              right.call(value, syms[i], next);
+              for (size_t j = 0; j < next.size(); ++j) {
+                if (call(CallSite(n, syms[i]), it->second, next[j])) {
+                  return true;
+                }
+              }
+            }
+          }
+
+          typename ReturnMap::const_iterator rets = returnsFrom.find(state);
+          if (rets == returnsFrom.end()) {
+            return false;
+          }
+          if (context != 0) {
+            contexts[context].exits[state].push_back(n);
+          }
+          for (typename OutMap::const_iterator it = rets->second.begin(); it != rets->second.end(); ++it) {
+            if (context == 0) {
+              if (left.isInitialState(it->first)
+                  && returns(n, it->second, CallSite(0, EPSILON), PENDING_RETURN))
+              {
+                return true;
+              }
+              continue;
+            }
+            typename std::map<State, std::vector<CallSite> >::const_iterator found_sites =
+              contexts[context].callSites.find(it->first);
+            if (found_sites == contexts[context].callSites.end()) {
+              continue;
+            }
+            // returns() adds nodes, but neither call sites nor contexts
+            std::vector<CallSite> const & sites = found_sites->second;
+            for (size_t i = 0; i < sites.size(); ++i) {
+              if (nodes[sites[i].first].live && returns(n, it->second, sites[i], MATCHED_RETURN)) {
+                return true;
+              }
+            }
+          }
+          return false;
+        }
+
+        /// The call site 'site' reaches product state (entry, value)
+        bool call(CallSite site, State entry, Value const & value)
+        {
+          std::pair<State, Value> key(entry, value);
+          typename ContextMap::iterator found = contextIds.find(key);
+          State pred = nodes[site.first].state;
+          if (found == contextIds.end()) {
+            size_t c = contexts.size();
+            contextIds[key] = c;
+            contexts.push_back(Context(site.first, site.second));
+            contexts[c].callSites[pred].push_back(site);
+            return add(Node(c, entry, value, START, 0, 0, EPSILON, EPSILON));
+          }
+
+          // Match the new call site with the exits that have a return
+          // transition back to it
+          size_t c = found->second;
+          contexts[c].callSites[pred].push_back(site);
+          typename std::map<State, std::set<State> >::const_iterator exit_states = exitsOf.find(pred);
+          if (exit_states == exitsOf.end()) {
+            return false;
+          }
+          std::set<State>::const_iterator ex = exit_states->second.begin();
+          for (; ex != exit_states->second.end(); ++ex) {
+            typename std::map<State, std::vector<size_t> >::const_iterator exits =
+              contexts[c].exits.find(*ex);
+            if (exits == contexts[c].exits.end()) {
+              continue;
+            }
+            Outs const & rets = returnsFrom.find(*ex)->second.find(pred)->second;
+            std::vector<size_t> const & nodes_at_exit = exits->second;
+            for (size_t i = 0; i < nodes_at_exit.size(); ++i) {
+              if (nodes[nodes_at_exit[i]].live
+                  && returns(nodes_at_exit[i], rets, site, MATCHED_RETURN))
+              {
+                return true;
+              }
+            }
+          }
+          return false;
+        }
+
+        /// Takes the return transitions 'rets' of the left NWA from node
+        /// 'exit' back to the call site 'site' (or, for a pending return,
+        /// to an initial state)
+        bool returns(size_t exit, Outs const & rets, CallSite site, How how)
+        {
+          std::vector<Value> next;
+          for (typename Outs::const_iterator it = rets.begin(); it != rets.end(); ++it) {
+            std::vector<Symbol> syms = concrete(it->first);
+            for (size_t i = 0; i < syms.size(); ++i) {
+              next.clear();
+              if (how == PENDING_RETURN) {
+                right.pendingReturn(nodes[exit].value, syms[i], next);
+                for (size_t j = 0; j < next.size(); ++j) {
+                  if (add(Node(0, it->second, next[j], PENDING_RETURN, exit, 0, syms[i], EPSILON))) {
+                    return true;
+                  }
+                }
+              }
+              else {
+                right.matchedReturn(nodes[exit].value, nodes[site.first].value, syms[i], next);
+                for (size_t j = 0; j < next.size(); ++j) {
+                  Node node(nodes[site.first].context, it->second, next[j],
+                            MATCHED_RETURN, site.first, exit, syms[i], site.second);
+                  if (add(node)) {
+                    return true;
+                  }
+                }
+              }
+            }
+          }
+          return false;
+        }
+
+        /// Appends the word read from the start of node n's context to n
+        void spell(size_t n, NestedWord & word) const
+        {
+          Node const & node = nodes[n];
+          switch (node.how) {
+            case START:
+              break;
+            case INTERNAL:
+              spell(node.parent, word);
+              word.appendInternal(node.symbol);
+              break;
+            case EPSILON_MOVE:
+              spell(node.parent, word);
+              break;
+            case PENDING_RETURN:
+              spell(node.parent, word);
+              word.appendReturn(node.symbol);
+              break;
+            case MATCHED_RETURN:
+              spell(node.parent, word);
+              word.appendCall(node.callSymbol);
+              spell(node.other, word);
+              word.appendReturn(node.symbol);
+              break;
+          }
+        }
+
+        /// Appends the whole word that leads to node n
+        void spellFromStart(size_t n, NestedWord & word) const
+        {
+          Context const & context = contexts[nodes[n].context];
+          if (nodes[n].context != 0) {
+            spellFromStart(context.caller, word);
+            word.appendCall(context.callSymbol);
+          }
+          spell(n, word);
+        }
+
+        NestedWordRefPtr word() const
+        {
+          NestedWordRefPtr word = new NestedWord();
+          spellFromStart(found, *word);
+          return word;
+        }
+
+        Nwa const & left;
+        Right & right;
+        std::vector<Symbol> alphabet;
+        OutMap internalsFrom;
+        OutMap callsFrom;
+        ReturnMap returnsFrom;
+        std::map<State, std::set<State> > exitsOf;   // call predecessor -> exits
+        std::set<State> useful;
+
+        std::vector<Node> nodes;
+        std::vector<Context> contexts;
+        ContextMap contextIds;
+        std::deque<size_t> worklist;
+        size_t found;
+      };
+
+    }
+  }
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef wali_nwa_query_details_SUMMARY_REACHABILITY_HPP
+#define wali_nwa_query_details_SUMMARY_REACHABILITY_HPP
+
+#include "opennwa/NwaFwd.hpp"
+#include "opennwa/NestedWord.hpp"
+#include "opennwa/details/CompactTransitionStorage.hpp"
+
+#include <map>
+#include <queue>
+#include <vector>
+
+namespace opennwa
+{
+  namespace query
+  {
+    namespace details
+    {
+
+      /**
+       *
+       * Finds a word that an NWA accepts by working on its transitions
+       * directly (Nwa::getCompactTransitions), instead of converting it to
+       * a WPDS and running poststar.
+       *
+       * The states are numbered densely. For each entry state that some
+       * call reaches, a "context" holds the states reachable from it by
+       * well-matched words, in a bitset; one more context holds the states
+       * reachable at the top level, where a return may use any initial
+       * state as its call predecessor (a pending return, as in
+       * languageContains). A return transition (x, c, a, r) joins an exit
+       * x of a context with each call site c that calls into it, whichever
+       * of the two is found first, and so acts as a summary edge. A final
+       * state reached in any context means the NWA accepts a word; the
+       * calls still open are left pending.
+       *
+       * With FirstFound, the search is breadth first and stops at the
+       * first final state. With ShortestWord, each context's states are
+       * visited in order of the length of the shortest word that reaches
+       * them from the entry (Knuth's generalization of Dijkstra's
+       * algorithm: a summary is never shorter than its parts), and then
+       * the shortest way into each context is chosen, so that the word
+       * found has as few symbols as possible. Epsilon transitions read
+       * nothing and count for nothing.
+       *
+       */
+      class SummaryReachability
+      {
+      public:
+        enum Order { FirstFound, ShortestWord };
+
+        SummaryReachability(Nwa const & nwa, Order order);
+
+        /// Whether the NWA accepts some word
+        bool accepts() const { return emptyWord || found != NONE; }
+
+        /// Returns a word the NWA accepts (a shortest one, with
+        /// ShortestWord), or NULL if there is none
+        NestedWordRefPtr acceptedWord() const;
+
+        /// The number of (context, state) pairs reached
+        size_t numFacts() const { return facts.size(); }
+
+        /// The number of contexts, counting the top level
+        size_t numContexts() const { return contexts.size(); }
+
+      private:
+        typedef opennwa::details::CompactTransitionStorage Transitions;
+        typedef Transitions::Index Index;
+
+        static const size_t NONE = ~size_t(0);
+
+        /// How a state was first reached in its context
+        enum How { START, INTERNAL, MATCHED_RETURN, PENDING_RETURN };
+
+        struct Fact
+        {
+          Fact(Index c, Index s, size_t len, How h, size_t p, size_t o, Index sym, Index call_sym)
+            : context(c), state(s), length(len), how(h), parent(p), other(o)
+            , symbol(sym), callSymbol(call_sym)
+          {}
+
+          Index context;
+          Index state;
+          size_t length;      // symbols read since the start of the context
+          How how;
+          size_t parent;      // the fact this one steps from (the call site, for MATCHED_RETURN)
+          size_t other;       // the exit fact, for MATCHED_RETURN
+          Index symbol;
+          Index callSymbol;   // for MATCHED_RETURN
+        };
+
+        struct Caller
+        {
+          Caller(size_t f, Index sym) : fact(f), symbol(sym) {}
+
+          size_t fact;
+          Index symbol;
+        };
+
+        struct Context
+        {
+          Context(size_t num_states, Caller in)
+            : reached(num_states, false), wayIn(in), finalFact(NONE)
+          {}
+
+          std::vector<bool> reached;
+          std::map<Index, size_t> exits;                  // facts, by exit state
+          std::map<Index, std::vector<Caller> > callers;  // by call site state
+          Caller wayIn;        // the call the word takes into this context
+          size_t finalFact;    // the first final state reached, if any
+        };
+
+        /// A fact waiting in the ShortestWord queue; the shortest (and,
+        /// among those, the oldest) comes out first
+        struct Pending
+        {
+          Pending(Fact const & f, size_t n) : fact(f), sequence(n) {}
+
+          bool operator<(Pending const & other) const
+          {
+            if (fact.length != other.fact.length) {
+              return fact.length > other.fact.length;
+            }
+            return sequence > other.sequence;
+          }
+
+          Fact fact;
+          size_t sequence;
+        };
+
+        void offer(Fact const & fact);
+        bool accept(Fact const & fact);
+        void process(size_t f);
+        void enter(size_t call_site, Index sym, Index entry);
+        void chooseWaysIn();
+
+        size_t length(Index sym) const;
+        void spell(size_t f, NestedWord & word) const;
+
+        opennwa::details::CompactTransitionStorageRefPtr trans;
+        Order order;
+        std::vector<bool> initial;
+        std::vector<bool> final;
+        std::vector<Index> contextOf;     // by entry state
+
+        std::vector<Fact> facts;
+        std::vector<Context> contexts;
+        std::priority_queue<Pending> heap;  // ShortestWord
+        size_t sequence;
+
+        bool emptyWord;                   // an initial state with no transitions is final
+        size_t found;
+      };
+
+    }
+  }
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif
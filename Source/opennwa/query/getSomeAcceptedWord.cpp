@@ -10,6 +10,7 @@
 #include "wali/wfa/State.hpp"
 #include "opennwa/Nwa.hpp"
 #include "opennwa/query/language.hpp"
+#include "opennwa/query/details/SummaryReachability.hpp"
 #include "opennwa/nwa_pds/conversions.hpp"
 #include "wali/wpds/WPDS.hpp"
 #include "opennwa/ClientInfo.hpp"
@@ -31,16 +32,22 @@ namespace opennwa {
 
       
     NestedWordRefPtr
-    getSomeAcceptedWord(Nwa const & nwa)
+    getSomeAcceptedWord(Nwa const & nwa, ReachabilityAlgorithm how)
     {
+      if (how == ReachabilityBySummaries) {
+        return details::SummaryReachability(nwa, details::SummaryReachability::FirstFound).acceptedWord();
+      }
       ReachGen wg;
       return getSomeAcceptedWordInternal(nwa, wg);
     }
 
 
     NestedWordRefPtr
-    getSomeShortestAcceptedWord(Nwa const & nwa)
+    getSomeShortestAcceptedWord(Nwa const & nwa, ReachabilityAlgorithm how)
     {
+      if (how == ReachabilityBySummaries) {
+        return details::SummaryReachability(nwa, details::SummaryReachability::ShortestWord).acceptedWord();
+      }
       ShortestWordGen wg;
       return getSomeAcceptedWordInternal(nwa, wg);
     }
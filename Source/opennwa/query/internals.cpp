@@ -34,12 +34,11 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Internals & src = trans.getInternals();
+      const Internals & src = trans.getInternalsWithSym(symbol);
       StateSet sources;
       for( InternalIterator it = src.begin(); it != src.end(); it++ )
       {
-        if( symbol == Trans::getInternalSym(*it) )
-          sources.insert( Trans::getSource(*it) );
+        sources.insert( Trans::getSource(*it) );
       }
       return sources;
     }
@@ -226,12 +225,11 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Internals & tgt = trans.getInternals();
+      const Internals & tgt = trans.getInternalsWithSym(symbol);
       StateSet targets;
       for( InternalIterator it = tgt.begin(); it != tgt.end(); it++ )
       {
-        if( symbol == Trans::getInternalSym(*it) )
-          targets.insert( Trans::getTarget(*it) );
+        targets.insert( Trans::getTarget(*it) );
       }
       return targets;
     }
@@ -4,6 +4,7 @@
 #include "opennwa/construct/complement.hpp"
 
 #include "opennwa/query/language.hpp"
+#include "opennwa/query/details/SummaryReachability.hpp"
 
 namespace opennwa {
   namespace query {
@@ -16,8 +17,12 @@ namespace opennwa {
 
 
     bool
-    languageSubsetEq(Nwa const & first, Nwa const & second)
+    languageSubsetEq(Nwa const & first, Nwa const & second, InclusionAlgorithm how)
     {
+      if (how == InclusionByAntichains) {
+        return getSomeWordInDifference(first, second) == NULL;
+      }
+
       Nwa second_copy = second;
         
       // We have to synchronize alphabets first
@@ -38,21 +43,24 @@ namespace opennwa {
 
       
     bool
-    languageIsEmpty(Nwa const & nwa)
+    languageIsEmpty(Nwa const & nwa, ReachabilityAlgorithm how)
     {
-      return nwa._private_isEmpty_();
+      if (how == ReachabilityByPoststar) {
+        return nwa._private_isEmpty_();
+      }
+      return !details::SummaryReachability(nwa, details::SummaryReachability::FirstFound).accepts();
     }
 
 
     bool
-    languageEquals(Nwa const & first, Nwa const & second)
+    languageEquals(Nwa const & first, Nwa const & second, InclusionAlgorithm how)
     {
       //The languages accepted by two NWAs are equivalent if they are both contained
       //in each other, ie L(a1) contained in L(a2) and L(a2) contained in L(a1).
-      bool first_in_second = query::languageSubsetEq(first, second);
-      bool second_in_first = query::languageSubsetEq(second, first);
-
-      return (first_in_second && second_in_first );
+      if (!query::languageSubsetEq(first, second, how)) {
+        return false;
+      }
+      return query::languageSubsetEq(second, first, how);
     }
       
   }
@@ -17,6 +17,20 @@ namespace opennwa {
     languageContains(Nwa const & nwa, NestedWord const & word);
 
 
+    /// @brief How languageSubsetEq and languageEquals decide inclusion
+    enum InclusionAlgorithm {
+      /// Search the product of the first NWA with the subset construction
+      /// of the second on the fly, keeping only the minimal macro-states
+      /// (see getSomeWordInDifference)
+      InclusionByAntichains,
+
+      /// Complement the second NWA, intersect it with the first, and test
+      /// the result for emptiness. Determinizing the second NWA can take
+      /// exponential time and space.
+      InclusionByComplement
+    };
+
+
     /**
      * @brief tests whether the language of the first NWA is included in the language of 
      *        the second NWA
@@ -26,12 +40,45 @@ namespace opennwa {
      *
      * @param - first: the proposed subset
      * @param - second: the proposed superset
+     * @param - how: the algorithm to use
      * @return true if the language of the first NWA is included in the language of the 
      *          second NWA, false otherwise
      *
      */
     bool
-    languageSubsetEq(Nwa const & left, Nwa const & right);
+    languageSubsetEq(Nwa const & left, Nwa const & right,
+                     InclusionAlgorithm how = InclusionByAntichains);
+
+
+    /**
+     *
+     * @brief Returns some word accepted by 'first' but not by 'second', or
+     *        NULL if L(first) is included in L(second).
+     *
+     * The search explores the product of 'first' with the summary
+     * construction that determinize uses for 'second' lazily, and prunes
+     * each product state whose macro-state is a superset of another
+     * reached with the same state of 'first', so 'second' is never
+     * determinized in full. The word found is short, but not necessarily
+     * the shortest.
+     *
+     */
+    extern
+    ref_ptr<NestedWord>
+    getSomeWordInDifference(Nwa const & first, Nwa const & second);
+
+
+    /// @brief How languageIsEmpty, getSomeAcceptedWord, and
+    /// getSomeShortestAcceptedWord search for an accepting run
+    enum ReachabilityAlgorithm {
+      /// Search the transitions of the NWA directly, computing summaries
+      /// of the calls (see details::SummaryReachability)
+      ReachabilityBySummaries,
+
+      /// Convert the NWA to a WPDS and run poststar from its initial
+      /// states. This allocates several objects per transition.
+      ReachabilityByPoststar
+    };
 
 
     /**
@@ -40,27 +87,64 @@ namespace opennwa {
      *
      * This method tests whether the language accepted by this NWA is empty.
      *
+     * @param - how: the algorithm to use
      * @return true if the language accepted by this NWA is empty
      *
      */
     bool
-    languageIsEmpty(Nwa const & nwa);
+    languageIsEmpty(Nwa const & nwa, ReachabilityAlgorithm how = ReachabilityBySummaries);
+
+
+    /**
+     *
+     * @brief tests whether the intersection of the languages of the given
+     *        NWAs is empty
+     *
+     * This is languageIsEmpty(*construct::intersect(first, second)), but
+     * the product is built only as the search reaches it, and the search
+     * stops at the first accepting configuration. (The one difference: a
+     * pending return here may use any initial state of either NWA as its
+     * call predecessor, as languageContains does, even after epsilon moves.)
+     * When the intersection is empty, the whole reachable product is
+     * still explored.
+     *
+     * @return true if no word is accepted by both NWAs
+     *
+     */
+    bool
+    languageIntersectionIsEmpty(Nwa const & first, Nwa const & second);
+
+
+    /**
+     *
+     * @brief Returns some word accepted by both 'first' and 'second', or
+     *        NULL if there isn't one.
+     *
+     * See languageIntersectionIsEmpty.
+     *
+     */
+    extern
+    ref_ptr<NestedWord>
+    getSomeWordInIntersection(Nwa const & first, Nwa const & second);
 
 
     /**
      *
      * @brief Returns some word accepted by 'nwa', or NULL if there isn't one.
      *
+     * @param - how: the algorithm to use
      * @return A word accepted by 'nwa', or NULL if there isn't one
      *
      */
     extern
     ref_ptr<NestedWord>
-    getSomeAcceptedWord(Nwa const & nwa);
+    getSomeAcceptedWord(Nwa const & nwa, ReachabilityAlgorithm how = ReachabilityBySummaries);
 
+    /// @brief Returns a word with the fewest symbols of those 'nwa'
+    /// accepts, or NULL if there isn't one. (Epsilons are not counted.)
     extern
     ref_ptr<NestedWord>
-    getSomeShortestAcceptedWord(Nwa const & nwa);
+    getSomeShortestAcceptedWord(Nwa const & nwa, ReachabilityAlgorithm how = ReachabilityBySummaries);
       
     extern
     ref_ptr<NestedWord>
@@ -78,11 +162,13 @@ namespace opennwa {
      *
      * @param - first: one of the NWAs whose language to test
      * @param - second: one of the NWAs whose language to test
+     * @param - how: the algorithm to use for the two inclusion tests
      * @return true if the languages accepted by the given NWAs are equal, false otherwise
      *
      */
     bool
-    languageEquals(Nwa const & first, Nwa const & second);
+    languageEquals(Nwa const & first, Nwa const & second,
+                   InclusionAlgorithm how = InclusionByAntichains);
       
   }
 }
@@ -0,0 +1,288 @@
+#include "opennwa/Nwa.hpp"
+#include "opennwa/NestedWord.hpp"
+#include "opennwa/query/language.hpp"
+#include "opennwa/query/details/ProductSearch.hpp"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+// Searches for a nested word in L(first) \ L(second) without complementing
+// 'second'. The search (details::ProductSearch) explores the product of
+// 'first' with the summary (subset) construction that determinize uses for
+// 'second', and keeps only the minimal macro-states it reaches (an
+// antichain): the operations on macro-states are monotone, so a product
+// state whose macro-state is a superset of another with the same state of
+// 'first' cannot lead anywhere the smaller one cannot.
+//
+// A macro-state is a relation over the states of 'second': (s, q) means
+// that 'second' can be in q now, having been in s when the innermost
+// pending call was made. In the outermost context, where there is no such
+// call, s is always TOP_LEVEL. Each s is a state 'second' can be in at that
+// call, so the q are exactly the states it can be in after the whole word,
+// pending calls and all.
+
+namespace opennwa {
+  namespace query {
+
+    namespace {
+
+      typedef unsigned int Index;
+      typedef std::pair<Index, Index> Pair;
+      typedef std::vector<Pair> Relation;
+
+      const Index TOP_LEVEL = ~0u;
+
+      void normalize(Relation & rel)
+      {
+        std::sort(rel.begin(), rel.end());
+        rel.erase(std::unique(rel.begin(), rel.end()), rel.end());
+      }
+
+
+      /// The NWA on the right of the inclusion, with its states numbered
+      /// densely, and the operations of the summary construction on its
+      /// macro-states.
+      class Superset
+      {
+      public:
+        typedef Relation Value;
+
+        static const bool pruneSubsumed = true;
+
+        explicit Superset(Nwa const & nwa)
+        {
+          for (Nwa::StateIterator st = nwa.beginStates(); st != nwa.endStates(); ++st) {
+            Index n = static_cast<Index>(numbers.size());
+            numbers[*st] = n;
+          }
+          size_t n = numbers.size();
+          final.resize(n, false);
+          initials.resize(n, false);
+          internals.resize(n);
+          calls.resize(n);
+          returns.resize(n);
+
+          for (Nwa::StateIterator st = nwa.beginFinalStates(); st != nwa.endFinalStates(); ++st) {
+            final[number(*st)] = true;
+          }
+          for (Nwa::StateIterator st = nwa.beginInitialStates(); st != nwa.endInitialStates(); ++st) {
+            initials[number(*st)] = true;
+          }
+
+          std::vector<std::vector<Index> > epsilons(n);
+          for (Nwa::InternalIterator it = nwa.beginInternalTrans(); it != nwa.endInternalTrans(); ++it) {
+            if (it->second == EPSILON) {
+              epsilons[number(it->first)].push_back(number(it->third));
+            }
+            else {
+              internals[number(it->first)].push_back(Out(it->second, number(it->third)));
+            }
+          }
+          for (Nwa::CallIterator it = nwa.beginCallTrans(); it != nwa.endCallTrans(); ++it) {
+            calls[number(it->first)].push_back(Out(it->second, number(it->third)));
+          }
+          for (Nwa::ReturnIterator it = nwa.beginReturnTrans(); it != nwa.endReturnTrans(); ++it) {
+            ReturnOut out = { number(it->second), it->third, number(it->fourth) };
+            returns[number(it->first)].push_back(out);
+          }
+
+          // Epsilon closures, each including the state itself
+          closure.resize(n);
+          std::vector<size_t> seen(n, n);
+          for (Index q = 0; q < n; ++q) {
+            std::vector<Index> & reach = closure[q];
+            reach.push_back(q);
+            seen[q] = q;
+            for (size_t i = 0; i < reach.size(); ++i) {
+              std::vector<Index> const & next = epsilons[reach[i]];
+              for (size_t j = 0; j < next.size(); ++j) {
+                if (seen[next[j]] != q) {
+                  seen[next[j]] = q;
+                  reach.push_back(next[j]);
+                }
+              }
+            }
+          }
+        }
+
+        void initial(std::vector<Relation> & values) const
+        {
+          Relation out;
+          for (Index q = 0; q < initials.size(); ++q) {
+            if (initials[q]) {
+              addClosure(out, TOP_LEVEL, q);
+            }
+          }
+          normalize(out);
+          values.push_back(out);
+        }
+
+        /// Macro-states are closed under epsilon already
+        void epsilon(Relation const &, std::vector<Relation> &) const
+        {
+        }
+
+        void internal(Relation const & rel, Symbol sym, std::vector<Relation> & values) const
+        {
+          Relation out;
+          for (Relation::const_iterator it = rel.begin(); it != rel.end(); ++it) {
+            std::vector<Out> const & outs = internals[it->second];
+            for (size_t i = 0; i < outs.size(); ++i) {
+              if (details::symbolMatches(outs[i].first, sym)) {
+                addClosure(out, it->first, outs[i].second);
+              }
+            }
+          }
+          normalize(out);
+          values.push_back(out);
+        }
+
+        /// The macro-state after a call on 'sym': {(c, e) | (s, c) in rel,
+        /// (c, sym, e) is a call transition}, closed under epsilon. Only the
+        /// states 'second' can be in at the call site are call
+        /// predecessors, so a word that ends inside the call is accepted
+        /// exactly when some state in the macro-state is final. (The return
+        /// combines the two as determinize does.)
+        void call(Relation const & rel, Symbol sym, std::vector<Relation> & values) const
+        {
+          std::vector<Index> sites;
+          for (Relation::const_iterator it = rel.begin(); it != rel.end(); ++it) {
+            sites.push_back(it->second);
+          }
+          std::sort(sites.begin(), sites.end());
+          sites.erase(std::unique(sites.begin(), sites.end()), sites.end());
+
+          Relation out;
+          for (size_t k = 0; k < sites.size(); ++k) {
+            Index q = sites[k];
+            for (size_t i = 0; i < calls[q].size(); ++i) {
+              if (details::symbolMatches(calls[q][i].first, sym)) {
+                addClosure(out, q, calls[q][i].second);
+              }
+            }
+          }
+          normalize(out);
+          values.push_back(out);
+        }
+
+        /// {(s, r) | (s, c) in call, (c, x) in exit, (x, c, sym, r) is a
+        /// return transition}, closed under epsilon
+        void matchedReturn(Relation const & exit, Relation const & call, Symbol sym,
+                           std::vector<Relation> & values) const
+        {
+          Relation summary;
+          for (Relation::const_iterator it = exit.begin(); it != exit.end(); ++it) {
+            std::vector<ReturnOut> const & outs = returns[it->second];
+            for (size_t i = 0; i < outs.size(); ++i) {
+              if (outs[i].pred == it->first && details::symbolMatches(outs[i].symbol, sym)) {
+                addClosure(summary, it->first, outs[i].returnSite);
+              }
+            }
+          }
+          normalize(summary);
+
+          Relation out;
+          for (Relation::const_iterator it = call.begin(); it != call.end(); ++it) {
+            Relation::const_iterator first =
+              std::lower_bound(summary.begin(), summary.end(), Pair(it->second, 0));
+            for (; first != summary.end() && first->first == it->second; ++first) {
+              out.push_back(Pair(it->first, first->second));
+            }
+          }
+          normalize(out);
+          values.push_back(out);
+        }
+
+        /// A return on 'sym' with an empty stack, where the call
+        /// predecessor can be any initial state
+        void pendingReturn(Relation const & exit, Symbol sym, std::vector<Relation> & values) const
+        {
+          Relation out;
+          for (Relation::const_iterator it = exit.begin(); it != exit.end(); ++it) {
+            std::vector<ReturnOut> const & outs = returns[it->second];
+            for (size_t i = 0; i < outs.size(); ++i) {
+              if (initials[outs[i].pred] && details::symbolMatches(outs[i].symbol, sym)) {
+                addClosure(out, TOP_LEVEL, outs[i].returnSite);
+              }
+            }
+          }
+          normalize(out);
+          values.push_back(out);
+        }
+
+        /// A word that 'first' accepts and 'second' does not
+        bool isTarget(bool leftFinal, Relation const & rel) const
+        {
+          if (!leftFinal) {
+            return false;
+          }
+          for (Relation::const_iterator it = rel.begin(); it != rel.end(); ++it) {
+            if (final[it->second]) {
+              return false;
+            }
+          }
+          return true;
+        }
+
+        /// Whatever 'larger' leads to, 'smaller' leads to as well
+        bool subsumes(Relation const & smaller, Relation const & larger) const
+        {
+          return std::includes(larger.begin(), larger.end(), smaller.begin(), smaller.end());
+        }
+
+      private:
+        typedef std::pair<Symbol, Index> Out;
+
+        struct ReturnOut
+        {
+          Index pred;
+          Symbol symbol;
+          Index returnSite;
+        };
+
+        Index number(State st) const
+        {
+          return numbers.find(st)->second;
+        }
+
+        void addClosure(Relation & out, Index first, Index q) const
+        {
+          std::vector<Index> const & reach = closure[q];
+          for (size_t i = 0; i < reach.size(); ++i) {
+            out.push_back(Pair(first, reach[i]));
+          }
+        }
+
+        std::map<State, Index> numbers;
+        std::vector<bool> final;
+        std::vector<bool> initials;
+        std::vector<std::vector<Index> > closure;
+        std::vector<std::vector<Out> > internals;   // non-epsilon, by source
+        std::vector<std::vector<Out> > calls;       // by call site
+        std::vector<std::vector<ReturnOut> > returns; // by exit
+      };
+
+
+    } // end anonymous namespace
+
+
+    NestedWordRefPtr
+    getSomeWordInDifference(Nwa const & first, Nwa const & second)
+    {
+      std::vector<Symbol> alphabet = details::concreteSymbols(first, second);
+      Superset superset(second);
+      details::ProductSearch<Superset> search(first, superset, alphabet);
+      return search.run();
+    }
+
+  }
+}
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,148 @@
+#include "opennwa/Nwa.hpp"
+#include "opennwa/NestedWord.hpp"
+#include "opennwa/query/language.hpp"
+#include "opennwa/query/details/ProductSearch.hpp"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+// Searches the product of two NWAs for an accepting configuration without
+// building the product (construct::intersect) first. details::ProductSearch
+// visits only the product states reachable from the initial ones, and
+// stops at the first one that is final in both NWAs, so a non-empty
+// intersection is usually found after a small part of the product.
+
+namespace opennwa {
+  namespace query {
+
+    namespace {
+
+      /// The second NWA of the product, stepped one state at a time
+      class Factor
+      {
+      public:
+        typedef State Value;
+
+        static const bool pruneSubsumed = false;
+
+        explicit Factor(Nwa const & nwa)
+          : nwa(nwa)
+        {
+          for (Nwa::InternalIterator it = nwa.beginInternalTrans(); it != nwa.endInternalTrans(); ++it) {
+            internals[it->first].push_back(Out(it->second, it->third));
+          }
+          for (Nwa::CallIterator it = nwa.beginCallTrans(); it != nwa.endCallTrans(); ++it) {
+            calls[it->first].push_back(Out(it->second, it->third));
+          }
+          for (Nwa::ReturnIterator it = nwa.beginReturnTrans(); it != nwa.endReturnTrans(); ++it) {
+            returns[std::make_pair(it->first, it->second)].push_back(Out(it->third, it->fourth));
+            if (nwa.isInitialState(it->second)) {
+              pendingReturns[it->first].push_back(Out(it->third, it->fourth));
+            }
+          }
+        }
+
+        void initial(std::vector<State> & values) const
+        {
+          values.insert(values.end(), nwa.beginInitialStates(), nwa.endInitialStates());
+        }
+
+        void epsilon(State st, std::vector<State> & values) const
+        {
+          step(internals, st, EPSILON, values);
+        }
+
+        void internal(State st, Symbol sym, std::vector<State> & values) const
+        {
+          step(internals, st, sym, values);
+        }
+
+        void call(State st, Symbol sym, std::vector<State> & values) const
+        {
+          step(calls, st, sym, values);
+        }
+
+        void matchedReturn(State exit, State call, Symbol sym, std::vector<State> & values) const
+        {
+          ReturnMap::const_iterator found = returns.find(std::make_pair(exit, call));
+          if (found != returns.end()) {
+            step(found->second, sym, values);
+          }
+        }
+
+        void pendingReturn(State exit, Symbol sym, std::vector<State> & values) const
+        {
+          step(pendingReturns, exit, sym, values);
+        }
+
+        bool isTarget(bool leftFinal, State st) const
+        {
+          return leftFinal && nwa.isFinalState(st);
+        }
+
+        bool subsumes(State a, State b) const
+        {
+          return a == b;
+        }
+
+      private:
+        typedef std::pair<Symbol, State> Out;
+        typedef std::vector<Out> Outs;
+        typedef std::map<State, Outs> OutMap;
+        typedef std::map<std::pair<State, State>, Outs> ReturnMap;
+
+        /// Follows the transitions in 'outs' that can read 'sym' (only the
+        /// epsilon ones, for EPSILON)
+        static void step(Outs const & outs, Symbol sym, std::vector<State> & values)
+        {
+          for (size_t i = 0; i < outs.size(); ++i) {
+            if (sym == EPSILON ? outs[i].first == EPSILON : details::symbolMatches(outs[i].first, sym)) {
+              values.push_back(outs[i].second);
+            }
+          }
+        }
+
+        static void step(OutMap const & outs, State st, Symbol sym, std::vector<State> & values)
+        {
+          OutMap::const_iterator found = outs.find(st);
+          if (found != outs.end()) {
+            step(found->second, sym, values);
+          }
+        }
+
+        Nwa const & nwa;
+        OutMap internals;
+        OutMap calls;
+        ReturnMap returns;          // by (exit, call predecessor)
+        OutMap pendingReturns;      // by exit, with an initial call predecessor
+      };
+
+    } // end anonymous namespace
+
+
+    NestedWordRefPtr
+    getSomeWordInIntersection(Nwa const & first, Nwa const & second)
+    {
+      std::vector<Symbol> alphabet = details::concreteSymbols(first, second);
+      Factor factor(second);
+      details::ProductSearch<Factor> search(first, factor, alphabet);
+      return search.run();
+    }
+
+
+    bool
+    languageIntersectionIsEmpty(Nwa const & first, Nwa const & second)
+    {
+      return getSomeWordInIntersection(first, second) == NULL;
+    }
+
+  }
+}
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -35,14 +35,11 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns & exit = trans.getReturns();
+      const Returns & exit = trans.getReturnsWithSym(symbol);
       StateSet exits;
       for( ReturnIterator it = exit.begin(); it != exit.end(); it++ )
       {
-        if( symbol == Trans::getReturnSym(*it) )
-        {
-          exits.insert( Trans::getExit(*it) );
-        }
+        exits.insert( Trans::getExit(*it) );
       }
       return exits;
     }
@@ -258,14 +255,11 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns & call = trans.getReturns();
+      const Returns & call = trans.getReturnsWithSym(symbol);
       StateSet calls;
       for( ReturnIterator it = call.begin(); it != call.end(); it++ )
       {
-        if( symbol == Trans::getReturnSym(*it) )
-        {
-          calls.insert( Trans::getCallSite(*it) );
-        }
+        calls.insert( Trans::getCallSite(*it) );
       }
       return calls;
     }
@@ -291,7 +285,7 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns call = trans.getTransExit(exitPoint);
+      const Returns & call = trans.getTransExit(exitPoint);
       StateSet calls;
       for( ReturnIterator it = call.begin(); it != call.end(); it++ )
       {
@@ -322,7 +316,7 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns call = trans.getTransExit(exitPoint);
+      const Returns & call = trans.getTransExit(exitPoint);
       std::set<std::pair<State,Symbol> > calls;
       for( ReturnIterator it = call.begin(); it != call.end(); it++ )
       {
@@ -345,7 +339,7 @@ namespace opennwa
     const std::set< State> getCalls(Nwa const & nwa)
     {
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
-      const Returns call = trans.getReturns();
+      const Returns & call = trans.getReturns();
       StateSet calls;
       for( ReturnIterator it = call.begin(); it != call.end(); it++ )
       {
@@ -373,7 +367,7 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns call = trans.getTransExit(exitPoint);
+      const Returns & call = trans.getTransExit(exitPoint);
       StateSet calls;
       for( ReturnIterator it = call.begin(); it != call.end(); it++ )
       {
@@ -400,7 +394,7 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns call = trans.getTransExit(exitPoint);
+      const Returns & call = trans.getTransExit(exitPoint);
       std::set<std::pair<State,Symbol> > calls;
       for( ReturnIterator it = call.begin(); it != call.end(); it++ )
       {
@@ -428,7 +422,7 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns call = trans.getTransRet(returnSite);
+      const Returns & call = trans.getTransRet(returnSite);
       StateSet calls;
       for( ReturnIterator it = call.begin(); it != call.end(); it++ )
       {
@@ -456,7 +450,7 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns call = trans.getTransRet(returnSite);
+      const Returns & call = trans.getTransRet(returnSite);
       std::set<std::pair<State,Symbol> > calls;
       for( ReturnIterator it = call.begin(); it != call.end(); it++ )
       {
@@ -476,7 +470,7 @@ namespace opennwa
     const std::set< Symbol> getReturnSym(Nwa const & nwa)
     {
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
-      const Returns rets = trans.getReturns();
+      const Returns & rets = trans.getReturns();
       std::set<Symbol> syms;
       for( ReturnIterator it = rets.begin(); it != rets.end(); it++ )
       {
@@ -506,11 +500,11 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns ret = trans.getTransExit(exitPoint);
+      std::pair<ReturnIterator, ReturnIterator> ret = trans.getTransExitPred(exitPoint, callSite);
       std::set<Symbol> syms;
-      for( ReturnIterator it = ret.begin(); it != ret.end(); it++ )
+      for( ReturnIterator it = ret.first; it != ret.second; it++ )
       {
-        if( (Trans::getCallSite(*it) == callSite) && (returnSite == Trans::getReturnSite(*it)) )
+        if( returnSite == Trans::getReturnSite(*it) )
         {
           syms.insert( Trans::getReturnSym(*it) );
         }
@@ -535,7 +529,7 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns ret = trans.getTransExit(exitPoint);
+      const Returns & ret = trans.getTransExit(exitPoint);
       std::set<Symbol> syms;
       for( ReturnIterator it = ret.begin(); it != ret.end(); it++ )
       {
@@ -561,7 +555,7 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns ret = trans.getTransPred(callSite);
+      const Returns & ret = trans.getTransPred(callSite);
       std::set<Symbol> syms;
       for( ReturnIterator it = ret.begin(); it != ret.end(); it++ )
       {
@@ -587,7 +581,7 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns ret = trans.getTransRet(returnSite);
+      const Returns & ret = trans.getTransRet(returnSite);
       std::set<Symbol> syms;
       for( ReturnIterator it = ret.begin(); it != ret.end(); it++ )
       {
@@ -615,14 +609,11 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns ret = trans.getTransExit(exitPoint);
+      std::pair<ReturnIterator, ReturnIterator> ret = trans.getTransExitPred(exitPoint, callSite);
       std::set<Symbol> syms;
-      for( ReturnIterator it = ret.begin(); it != ret.end(); it++ )
+      for( ReturnIterator it = ret.first; it != ret.second; it++ )
       {
-        if( (Trans::getCallSite(*it) == callSite) )
-        {
-          syms.insert( Trans::getReturnSym(*it) );
-        }
+        syms.insert( Trans::getReturnSym(*it) );
       }
       return syms;
     }
@@ -646,7 +637,7 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns ret = trans.getTransExit(exitPoint);
+      const Returns & ret = trans.getTransExit(exitPoint);
       std::set<Symbol> syms;
       for( ReturnIterator it = ret.begin(); it != ret.end(); it++ )
       {
@@ -677,7 +668,7 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns ret = trans.getTransPred(callSite);
+      const Returns & ret = trans.getTransPred(callSite);
       std::set<Symbol> syms;
       for( ReturnIterator it = ret.begin(); it != ret.end(); it++ )
       {
@@ -706,14 +697,11 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
       
-      const Returns ret = trans.getReturns();
+      const Returns & ret = trans.getReturnsWithSym(symbol);
       StateSet returns;
       for( ReturnIterator it = ret.begin(); it != ret.end(); it++ )
       {
-        if( symbol == Trans::getReturnSym(*it) )
-        {
-          returns.insert( Trans::getReturnSite(*it) );
-        }
+        returns.insert( Trans::getReturnSite(*it) );
       }
       return returns;
     }
@@ -739,11 +727,11 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns ret = trans.getTransExit(exitPoint);
+      std::pair<ReturnIterator, ReturnIterator> ret = trans.getTransExitPred(exitPoint, callSite);
       StateSet returns;
-      for( ReturnIterator it = ret.begin(); it != ret.end(); it++ )
+      for( ReturnIterator it = ret.first; it != ret.second; it++ )
       {
-        if( (Trans::getCallSite(*it) == callSite) && (symbol == Trans::getReturnSym(*it)) )
+        if( symbol == Trans::getReturnSym(*it) )
         {
           returns.insert( Trans::getReturnSite(*it) );
         }
@@ -770,14 +758,11 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns ret = trans.getTransExit(exit);
+      std::pair<ReturnIterator, ReturnIterator> ret = trans.getTransExitPred(exit, callSite);
       std::set<std::pair<Symbol,State> > returns;
-      for( ReturnIterator it = ret.begin(); it != ret.end(); it++ )
+      for( ReturnIterator it = ret.first; it != ret.second; it++ )
       {
-        if( Trans::getCallSite(*it) == callSite )
-        {
-          returns.insert( std::pair<Symbol,State>(Trans::getReturnSym(*it),Trans::getReturnSite(*it)) );
-        }
+        returns.insert( std::pair<Symbol,State>(Trans::getReturnSym(*it),Trans::getReturnSite(*it)) );
       }
       return returns;
     }
@@ -793,7 +778,7 @@ namespace opennwa
     const std::set< State> getReturns(Nwa const & nwa)
     {
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
-      const Returns ret = trans.getReturns();
+      const Returns & ret = trans.getReturns();
       StateSet returns;
       for( ReturnIterator it = ret.begin(); it != ret.end(); it++ )
       {
@@ -821,7 +806,7 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns ret = trans.getTransExit(exitPoint);
+      const Returns & ret = trans.getTransExit(exitPoint);
       StateSet returns;
       for( ReturnIterator it = ret.begin(); it != ret.end(); it++ )
       {
@@ -848,7 +833,7 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns ret = trans.getTransExit(exitPoint);
+      const Returns & ret = trans.getTransExit(exitPoint);
       std::set<std::pair<Symbol,State> > returns;
       for( ReturnIterator it = ret.begin(); it != ret.end(); it++ )
       {
@@ -876,7 +861,7 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns ret = trans.getTransPred(callSite);
+      const Returns & ret = trans.getTransPred(callSite);
       StateSet returns;
       for( ReturnIterator it = ret.begin(); it != ret.end(); it++ )
       {
@@ -903,7 +888,7 @@ namespace opennwa
 
       details::TransitionStorage const & trans = nwa._private_get_transition_storage_();
 
-      const Returns ret = trans.getTransPred(callSite);
+      const Returns & ret = trans.getTransPred(callSite);
       std::set<std::pair<Symbol,State> > returns;
       for( ReturnIterator it = ret.begin(); it != ret.end(); it++ )
       {
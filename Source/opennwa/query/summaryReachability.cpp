@@ -0,0 +1,334 @@
+#include "opennwa/Nwa.hpp"
+#include "opennwa/query/details/SummaryReachability.hpp"
+
+#include <functional>
+#include <utility>
+
+namespace opennwa {
+  namespace query {
+    namespace details {
+
+      namespace {
+        /// What spell() has left to do
+        enum Action { SPELL_FACT, APPEND_INTERNAL, APPEND_CALL, APPEND_RETURN };
+      }
+
+      const size_t SummaryReachability::NONE;
+
+
+      SummaryReachability::SummaryReachability(Nwa const & nwa, Order order)
+        : trans(nwa.getCompactTransitions())
+        , order(order)
+        , sequence(0)
+        , emptyWord(false)
+        , found(NONE)
+      {
+        if (nwa.sizeInitialStates() == 0 || nwa.sizeFinalStates() == 0) {
+          return;
+        }
+
+        size_t n = trans->numStates();
+        initial.resize(n, false);
+        final.resize(n, false);
+        contextOf.resize(n, Transitions::NONE);
+
+        for (Nwa::StateIterator st = nwa.beginFinalStates(); st != nwa.endFinalStates(); ++st) {
+          Index i = trans->stateIndex(*st);
+          if (i != Transitions::NONE) {
+            final[i] = true;
+          }
+        }
+
+        std::vector<Index> starts;
+        for (Nwa::StateIterator st = nwa.beginInitialStates(); st != nwa.endInitialStates(); ++st) {
+          Index i = trans->stateIndex(*st);
+          if (i != Transitions::NONE) {
+            initial[i] = true;
+            starts.push_back(i);
+          }
+          else if (nwa.isFinalState(*st)) {
+            // No word is shorter, and no search can reach this state
+            emptyWord = true;
+            return;
+          }
+        }
+
+        contexts.push_back(Context(n, Caller(NONE, 0)));
+        for (size_t i = 0; i < starts.size(); ++i) {
+          offer(Fact(0, starts[i], 0, START, NONE, NONE, 0, 0));
+        }
+
+        if (order == FirstFound) {
+          // 'facts' is the queue: accept() appends to it
+          for (size_t f = 0; f < facts.size() && found == NONE; ++f) {
+            process(f);
+          }
+        }
+        else {
+          while (!heap.empty()) {
+            Fact fact = heap.top().fact;
+            heap.pop();
+            if (accept(fact)) {
+              process(facts.size() - 1);
+            }
+          }
+          chooseWaysIn();
+        }
+      }
+
+
+      void
+      SummaryReachability::offer(Fact const & fact)
+      {
+        if (order == FirstFound) {
+          accept(fact);
+        }
+        else {
+          heap.push(Pending(fact, sequence++));
+        }
+      }
+
+
+      /// Records 'fact' unless its state was reached in its context
+      /// already. Returns true if it is new.
+      bool
+      SummaryReachability::accept(Fact const & fact)
+      {
+        Context & context = contexts[fact.context];
+        if (context.reached[fact.state]) {
+          return false;
+        }
+        context.reached[fact.state] = true;
+        facts.push_back(fact);
+
+        if (final[fact.state] && context.finalFact == NONE) {
+          context.finalFact = facts.size() - 1;
+          if (order == FirstFound) {
+            found = context.finalFact;
+          }
+        }
+        return true;
+      }
+
+
+      void
+      SummaryReachability::process(size_t f)
+      {
+        // A copy: 'facts' grows as we go
+        Fact const fact = facts[f];
+
+        Transitions::Edges internals = trans->internalsFrom(fact.state);
+        for (Transitions::Edges::const_iterator it = internals.begin(); it != internals.end(); ++it) {
+          offer(Fact(fact.context, it->target, fact.length + length(it->symbol),
+                     INTERNAL, f, NONE, it->symbol, 0));
+        }
+
+        Transitions::Edges calls = trans->callsFrom(fact.state);
+        for (Transitions::Edges::const_iterator it = calls.begin(); it != calls.end(); ++it) {
+          enter(f, it->symbol, it->target);
+        }
+
+        Transitions::ReturnEdges returns = trans->returnsFromExit(fact.state);
+        if (returns.empty()) {
+          return;
+        }
+        if (fact.context == 0) {
+          for (Transitions::ReturnEdges::const_iterator it = returns.begin(); it != returns.end(); ++it) {
+            if (initial[it->pred]) {
+              offer(Fact(0, it->returnSite, fact.length + 1, PENDING_RETURN, f, NONE, it->symbol, 0));
+            }
+          }
+          return;
+        }
+
+        // offer() adds facts, but neither contexts nor callers
+        Context & context = contexts[fact.context];
+        context.exits[fact.state] = f;
+        for (Transitions::ReturnEdges::const_iterator it = returns.begin(); it != returns.end(); ++it) {
+          std::map<Index, std::vector<Caller> >::const_iterator callers = context.callers.find(it->pred);
+          if (callers == context.callers.end()) {
+            continue;
+          }
+          for (size_t i = 0; i < callers->second.size(); ++i) {
+            Caller const & caller = callers->second[i];
+            Index site_context = facts[caller.fact].context;
+            size_t site_length = facts[caller.fact].length;
+            offer(Fact(site_context, it->returnSite, site_length + fact.length + 2,
+                       MATCHED_RETURN, caller.fact, f, it->symbol, caller.symbol));
+          }
+        }
+      }
+
+
+      /// The fact 'call_site' calls into 'entry' on 'sym'
+      void
+      SummaryReachability::enter(size_t call_site, Index sym, Index entry)
+      {
+        Index pred = facts[call_site].state;
+        Index c = contextOf[entry];
+        if (c == Transitions::NONE) {
+          c = static_cast<Index>(contexts.size());
+          contextOf[entry] = c;
+          contexts.push_back(Context(trans->numStates(), Caller(call_site, sym)));
+          contexts[c].callers[pred].push_back(Caller(call_site, sym));
+          offer(Fact(c, entry, 0, START, NONE, NONE, 0, 0));
+          return;
+        }
+
+        // Match the new call site with the exits that have a return
+        // transition back to it
+        Context & context = contexts[c];
+        context.callers[pred].push_back(Caller(call_site, sym));
+        Transitions::Positions returns = trans->returnsFromPred(pred);
+        for (Transitions::Positions::const_iterator pos = returns.begin(); pos != returns.end(); ++pos) {
+          Transitions::ReturnEdge const & ret = trans->returnAt(*pos);
+          std::map<Index, size_t>::const_iterator exit = context.exits.find(ret.exit);
+          if (exit == context.exits.end()) {
+            continue;
+          }
+          offer(Fact(facts[call_site].context, ret.returnSite,
+                     facts[call_site].length + facts[exit->second].length + 2,
+                     MATCHED_RETURN, call_site, exit->second, ret.symbol, sym));
+        }
+      }
+
+
+      /// Picks the shortest way into each context (shortest paths over
+      /// the calls between contexts), and the shortest accepted word
+      void
+      SummaryReachability::chooseWaysIn()
+      {
+        std::vector<std::vector<std::pair<Index, Caller> > > calls_from(contexts.size());
+        for (Index c = 1; c < contexts.size(); ++c) {
+          std::map<Index, std::vector<Caller> >::const_iterator it = contexts[c].callers.begin();
+          for (; it != contexts[c].callers.end(); ++it) {
+            for (size_t i = 0; i < it->second.size(); ++i) {
+              calls_from[facts[it->second[i].fact].context].push_back(std::make_pair(c, it->second[i]));
+            }
+          }
+        }
+
+        typedef std::pair<size_t, Index> Distance;
+        std::priority_queue<Distance, std::vector<Distance>, std::greater<Distance> > queue;
+        std::vector<size_t> best(contexts.size(), NONE);
+        best[0] = 0;
+        queue.push(Distance(0, 0));
+        while (!queue.empty()) {
+          Distance d = queue.top();
+          queue.pop();
+          if (d.first != best[d.second]) {
+            continue;
+          }
+          std::vector<std::pair<Index, Caller> > const & calls = calls_from[d.second];
+          for (size_t i = 0; i < calls.size(); ++i) {
+            size_t into = d.first + facts[calls[i].second.fact].length + 1;
+            if (into < best[calls[i].first]) {
+              best[calls[i].first] = into;
+              contexts[calls[i].first].wayIn = calls[i].second;
+              queue.push(Distance(into, calls[i].first));
+            }
+          }
+        }
+
+        size_t shortest = NONE;
+        for (Index c = 0; c < contexts.size(); ++c) {
+          size_t f = contexts[c].finalFact;
+          if (f != NONE && best[c] != NONE && best[c] + facts[f].length < shortest) {
+            shortest = best[c] + facts[f].length;
+            found = f;
+          }
+        }
+      }
+
+
+      size_t
+      SummaryReachability::length(Index sym) const
+      {
+        return trans->symbol(sym) == EPSILON ? 0 : 1;
+      }
+
+
+      NestedWordRefPtr
+      SummaryReachability::acceptedWord() const
+      {
+        if (emptyWord) {
+          return new NestedWord();
+        }
+        if (found == NONE) {
+          return NULL;
+        }
+
+        std::vector<Caller> calls;   // innermost first
+        for (Index c = facts[found].context; c != 0; c = facts[contexts[c].wayIn.fact].context) {
+          calls.push_back(contexts[c].wayIn);
+        }
+
+        NestedWordRefPtr word = new NestedWord();
+        for (size_t i = calls.size(); i > 0; --i) {
+          spell(calls[i - 1].fact, *word);
+          word->appendCall(trans->symbol(calls[i - 1].symbol));
+        }
+        spell(found, *word);
+        return word;
+      }
+
+
+      /// Appends the word read from the start of fact f's context to f.
+      /// Words can be much longer than the C++ stack is deep, so this
+      /// keeps its own.
+      void
+      SummaryReachability::spell(size_t f, NestedWord & word) const
+      {
+        std::vector<std::pair<Action, size_t> > todo(1, std::make_pair(SPELL_FACT, f));
+        while (!todo.empty()) {
+          std::pair<Action, size_t> step = todo.back();
+          todo.pop_back();
+          switch (step.first) {
+            case APPEND_INTERNAL:
+              word.appendInternal(trans->symbol(static_cast<Index>(step.second)));
+              continue;
+            case APPEND_CALL:
+              word.appendCall(trans->symbol(static_cast<Index>(step.second)));
+              continue;
+            case APPEND_RETURN:
+              word.appendReturn(trans->symbol(static_cast<Index>(step.second)));
+              continue;
+            case SPELL_FACT:
+              break;
+          }
+
+          // Pushed in reverse
+          Fact const & fact = facts[step.second];
+          switch (fact.how) {
+            case START:
+              break;
+            case INTERNAL:
+              if (trans->symbol(fact.symbol) != EPSILON) {
+                todo.push_back(std::make_pair(APPEND_INTERNAL, size_t(fact.symbol)));
+              }
+              todo.push_back(std::make_pair(SPELL_FACT, fact.parent));
+              break;
+            case PENDING_RETURN:
+              todo.push_back(std::make_pair(APPEND_RETURN, size_t(fact.symbol)));
+              todo.push_back(std::make_pair(SPELL_FACT, fact.parent));
+              break;
+            case MATCHED_RETURN:
+              todo.push_back(std::make_pair(APPEND_RETURN, size_t(fact.symbol)));
+              todo.push_back(std::make_pair(SPELL_FACT, fact.other));
+              todo.push_back(std::make_pair(APPEND_CALL, size_t(fact.callSymbol)));
+              todo.push_back(std::make_pair(SPELL_FACT, fact.parent));
+              break;
+          }
+        }
+      }
+
+    }
+  }
+}
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
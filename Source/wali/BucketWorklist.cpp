@@ -0,0 +1,90 @@
+#include "wali/BucketWorklist.hpp"
+
+namespace wali
+{
+  namespace details
+  {
+    RankBuckets::RankBuckets( int max_bucket )
+      : max_bucket(max_bucket)
+      , first(0)
+      , in_buckets(0)
+    {}
+
+    void RankBuckets::put( wfa::ITrans * t, int rank )
+    {
+      if( rank < 0 || rank >= max_bucket ) {
+        overflow.insert(std::make_pair(rank, t));
+        return;
+      }
+
+      size_t index = static_cast<size_t>(rank);
+      if( index >= buckets.size() ) {
+        // Grow geometrically so the buckets are only copied O(log n) times
+        size_t n = buckets.size() * 2;
+        if( n <= index ) {
+          n = index + 1;
+        }
+        if( n > static_cast<size_t>(max_bucket) ) {
+          n = static_cast<size_t>(max_bucket);
+        }
+        buckets.resize(n);
+      }
+      buckets[index].push_back(t);
+      ++in_buckets;
+      if( index < first ) {
+        first = index;
+      }
+    }
+
+    wfa::ITrans * RankBuckets::get()
+    {
+      overflow_t::iterator o = overflow.begin();
+      if( in_buckets == 0 || (o != overflow.end() && o->first < 0) ) {
+        assert(o != overflow.end());
+        wfa::ITrans * t = o->second;
+        overflow.erase(o);
+        return t;
+      }
+
+      while( buckets[first].empty() ) {
+        ++first;
+      }
+      wfa::ITrans * t = buckets[first].back();
+      buckets[first].pop_back();
+      --in_buckets;
+      return t;
+    }
+
+    bool RankBuckets::empty() const
+    {
+      return in_buckets == 0 && overflow.empty();
+    }
+
+    size_t RankBuckets::size() const
+    {
+      return in_buckets + overflow.size();
+    }
+
+    void RankBuckets::clear()
+    {
+      for( size_t i = first ; in_buckets > 0 && i < buckets.size() ; i++ ) {
+        for( size_t j = 0 ; j < buckets[i].size() ; j++ ) {
+          buckets[i][j]->unmark();
+        }
+        in_buckets -= buckets[i].size();
+        buckets[i].clear();
+      }
+      for( overflow_t::iterator o = overflow.begin() ; o != overflow.end() ; o++ ) {
+        o->second->unmark();
+      }
+      overflow.clear();
+      first = 0;
+    }
+  }
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,141 @@
+#ifndef wali_BUCKET_WORKLIST_GUARD
+#define wali_BUCKET_WORKLIST_GUARD 1
+
+#include "wali/Common.hpp"
+#include "wali/Worklist.hpp"
+#include "wali/wfa/Trans.hpp"
+
+#include <map>
+#include <vector>
+
+namespace wali
+{
+  namespace details
+  {
+    /*!
+     * @class RankBuckets
+     *
+     * Transitions kept by an integer rank, smallest rank first (Dial's
+     * bucket queue). Ranks in [0, max_bucket) index straight into a
+     * vector of buckets, and 'first' is a cursor below which every
+     * bucket is empty; get() moves it forward to the next nonempty one.
+     * When ranks come out in increasing order -- as they do for a
+     * saturation whose weights only grow along a path -- each put and
+     * get is O(1) amortized, and nothing is allocated once the buckets
+     * have reached their working size. A put below the cursor just moves
+     * it back, so other orders are still correct.
+     *
+     * Ranks outside [0, max_bucket) (e.g., the rank of an infinite
+     * distance) go to an ordered overflow map instead.
+     */
+    class RankBuckets
+    {
+      public:
+        explicit RankBuckets( int max_bucket );
+
+        void put( wfa::ITrans * t, int rank );
+
+        /// Removes and returns an item of the smallest rank. Must not be
+        /// called when empty.
+        wfa::ITrans * get();
+
+        bool empty() const;
+
+        size_t size() const;
+
+        /// Unmarks every item and empties the buckets
+        void clear();
+
+      private:
+        typedef std::vector< std::vector< wfa::ITrans* > > buckets_t;
+        typedef std::multimap< int, wfa::ITrans* > overflow_t;
+
+        int max_bucket;
+        buckets_t buckets;
+        size_t first;
+        size_t in_buckets;
+        overflow_t overflow;
+    };
+  }
+
+
+  /*!
+   * @class BucketWorklist
+   *
+   * A priority worklist for weights that are small integers, such as
+   * ShortestPathSemiring distances or witness lengths: the same order as
+   * RankedWorklist, without a balanced tree. Rank is a function object
+   * with
+   *
+   *   int operator()( wfa::ITrans const * t ) const
+   *
+   * which is called once, when t is put on the worklist; smaller ranks
+   * come out first. Ranks at or above max_bucket still work, but fall
+   * back to an O(log n) map.
+   *
+   * @see details::RankBuckets
+   */
+  template< typename Rank >
+  class BucketWorklist : public Worklist<wfa::ITrans>
+  {
+    public:
+      enum { DEFAULT_MAX_BUCKET = 1 << 16 };
+
+      explicit BucketWorklist( int max_bucket = DEFAULT_MAX_BUCKET )
+        : Worklist<wfa::ITrans>()
+        , buckets(max_bucket)
+      {}
+
+      virtual ~BucketWorklist()
+      {
+        clear();
+      }
+
+      virtual bool put( wfa::ITrans * t )
+      {
+        if( !t->marked() ) {
+          t->mark();
+          buckets.put(t, rank(t));
+          return true;
+        }
+        else
+          return false;
+      }
+
+      virtual wfa::ITrans * get()
+      {
+        wfa::ITrans * t = buckets.get();
+        t->unmark();
+        return t;
+      }
+
+      virtual bool empty() const
+      {
+        return buckets.empty();
+      }
+
+      virtual void clear()
+      {
+        buckets.clear();
+      }
+
+      virtual size_t size() const
+      {
+        return buckets.size();
+      }
+
+    private:
+      Rank rank;
+      details::RankBuckets buckets;
+
+  }; // class BucketWorklist
+
+} // namespace wali
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif  // wali_BUCKET_WORKLIST_GUARD
@@ -11,6 +11,7 @@
 #endif
 
 #include <climits> // ULONG_MAX
+#include <cmath>
 #include <utility>  // std::pair
 #include <functional>
 #include <iostream>
@@ -20,8 +21,10 @@
 
 
 /*
- * TODO??:  make erase shrink the number of buckets
  * TODO??:  make GROWTH|HASHMAP_SHRINK_FRACTION member vars vs. static
+ *
+ * See also wali/OpenHashMap.hpp, an open-addressing map with the same
+ * interface.
  */
 
 namespace wali
@@ -238,17 +241,23 @@ namespace wali
 
         public:     // con/destructor
           HashMap( size_type the_size=47 )
-            : numValues(0),numBuckets(the_size), 
-              growthFactor( static_cast<double>(the_size) * HASHMAP_GROWTH_FRACTION ), 
-              shrinkFactor( static_cast<double>(the_size) * HASHMAP_SHRINK_FRACTION )
+            : numValues(0),numBuckets(the_size),minBuckets(the_size),
+              growthFactor( fractionOf(the_size,HASHMAP_GROWTH_FRACTION) ),
+              shrinkFactor( fractionOf(the_size,HASHMAP_SHRINK_FRACTION) )
         { initBuckets(); }
 
           HashMap( const HashMap& hm )
+            : numValues(0),numBuckets(hm.minBuckets),minBuckets(hm.minBuckets),
+              growthFactor( fractionOf(hm.minBuckets,HASHMAP_GROWTH_FRACTION) ),
+              shrinkFactor( fractionOf(hm.minBuckets,HASHMAP_SHRINK_FRACTION) )
           {
+            initBuckets();
             operator=(hm);
           }
 
           HashMap& operator=( const HashMap& hm ) {
+            if( this == &hm )
+              return *this;
             clear();
             for( const_iterator it = hm.begin() ; it != hm.end() ; it++ ) {
               insert(key(it),value(it));
@@ -455,13 +464,21 @@ namespace wali
 
         private:    // methods
           void resize( size_type the_size );
+          void rehash( size_type new_size );
+
+          /// fraction * n, rounded up, so that an integer count is below
+          /// it exactly when it is below the real product
+          static size_type fractionOf( size_type n, double fraction ) {
+            return static_cast<size_type>(std::ceil(static_cast<double>(n) * fraction));
+          }
 
         private:    // variables
           bucket_type **buckets;
           size_type numValues;
           size_type numBuckets;
-          double growthFactor;
-          double shrinkFactor;
+          size_type minBuckets;
+          size_type growthFactor;
+          size_type shrinkFactor;
           HashFunc hashFunc;
           EqualFunc equalFunc;
       };
@@ -533,6 +550,12 @@ namespace wali
               }
             }
           }
+
+          // Shrink once the table is mostly empty, but never below the
+          // size it was created with. Halving leaves the load well under
+          // the growth fraction, so insert/erase cannot thrash.
+          if( numBuckets / 2 >= minBuckets && numValues < shrinkFactor )
+            rehash( numBuckets / 2 );
         }
       }
 
@@ -569,7 +592,15 @@ namespace wali
         size_type new_size = numBuckets * 2;
         if( new_size >= SIZE_TYPE_MAX )
           return;
+        rehash( new_size );
+      }
 
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc >
+      void HashMap<Key,Data,HashFunc,EqualFunc>::rehash( size_type new_size )
+      {
 #ifdef DBGHASHMAP
         printf("DBG HashMap : Resizing to %lu buckets\n",new_size);
 #endif
@@ -609,8 +640,8 @@ namespace wali
         buckets = tmp;
         numBuckets = new_size;
         // set up new growth|shrink factors
-        growthFactor = static_cast<double>(numBuckets) * HASHMAP_GROWTH_FRACTION;
-        shrinkFactor = static_cast<double>(numBuckets) * HASHMAP_SHRINK_FRACTION;
+        growthFactor = fractionOf(numBuckets,HASHMAP_GROWTH_FRACTION);
+        shrinkFactor = fractionOf(numBuckets,HASHMAP_SHRINK_FRACTION);
       }
 
 } // namespace wali
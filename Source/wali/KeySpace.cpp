@@ -5,7 +5,9 @@
 
 #include <sstream>
 #include <cassert>
+#include <cstdlib>
 #include <cstring>
+#include <typeinfo>
 #include "wali/Common.hpp"
 #include "wali/KeySpace.hpp"
 #include "wali/KeySource.hpp"
@@ -17,12 +19,121 @@
 namespace wali
 {
 
-  KeySpace::KeySpace()
+  KeySpace::KeySpace() :
+    next(0)
   {
   }
 
   KeySpace::~KeySpace()
   {
+    clear();
+  }
+
+  KeySpace::Shard & KeySpace::shardFor( size_t hash )
+  {
+    // HashMap buckets use the low bits of the hash, so mix in higher ones
+    return shards[(hash ^ (hash >> 16)) % NUM_SHARDS];
+  }
+
+  Key KeySpace::allocate( key_src_t ks )
+  {
+    Key key = next.fetch_add(1);
+    size_t c = key >> CHUNK_BITS;
+    if( c >= MAX_CHUNKS ) {
+      *waliErr << "[ERROR] Ran out of wali::Keys\n";
+      assert(0);
+      abort();
+    }
+
+    slot_t * chunk = values[c].load();
+    if( 0 == chunk ) {
+      // Several threads may race to allocate the chunk; the losers
+      // throw theirs away and use the winner's.
+      slot_t * fresh = new slot_t[CHUNK_SIZE];
+      if( values[c].compare_exchange_strong(chunk, fresh) ) {
+        chunk = fresh;
+      }
+      else {
+        delete [] fresh;
+      }
+    }
+    chunk[key & (CHUNK_SIZE - 1)].store(ks.get_ptr());
+    return key;
+  }
+
+  size_t KeySpace::StringRefHash::operator()( StringRef const & s ) const
+  {
+    // djb2, as for hm_hash< const char * >, but over all s.size bytes
+    unsigned long hash = 5381;
+    for( size_t i = 0 ; i < s.size ; ++i ) {
+      hash = ((hash << 5) + hash) + static_cast<unsigned char>(s.data[i]);
+    }
+    return hash;
+  }
+
+  bool KeySpace::StringRefEqual::operator()( StringRef const & lhs, StringRef const & rhs ) const
+  {
+    return lhs.size == rhs.size && 0 == memcmp(lhs.data, rhs.data, lhs.size);
+  }
+
+  Key KeySpace::getStringKey( StringRef s, key_src_t ks )
+  {
+    StringRefHash hasher;
+    Shard & shard = shardFor(hasher(s));
+    util::LockGuard guard(shard.lock);
+
+    str_hash_map_t::iterator it = shard.strings.find(s);
+    if( it != shard.strings.end() ) {
+      return it->second;
+    }
+    if( !ks.is_valid() ) {
+      ks = new StringSource(std::string(s.data, s.size));
+    }
+    Key key = allocate(ks);
+    shard.sources.push_back(ks);
+    // Key the map by the source's copy of the string, which lives as long
+    // as the source does
+    StringSource * src = static_cast<StringSource*>(ks.get_ptr());
+    shard.strings.insert(StringRef(src->c_str(), src->size()), key);
+    return key;
+  }
+
+  Key KeySpace::getIntKey( int i, key_src_t ks )
+  {
+    hm_hash< int > hasher;
+    Shard & shard = shardFor(hasher(i));
+    util::LockGuard guard(shard.lock);
+
+    int_hash_map_t::iterator it = shard.ints.find(i);
+    if( it != shard.ints.end() ) {
+      return it->second;
+    }
+    if( !ks.is_valid() ) {
+      ks = new IntSource(i);
+    }
+    Key key = allocate(ks);
+    shard.sources.push_back(ks);
+    shard.ints.insert(i, key);
+    return key;
+  }
+
+  Key KeySpace::getPairKey( KeyPair const & kp, key_src_t ks )
+  {
+    hm_hash< KeyPair > hasher;
+    Shard & shard = shardFor(hasher(kp));
+    util::LockGuard guard(shard.lock);
+
+    pair_hash_map_t::iterator it = shard.pairs.find(kp);
+    if( it != shard.pairs.end() ) {
+      return it->second;
+    }
+    if( !ks.is_valid() ) {
+      ks = new KeyPairSource(kp.first, kp.second);
+    }
+    Key key = allocate(ks);
+    shard.sources.push_back(ks);
+    shard.pairs.insert(kp, key);
+    return key;
   }
 
   /**
@@ -38,16 +149,32 @@ namespace wali
    */
   wali_key_t KeySpace::getKey( key_src_t ks )
   {
-    ks_hash_map_t::iterator it = keymap.find(ks);
+    // Sources of the types with their own tables must go to those tables
+    // so that, e.g., getKey(new StringSource("a")) == getKey("a").
+    std::type_info const & type = typeid(*ks);
+    if( type == typeid(StringSource) ) {
+      StringSource * src = static_cast<StringSource*>(ks.get_ptr());
+      return getStringKey(StringRef(src->c_str(), src->size()), ks);
+    }
+    else if( type == typeid(IntSource) ) {
+      return getIntKey(static_cast<IntSource*>(ks.get_ptr())->getInt(), ks);
+    }
+    else if( type == typeid(KeyPairSource) ) {
+      return getPairKey(static_cast<KeyPairSource*>(ks.get_ptr())->get_key_pair(), ks);
+    }
+
+    Shard & shard = shardFor(ks->hash());
+    util::LockGuard guard(shard.lock);
+
+    ks_hash_map_t::iterator it = shard.keymap.find(ks);
     wali_key_t key;
-    if( it != keymap.end() )
+    if( it != shard.keymap.end() )
     {
       key = it->second;
     }
     else {
-      key = values.size();
-      keymap.insert(ks,key);
-      values.push_back(ks);
+      key = allocate(ks);
+      shard.keymap.insert(ks,key);
     }
     return key;
   }
@@ -58,7 +185,7 @@ namespace wali
    */
   Key KeySpace::getKey( const std::string& s )
   {
-    return (s == "") ? WALI_EPSILON : getKey( new StringSource(s) );
+    return (s == "") ? WALI_EPSILON : getStringKey( StringRef(s.data(), s.size()), 0 );
   }
 
   /**
@@ -67,8 +194,8 @@ namespace wali
    */
   Key KeySpace::getKey( const char* s )
   {
-    return ((s == NULL) || (strlen(s) == 0)) ?
-      WALI_EPSILON : getKey( new StringSource(s) );
+    return ((s == NULL) || (*s == '\0')) ?
+      WALI_EPSILON : getStringKey( StringRef(s, strlen(s)), 0 );
   }
 
   /**
@@ -77,7 +204,7 @@ namespace wali
    */
   Key KeySpace::getKey( int i )
   {
-    return getKey( new IntSource(i) );
+    return getIntKey( i, 0 );
   }
 
   /**
@@ -86,7 +213,7 @@ namespace wali
    */
   Key KeySpace::getKey( Key k1, Key k2 )
   {
-    return getKey( new KeyPairSource(k1,k2) );
+    return getPairKey( KeyPair(k1,k2), 0 );
   }
 
   // @author Amanda Burton  
@@ -112,7 +239,12 @@ namespace wali
     key_src_t ksrc = 0;
     if( key < size() )
     {
-      ksrc = values[key];
+      // The chunk or the entry may still be NULL if another thread is in
+      // the middle of allocating this key
+      slot_t * chunk = values[key >> CHUNK_BITS].load();
+      if( chunk != 0 ) {
+        ksrc = chunk[key & (CHUNK_SIZE - 1)].load();
+      }
     }
     return ksrc;
   }
@@ -123,13 +255,24 @@ namespace wali
    */
   void KeySpace::clear()
   {
-    keymap.clear();
-    {
-      ks_vector_t TEMP;
-      TEMP.swap(values);
+    for( size_t i = 0 ; i < NUM_SHARDS ; ++i ) {
+      Shard & shard = shards[i];
+      shard.keymap.clear();
+      shard.strings.clear();
+      shard.ints.clear();
+      shard.pairs.clear();
+      {
+        std::vector< key_src_t > TEMP;
+        TEMP.swap(shard.sources);
+      }
+      assert( shard.keymap.size() == 0 );
+      assert( shard.strings.size() == 0 );
+    }
+    for( size_t c = 0 ; c < MAX_CHUNKS ; ++c ) {
+      delete [] values[c].load();
+      values[c].store(0);
     }
-    assert( keymap.size() == 0 );
-    assert( values.size() == 0 );
+    next.store(0);
   }
 
   /**
@@ -137,7 +280,7 @@ namespace wali
    */
   size_t KeySpace::size()
   {
-    return values.size();
+    return next.load();
   }
 
   /**
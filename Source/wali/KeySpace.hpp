@@ -6,14 +6,29 @@
  */
 
 #include "wali/Common.hpp"
-#include "wali/HashMap.hpp"
+#include "wali/OpenHashMap.hpp"
+#include "wali/KeyContainer.hpp"
 #include "wali/KeySource.hpp"   //! defines hm_hash<wali::KeySource*>
+#include "wali/util/Threads.hpp"
 #include <vector>
 
 namespace wali
 {
   /**
    * @class KeySpace
+   *
+   * The KeySpace may be used from several threads at once (when WALi is
+   * built with threads=1), except for clear().
+   *
+   * The source -> key direction is split into NUM_SHARDS independently
+   * locked shards. Strings, ints, and key pairs have their own tables in
+   * each shard, so looking them up hashes the raw value and does not
+   * allocate a KeySource unless the key is new. Sources of any other type
+   * (and those passed in directly through getKey(key_src_t)) go through
+   * a general table of key_src_t.
+   *
+   * The key -> source direction is a table that is never moved once
+   * allocated, so getKeySource, printKey, and key2str take no locks.
    */
   class KeySpace
   {
@@ -74,7 +89,8 @@ namespace wali
 
     /**
      * Reset the KeySpace. Clears all keys and deletes
-     * all KeySources
+     * all KeySources. Must not run concurrently with anything
+     * else that uses the KeySpace.
      */
     void clear();
 
@@ -110,22 +126,85 @@ namespace wali
     std::string key2str( wali::Key key );
 
   protected:
-    typedef wali::HashMap< key_src_t, wali::Key > ks_hash_map_t;
-    typedef std::vector< key_src_t > ks_vector_t;
+    /// A string that may contain NULs, owned by a StringSource (or, for
+    /// lookups, by the caller)
+    struct StringRef
+    {
+      StringRef() : data(0), size(0) {}
+      StringRef( const char * data, size_t size ) : data(data), size(size) {}
+
+      const char * data;
+      size_t size;
+    };
+
+    struct StringRefHash
+    {
+      size_t operator()( StringRef const & s ) const;
+    };
+
+    struct StringRefEqual
+    {
+      bool operator()( StringRef const & lhs, StringRef const & rhs ) const;
+    };
+
+    typedef wali::HotHashMap< key_src_t, wali::Key >::type ks_hash_map_t;
+    /// The strings are owned by the StringSources in 'values'
+    typedef wali::HotHashMap< StringRef, wali::Key, StringRefHash, StringRefEqual >::type str_hash_map_t;
+    typedef wali::HotHashMap< int, wali::Key >::type int_hash_map_t;
+    typedef wali::HotHashMap< KeyPair, wali::Key >::type pair_hash_map_t;
 
-    /** 
-     * keymap maps key_src_t to wali::Key. The wali::Key is
-     * an index into the vector values
+    /**
+     * A slice of the source -> key mapping. A source lives in the shard
+     * picked by shardFor(hash of the source).
      */
-    ks_hash_map_t keymap;
+    struct Shard
+    {
+      util::Mutex lock;
+      ks_hash_map_t keymap;
+      str_hash_map_t strings;
+      int_hash_map_t ints;
+      pair_hash_map_t pairs;
+      /// Keeps every KeySource of this shard alive
+      std::vector< key_src_t > sources;
+    };
+
+    static const size_t NUM_SHARDS = 64;
+
+    /// wali::Key -> KeySource is stored in chunks of CHUNK_SIZE entries
+    static const size_t CHUNK_BITS = 12;
+    static const size_t CHUNK_SIZE = static_cast<size_t>(1) << CHUNK_BITS;
+    static const size_t MAX_CHUNKS = static_cast<size_t>(1) << 16;
+
+    typedef util::Atomic< KeySource * > slot_t;
+
+    Shard & shardFor( size_t hash );
+
+    /// Allocates the next key for 'ks' and makes it visible to
+    /// getKeySource. Must be called with the lock of ks's shard held.
+    wali::Key allocate( key_src_t ks );
+
+    /// The typed lookups. If the key is new, 'ks' becomes its source;
+    /// if 'ks' is NULL, a source is only allocated in that case.
+    wali::Key getStringKey( StringRef s, key_src_t ks );
+    wali::Key getIntKey( int i, key_src_t ks );
+    wali::Key getPairKey( KeyPair const & kp, key_src_t ks );
+
+    Shard shards[NUM_SHARDS];
 
     /**
      * wali::Key's are guaranteed to be unique w.r.t. this KeySpace
-     * because they are indexes into the vector values. KeySource's
-     * are retrieved by a lookup into values
+     * because they are indexes into values. values[k >> CHUNK_BITS] is a
+     * chunk; once allocated, chunks never move, so readers can find a
+     * KeySource without locking.
      */
-    ks_vector_t values;
+    util::Atomic< slot_t * > values[MAX_CHUNKS];
+
+    /// The next key to hand out, and so the number of keys
+    util::Atomic< size_t > next;
 
+  private:
+    KeySpace( KeySpace const & );
+    KeySpace & operator=( KeySpace const & );
   }; // class KeySpace
 
 } // namespace wali
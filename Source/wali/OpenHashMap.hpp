@@ -0,0 +1,647 @@
+#ifndef wali_OPEN_HASH_MAP_GUARD
+#define wali_OPEN_HASH_MAP_GUARD 1
+
+/*
+ * An open-addressing counterpart to wali::HashMap.
+ *
+ * HashMap chains its buckets, so every insert allocates a node and every
+ * find chases pointers through the chain. OpenHashMap instead keeps a
+ * single power-of-two array of slots and resolves collisions with Robin
+ * Hood linear probing: an element may displace one that is closer to its
+ * home slot, which keeps probe sequences short and lets an unsuccessful
+ * find stop early. Each slot stores the element's (mixed) hash, so most
+ * probes never touch the key.
+ *
+ * The elements themselves live in nodes that never move once created,
+ * which WALi depends on -- for instance, the saturation procedures hold a
+ * reference to a WFA::kpmap entry while inserting new transitions. Nodes
+ * are carved out of blocks owned by the map and recycled through a free
+ * list, so inserting does not call operator new per element.
+ *
+ * As with std::unordered_map, references to elements stay valid until the
+ * element is erased, but insert and erase invalidate iterators.
+ *
+ * The interface is the one of HashMap, so the two can be swapped via
+ * HotHashMap below.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "wali/hm_hash.hpp"
+#include "wali/HashMap.hpp"
+
+#define OPENHASHMAP_GROWTH_FRACTION 0.8
+#define OPENHASHMAP_SHRINK_FRACTION 0.2
+
+namespace wali
+{
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc > class OpenHashMap;
+
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc > class OpenHashMapConstIterator;
+
+  /**
+   * Iterates over the slots of an OpenHashMap, skipping empty ones.
+   */
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc >
+      class OpenHashMapIterator
+      {
+        public:
+          friend class OpenHashMap< Key,Data,HashFunc,EqualFunc >;
+          friend class OpenHashMapConstIterator< Key,Data,HashFunc,EqualFunc >;
+
+          typedef OpenHashMap< Key,Data,HashFunc,EqualFunc > hashmap_type;
+          typedef std::pair< Key,Data >                      value_type;
+          typedef size_t                                     size_type;
+
+          OpenHashMapIterator() : slot(0),hashMap(0) {}
+
+          OpenHashMapIterator( size_type s,hashmap_type *hmap )
+            : slot(s),hashMap(hmap) {}
+
+          inline value_type *operator->() const
+          {
+            return hashMap->slots[slot].node;
+          }
+
+          inline value_type& operator*() const
+          {
+            return *(hashMap->slots[slot].node);
+          }
+
+          inline bool operator==( const OpenHashMapIterator& right ) const
+          {
+            return right.slot == slot && right.hashMap == hashMap;
+          }
+
+          inline bool operator!=( const OpenHashMapIterator& right ) const
+          {
+            return !(*this == right);
+          }
+
+          inline OpenHashMapIterator& operator++()
+          {
+            slot = hashMap->nextOccupied( slot+1 );
+            return *this;
+          }
+
+          OpenHashMapIterator operator++( int )
+          {
+            OpenHashMapIterator old = *this;
+            ++(*this);
+            return old;
+          }
+
+        protected:
+          size_type     slot;
+          hashmap_type *hashMap;
+      };
+
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc >
+      class OpenHashMapConstIterator
+      {
+        public:
+          friend class OpenHashMap< Key,Data,HashFunc,EqualFunc >;
+
+          typedef OpenHashMap< Key,Data,HashFunc,EqualFunc >         hashmap_type;
+          typedef OpenHashMapIterator< Key,Data,HashFunc,EqualFunc > iterator;
+          typedef std::pair< Key,Data >                              value_type;
+          typedef size_t                                             size_type;
+
+          OpenHashMapConstIterator() : slot(0),hashMap(0) {}
+
+          OpenHashMapConstIterator( size_type s,const hashmap_type *hmap )
+            : slot(s),hashMap(hmap) {}
+
+          OpenHashMapConstIterator( const iterator& it )
+            : slot(it.slot),hashMap(it.hashMap) {}
+
+          inline const value_type *operator->() const
+          {
+            return hashMap->slots[slot].node;
+          }
+
+          inline const value_type& operator*() const
+          {
+            return *(hashMap->slots[slot].node);
+          }
+
+          inline bool operator==( const OpenHashMapConstIterator& right ) const
+          {
+            return right.slot == slot && right.hashMap == hashMap;
+          }
+
+          inline bool operator!=( const OpenHashMapConstIterator& right ) const
+          {
+            return !(*this == right);
+          }
+
+          inline OpenHashMapConstIterator& operator++()
+          {
+            slot = hashMap->nextOccupied( slot+1 );
+            return *this;
+          }
+
+          OpenHashMapConstIterator operator++( int )
+          {
+            OpenHashMapConstIterator old = *this;
+            ++(*this);
+            return old;
+          }
+
+        protected:
+          size_type           slot;
+          const hashmap_type *hashMap;
+      };
+
+
+  /**
+   * class OpenHashMap
+   *
+   * A drop-in replacement for HashMap; see the comment at the top of
+   * this file.
+   */
+  template< typename Key,
+    typename Data,
+    typename HashFunc = hm_hash< Key >,
+    typename EqualFunc = hm_equal< Key > >
+      class OpenHashMap
+      {
+        public:     // typedef
+          typedef OpenHashMapIterator< Key,Data,HashFunc,EqualFunc >      iterator;
+          typedef OpenHashMapConstIterator< Key,Data,HashFunc,EqualFunc > const_iterator;
+          typedef OpenHashMap< Key,Data,HashFunc,EqualFunc >              hashmap_type;
+          typedef std::pair< Key,Data >                                   pair_type;
+          typedef pair_type                                               value_type;
+          typedef size_t                                                  size_type;
+
+          typedef Key   key_type;
+          typedef Data  mapped_type;
+
+          friend class OpenHashMapIterator<Key,Data,HashFunc,EqualFunc>;
+          friend class OpenHashMapConstIterator<Key,Data,HashFunc,EqualFunc>;
+
+        public:     // con/destructor
+          OpenHashMap( size_type the_size=47 )
+            : slots(0),numValues(0),numSlots(0),minSlots(0),freeList(0),
+              nextBlockSize(16)
+          {
+            minSlots = slotsFor( the_size );
+            initSlots( minSlots );
+          }
+
+          OpenHashMap( const OpenHashMap& hm )
+            : slots(0),numValues(0),numSlots(0),minSlots(hm.minSlots),
+              freeList(0),nextBlockSize(16)
+          {
+            initSlots( std::max( minSlots,slotsFor( hm.size() ) ) );
+            for( const_iterator it = hm.begin() ; it != hm.end() ; it++ ) {
+              insert( *it );
+            }
+          }
+
+          OpenHashMap& operator=( const OpenHashMap& hm )
+          {
+            if( this != &hm ) {
+              clear();
+              for( const_iterator it = hm.begin() ; it != hm.end() ; it++ ) {
+                insert( *it );
+              }
+            }
+            return *this;
+          }
+
+          ~OpenHashMap()
+          {
+            clear();
+            releaseBlocks();
+            delete[] slots;
+          }
+
+        public:        // inline methods
+          void clear()
+          {
+            for( size_type i = 0 ; i < numSlots ; i++ ) {
+              if( slots[i].node ) {
+                releaseNode( slots[i].node );
+                slots[i].node = 0;
+              }
+            }
+            numValues = 0;
+            if( numSlots != minSlots ) {
+              delete[] slots;
+              initSlots( minSlots );
+            }
+          }
+
+          inline size_type size() const
+          {
+            return numValues;
+          }
+
+          inline size_type capacity() const
+          {
+            return numSlots;
+          }
+
+          inline std::pair<iterator,bool> insert( const Key& k, const Data& d )
+          {
+            return insert( pair_type(k,d) );
+          }
+
+          void erase( const Key& key_to_erase )
+          {
+            iterator it = find( key_to_erase );
+            if( it != end() )
+              erase( it );
+          }
+
+          inline iterator begin()
+          {
+            return iterator( nextOccupied(0),this );
+          }
+
+          inline iterator end()
+          {
+            return iterator( numSlots,this );
+          }
+
+          inline const_iterator begin() const
+          {
+            return const_iterator( nextOccupied(0),this );
+          }
+
+          inline const_iterator end() const
+          {
+            return const_iterator( numSlots,this );
+          }
+
+          Key & key( iterator & it )
+          {
+            return it->first;
+          }
+
+          const Key & key( const_iterator & it ) const
+          {
+            return it->first;
+          }
+
+          Data & value( iterator & it )
+          {
+            return it->second;
+          }
+
+          const Data & value( const_iterator & it ) const
+          {
+            return it->second;
+          }
+
+          Data & data( iterator & it )
+          {
+            return it->second;
+          }
+
+          const Data & data( const_iterator & it ) const
+          {
+            return it->second;
+          }
+
+          void print_stats( std::ostream & o = std::cout ) const
+          {
+            size_type total_dist = 0;
+            size_type max_dist = 0;
+            for( size_type i = 0 ; i < numSlots ; i++ ) {
+              if( slots[i].node ) {
+                size_type d = distance( slots[i].hash,i );
+                total_dist += d;
+                if( d > max_dist )
+                  max_dist = d;
+              }
+            }
+            o << "Stats:\n";
+            o << "\tNumber of Values   : " << numValues << std::endl;
+            o << "\tNumber of Slots    : " << numSlots << std::endl;
+            o << "\tAverage probe dist : "
+              << (numValues ? static_cast<double>(total_dist) / static_cast<double>(numValues) : 0.0)
+              << std::endl;
+            o << "\tMax probe dist     : " << max_dist << std::endl;
+          }
+
+        public:        // methods
+          std::pair<iterator,bool> insert( const value_type& );
+          iterator find( const Key& );
+          const_iterator find( const Key& ) const;
+          void erase( iterator it );
+          Data & operator[](const Key & k) {
+            return (*((insert(value_type(k, Data()))).first)).second;
+          }
+
+        private:    // types
+          struct Slot
+          {
+            size_type   hash;
+            value_type *node;    // 0 iff the slot is empty
+          };
+
+          /// A released node's storage holds the next free node
+          struct FreeNode
+          {
+            FreeNode *next;
+          };
+
+        private:    // inline methods
+          /// The table is indexed by the low bits of the hash, so HashFunc
+          /// must mix well; the hm_hash specializations all do.
+          inline size_type hashOf( const Key& k ) const
+          {
+            return hashFunc(k);
+          }
+
+          inline size_type home( size_type hash ) const
+          {
+            return hash & (numSlots-1);
+          }
+
+          inline size_type distance( size_type hash,size_type slot ) const
+          {
+            return (slot + numSlots - home(hash)) & (numSlots-1);
+          }
+
+          size_type nextOccupied( size_type slot ) const
+          {
+            while( slot < numSlots && !slots[slot].node )
+              slot++;
+            return slot;
+          }
+
+          /// The smallest power of two that holds n elements without
+          /// exceeding the growth fraction
+          static size_type slotsFor( size_type n )
+          {
+            size_type s = 8;
+            while( static_cast<double>(s) * OPENHASHMAP_GROWTH_FRACTION
+                   < static_cast<double>(n) )
+              s *= 2;
+            return s;
+          }
+
+          void initSlots( size_type n )
+          {
+            slots = new Slot[n];
+            for( size_type i = 0 ; i < n ; i++ ) {
+              slots[i].hash = 0;
+              slots[i].node = 0;
+            }
+            numSlots = n;
+          }
+
+          /************ Node storage *************************/
+          value_type *allocNode( const value_type& v )
+          {
+            if( !freeList ) {
+              // Round up so that each node is suitably aligned for both
+              // a value_type and a FreeNode.
+              size_type nodeSize = (sizeof(value_type) + sizeof(FreeNode) - 1)
+                / sizeof(FreeNode) * sizeof(FreeNode);
+              char *block = static_cast<char*>(
+                  ::operator new( nodeSize * nextBlockSize ));
+              blocks.push_back( block );
+              // Thread the new nodes onto the free list back to front so
+              // they are handed out in address order.
+              for( size_type i = nextBlockSize ; i > 0 ; i-- ) {
+                FreeNode *f = reinterpret_cast<FreeNode*>( block + nodeSize*(i-1) );
+                f->next = freeList;
+                freeList = f;
+              }
+              if( nextBlockSize < 4096 )
+                nextBlockSize *= 2;
+            }
+            FreeNode *f = freeList;
+            freeList = f->next;
+            return new (static_cast<void*>(f)) value_type( v );
+          }
+
+          void releaseNode( value_type *node )
+          {
+            node->~value_type();
+            FreeNode *f = reinterpret_cast<FreeNode*>( node );
+            f->next = freeList;
+            freeList = f;
+          }
+
+          void releaseBlocks()
+          {
+            for( size_type i = 0 ; i < blocks.size() ; i++ ) {
+              ::operator delete( blocks[i] );
+            }
+            blocks.clear();
+            freeList = 0;
+            nextBlockSize = 16;
+          }
+
+        private:    // methods
+          size_type place( size_type hash,value_type *node );
+          void rehash( size_type new_size );
+
+        private:    // variables
+          Slot *slots;
+          size_type numValues;
+          size_type numSlots;
+          size_type minSlots;
+          std::vector< char* > blocks;
+          FreeNode *freeList;
+          size_type nextBlockSize;
+          HashFunc hashFunc;
+          EqualFunc equalFunc;
+      };
+
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc >
+      OpenHashMapIterator< Key,Data,HashFunc,EqualFunc >
+      OpenHashMap< Key,Data,HashFunc,EqualFunc >::find( const Key& the_key )
+      {
+        size_type hash = hashOf( the_key );
+        size_type slot = home( hash );
+        for( size_type dist = 0 ; slots[slot].node ; dist++ ) {
+          // Robin Hood invariant: once we pass an element that is closer
+          // to its home than we are to ours, the key is not present.
+          if( distance( slots[slot].hash,slot ) < dist )
+            break;
+          if( slots[slot].hash == hash && equalFunc( the_key,slots[slot].node->first ) )
+            return iterator( slot,this );
+          slot = (slot+1) & (numSlots-1);
+        }
+        return end();
+      }
+
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc >
+      OpenHashMapConstIterator< Key,Data,HashFunc,EqualFunc >
+      OpenHashMap< Key,Data,HashFunc,EqualFunc >::find( const Key& the_key ) const
+      {
+        size_type hash = hashOf( the_key );
+        size_type slot = home( hash );
+        for( size_type dist = 0 ; slots[slot].node ; dist++ ) {
+          if( distance( slots[slot].hash,slot ) < dist )
+            break;
+          if( slots[slot].hash == hash && equalFunc( the_key,slots[slot].node->first ) )
+            return const_iterator( slot,this );
+          slot = (slot+1) & (numSlots-1);
+        }
+        return end();
+      }
+
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc >
+      std::pair< OpenHashMapIterator< Key,Data,HashFunc,EqualFunc >,bool >
+      OpenHashMap< Key,Data,HashFunc,EqualFunc >::insert( const value_type& the_value )
+      {
+        typedef std::pair< iterator,bool > RPair;
+        iterator it = find( the_value.first );
+        if( it != end() )
+          return RPair( it,false );
+
+        if( static_cast<double>(numValues+1) >
+            static_cast<double>(numSlots) * OPENHASHMAP_GROWTH_FRACTION )
+          rehash( numSlots*2 );
+
+        value_type *node = allocNode( the_value );
+        size_type slot = place( hashOf( the_value.first ),node );
+        numValues++;
+        return RPair( iterator( slot,this ),true );
+      }
+
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc >
+      void OpenHashMap< Key,Data,HashFunc,EqualFunc >::erase(
+          typename OpenHashMap< Key,Data,HashFunc,EqualFunc >::iterator it )
+      {
+        if( it.hashMap != this || it.slot >= numSlots || !slots[it.slot].node )
+          return;
+
+        releaseNode( slots[it.slot].node );
+        numValues--;
+
+        // Backward-shift deletion: pull each following element that is
+        // not in its home slot back by one, so no tombstones are needed.
+        size_type hole = it.slot;
+        size_type next = (hole+1) & (numSlots-1);
+        while( slots[next].node && distance( slots[next].hash,next ) > 0 ) {
+          slots[hole] = slots[next];
+          hole = next;
+          next = (next+1) & (numSlots-1);
+        }
+        slots[hole].hash = 0;
+        slots[hole].node = 0;
+
+        if( numSlots > minSlots &&
+            static_cast<double>(numValues) <
+            static_cast<double>(numSlots) * OPENHASHMAP_SHRINK_FRACTION )
+          rehash( numSlots/2 );
+      }
+
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc >
+      typename OpenHashMap< Key,Data,HashFunc,EqualFunc >::size_type
+      OpenHashMap< Key,Data,HashFunc,EqualFunc >::place(
+          size_type hash,value_type *node )
+      {
+        // Returns the slot where 'node' (not whatever it displaced) ends up
+        size_type placed = numSlots;
+        size_type slot = home( hash );
+        size_type dist = 0;
+        while( slots[slot].node ) {
+          size_type existing = distance( slots[slot].hash,slot );
+          if( existing < dist ) {
+            // Take from the rich: swap with the element nearer its home
+            // and carry that one forward instead.
+            std::swap( hash,slots[slot].hash );
+            std::swap( node,slots[slot].node );
+            dist = existing;
+            if( placed == numSlots )
+              placed = slot;
+          }
+          slot = (slot+1) & (numSlots-1);
+          dist++;
+        }
+        slots[slot].hash = hash;
+        slots[slot].node = node;
+        return placed == numSlots ? slot : placed;
+      }
+
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc >
+      void OpenHashMap< Key,Data,HashFunc,EqualFunc >::rehash( size_type new_size )
+      {
+#ifdef DBGHASHMAP
+        printf("DBG OpenHashMap : Rehashing to %lu slots\n",new_size);
+#endif
+        Slot *old = slots;
+        size_type oldSize = numSlots;
+        initSlots( new_size );
+        for( size_type i = 0 ; i < oldSize ; i++ ) {
+          if( old[i].node )
+            place( old[i].hash,old[i].node );
+        }
+        delete[] old;
+      }
+
+
+  /**
+   * Picks the map implementation for WALi's hot paths (the WPDS Config
+   * table, the WFA transition and state maps, and the KeySpace): the
+   * open-addressing OpenHashMap when built with 'scons hashmap=open'
+   * (which defines WALI_OPEN_HASHMAP), and the chained HashMap otherwise.
+   *
+   *   typedef HotHashMap< KeyPair,Config* >::type chash_t;
+   */
+  template< typename Key,
+    typename Data,
+    typename HashFunc = hm_hash< Key >,
+    typename EqualFunc = hm_equal< Key > >
+      struct HotHashMap
+      {
+#if defined(WALI_OPEN_HASHMAP) && WALI_OPEN_HASHMAP
+        typedef OpenHashMap< Key,Data,HashFunc,EqualFunc > type;
+#else
+        typedef HashMap< Key,Data,HashFunc,EqualFunc > type;
+#endif
+      };
+
+} // namespace wali
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif  // wali_OPEN_HASH_MAP_GUARD
@@ -5,6 +5,7 @@
 #include "wali/Common.hpp"
 #include "wali/RankedWorklist.hpp"
 #include "wali/witness/Witness.hpp"
+#include "wali/witness/CompactWitness.hpp"
 
 namespace wali
 {
@@ -67,6 +68,10 @@ namespace wali
     if (p != NULL) {
       return doRankOf(p->weight());
     }
+    witness::CompactWitness * c = dynamic_cast<witness::CompactWitness*>(a->weight().get_ptr());
+    if (c != NULL) {
+      return doRankOf(c->weight());
+    }
     else {
       return doRankOf(a->weight());
     }
@@ -92,6 +92,30 @@ namespace wali
     return t.second;
   }
 
+  bool SemElem::hasBatchOperations() const
+  {
+    return false;
+  }
+
+  void SemElem::extendMany( SemElem * const * lhs,
+                            SemElem * const * rhs,
+                            size_t n,
+                            sem_elem_t * out )
+  {
+    for( size_t i = 0 ; i < n ; i++ ) {
+      out[i] = lhs[i]->extend(rhs[i]);
+    }
+  }
+
+  sem_elem_t SemElem::combineMany( SemElem * const * ses, size_t n )
+  {
+    sem_elem_t result = this;
+    for( size_t i = 0 ; i < n ; i++ ) {
+      result = result->combine(ses[i]);
+    }
+    return result;
+  }
+
     
   sem_elem_t SemElem::star() {
     sem_elem_t w = combine(one());
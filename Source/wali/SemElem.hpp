@@ -221,6 +221,33 @@ namespace wali
       extendAndDiff(sem_elem_t next, sem_elem_t subtrahend);
 
 
+      /**
+       *  Batched extend and combine, for solvers that have several
+       *  independent operations ready at once. 'this' only picks the
+       *  implementation; it must be of the same domain as the operands.
+       *
+       *  The defaults just loop over extend and combine. A domain that
+       *  overrides them with something cheaper (sharing allocations or
+       *  per-operand setup) should also make hasBatchOperations return
+       *  true: the solvers only gather operands into batches for such
+       *  domains.
+       */
+      virtual bool hasBatchOperations() const;
+
+      /**
+       *  Sets out[i] to lhs[i] extend rhs[i], for i < n
+       */
+      virtual void extendMany( SemElem * const * lhs,
+                               SemElem * const * rhs,
+                               size_t n,
+                               sem_elem_t * out );
+
+      /**
+       *  Returns this combine ses[0] combine ... combine ses[n-1]
+       */
+      virtual sem_elem_t combineMany( SemElem * const * ses, size_t n );
+
+
 #if defined(_MSC_VER)
 #  pragma warning(push)
 #  pragma warning(disable: 4716) // must return a value
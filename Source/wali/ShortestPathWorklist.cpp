@@ -6,6 +6,8 @@
 #include "wali/ShortestPathWorklist.hpp"
 #include "wali/ShortestPathSemiring.hpp"
 #include "wali/wfa/Trans.hpp"
+#include "wali/witness/Witness.hpp"
+#include "wali/witness/CompactWitness.hpp"
 #include <climits>
 #include <cstdlib>
 #include <iostream>
@@ -21,25 +23,59 @@ namespace wali
   {
   }
 
-  int ShortestPathWorklist::doRankOf( sem_elem_t a ) const
+  namespace
   {
-    ShortestPathSemiring * p = dynamic_cast<ShortestPathSemiring*>(a.get_ptr());
-    if (p == NULL) {
-      std::cout << "Error: weight not a shortestpathsemiring. It is: ";
-      if (a != NULL) {
-        std::cout << typeid(*a).name() << "\n";
+    int distanceRank( sem_elem_t a )
+    {
+      ShortestPathSemiring * p = dynamic_cast<ShortestPathSemiring*>(a.get_ptr());
+      if (p == NULL) {
+        std::cout << "Error: weight not a shortestpathsemiring. It is: ";
+        if (a != NULL) {
+          std::cout << typeid(*a).name() << "\n";
+        }
+        else {
+          std::cout << "null\n";
+        }
+        std::exit(1);
       }
-      else {
-        std::cout << "null\n";
+    
+      unsigned int rank = p->getNum();
+      if (rank > INT_MAX) {
+        rank = INT_MAX;
       }
-      std::exit(1);
+      return rank;
     }
-    
-    unsigned int rank = p->getNum();
-    if (rank > INT_MAX) {
-      rank = INT_MAX;
+  }
+
+  int ShortestPathWorklist::doRankOf( sem_elem_t a ) const
+  {
+    return distanceRank(a);
+  }
+
+
+  int ShortestPathRank::operator()( wfa::ITrans const * t ) const
+  {
+    witness::Witness * w = dynamic_cast<witness::Witness*>(t->weight().get_ptr());
+    if (w != NULL) {
+      return distanceRank(w->weight());
+    }
+    witness::CompactWitness * c = dynamic_cast<witness::CompactWitness*>(t->weight().get_ptr());
+    if (c != NULL) {
+      return distanceRank(c->weight());
+    }
+    else {
+      return distanceRank(t->weight());
     }
-    return rank;
+  }
+
+
+  ShortestPathBucketWorklist::ShortestPathBucketWorklist( int max_bucket )
+    : BucketWorklist<ShortestPathRank>(max_bucket)
+  {
+  }
+
+  ShortestPathBucketWorklist::~ShortestPathBucketWorklist()
+  {
   }
 
 }
@@ -7,6 +7,7 @@
 
 #include "wali/Common.hpp"
 #include "wali/RankedWorklist.hpp"
+#include "wali/BucketWorklist.hpp"
 
 namespace wali
 {
@@ -23,6 +24,31 @@ namespace wali
 
   }; // class PriorityWorklist
 
+
+  /*!
+   * Ranks a transition by its ShortestPathSemiring distance (the
+   * distance of its witness's weight, if it has one), clamped to
+   * INT_MAX.
+   */
+  struct ShortestPathRank
+  {
+    int operator()( wfa::ITrans const * t ) const;
+  };
+
+  /*!
+   * The order of ShortestPathWorklist, kept in buckets by distance
+   * instead of in a multimap.
+   *
+   * @see BucketWorklist
+   */
+  class ShortestPathBucketWorklist : public BucketWorklist<ShortestPathRank>
+  {
+    public:
+      explicit ShortestPathBucketWorklist( int max_bucket = DEFAULT_MAX_BUCKET );
+      virtual ~ShortestPathBucketWorklist();
+
+  }; // class ShortestPathBucketWorklist
+
 } // namespace wali
 
 #endif  // wali_SHORTEST_PATH_WORKLIST_GUARD
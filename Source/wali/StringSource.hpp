@@ -31,6 +31,12 @@ namespace wali
 
       std::string getString() const;
 
+      /// The string itself, without a copy. Valid as long as this is.
+      const char* c_str() const { return s.c_str(); }
+
+      /// The length of the string, which may contain NULs
+      size_t size() const { return s.size(); }
+
     private:
       const std::string s;
   };
@@ -0,0 +1,145 @@
+#include "wali/WeightInterner.hpp"
+
+namespace wali
+{
+  WeightInterner::WeightInterner( size_t the_element_bytes )
+    : element_bytes(the_element_bytes)
+    , num_lookups(0)
+    , num_hits(0)
+    , num_copies(0)
+  {
+  }
+
+  WeightInterner::~WeightInterner()
+  {
+    // Weights that outlive the table must not claim to be canonical
+    disown();
+  }
+
+  sem_elem_t WeightInterner::intern( sem_elem_t w )
+  {
+    return intern(w, 0);
+  }
+
+  sem_elem_t WeightInterner::intern( sem_elem_t w, sem_elem_t (*wrap)( SemElem * ) )
+  {
+    if( w == NULL ) {
+      return w;
+    }
+    util::LockGuard guard(lock);
+    ++num_lookups;
+    table_t::iterator it = table.find(w);
+    if( it != table.end() ) {
+      ++num_hits;
+      return *it;
+    }
+    if( wrap != 0 ) {
+      w = wrap(w.get_ptr());
+      ++num_copies;
+    }
+    table.insert(w);
+    Interned * in = dynamic_cast<Interned*>(w.get_ptr());
+    if( in != 0 ) {
+      in->owner = this;
+    }
+    return w;
+  }
+
+  size_t WeightInterner::purge()
+  {
+    util::LockGuard guard(lock);
+    size_t dropped = 0;
+    table_t::iterator it = table.begin();
+    while( it != table.end() ) {
+      // Nobody else can get a new reference without the lock
+      if( static_cast<unsigned int>((*it)->count) == 1 ) {
+        it = table.erase(it);
+        ++dropped;
+      }
+      else {
+        ++it;
+      }
+    }
+    return dropped;
+  }
+
+  void WeightInterner::clear()
+  {
+    util::LockGuard guard(lock);
+    disown();
+    table.clear();
+  }
+
+  void WeightInterner::disown()
+  {
+    for( table_t::iterator it = table.begin() ; it != table.end() ; ++it ) {
+      Interned * in = dynamic_cast<Interned*>(it->get_ptr());
+      if( in != 0 ) {
+        in->owner = 0;
+      }
+    }
+  }
+
+  size_t WeightInterner::size() const
+  {
+    util::LockGuard guard(lock);
+    return table.size();
+  }
+
+  size_t WeightInterner::lookups() const
+  {
+    util::LockGuard guard(lock);
+    return num_lookups;
+  }
+
+  size_t WeightInterner::hits() const
+  {
+    util::LockGuard guard(lock);
+    return num_hits;
+  }
+
+  double WeightInterner::hitRate() const
+  {
+    util::LockGuard guard(lock);
+    return num_lookups == 0 ? 0.0 : double(num_hits) / double(num_lookups);
+  }
+
+  size_t WeightInterner::copies() const
+  {
+    util::LockGuard guard(lock);
+    return num_copies;
+  }
+
+  size_t WeightInterner::bytesSaved() const
+  {
+    util::LockGuard guard(lock);
+    return num_hits > num_copies ? (num_hits - num_copies) * element_bytes : 0;
+  }
+
+  std::ostream & WeightInterner::print_stats( std::ostream & o ) const
+  {
+    size_t n, l, h, c;
+    {
+      util::LockGuard guard(lock);
+      n = table.size();
+      l = num_lookups;
+      h = num_hits;
+      c = num_copies;
+    }
+    o << "WeightInterner: " << n << " weights, "
+      << l << " lookups, " << h << " hits";
+    if( l != 0 ) {
+      o << " (" << (100.0 * double(h) / double(l)) << "%)";
+    }
+    o << ", " << c << " copies, "
+      << (h > c ? (h - c) * element_bytes : 0) << " bytes saved\n";
+    return o;
+  }
+
+} // namespace wali
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
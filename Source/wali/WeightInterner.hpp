@@ -0,0 +1,245 @@
+#ifndef wali_WEIGHT_INTERNER_GUARD
+#define wali_WEIGHT_INTERNER_GUARD 1
+
+#include "wali/SemElem.hpp"
+#include "wali/util/Threads.hpp"
+#include "wali/util/unordered_set.hpp"
+
+#include <iostream>
+
+namespace wali
+{
+  class WeightInterner;
+
+  /**
+   * @class Interned
+   *
+   * Mixin for weights that a WeightInterner may hand out as canonical
+   * representatives. The interner records itself in a weight when it
+   * puts that weight in its table; two weights with the same owner are
+   * then equal exactly when they are the same object.
+   *
+   * @see InternedWeight
+   */
+  class Interned
+  {
+    public:
+      Interned() : owner(0) {}
+
+      /// A copy is not in any table
+      Interned( Interned const & ) : owner(0) {}
+      Interned & operator=( Interned const & ) { return *this; }
+
+      /// The table this weight is canonical in, or NULL
+      WeightInterner const * internedIn() const { return owner; }
+
+      bool isInterned() const { return owner != 0; }
+
+    private:
+      friend class WeightInterner;
+      WeightInterner const * owner;
+  };
+
+
+  /**
+   * @class WeightInterner
+   *
+   * A unique table of weights (hash-consing). intern(w) returns the
+   * weight in the table that is equal() to w, adding w if there is none,
+   * so a domain that passes every weight it creates through one table
+   * keeps a single copy of each value. Weights must implement
+   * SemElem::hash() consistently with equal().
+   *
+   * The table holds a reference to each weight in it, so weights are not
+   * reclaimed until purge() (which drops those nothing else refers to) or
+   * clear() is called.
+   *
+   * Under WALI_THREADS the table is locked, so several threads may intern
+   * weights at once.
+   *
+   * @see InternedWeight
+   */
+  class WeightInterner
+  {
+    public:
+      /// 'element_bytes' is the size of one weight, and is only used to
+      /// report the memory saved by sharing.
+      explicit WeightInterner( size_t element_bytes = 0 );
+      ~WeightInterner();
+
+      /// Returns the canonical weight equal to w. If w is new and is
+      /// Interned, it is marked as belonging to this table.
+      sem_elem_t intern( sem_elem_t w );
+
+      /// Like intern(w), but if w is new, puts wrap(w) in the table
+      /// instead of w and returns it. wrap(w) must be equal() to w (e.g.,
+      /// an Interned copy of it); it is only called on a miss, so looking
+      /// up a weight that is already there allocates nothing.
+      sem_elem_t intern( sem_elem_t w, sem_elem_t (*wrap)( SemElem * ) );
+
+      /// Drops the weights that only the table refers to. Returns how
+      /// many were dropped.
+      size_t purge();
+
+      /// Drops every weight. Weights still in use stay valid, but are no
+      /// longer canonical, so equal() falls back to a deep compare.
+      void clear();
+
+      /// Number of distinct weights in the table
+      size_t size() const;
+
+      /// Number of calls to intern()
+      size_t lookups() const;
+
+      /// Number of calls to intern() that found an equal weight
+      size_t hits() const;
+
+      /// hits() / lookups(), or 0 before the first lookup
+      double hitRate() const;
+
+      /// Number of weights that intern(w, wrap) copied with wrap
+      size_t copies() const;
+
+      /// Bytes of weights that were not kept because an equal one was
+      /// already in the table, less the bytes of the copies made to put
+      /// new weights in it (0 if the copies cost more)
+      size_t bytesSaved() const;
+
+      std::ostream & print_stats( std::ostream & o = std::cout ) const;
+
+    private:
+      typedef util::unordered_set<sem_elem_t, SemElemRefPtrHash, SemElemRefPtrEqual> table_t;
+
+      WeightInterner( WeightInterner const & );
+      WeightInterner & operator=( WeightInterner const & );
+
+      void disown();
+
+      mutable util::Mutex lock;
+      table_t table;
+      size_t element_bytes;
+      size_t num_lookups;
+      size_t num_hits;
+      size_t num_copies;
+  };
+
+
+  /**
+   * @class InternedWeight
+   *
+   * Turns an existing weight domain into a hash-consed one:
+   *
+   *     typedef InternedWeight<ShortestPathSemiring> Dist;
+   *     sem_elem_t w = Dist::make(ShortestPathSemiring(3));
+   *
+   * The results of one, zero, extend, combine and star are passed through
+   * a WeightInterner shared by every InternedWeight<Base>, so equal
+   * values are represented by one object and equal() on two of them is a
+   * pointer comparison. Base must be copyable, implement hash(), and
+   * accept an InternedWeight<Base> wherever it accepts a Base (which it
+   * does if it uses dynamic_cast<Base*> on its arguments).
+   *
+   * Results of the other operations (e.g., diff) are Base's own, and are
+   * compared with Base::equal, so mixing the two is safe.
+   */
+  template< typename Base >
+  class InternedWeight : public Base, public Interned
+  {
+    public:
+      InternedWeight() : Base() {}
+
+      explicit InternedWeight( Base const & b ) : Base(b) {}
+
+      /// Returns the canonical weight equal to b
+      static sem_elem_t make( Base const & b )
+      {
+        return interner().intern(new InternedWeight(b));
+      }
+
+      /// The unique table shared by every InternedWeight<Base>
+      static WeightInterner & interner()
+      {
+        static WeightInterner table(sizeof(InternedWeight));
+        return table;
+      }
+
+      /// Returns the canonical weight equal to w if it is a Base, and w
+      /// otherwise. A plain Base is looked up as it is, and only copied
+      /// into an InternedWeight if the table has no equal weight yet.
+      static sem_elem_t canonicalize( sem_elem_t w )
+      {
+        if( w == NULL ) {
+          return w;
+        }
+        InternedWeight * iw = dynamic_cast<InternedWeight*>(w.get_ptr());
+        if( iw == 0 ) {
+          if( dynamic_cast<Base*>(w.get_ptr()) == 0 ) {
+            return w;
+          }
+          return interner().intern(w, &wrap);
+        }
+        else if( iw->internedIn() == &interner() ) {
+          return w;
+        }
+        return interner().intern(w);
+      }
+
+      using Base::extend;
+      using Base::combine;
+      using Base::equal;
+
+      virtual sem_elem_t one() const
+      {
+        return canonicalize(Base::one());
+      }
+
+      virtual sem_elem_t zero() const
+      {
+        return canonicalize(Base::zero());
+      }
+
+      virtual sem_elem_t extend( SemElem * se )
+      {
+        return canonicalize(Base::extend(se));
+      }
+
+      virtual sem_elem_t combine( SemElem * se )
+      {
+        return canonicalize(Base::combine(se));
+      }
+
+      virtual sem_elem_t star()
+      {
+        return canonicalize(Base::star());
+      }
+
+      virtual bool equal( SemElem * se ) const
+      {
+        if( se == this ) {
+          return true;
+        }
+        if( isInterned() ) {
+          Interned const * other = dynamic_cast<Interned const *>(se);
+          if( other != 0 && other->internedIn() == internedIn() ) {
+            return false;
+          }
+        }
+        return Base::equal(se);
+      }
+
+    private:
+      static sem_elem_t wrap( SemElem * b )
+      {
+        return new InternedWeight(*dynamic_cast<Base*>(b));
+      }
+  };
+
+} // namespace wali
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif // wali_WEIGHT_INTERNER_GUARD
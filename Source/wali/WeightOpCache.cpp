@@ -0,0 +1,204 @@
+#include "wali/WeightOpCache.hpp"
+
+#include <algorithm>
+
+namespace wali
+{
+  namespace
+  {
+    struct CacheRegistry
+    {
+      util::Mutex lock;
+      std::vector<WeightOpCache const *> caches;
+    };
+
+    CacheRegistry & registry()
+    {
+      static CacheRegistry the_registry;
+      return the_registry;
+    }
+
+    bool owned( SemElem const * se )
+    {
+      // A count of 0 means the weight is not held by any ref_ptr (it is
+      // on the stack, say), so the cache must not take a reference.
+      return se != 0 && static_cast<unsigned int>(se->count) != 0;
+    }
+  }
+
+  WeightOpCache::WeightOpCache( size_t capacity, std::string const & the_name )
+    : name(the_name)
+    , max_entries(capacity)
+    , hand(0)
+    , num_hits(0)
+    , num_misses(0)
+    , num_evictions(0)
+  {
+    CacheRegistry & reg = registry();
+    util::LockGuard guard(reg.lock);
+    reg.caches.push_back(this);
+  }
+
+  WeightOpCache::~WeightOpCache()
+  {
+    CacheRegistry & reg = registry();
+    util::LockGuard guard(reg.lock);
+    reg.caches.erase(std::remove(reg.caches.begin(), reg.caches.end(), this),
+                     reg.caches.end());
+  }
+
+  bool WeightOpCache::find( int op, SemElem const * lhs, SemElem const * rhs, sem_elem_t & result )
+  {
+    OpKey key = { op, lhs, rhs };
+    util::LockGuard guard(lock);
+    index_t::const_iterator it = index.find(key);
+    if( it == index.end() ) {
+      ++num_misses;
+      return false;
+    }
+    ++num_hits;
+    Entry & e = entries[it->second];
+    e.referenced = true;
+    result = e.result;
+    return true;
+  }
+
+  void WeightOpCache::insert( int op, SemElem * lhs, SemElem * rhs, sem_elem_t result )
+  {
+    if( !owned(lhs) || !owned(rhs) ) {
+      return;
+    }
+    OpKey key = { op, lhs, rhs };
+
+    // Released after the lock, in case dropping the last reference to a
+    // weight is expensive
+    Entry evicted;
+
+    util::LockGuard guard(lock);
+    if( max_entries == 0 || index.find(key) != index.end() ) {
+      return;
+    }
+
+    size_t slot;
+    if( entries.size() < max_entries ) {
+      slot = entries.size();
+      entries.push_back(Entry());
+    }
+    else {
+      while( entries[hand].referenced ) {
+        entries[hand].referenced = false;
+        hand = (hand + 1) % entries.size();
+      }
+      slot = hand;
+      hand = (hand + 1) % entries.size();
+      index.erase(entries[slot].key);
+      evicted = entries[slot];
+      ++num_evictions;
+    }
+
+    Entry & e = entries[slot];
+    e.key = key;
+    e.lhs = lhs;
+    e.rhs = rhs;
+    e.result = result;
+    e.referenced = false;
+    index[key] = slot;
+  }
+
+  void WeightOpCache::setCapacity( size_t capacity )
+  {
+    std::vector<Entry> old;
+    util::LockGuard guard(lock);
+    old.swap(entries);
+    index.clear();
+    hand = 0;
+    max_entries = capacity;
+  }
+
+  size_t WeightOpCache::capacity() const
+  {
+    util::LockGuard guard(lock);
+    return max_entries;
+  }
+
+  void WeightOpCache::clear()
+  {
+    std::vector<Entry> old;
+    util::LockGuard guard(lock);
+    old.swap(entries);
+    index.clear();
+    hand = 0;
+  }
+
+  size_t WeightOpCache::size() const
+  {
+    util::LockGuard guard(lock);
+    return entries.size();
+  }
+
+  size_t WeightOpCache::hits() const
+  {
+    util::LockGuard guard(lock);
+    return num_hits;
+  }
+
+  size_t WeightOpCache::misses() const
+  {
+    util::LockGuard guard(lock);
+    return num_misses;
+  }
+
+  size_t WeightOpCache::evictions() const
+  {
+    util::LockGuard guard(lock);
+    return num_evictions;
+  }
+
+  double WeightOpCache::hitRate() const
+  {
+    util::LockGuard guard(lock);
+    size_t lookups = num_hits + num_misses;
+    return lookups == 0 ? 0.0 : double(num_hits) / double(lookups);
+  }
+
+  std::ostream & WeightOpCache::print_stats( std::ostream & o ) const
+  {
+    size_t n, cap, h, m, ev;
+    {
+      util::LockGuard guard(lock);
+      n = entries.size();
+      cap = max_entries;
+      h = num_hits;
+      m = num_misses;
+      ev = num_evictions;
+    }
+    o << "WeightOpCache";
+    if( !name.empty() ) {
+      o << " " << name;
+    }
+    o << ": " << n << "/" << cap << " entries, "
+      << h << " hits, " << m << " misses";
+    if( h + m != 0 ) {
+      o << " (" << (100.0 * double(h) / double(h + m)) << "% hits)";
+    }
+    o << ", " << ev << " evictions\n";
+    return o;
+  }
+
+  std::ostream & WeightOpCache::printAll( std::ostream & o )
+  {
+    CacheRegistry & reg = registry();
+    util::LockGuard guard(reg.lock);
+    for( size_t i = 0 ; i < reg.caches.size() ; ++i ) {
+      reg.caches[i]->print_stats(o);
+    }
+    return o;
+  }
+
+} // namespace wali
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
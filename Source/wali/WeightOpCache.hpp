@@ -0,0 +1,228 @@
+#ifndef wali_WEIGHT_OP_CACHE_GUARD
+#define wali_WEIGHT_OP_CACHE_GUARD 1
+
+#include "wali/SemElem.hpp"
+#include "wali/util/Threads.hpp"
+#include "wali/util/unordered_map.hpp"
+
+#include <iostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace wali
+{
+  /**
+   * @class WeightOpCache
+   *
+   * A bounded cache of the results of binary weight operations, keyed on
+   * the identity (address) of the operands. Each entry holds references
+   * to both operands and to the result, so an address cannot be reused
+   * for a different weight while it is in the cache. Weights that are
+   * not owned by a ref_ptr (e.g., ones on the stack) are never cached.
+   *
+   * When the cache is full, entries are evicted with the clock algorithm
+   * (an approximation of LRU): every hit sets an entry's reference bit,
+   * and the clock hand clears bits until it finds an entry whose bit is
+   * clear.
+   *
+   * Keying on identity means equal operands that are different objects
+   * miss; for domains that also use InternedWeight, identity and equality
+   * coincide.
+   *
+   * Every live cache is listed by printAll(), which WPDS::printStatistics
+   * and WFA::printStatistics call.
+   *
+   * Under WALI_THREADS the cache is locked, so several threads may use it
+   * at once. Two threads that miss on the same operands both compute the
+   * result.
+   *
+   * @see MemoizedWeight
+   */
+  class WeightOpCache
+  {
+    public:
+      /// The operations a MemoizedWeight caches. Other users may use
+      /// their own numbers.
+      enum Op { EXTEND = 0, COMBINE = 1 };
+
+      enum { DEFAULT_CAPACITY = 4096 };
+
+      /// A capacity of 0 disables the cache. 'name' is printed by
+      /// print_stats().
+      explicit WeightOpCache( size_t capacity = DEFAULT_CAPACITY,
+                              std::string const & name = "" );
+      ~WeightOpCache();
+
+      /// If 'op lhs rhs' is cached, sets 'result' to it and returns true
+      bool find( int op, SemElem const * lhs, SemElem const * rhs, sem_elem_t & result );
+
+      /// Records that 'op lhs rhs' is 'result'
+      void insert( int op, SemElem * lhs, SemElem * rhs, sem_elem_t result );
+
+      /// Empties the cache and sets its capacity
+      void setCapacity( size_t capacity );
+
+      size_t capacity() const;
+
+      /// Empties the cache (the counters are kept)
+      void clear();
+
+      size_t size() const;
+      size_t hits() const;
+      size_t misses() const;
+      size_t evictions() const;
+
+      /// hits() / (hits() + misses()), or 0 before the first lookup
+      double hitRate() const;
+
+      std::ostream & print_stats( std::ostream & o = std::cout ) const;
+
+      /// Prints the statistics of every cache that exists
+      static std::ostream & printAll( std::ostream & o );
+
+    private:
+      struct OpKey
+      {
+        int op;
+        SemElem const * lhs;
+        SemElem const * rhs;
+
+        bool operator==( OpKey const & other ) const {
+          return op == other.op && lhs == other.lhs && rhs == other.rhs;
+        }
+      };
+
+      struct OpKeyHash
+      {
+        size_t operator()( OpKey const & k ) const {
+          size_t h = reinterpret_cast<size_t>(k.lhs);
+          h = h * 31 + (reinterpret_cast<size_t>(k.rhs) >> 4);
+          return h * 31 + static_cast<size_t>(k.op);
+        }
+      };
+
+      struct Entry
+      {
+        OpKey key;
+        sem_elem_t lhs;
+        sem_elem_t rhs;
+        sem_elem_t result;
+        bool referenced;
+      };
+
+      typedef util::unordered_map<OpKey, size_t, OpKeyHash> index_t;
+
+      WeightOpCache( WeightOpCache const & );
+      WeightOpCache & operator=( WeightOpCache const & );
+
+      mutable util::Mutex lock;
+      std::string name;
+      size_t max_entries;
+      std::vector<Entry> entries;
+      index_t index;
+      size_t hand;
+      size_t num_hits;
+      size_t num_misses;
+      size_t num_evictions;
+  };
+
+
+  /**
+   * @class MemoizedWeight
+   *
+   * Adds a WeightOpCache to an existing weight domain:
+   *
+   *     typedef MemoizedWeight<BddWeight> Weight;
+   *     sem_elem_t w = Weight::make(BddWeight(...));
+   *
+   * extend and combine first look in a cache shared by every
+   * MemoizedWeight<Base>, and only call Base's operation on a miss.
+   * Results of one, zero, extend, combine and star are (copied into)
+   * MemoizedWeights, so the results of later operations are cached too.
+   * Base must be copyable and accept a MemoizedWeight<Base> wherever it
+   * accepts a Base.
+   *
+   * This pays off for domains whose operations are expensive; for cheap
+   * ones the lookup (and the copy of each new result) costs more than it
+   * saves.
+   */
+  template< typename Base >
+  class MemoizedWeight : public Base
+  {
+    public:
+      MemoizedWeight() : Base() {}
+
+      explicit MemoizedWeight( Base const & b ) : Base(b) {}
+
+      static sem_elem_t make( Base const & b )
+      {
+        return new MemoizedWeight(b);
+      }
+
+      /// The cache shared by every MemoizedWeight<Base>
+      static WeightOpCache & cache()
+      {
+        static WeightOpCache the_cache(WeightOpCache::DEFAULT_CAPACITY,
+                                       typeid(Base).name());
+        return the_cache;
+      }
+
+      /// Returns w as a MemoizedWeight if it is a Base, and w otherwise
+      static sem_elem_t wrap( sem_elem_t w )
+      {
+        if( w == NULL || dynamic_cast<MemoizedWeight*>(w.get_ptr()) != 0 ) {
+          return w;
+        }
+        Base * b = dynamic_cast<Base*>(w.get_ptr());
+        return b == 0 ? w : sem_elem_t(new MemoizedWeight(*b));
+      }
+
+      using Base::extend;
+      using Base::combine;
+
+      virtual sem_elem_t one() const
+      {
+        return wrap(Base::one());
+      }
+
+      virtual sem_elem_t zero() const
+      {
+        return wrap(Base::zero());
+      }
+
+      virtual sem_elem_t extend( SemElem * se )
+      {
+        sem_elem_t result;
+        if( !cache().find(WeightOpCache::EXTEND, this, se, result) ) {
+          result = wrap(Base::extend(se));
+          cache().insert(WeightOpCache::EXTEND, this, se, result);
+        }
+        return result;
+      }
+
+      virtual sem_elem_t combine( SemElem * se )
+      {
+        sem_elem_t result;
+        if( !cache().find(WeightOpCache::COMBINE, this, se, result) ) {
+          result = wrap(Base::combine(se));
+          cache().insert(WeightOpCache::COMBINE, this, se, result);
+        }
+        return result;
+      }
+
+      virtual sem_elem_t star()
+      {
+        return wrap(Base::star());
+      }
+  };
+
+} // namespace wali
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif // wali_WEIGHT_OP_CACHE_GUARD
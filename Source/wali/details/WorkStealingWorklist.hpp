@@ -0,0 +1,197 @@
+#ifndef wali_WORK_STEALING_WORKLIST_GUARD
+#define wali_WORK_STEALING_WORKLIST_GUARD 1
+
+#include "wali/Common.hpp"
+#include "wali/Worklist.hpp"
+#include "wali/KeyContainer.hpp"
+#include "wali/util/Threads.hpp"
+#include "wali/wfa/ITrans.hpp"
+
+#include <deque>
+#include <vector>
+
+#if WALI_THREADS
+
+namespace wali
+{
+  namespace details
+  {
+
+    /*!
+     * @class WorkStealingWorklist
+     *
+     * Worklist used by the parallel pre* and post* saturation.
+     *
+     * Transitions are partitioned by their (from, stack) key: each key is
+     * owned by exactly one worker, and put() places a transition on the
+     * deque of its owner. A worker takes work from the back of its own
+     * deque and, when that runs dry, steals from the front of the other
+     * workers' deques.
+     *
+     * Termination is detected with a count of pending items, which
+     * includes both the items sitting in a deque and the items a worker is
+     * currently processing. A worker must call done() once it has finished
+     * with an item returned by get(worker, t); since any transitions
+     * created while processing it are put() first, the count only reaches
+     * zero once the saturation has converged.
+     *
+     * The "marked" bit of a transition is only touched while holding the
+     * lock of its owner's deque.
+     */
+    class WorkStealingWorklist : public Worklist<wfa::ITrans>
+    {
+    public:
+      explicit WorkStealingWorklist( unsigned workers )
+        : deques(workers == 0 ? 1 : workers)
+        , pending(0)
+      {
+        for( size_t i = 0 ; i < deques.size() ; ++i ) {
+          deques[i] = new Deque();
+        }
+      }
+
+      virtual ~WorkStealingWorklist()
+      {
+        clear();
+        for( size_t i = 0 ; i < deques.size() ; ++i ) {
+          delete deques[i];
+        }
+      }
+
+      /// The worker that owns transitions with t's (from, stack) key
+      unsigned owner( wfa::ITrans const * t ) const
+      {
+        hm_hash<KeyPair> hasher;
+        return static_cast<unsigned>(hasher(t->keypair()) % deques.size());
+      }
+
+      virtual bool put( wfa::ITrans * t )
+      {
+        Deque & d = *deques[owner(t)];
+        std::lock_guard<std::mutex> guard(d.lock);
+        if( t->marked() ) {
+          return false;
+        }
+        t->mark();
+        ++pending;
+        d.items.push_back(t);
+        return true;
+      }
+
+      /// Sequential interface: equivalent to a get by worker 0 that does
+      /// not count as in-flight work.
+      virtual wfa::ITrans * get()
+      {
+        wfa::ITrans * t = 0;
+        if( take(0, t) ) {
+          --pending;
+        }
+        return t;
+      }
+
+      /*!
+       * Gets the next item for 'worker', stealing from other workers if its
+       * own deque is empty. Returns false once every deque is empty and no
+       * worker is still processing an item, i.e., when saturation is done.
+       */
+      bool get( unsigned worker, wfa::ITrans * & t )
+      {
+        while( true ) {
+          if( take(worker, t) ) {
+            return true;
+          }
+          if( pending.load() == 0 ) {
+            t = 0;
+            return false;
+          }
+          std::this_thread::yield();
+        }
+      }
+
+      /// Signals that a worker has finished processing an item it got
+      void done()
+      {
+        --pending;
+      }
+
+      virtual bool empty() const
+      {
+        return size() == 0;
+      }
+
+      virtual void clear()
+      {
+        for( size_t i = 0 ; i < deques.size() ; ++i ) {
+          Deque & d = *deques[i];
+          std::lock_guard<std::mutex> guard(d.lock);
+          for( std::deque<wfa::ITrans*>::iterator it = d.items.begin();
+               it != d.items.end() ; ++it )
+          {
+            (*it)->unmark();
+            --pending;
+          }
+          d.items.clear();
+        }
+      }
+
+      virtual size_t size() const
+      {
+        size_t n = 0;
+        for( size_t i = 0 ; i < deques.size() ; ++i ) {
+          Deque & d = *deques[i];
+          std::lock_guard<std::mutex> guard(d.lock);
+          n += d.items.size();
+        }
+        return n;
+      }
+
+    private:
+      struct Deque
+      {
+        std::mutex lock;
+        std::deque<wfa::ITrans*> items;
+      };
+
+      /// Pops from the back of worker's deque, or steals from the front of
+      /// another one.
+      bool take( unsigned worker, wfa::ITrans * & t )
+      {
+        size_t n = deques.size();
+        for( size_t i = 0 ; i < n ; ++i ) {
+          Deque & d = *deques[(worker + i) % n];
+          std::lock_guard<std::mutex> guard(d.lock);
+          if( !d.items.empty() ) {
+            if( i == 0 ) {
+              t = d.items.back();
+              d.items.pop_back();
+            }
+            else {
+              t = d.items.front();
+              d.items.pop_front();
+            }
+            t->unmark();
+            return true;
+          }
+        }
+        return false;
+      }
+
+      WorkStealingWorklist( WorkStealingWorklist const & );
+      WorkStealingWorklist & operator=( WorkStealingWorklist const & );
+
+      std::vector<Deque*> deques;
+      std::atomic<size_t> pending;
+    };
+
+  } // namespace details
+} // namespace wali
+
+#endif // WALI_THREADS
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif  // wali_WORK_STEALING_WORKLIST_GUARD
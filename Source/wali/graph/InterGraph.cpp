@@ -3,8 +3,10 @@
 #include "wali/graph/RegExp.hpp"
 #include "wali/graph/Functional.hpp"
 
+#include "wali/util/Threads.hpp"
 #include "wali/util/Timer.hpp"
 
+#include <algorithm>
 #include <math.h>
 #include <stdlib.h>
 #include <time.h>
@@ -117,6 +119,18 @@ namespace wali {
             return InterSourceOutNode;
         }
 
+        namespace {
+          /// Builds the path sequence and regular expressions of one
+          /// IntraGraph per index
+          struct IntraSolutionSetup {
+            std::vector<IntraGraph *> &grs;
+            explicit IntraSolutionSetup(std::vector<IntraGraph *> &g) : grs(g) {}
+            void operator()(size_t i) {
+              grs[i]->setupIntraSolution(false);
+            }
+          };
+        }
+
         bool is_source_type(inter_node_t t1) {
             return (t1 == InterSource || t1 == InterSourceOutNode);
         }
@@ -136,6 +150,12 @@ namespace wali {
           }
         }
 
+        void ETransHandler::setWeight(int ret, sem_elem_t wtCallRule) {
+          EdgeMap::iterator it = edgeMap.find(ret);
+          assert(it != edgeMap.end());
+          it->second.second = wtCallRule;
+        }
+
         void ETransHandler::tensorAllWeights()
         {
           if(edgeMap.size() == 0)
@@ -178,10 +198,13 @@ namespace wali {
           dag = new RegExpDag();
           count = 0;
           isOutputAutomatonTensored = false;
+          worker_threads = 1;
         }
 
         InterGraph::~InterGraph() {
           delete dag;
+          for(unsigned i = 0; i < graph_dags.size(); i++)
+            delete graph_dags[i];
           std::set<IntraGraph*> deleteGr;
           for(unsigned i = 0; i < nodes.size(); i++) {
             if(nodes[i].gr && intra_graph_uf->find(i) == (int)i) {
@@ -314,11 +337,11 @@ namespace wali {
           return out;
         }
 
-        void InterGraph::addEdge(Transition src, Transition tgt, wali::sem_elem_t se) {
+        int InterGraph::addEdge(Transition src, Transition tgt, wali::sem_elem_t se) {
           int eno = intra_edgeno(src,tgt);
           if(eno != -1) { // edge already present
             intra_edges[eno].weight = intra_edges[eno].weight->combine(se);
-            return;
+            return eno;
           }
           int s = nodeno(src);
           int t = nodeno(tgt);
@@ -327,20 +350,22 @@ namespace wali {
           int e = intra_edges.size() - 1;
           nodes[s].outgoing.push_back(e);
           nodes[t].incoming.push_back(e);
+          return e;
         }
 
-        void InterGraph::addCallRetEdge(Transition src, Transition tgt, wali::sem_elem_t se) {
+        int InterGraph::addCallRetEdge(Transition src, Transition tgt, wali::sem_elem_t se) {
           addEdge(src, tgt, se->one());
           int s = nodeno(src);
           int t = nodeno(tgt);
           eHandler.addEdge(s, t, se);
+          return t;
         }
 
-        void InterGraph::addEdge(Transition src1, Transition src2, Transition tgt, wali::sem_elem_t se) {
+        int InterGraph::addEdge(Transition src1, Transition src2, Transition tgt, wali::sem_elem_t se) {
           int eno = inter_edgeno(src1,src2,tgt);
           if(eno != -1) { // edge already present
             inter_edges[eno].weight = inter_edges[eno].weight->combine(se);
-            return;
+            return eno;
           }
           int s1 = nodeno(src1);
           int s2 = nodeno(src2);
@@ -350,14 +375,14 @@ namespace wali {
           inter_edges.push_back(ed);
           nodes[s2].out_hyper_edges.push_back(inter_edges.size() - 1);
           nodes[s1].out1_hyper_edges.push_back(inter_edges.size() - 1);
-
+          return inter_edges.size() - 1;
         }
 
-        void InterGraph::addEdge(Transition src1, Transition src2, Transition tgt, merge_fn_t mf) {
+        int InterGraph::addEdge(Transition src1, Transition src2, Transition tgt, merge_fn_t mf) {
           assert(running_ewpds);
           int eno = inter_edgeno(src1,src2,tgt);
           if(eno != -1 && mf == inter_edges[eno].mf) { // edge already present
-            return;
+            return eno;
           }
           int s1 = nodeno(src1);
           int s2 = nodeno(src2);
@@ -367,6 +392,7 @@ namespace wali {
           inter_edges.push_back(ed);
           nodes[s2].out_hyper_edges.push_back(inter_edges.size() - 1);
           nodes[s1].out1_hyper_edges.push_back(inter_edges.size() - 1);
+          return inter_edges.size() - 1;
         }
 
         void InterGraph::addCallEdge(Transition src1, Transition src2) {
@@ -388,6 +414,54 @@ namespace wali {
           eHandler.addEdge(-1, n, wtAfterCall);
         }
 
+        int InterGraph::sourceNode(Transition t) {
+          TransMap::iterator it = node_number.find(t);
+          if(it == node_number.end() || !is_source_type(nodes[it->second].type))
+            return -1;
+          return it->second;
+        }
+
+        void InterGraph::setEdgeWeight(int eno, wali::sem_elem_t se) {
+          intra_edges[eno].weight = se;
+          IntraGraph *gr = nodes[intra_edges[eno].src].gr;
+          if(gr)
+            changed_graphs.insert(gr);
+        }
+
+        void InterGraph::setHyperEdgeWeight(int eno, wali::sem_elem_t se) {
+          inter_edges[eno].weight = se;
+          // The weight is applied when the hyper edge's target is updated
+          IntraGraph *gr = nodes[inter_edges[eno].tgt].gr;
+          if(gr)
+            changed_graphs.insert(gr);
+        }
+
+        void InterGraph::setHyperEdgeMergeFn(int eno, wali::merge_fn_t mf) {
+          assert(running_ewpds);
+          inter_edges[eno].mf = mf;
+          IntraGraph *gr = nodes[inter_edges[eno].tgt].gr;
+          if(gr)
+            changed_graphs.insert(gr);
+        }
+
+        void InterGraph::setCallRetWeight(int ret, wali::sem_elem_t se) {
+          // Only read by get_weight, so nothing needs to be saturated again
+          eHandler.setWeight(ret, se);
+        }
+
+        void InterGraph::setSourceWeight(int n, wali::sem_elem_t se) {
+          assert(is_source_type(nodes[n].type));
+          IntraGraph *gr = nodes[n].gr;
+          if(gr) {
+            // Its IntraGraph holds the weight on the edge from the super
+            // source; rebuildIntraGraph puts the new one there
+            changed_sources[n] = se;
+            changed_graphs.insert(gr);
+          }
+          else
+            nodes[n].weight = se;
+        }
+
         unsigned InterGraph::SCCLight(SCCGraphs& grlist, SCCGraphs& grsorted)
         {
           SCCGraphs::iterator gr_it;
@@ -1173,20 +1247,33 @@ namespace wali {
           for(it2 = inter_edges.begin(); it2 != inter_edges.end(); it2++) {
             intra_graph_uf->takeUnion((*it2).src1,(*it2).tgt);
           }
+          // See setWorkerThreads
+          bool parallel = util::effective_threads(worker_threads) > 1;
+
           IntraGraph::SharedMemBuffer * memBuf = NULL;
 #ifdef INTRAGRAPH_SHARED_MEMORY
           // Before creating IntraGraphs, create a CommonBuffer, if needed.
-          int max_size = 0;
-          for(gr_it = gr_list.begin(); gr_it != gr_list.end(); gr_it++) {
-            max_size = (max_size > (*gr_it)->getSize()) ? max_size : (*gr_it)->getSize();
+          // (IntraGraphs solved on different threads cannot share one.)
+          if(!parallel) {
+            int max_size = 0;
+            for(gr_it = gr_list.begin(); gr_it != gr_list.end(); gr_it++) {
+              max_size = (max_size > (*gr_it)->getSize()) ? max_size : (*gr_it)->getSize();
+            }
+            memBuf  = new IntraGraph::SharedMemBuffer(max_size);
           }
-          memBuf  = new IntraGraph::SharedMemBuffer(max_size);
 #endif
 
           for(i = 0; i < n;i++) {
             int j = intra_graph_uf->find(i);
             if(nodes[j].gr == NULL) {
-              nodes[j].gr = new IntraGraph(dag, running_prestar,sem, memBuf);
+              RegExpDag * gr_dag = dag;
+              if(parallel) {
+                gr_dag = new RegExpDag();
+                gr_dag->topDownEval(dag->isTopDownEval());
+                gr_dag->startSatProcess(sem);
+                graph_dags.push_back(gr_dag);
+              }
+              nodes[j].gr = new IntraGraph(gr_dag, running_prestar,sem, memBuf);
               gr_list.push_back(nodes[j].gr);
             }
             nodes[i].gr = nodes[j].gr;
@@ -1225,12 +1312,20 @@ namespace wali {
 #if defined(PPP_DBG) && PPP_DBG >= 0
           vector<reg_exp_t> outNodeRegExps;
 #endif
-          for(gr_it = gr_list.begin(); gr_it != gr_list.end(); gr_it++) {
-            (*gr_it)->setupIntraSolution(false);
+          if(parallel) {
+            // The IntraGraphs do not share a dag, so their path sequences
+            // can be computed concurrently.
+            std::vector<IntraGraph *> grs(gr_list.begin(), gr_list.end());
+            IntraSolutionSetup setup(grs);
+            util::parallel_for(worker_threads, grs.size(), setup);
+          } else {
+            for(gr_it = gr_list.begin(); gr_it != gr_list.end(); gr_it++) {
+              (*gr_it)->setupIntraSolution(false);
 #if defined(PPP_DBG) && PPP_DBG >= 0
-            for(list<int>::const_iterator cit = (*gr_it)->out_nodes_intra->begin(); cit != (*gr_it)->out_nodes_intra->end(); ++cit)
-              outNodeRegExps.push_back((*gr_it)->nodes[*cit].regexp);
+              for(list<int>::const_iterator cit = (*gr_it)->out_nodes_intra->begin(); cit != (*gr_it)->out_nodes_intra->end(); ++cit)
+                outNodeRegExps.push_back((*gr_it)->nodes[*cit].regexp);
 #endif
+            }
           }
 
 #if defined(PPP_DBG) && PPP_DBG >= 0
@@ -1262,11 +1357,15 @@ namespace wali {
               max_scc_required = (max_scc_required >= nodes[nno].gr->scc_number) ? max_scc_required : nodes[nno].gr->scc_number;
             }
           }
-          gr_it = gr_sorted.begin();
-          for(unsigned scc_n = 1; scc_n <= max_scc_required; scc_n++) {
-            bfsIntra(*gr_it, scc_n);
-            setup_worklist(gr_sorted, gr_it, scc_n, worklist);
-            numSteps += saturate(worklist,scc_n);
+          if(parallel) {
+            numSteps = parallelSaturate(gr_sorted, components, max_scc_required);
+          } else {
+            gr_it = gr_sorted.begin();
+            for(unsigned scc_n = 1; scc_n <= max_scc_required; scc_n++) {
+              bfsIntra(*gr_it, scc_n);
+              setup_worklist(gr_sorted, gr_it, scc_n, worklist);
+              numSteps += saturate(worklist,scc_n);
+            }
           }
 #if defined(PPP_DBG) && PPP_DBG >= 0
           cout << "Total number of steps: " << numSteps << endl;
@@ -1309,11 +1408,254 @@ namespace wali {
 #endif
         dag->stopSatProcess();
         dag->executingPoststar(!running_prestar);
+        for(unsigned d = 0; d < graph_dags.size(); d++) {
+          graph_dags[d]->stopSatProcess();
+          graph_dags[d]->executingPoststar(!running_prestar);
+        }
 #ifdef INTRAGRAPH_SHARED_MEMORY
         delete memBuf;
 #endif
     }
 
+    IntraGraph * InterGraph::rebuildIntraGraph(IntraGraph *old) {
+      // In the RegExpDag old was built in: its own one if it was solved
+      // on a worker thread
+      IntraGraph *gr = new IntraGraph(old->dag, running_prestar, sem);
+      gr->scc_number = old->scc_number;
+      gr->bfs_number = (unsigned)(-1);
+      unsigned n = nodes.size();
+      unsigned i;
+
+      // Same order as in setupInterSolution, so the nodes keep their
+      // intra_nodeno
+      for(i = 0; i < n; i++) {
+        if(nodes[i].gr != old)
+          continue;
+        int intra = gr->makeNode(nodes[i].trans);
+        assert(intra == nodes[i].intra_nodeno);
+        if(is_source_type(nodes[i].type)) {
+          // setupInterSolution zeroed nodes[i].weight, but old still has
+          // the source weight on its edge from the super source
+          std::map<int, wali::sem_elem_t>::iterator src = changed_sources.find((int)i);
+          if(src != changed_sources.end()) {
+            gr->setSource(intra, src->second);
+            changed_sources.erase(src);
+          }
+          else
+            gr->setSource(intra, old->readEdgeWeight(0, intra));
+        }
+      }
+      for(i = 0; i < n; i++) {
+        if(nodes[i].gr == old)
+          nodes[i].gr = gr;
+      }
+
+      std::vector<GraphEdge>::iterator it;
+      for(it = intra_edges.begin(); it != intra_edges.end(); it++) {
+        if(nodes[(*it).src].gr == gr)
+          gr->addEdge(nodes[(*it).src].intra_nodeno, nodes[(*it).tgt].intra_nodeno, (*it).weight);
+      }
+      std::vector<HyperEdge>::iterator it2;
+      for(it2 = inter_edges.begin(); it2 != inter_edges.end(); it2++) {
+        if(nodes[(*it2).tgt].gr == gr)
+          gr->addEdge(nodes[(*it2).src1].intra_nodeno, nodes[(*it2).tgt].intra_nodeno, sem->zero(), true);
+        if(nodes[(*it2).src2].gr == gr)
+          gr->setOutNode(nodes[(*it2).src2].intra_nodeno, (*it2).src2);
+      }
+      std::vector<call_edge_t>::iterator it3;
+      for(it3 = call_edges.begin(); it3 != call_edges.end(); it3++) {
+        IntraGraph *gr1 = nodes[(*it3).first].gr;
+        IntraGraph *gr2 = nodes[(*it3).second].gr;
+        if(gr1 == gr)
+          gr1->addCallEdge(gr2);
+        else if(gr2 == gr && gr1->calls.erase(old) > 0)
+          gr1->addCallEdge(gr2);
+      }
+
+      std::replace(gr_list.begin(), gr_list.end(), old, gr);
+      delete old;
+      return gr;
+    }
+
+    unsigned InterGraph::updateInterSolution() {
+      assert(intra_graph_uf != NULL && !runningNewton && newtonGr == NULL);
+      if(changed_graphs.empty())
+        return 0;
+
+      // Everything downstream of a changed IntraGraph is out of date. SCCs
+      // only pass weights to SCCs with larger numbers.
+      std::set<unsigned> dirty;
+      std::set<IntraGraph *>::iterator cit;
+      for(cit = changed_graphs.begin(); cit != changed_graphs.end(); cit++)
+        dirty.insert((*cit)->scc_number);
+      changed_graphs.clear();
+
+      std::multimap<unsigned, IntraGraph *> by_scc;
+      std::list<IntraGraph *>::iterator gr_it;
+      for(gr_it = gr_list.begin(); gr_it != gr_list.end(); gr_it++)
+        by_scc.insert(std::make_pair((*gr_it)->scc_number, *gr_it));
+
+      std::vector<IntraGraph *> stale;
+      std::multimap<unsigned, IntraGraph *>::iterator bit;
+      for(bit = by_scc.begin(); bit != by_scc.end(); bit++) {
+        IntraGraph *gr = bit->second;
+        if(dirty.find(gr->scc_number) == dirty.end())
+          continue;
+        stale.push_back(gr);
+        std::list<int> *outnodes = gr->getOutTransitions();
+        for(std::list<int>::iterator on = outnodes->begin(); on != outnodes->end(); on++) {
+          std::list<int> &hyper = nodes[*on].out_hyper_edges;
+          for(std::list<int>::iterator e = hyper.begin(); e != hyper.end(); e++)
+            dirty.insert(nodes[inter_edges[*e].tgt].gr->scc_number);
+        }
+      }
+
+      // Rebuild the stale IntraGraphs. The others keep the regular
+      // expressions of the earlier sat processes.
+      std::set<RegExpDag *> stale_dags;
+      for(unsigned i = 0; i < stale.size(); i++)
+        stale_dags.insert(stale[i]->dag);
+      std::set<RegExpDag *>::iterator dit;
+      for(dit = stale_dags.begin(); dit != stale_dags.end(); dit++)
+        (*dit)->startSatProcess(sem);
+      std::list<IntraGraph *> gr_sorted;
+      std::set<IntraGraph *> rebuilt;
+      for(unsigned i = 0; i < stale.size(); i++) {
+        IntraGraph *gr = rebuildIntraGraph(stale[i]);
+        gr_sorted.push_back(gr);
+        rebuilt.insert(gr);
+      }
+      for(gr_it = gr_sorted.begin(); gr_it != gr_sorted.end(); gr_it++) {
+        (*gr_it)->setupIntraSolution(false);
+        std::list<int> *outnodes = (*gr_it)->getOutTransitions();
+        for(std::list<int>::iterator on = outnodes->begin(); on != outnodes->end(); on++)
+          nodes[*on].weight = NULL;
+      }
+
+      // Weights passed in from the SCCs that are still up to date
+      for(unsigned e = 0; e < inter_edges.size(); e++) {
+        HyperEdge &he = inter_edges[e];
+        IntraGraph *gr = nodes[he.tgt].gr;
+        if(rebuilt.find(gr) == rebuilt.end() || rebuilt.find(nodes[he.src2].gr) != rebuilt.end())
+          continue;
+        sem_elem_t weight = nodes[he.src2].weight;
+        if(weight.get_ptr() == NULL)
+          continue;
+        sem_elem_t uw;
+        if(running_ewpds && he.mf.get_ptr())
+          uw = he.mf->apply_f(sem->one(), weight);
+        else
+          uw = he.weight->extend(weight);
+        gr->updateEdgeWeight(nodes[he.src1].intra_nodeno, nodes[he.tgt].intra_nodeno, uw);
+      }
+
+      std::multiset<tup> worklist;
+      unsigned saturated = 0;
+      gr_it = gr_sorted.begin();
+      while(gr_it != gr_sorted.end()) {
+        unsigned scc_n = (*gr_it)->scc_number;
+        if(scc_n > (unsigned)max_scc_computed)
+          break;
+        bfsIntra(*gr_it, scc_n);
+        setup_worklist(gr_sorted, gr_it, scc_n, worklist);
+        saturate(worklist, scc_n);
+        saturated++;
+      }
+
+      for(dit = stale_dags.begin(); dit != stale_dags.end(); dit++) {
+        (*dit)->stopSatProcess();
+        (*dit)->executingPoststar(!running_prestar);
+      }
+      return saturated;
+    }
+
+    /**
+     * Saturates one SCC per index, for the SCCs of one wave of
+     * parallelSaturate.
+     **/
+    class InterGraph::SccSaturator {
+      public:
+        SccSaturator(InterGraph &g, std::list<IntraGraph *> &sorted,
+            std::vector<std::list<IntraGraph *>::iterator> &f,
+            std::vector<unsigned> &w)
+          : igr(g), gr_sorted(sorted), first(f), wave(w),
+            deferred(w.size()), wave_stats(w.size()), steps(w.size(), 0)
+        {}
+
+        void operator()(size_t i) {
+          unsigned scc_n = wave[i];
+          std::list<IntraGraph *>::iterator gr_it = first[scc_n];
+          std::multiset<tup> worklist;
+          igr.bfsIntra(*gr_it, scc_n);
+          igr.setup_worklist(gr_sorted, gr_it, scc_n, worklist);
+          steps[i] = igr.saturate(worklist, scc_n, &deferred[i], &wave_stats[i]);
+        }
+
+        InterGraph &igr;
+        std::list<IntraGraph *> &gr_sorted;
+        std::vector<std::list<IntraGraph *>::iterator> &first;
+        std::vector<unsigned> &wave;
+
+        // One of each per SCC in the wave, so the threads share nothing
+        std::vector< std::vector<DeferredUpdate> > deferred;
+        std::vector<InterGraphStats> wave_stats;
+        std::vector<int> steps;
+    };
+
+    int InterGraph::parallelSaturate(std::list<IntraGraph *> &gr_sorted,
+        unsigned components, unsigned max_scc_required)
+    {
+      // The graphs of each SCC are contiguous in gr_sorted, in SCC order
+      std::vector<std::list<IntraGraph *>::iterator> first(components + 1, gr_sorted.end());
+      for(std::list<IntraGraph *>::iterator it = gr_sorted.begin(); it != gr_sorted.end(); it++) {
+        if(first[(*it)->scc_number] == gr_sorted.end())
+          first[(*it)->scc_number] = it;
+      }
+
+      // An SCC goes in the wave after the last SCC that passes weights
+      // to it. SCCs only pass weights to SCCs with larger numbers.
+      std::vector<unsigned> level(components + 1, 0);
+      unsigned num_waves = 0;
+      for(std::list<IntraGraph *>::iterator it = gr_sorted.begin(); it != gr_sorted.end(); it++) {
+        unsigned scc_n = (*it)->scc_number;
+        num_waves = (num_waves > level[scc_n] + 1) ? num_waves : level[scc_n] + 1;
+        std::list<int> *outnodes = (*it)->getOutTransitions();
+        for(std::list<int>::iterator on = outnodes->begin(); on != outnodes->end(); on++) {
+          std::list<int> &hyper = nodes[*on].out_hyper_edges;
+          for(std::list<int>::iterator e = hyper.begin(); e != hyper.end(); e++) {
+            unsigned tgt_scc = nodes[inter_edges[*e].tgt].gr->scc_number;
+            if(tgt_scc != scc_n && level[tgt_scc] < level[scc_n] + 1)
+              level[tgt_scc] = level[scc_n] + 1;
+          }
+        }
+      }
+
+      std::vector< std::vector<unsigned> > waves(num_waves);
+      for(unsigned scc_n = 1; scc_n <= max_scc_required; scc_n++) {
+        waves[level[scc_n]].push_back(scc_n);
+      }
+
+      int numSteps = 0;
+      for(unsigned w = 0; w < waves.size(); w++) {
+        if(waves[w].empty())
+          continue;
+        SccSaturator sat(*this, gr_sorted, first, waves[w]);
+        util::parallel_for(worker_threads, waves[w].size(), sat);
+
+        // Pass the weights on to the later SCCs, in SCC order
+        for(unsigned i = 0; i < waves[w].size(); i++) {
+          std::vector<DeferredUpdate> &updates = sat.deferred[i];
+          for(unsigned u = 0; u < updates.size(); u++) {
+            updates[u].gr->updateEdgeWeight(updates[u].src, updates[u].tgt, updates[u].weight);
+          }
+          STAT(stats.niter += sat.wave_stats[i].niter);
+          STAT(stats.nextend += sat.wave_stats[i].nextend);
+          numSteps += sat.steps[i];
+        }
+      }
+      return numSteps;
+    }
+
     std::ostream &InterGraph::print_stats(std::ostream &out) {
       InterGraphStats total_stats = stats;
       int n = nodes.size();
@@ -1349,6 +1691,14 @@ namespace wali {
       total_stats.nnodes = nodes.size();
 
       RegExpStats rst = dag->get_stats();
+      for(unsigned d = 0; d < graph_dags.size(); d++) {
+        RegExpStats gst = graph_dags[d]->get_stats();
+        rst.nstar += gst.nstar;
+        rst.nextend += gst.nextend;
+        rst.ncombine += gst.ncombine;
+        rst.hashmap_hits += gst.hashmap_hits;
+        rst.hashmap_misses += gst.hashmap_misses;
+      }
       total_stats.ncombine += rst.ncombine;
       total_stats.nextend += rst.nextend;
       total_stats.nstar += rst.nstar;
@@ -1385,10 +1735,13 @@ namespace wali {
     }
 
     // New Saturation Procedure -- minimize calls to get_weight
-    int InterGraph::saturate(multiset<tup> &worklist, unsigned scc_n) {
+    int InterGraph::saturate(multiset<tup> &worklist, unsigned scc_n,
+        std::vector<DeferredUpdate> *deferred, InterGraphStats *st) {
       int numSteps = 0;
       sem_elem_t weight;
       std::list<int> *moutnodes;
+      if(st == NULL)
+        st = &stats;
 
       while(!worklist.empty()) {
         // Get an outnode whose weight is to be propagated
@@ -1404,7 +1757,7 @@ namespace wali {
           continue;
         nodes[onode].weight = weight;
 
-        STAT(stats.niter++);
+        STAT(st->niter++);
 
         FWPDSDBGS(
             cout << "Popped ";
@@ -1430,8 +1783,13 @@ namespace wali {
           } else {
             uw = inter_edges[*beg].weight->extend(weight);
           }
-          STAT(stats.nextend++);
-          nodes[inode].gr->updateEdgeWeight(nodes[onode1].intra_nodeno, nodes[inode].intra_nodeno, uw);
+          STAT(st->nextend++);
+          if(deferred && nodes[inode].gr->scc_number != scc_n) {
+            DeferredUpdate u = { nodes[inode].gr, nodes[onode1].intra_nodeno, nodes[inode].intra_nodeno, uw };
+            deferred->push_back(u);
+          } else {
+            nodes[inode].gr->updateEdgeWeight(nodes[onode1].intra_nodeno, nodes[inode].intra_nodeno, uw);
+          }
         }
         // Go through all targets again and insert them into the workist without
         // seeing if they actually got modified or not
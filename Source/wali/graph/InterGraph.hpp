@@ -87,6 +87,8 @@ namespace wali {
          ETransHandler() {}
          bool exists(int ret);
          void addEdge(int call, int ret, sem_elem_t wtCallRule);
+         /// Replaces the weight of the dependency of ret
+         void setWeight(int ret, sem_elem_t wtCallRule);
          /**
           * If using Newton Method based on tensored weights, these weights need to be tensored as well.
           **/
@@ -235,6 +237,29 @@ namespace wali {
             bool running_prestar;
             InterGraphStats stats;
 
+            unsigned worker_threads;
+
+            /// The IntraGraphs' own RegExpDags when solved with more than
+            /// one thread; empty otherwise. See setWorkerThreads.
+            std::vector<RegExpDag *> graph_dags;
+
+            /// IntraGraphs with an edge changed since the last solution.
+            /// See updateInterSolution.
+            std::set<IntraGraph *> changed_graphs;
+
+            /// New weights for source nodes, by node number, taken up when
+            /// their IntraGraphs are rebuilt. See setSourceWeight.
+            std::map<int, wali::sem_elem_t> changed_sources;
+
+            /// A new weight for an edge of an IntraGraph in a later SCC,
+            /// held back until the current wave of SCCs is saturated
+            struct DeferredUpdate {
+              IntraGraph * gr;
+              int src;
+              int tgt;
+              sem_elem_t weight;
+            };
+
             static std::ostream &defaultPrintOp(std::ostream &out, int a) {
               out << a;
               return out;
@@ -249,18 +274,80 @@ namespace wali {
           public:
             InterGraph(wali::sem_elem_t s, bool e, bool pre, bool n = false);
             ~InterGraph();
-            void addEdge(Transition src, Transition tgt, wali::sem_elem_t se);
-            void addEdge(Transition src1, Transition src2, Transition tgt, wali::sem_elem_t se);
-            void addEdge(Transition src1, Transition src2, Transition tgt, wali::merge_fn_t mf);
-            void addCallRetEdge(Transition src, Transition tgt, wali::sem_elem_t se);
+            /// @return the number of the (intra) edge
+            int addEdge(Transition src, Transition tgt, wali::sem_elem_t se);
+            /// @return the number of the hyper edge
+            int addEdge(Transition src1, Transition src2, Transition tgt, wali::sem_elem_t se);
+            /// @return the number of the hyper edge
+            int addEdge(Transition src1, Transition src2, Transition tgt, wali::merge_fn_t mf);
+            /// @return the node number of tgt, whose weight depends on se
+            int addCallRetEdge(Transition src, Transition tgt, wali::sem_elem_t se);
 
             void addCallEdge(Transition src1, Transition src2);
 
             void setSource(Transition t, wali::sem_elem_t se);
             void setESource(Transition t, wali::sem_elem_t wtAtCall, wali::sem_elem_t wtAfterCall);
+            /// @return the node number of t, or -1 if t is not a source
+            int sourceNode(Transition t);
 
             void setupInterSolution(std::list<Transition> *wt_required = NULL);
 
+            /**
+             * Change the weight (or merge function) of an edge added with
+             * addEdge or addCallRetEdge, or the weight of the source node
+             * numbered n (see sourceNode). After setupInterSolution, the
+             * change takes effect on the next call to updateInterSolution.
+             */
+            void setEdgeWeight(int eno, wali::sem_elem_t se);
+            void setHyperEdgeWeight(int eno, wali::sem_elem_t se);
+            void setHyperEdgeMergeFn(int eno, wali::merge_fn_t mf);
+            void setCallRetWeight(int ret, wali::sem_elem_t se);
+            void setSourceWeight(int n, wali::sem_elem_t se);
+
+            /**
+             * Brings the solution computed by setupInterSolution up to date
+             * with the edge weights changed since. Only the IntraGraphs in
+             * an SCC with a changed edge, or in an SCC that such an SCC
+             * passes weights to, have their regular expressions rebuilt and
+             * are saturated again; the others keep their weights. The
+             * nodes and edges of the InterGraph must be unchanged. Not
+             * supported after setupNewtonSolution.
+             *
+             * @return the number of SCCs that were saturated again
+             */
+            unsigned updateInterSolution();
+
+            /**
+             * Set the number of threads setupInterSolution uses. 1 (the
+             * default) solves the IntraGraphs one SCC at a time; 0 uses one
+             * thread per hardware thread.
+             *
+             * With more than one thread, each IntraGraph gets a RegExpDag
+             * of its own instead of sharing 'dag', so that the path
+             * sequences and regular expressions of different IntraGraphs
+             * can be built and evaluated on different threads. The SCCs of
+             * the IntraGraph call graph are then saturated in topological
+             * waves: the SCCs in a wave do not depend on each other, so they
+             * are saturated concurrently, and the weights they pass to
+             * later SCCs are applied once the wave is done. The answer is
+             * the same as the sequential one.
+             *
+             * The weight domain must be safe to use from several threads
+             * at once, and weights must be reference counted atomically
+             * (see WPDS::setWorkerThreads). Because the regular expressions
+             * no longer share a dag, this must not be used on an InterGraph
+             * that a SummaryGraph will be built from. Ignored by
+             * setupNewtonSolution and when WALi is built without
+             * threads=1.
+             */
+            void setWorkerThreads(unsigned num_threads) {
+              worker_threads = num_threads;
+            }
+
+            unsigned getWorkerThreads() const {
+              return worker_threads;
+            }
+
             /**
              * @brief From the given TDG (The original InterGraph), create linearized TDGs corresponding
              * to each step of Newton. Then, solve the poststar problem by executing steps of the newton's 
@@ -334,7 +421,27 @@ namespace wali {
                 SCCGraphs& grsorted);
 
 
-            int saturate(std::multiset<tup> &worklist, unsigned scc_n);
+            int saturate(std::multiset<tup> &worklist, unsigned scc_n,
+                std::vector<DeferredUpdate> *deferred = NULL,
+                InterGraphStats *st = NULL);
+
+            /**
+             * Saturates SCCs 1..max_scc_required of gr_sorted in
+             * topological waves on worker_threads threads.
+             * @return the total number of saturation steps
+             **/
+            int parallelSaturate(std::list<IntraGraph *> &gr_sorted,
+                unsigned components, unsigned max_scc_required);
+
+            class SccSaturator;
+            friend class SccSaturator;
+
+            /**
+             * Builds a new IntraGraph, in the current sat process of dag,
+             * for the nodes of the InterGraph that belong to old, and
+             * replaces old with it.
+             **/
+            IntraGraph * rebuildIntraGraph(IntraGraph *old);
 
             void setup_worklist(std::list<IntraGraph *> &gr_sorted, 
                 std::list<IntraGraph *>::iterator &gr_it, 
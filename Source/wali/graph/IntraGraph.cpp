@@ -722,6 +722,11 @@ namespace wali {
       // Initialize for a backward query from outnode
       node_pop_weight[outnode] = se->one();
 
+      if(se->hasBatchOperations()) {
+        calculatePopWeightsBatched();
+        return;
+      }
+
       // Solve for weights from the path sequence (Go in reverse order)
       for(i=(int)path_sequence.size() - 1; i >= 0; i--) {
         PathSequence &ps = path_sequence[i];
@@ -734,6 +739,61 @@ namespace wali {
       }
     }
 
+    // The path-sequence loop of calculatePopWeights, for weights with
+    // batch operations. The steps are cut into runs in which no step
+    // reads a node that an earlier step of the run writes; the extends
+    // of a run are independent, so they are done with one extendMany,
+    // and the weights flowing into each node with one combineMany.
+    void IntraGraph::calculatePopWeightsBatched() {
+      int n = nnodes;
+      vector<bool> written(n, false);
+      vector< vector<SemElem*> > incoming(n);
+      vector<int> touched;
+
+      int i = (int)path_sequence.size() - 1;
+      while(i >= 0) {
+        vector<int> run;
+        vector<sem_elem_t> weights;
+        vector<SemElem*> lhs, rhs;
+        for( ; i >= 0; i--) {
+          PathSequence &ps = path_sequence[i];
+          if(written[ps.tgt]) {
+            break;
+          }
+          written[ps.src] = true;
+          run.push_back(i);
+          weights.push_back(ps.regexp->get_weight());
+          lhs.push_back(weights.back().get_ptr());
+          rhs.push_back(node_pop_weight[ps.tgt].get_ptr());
+        }
+
+        vector<sem_elem_t> extended(run.size());
+        se->extendMany(&lhs[0], &rhs[0], run.size(), &extended[0]);
+
+        // A step with src == tgt replaces the weight; it comes before
+        // any step of the run that combines into the same node, since
+        // those would have ended the run
+        for(size_t k = 0; k < run.size(); k++) {
+          PathSequence &ps = path_sequence[run[k]];
+          written[ps.src] = false;
+          if(ps.src == ps.tgt) {
+            node_pop_weight[ps.src] = extended[k];
+          } else {
+            if(incoming[ps.src].empty()) {
+              touched.push_back(ps.src);
+            }
+            incoming[ps.src].push_back(extended[k].get_ptr());
+          }
+        }
+        for(size_t k = 0; k < touched.size(); k++) {
+          int v = touched[k];
+          node_pop_weight[v] = node_pop_weight[v]->combineMany(&incoming[v][0], incoming[v].size());
+          incoming[v].clear();
+        }
+        touched.clear();
+      }
+    }
+
     // Return the pop weight
     // precondition: calculatePopWeights must have already
     // been called.
@@ -385,6 +385,7 @@ namespace wali {
 
             sem_elem_t popWeight(int nno);
             void calculatePopWeights(int eps_nno);
+            void calculatePopWeightsBatched();
 
             void solveRegSummarySolution();
             void preSolveRegSummarySolution();
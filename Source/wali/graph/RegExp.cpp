@@ -5,6 +5,7 @@
 #include <iterator>
 #include <cassert>
 #include <sstream>
+#include <vector>
 
 #if defined(PPP_DBG)
 #include "wali/SemElemTensor.hpp"
@@ -1547,19 +1548,35 @@ namespace wali {
                               sem_elem_t wnew = value;
                               sem_elem_t wchange = value->zero();
                               unsigned max = last_change;
+#ifdef DWPDS
+                              bool batch = false;
+#else
+                              // Combine the changed children in one go
+                              // if the weights can
+                              bool batch = value->hasBatchOperations();
+#endif
+                              std::vector<SemElem*> changes;
                               for(ch = children.begin(); ch != children.end(); ch++) {
                                   (*ch)->evaluate();
                                   if((*ch)->last_change > last_seen) {
+                                      if(batch) {
+                                          changes.push_back((*ch)->value.get_ptr());
+                                      } else {
 #ifdef DWPDS
-                                      wchange = wchange->combine((*ch)->get_delta(last_seen));
+                                          wchange = wchange->combine((*ch)->get_delta(last_seen));
 #else
-                                      wchange = wchange->combine((*ch)->value);
+                                          wchange = wchange->combine((*ch)->value);
 #endif
+                                      }
                                       max = ((*ch)->last_change > max) ? (*ch)->last_change : max;
                                       STAT(dag->stats.ncombine++);
                                   }
                               }
-                              wnew = wnew->combine(wchange);
+                              if(batch) {
+                                  wnew = changes.empty() ? wnew : wnew->combineMany(&changes[0], changes.size());
+                              } else {
+                                  wnew = wnew->combine(wchange);
+                              }
 
                               if(!value->equal(wnew)) {
                                   last_change = max;
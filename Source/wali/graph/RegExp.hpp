@@ -493,6 +493,9 @@ namespace wali {
             void topDownEval(bool f) {
               top_down_eval = f;
             }
+            bool isTopDownEval() const {
+              return top_down_eval;
+            }
 
             RegExpStats get_stats() {
               return stats;
@@ -11,13 +11,105 @@
 #include <climits>
 #include <iostream>
 
+/*
+ * Reference-count policy. With 'scons refcount=atomic' (the default when
+ * building with threads=1), WALI_ATOMIC_REFCOUNT is defined and
+ * Countable::count is a std::atomic, so weights, witnesses, etc. can be
+ * shared between threads -- which the parallel solvers need. Otherwise
+ * the count is a plain unsigned int.
+ */
+#ifndef WALI_ATOMIC_REFCOUNT
+#  define WALI_ATOMIC_REFCOUNT 0
+#endif
+
+#if WALI_ATOMIC_REFCOUNT
+#  include <atomic>
+#endif
+
+#if __cplusplus >= 201103L || defined(__GXX_EXPERIMENTAL_CXX0X__)
+#  define WALI_REF_PTR_HAS_MOVE 1
+#else
+#  define WALI_REF_PTR_HAS_MOVE 0
+#endif
+
 namespace wali
 {
+  namespace details
+  {
+#if WALI_ATOMIC_REFCOUNT
+    /**
+     * An atomic reference count. Taking a reference only needs relaxed
+     * ordering (whoever hands out the pointer already holds one), while
+     * dropping one is acq_rel so that the thread which deletes the object
+     * sees every other thread's writes to it.
+     *
+     * Reads through the conversion to unsigned are relaxed and only good
+     * for assertions and heuristics.
+     */
+    class AtomicCount
+    {
+      public:
+        AtomicCount( unsigned int n = 0 ) : value(n) {}
+
+        /// Copying an object does not copy its references
+        AtomicCount( const AtomicCount& ) : value(0) {}
+        AtomicCount& operator=( const AtomicCount& ) { return *this; }
+
+        /// Sets the count outright, as a plain count would be (e.g. to
+        /// pin an object that is never freed)
+        AtomicCount& operator=( unsigned int n ) {
+          value.store(n, std::memory_order_relaxed);
+          return *this;
+        }
+
+        operator unsigned int() const {
+          return value.load(std::memory_order_relaxed);
+        }
+
+        void increment() {
+          value.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /// Returns the count after decrementing
+        unsigned int decrement() {
+          return value.fetch_sub(1, std::memory_order_acq_rel) - 1;
+        }
+
+      private:
+        std::atomic<unsigned int> value;
+    };
+
+    inline void count_acquire( AtomicCount& count ) {
+      count.increment();
+    }
+
+    inline bool count_release( AtomicCount& count ) {
+      return count.decrement() == 0;
+    }
+#endif
+
+    /// Classes that keep their own 'count' member (rather than
+    /// inheriting from Countable) get plain, non-atomic counting.
+    template< typename Count >
+    inline void count_acquire( Count& count ) {
+      ++count;
+    }
+
+    /// Returns true if that was the last reference
+    template< typename Count >
+    inline bool count_release( Count& count ) {
+      return --count == 0;
+    }
+  }
 
   /**
    * @class ref_ptr
    * @brief A reference counting pointer class
-   * @warning This class is *NOT* thread safe.
+   * @warning Unless WALi is built with an atomic reference count (see
+   * WALI_ATOMIC_REFCOUNT above), this class is *NOT* thread safe. Even
+   * then, a single ref_ptr object must not be modified by one thread
+   * while another reads it; it is the pointed-to object that may be
+   * shared.
    *
    * The templated class should use the mixin Countable. When using Countable
    * simply pass a boolean true or false to the rcmix constructor.  The default
@@ -43,9 +135,14 @@ namespace wali
 
   template< typename T > class ref_ptr
   {
+      template< typename S > friend class ref_ptr;
 
     public:
+#if WALI_ATOMIC_REFCOUNT
+      typedef details::AtomicCount count_t;
+#else
       typedef unsigned int count_t;
+#endif
 
       ref_ptr( T *t = 0 ) {
         acquire(t);
@@ -62,6 +159,30 @@ namespace wali
         acquire( rp.get_ptr() );
       }
 
+#if WALI_REF_PTR_HAS_MOVE
+      /**
+       * Moving steals the reference, so temporaries (e.g., the result of
+       * extend() passed straight to combine()) do not touch the count.
+       */
+      ref_ptr( ref_ptr&& rp ) : ptr(rp.ptr) {
+        rp.ptr = 0;
+      }
+
+      template< typename S > ref_ptr<T>( ref_ptr<S>&& rp ) : ptr(rp.ptr) {
+        rp.ptr = 0;
+      }
+
+      ref_ptr& operator=( ref_ptr&& rp ) {
+        if( this != &rp ) {
+          T * old_ptr = ptr;
+          ptr = rp.ptr;
+          rp.ptr = 0;
+          release(old_ptr);
+        }
+        return *this;
+      }
+#endif
+
       ~ref_ptr() {
         release();
       }
@@ -114,7 +235,7 @@ namespace wali
       {
         ptr = t;
         if( t ) {
-          ++t->count;
+          details::count_acquire(t->count);
 #ifdef DBGREFPTR
           std::cout << "Acquired " << t << " with count = "
             << t->count << std::endl;
@@ -125,12 +246,15 @@ namespace wali
       static void release( T * old_ptr )
       {
         if( old_ptr ) {
-          --old_ptr->count;
+          // Decide whether to delete from the value the decrement
+          // produced; re-reading the count could race with another
+          // thread's release.
+          bool last = details::count_release(old_ptr->count);
 #ifdef DBGREFPTR
           std::cout << "Released " << *old_ptr << " with count = "
             << old_ptr->count << std::endl;
 #endif
-          if( old_ptr->count == 0 ) {
+          if( last ) {
 #ifdef DBGREFPTR
             std::cout << "Deleting ptr: " << *old_ptr << std::endl;
 #endif
@@ -0,0 +1,202 @@
+#include "wali/util/Arena.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace wali
+{
+  namespace util
+  {
+    namespace
+    {
+      void* alignedAllocate( size_t bytes, size_t alignment )
+      {
+#if defined(_WIN32)
+        void* p = _aligned_malloc(bytes, alignment);
+#else
+        void* p = 0;
+        if( posix_memalign(&p, alignment, bytes) != 0 ) {
+          p = 0;
+        }
+#endif
+        if( p == 0 ) {
+          throw std::bad_alloc();
+        }
+        return p;
+      }
+
+      void alignedFree( void* p )
+      {
+#if defined(_WIN32)
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+      }
+
+      size_t powerOfTwo( size_t bytes )
+      {
+        size_t p = Arena::ALIGNMENT;
+        while( p < bytes ) {
+          p *= 2;
+        }
+        return p;
+      }
+    }
+
+    Arena::Arena( size_t the_block_size )
+      : block_size(powerOfTwo(the_block_size))
+      , spare(0)
+      , reserved_bytes(0)
+    {
+      std::memset(cur, 0, sizeof(cur));
+      std::memset(end, 0, sizeof(end));
+      std::memset(free_lists, 0, sizeof(free_lists));
+    }
+
+    Arena::~Arena()
+    {
+      release();
+    }
+
+    void* Arena::allocate( size_t bytes )
+    {
+      bytes = round(bytes == 0 ? 1 : bytes);
+
+      size_t size = bytes / ALIGNMENT - 1;
+      if( size >= NUM_SIZES || bytes > block_size ) {
+        // Objects this big get a block of their own
+        return newBlock(bytes, 0);
+      }
+
+      if( free_lists[size] ) {
+        FreeBlock* f = free_lists[size];
+        free_lists[size] = f->next;
+        return f;
+      }
+
+      if( static_cast<size_t>(end[size] - cur[size]) < bytes ) {
+        cur[size] = newBlock(block_size / bytes * bytes, bytes);
+        end[size] = cur[size] + block_size / bytes * bytes;
+      }
+      void* p = cur[size];
+      cur[size] += bytes;
+      return p;
+    }
+
+    void Arena::deallocate( void* p )
+    {
+      if( p == 0 ) {
+        return;
+      }
+      Block const * b = blockOf(p);
+      assert(b != 0);
+      size_t piece = b->piece;
+      if( piece != 0 ) {
+        FreeBlock* f = static_cast<FreeBlock*>(p);
+        f->next = free_lists[piece / ALIGNMENT - 1];
+        free_lists[piece / ALIGNMENT - 1] = f;
+      }
+      // A big object's block is reclaimed by reset() or release()
+    }
+
+    bool Arena::owns( void const * p ) const
+    {
+      return blockOf(p) != 0;
+    }
+
+    Arena::Block const * Arena::blockOf( void const * p ) const
+    {
+      char const * c = static_cast<char const *>(p);
+      block_map_t::const_iterator b = blocks.find(reinterpret_cast<size_t>(c) / block_size);
+      if( b == blocks.end() || c >= b->second.end ) {
+        return 0;
+      }
+      return &b->second;
+    }
+
+    void Arena::release()
+    {
+      for( block_map_t::iterator b = blocks.begin() ; b != blocks.end() ; ++b ) {
+        alignedFree(b->second.start);
+      }
+      blocks.clear();
+      spare = 0;
+      reserved_bytes = 0;
+      std::memset(cur, 0, sizeof(cur));
+      std::memset(end, 0, sizeof(end));
+      std::memset(free_lists, 0, sizeof(free_lists));
+    }
+
+    void Arena::reset()
+    {
+      // The blocks are chained through their first bytes, so that
+      // resetting does not allocate. (The first allocation after a big
+      // teardown can cost the heap a lot.)
+      spare = 0;
+      FreeBlock* big = 0;
+      for( block_map_t::iterator b = blocks.begin() ; b != blocks.end() ; ++b ) {
+        FreeBlock* f = reinterpret_cast<FreeBlock*>(b->second.start);
+        if( b->second.piece == 0 ) {
+          f->next = big;
+          big = f;
+        }
+        else {
+          f->next = spare;
+          spare = f;
+        }
+      }
+      while( big ) {
+        char* start = reinterpret_cast<char*>(big);
+        big = big->next;
+        size_t index = reinterpret_cast<size_t>(start) / block_size;
+        reserved_bytes -= static_cast<size_t>(blocks.find(index)->second.end - start);
+        blocks.erase(index);
+        alignedFree(start);
+      }
+      std::memset(cur, 0, sizeof(cur));
+      std::memset(end, 0, sizeof(end));
+      std::memset(free_lists, 0, sizeof(free_lists));
+    }
+
+    char* Arena::newBlock( size_t bytes, size_t piece )
+    {
+      if( piece != 0 && spare ) {
+        // Every small block spans block_size bytes, whatever its piece
+        char* block = reinterpret_cast<char*>(spare);
+        spare = spare->next;
+        Block & b = blocks.find(reinterpret_cast<size_t>(block) / block_size)->second;
+        b.end = block + bytes;
+        b.piece = piece;
+        return block;
+      }
+
+      // Every piece is a multiple of ALIGNMENT, and a block starts on a
+      // multiple of block_size, so the first block_size bytes of anything
+      // in it map to it in 'blocks'. A small block fills exactly that
+      // range (so reset() can hand it to any piece size); a big object's
+      // block may end before it (then the rest of the range is someone
+      // else's) or run past it.
+      size_t reserve = piece != 0 ? block_size : bytes;
+      char* block = static_cast<char*>(alignedAllocate(reserve, block_size));
+      Block b;
+      b.start = block;
+      b.end = block + bytes;
+      b.piece = piece;
+      blocks.insert(reinterpret_cast<size_t>(block) / block_size, b);
+      reserved_bytes += reserve;
+      return block;
+    }
+
+  } // namespace util
+} // namespace wali
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,166 @@
+#ifndef wali_util_ARENA_GUARD
+#define wali_util_ARENA_GUARD 1
+
+#include "wali/OpenHashMap.hpp"
+
+#include <cstddef>
+#include <new>
+
+namespace wali
+{
+  namespace util
+  {
+    /**
+     * @class Arena
+     *
+     * A region allocator. Memory is carved out of large blocks by bumping
+     * a pointer, and all of it is given back at once by release() (or the
+     * destructor), so objects allocated together sit next to each other
+     * and freeing them does not go through the heap one at a time.
+     *
+     * Each block holds pieces of a single size, so the arena can tell the
+     * size of a piece from its address, and objects carry no header.
+     * Blocks are aligned to the block size (a power of two), so the
+     * block a piece is in, and whether the arena owns an address at
+     * all, are found with one hash lookup on the address. A
+     * piece handed back with deallocate() goes on a free list for its
+     * size and is reused by the next allocate() of that size. This keeps
+     * an arena from growing without bound when, as in saturation, many
+     * short-lived objects of a few sizes are created and dropped.
+     *
+     * Objects are created with the placement form 'new (arena) T(...)'
+     * and destroyed with destroy(); whoever owns the arena (e.g. a WFA)
+     * must know which of its objects came from it -- see owns().
+     *
+     * An Arena is not thread safe.
+     */
+    class Arena
+    {
+      public:
+        /// Every allocation is aligned to (and rounded up to) this
+        static const size_t ALIGNMENT = 16;
+
+        /// block_size is rounded up to a power of two
+        explicit Arena( size_t block_size = 64 * 1024 );
+        ~Arena();
+
+        void* allocate( size_t bytes );
+
+        /// Hands back a piece from allocate()
+        void deallocate( void* p );
+
+        /// Whether p points into memory from this arena. p must point into
+        /// the first block_size bytes of the object, which holds for the
+        /// start of anything this arena allocated.
+        bool owns( void const * p ) const;
+
+        /// Runs the destructor of an object created by 'new (arena) T'
+        /// and hands its memory back. T must be polymorphic, so that p
+        /// may point to a base of the object.
+        template< typename T >
+        void destroy( T* p ) {
+          void* mem = dynamic_cast<void*>(p);
+          p->~T();
+          deallocate(mem);
+        }
+
+        /// Runs the destructor of an object created by 'new (arena) T' but
+        /// leaves its memory alone, for an owner that is about to reset()
+        /// or release() the arena anyway.
+        template< typename T >
+        void destruct( T* p ) {
+          p->~T();
+        }
+
+        /// Gives back every block. Anything allocated from this arena
+        /// must already be destroyed.
+        void release();
+
+        /// Like release(), but keeps the blocks of small pieces to carve
+        /// new pieces (of any size) from, instead of returning them to
+        /// the heap. Giving a block back can cost more than all the
+        /// frees the arena saved, so an owner that is cleared and filled
+        /// again, like a WFA, resets its arena and leaves release() to
+        /// the destructor.
+        void reset();
+
+        /// Number of bytes obtained from the heap
+        size_t reserved() const { return reserved_bytes; }
+
+      private:
+        struct FreeBlock
+        {
+          FreeBlock* next;
+        };
+
+        struct Block
+        {
+          char* start;
+          char* end;
+          /// The size of each piece; 0 for a block holding one big object
+          size_t piece;
+        };
+
+        struct IndexHash
+        {
+          size_t operator()( size_t index ) const { return index; }
+        };
+
+        struct IndexEqual
+        {
+          bool operator()( size_t a, size_t b ) const { return a == b; }
+        };
+
+        /// Address / block_size -> the block that starts there
+        typedef HotHashMap< size_t, Block, IndexHash, IndexEqual >::type block_map_t;
+
+        // Sizes up to NUM_SIZES * ALIGNMENT get blocks of their own size
+        enum { NUM_SIZES = 32 };
+
+        static size_t round( size_t bytes ) {
+          return (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        }
+
+        char* newBlock( size_t bytes, size_t piece );
+
+        /// The block p points into, or 0
+        Block const * blockOf( void const * p ) const;
+
+        Arena( Arena const & );
+        Arena & operator=( Arena const & );
+
+        size_t block_size;
+        /// To find the size of a piece, and what the arena owns
+        block_map_t blocks;
+        /// Small blocks kept by reset() that nothing is carved from yet
+        FreeBlock* spare;
+        /// The unused part of the current block of each size
+        char* cur[NUM_SIZES];
+        char* end[NUM_SIZES];
+        FreeBlock* free_lists[NUM_SIZES];
+        size_t reserved_bytes;
+    };
+
+  } // namespace util
+} // namespace wali
+
+
+/// 'new (arena) T(...)' allocates the object from an Arena
+inline void* operator new( size_t bytes, wali::util::Arena & arena )
+{
+  return arena.allocate(bytes);
+}
+
+/// Only called if a constructor throws
+inline void operator delete( void* p, wali::util::Arena & arena )
+{
+  arena.deallocate(p);
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif // wali_util_ARENA_GUARD
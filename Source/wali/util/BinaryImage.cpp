@@ -0,0 +1,301 @@
+#include "wali/util/BinaryImage.hpp"
+#include "wali/Key.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace wali
+{
+  namespace util
+  {
+    typedef BinaryImageWriter::Word Word;
+
+    const Word BinaryImageWriter::FIRST_SECTION;
+
+    namespace
+    {
+      // Layout of the header, in words
+      enum { HEADER_MAGIC, HEADER_VERSION, HEADER_BYTE_ORDER, HEADER_NUM_SECTIONS, SECTION_TABLE };
+
+      const Word BYTE_ORDER_MARK = 0x01020304;
+
+      Word magicWord( char const * magic )
+      {
+        Word w;
+        std::memcpy(&w, magic, sizeof(w));
+        return w;
+      }
+
+      /// 's' as a number of words, copied into 'out'
+      void toWords( std::string const & s, std::vector<Word> & out )
+      {
+        out.assign((s.size() + sizeof(Word) - 1) / sizeof(Word), 0);
+        if( !s.empty() ) {
+          std::memcpy(&out[0], s.data(), s.size());
+        }
+      }
+    }
+
+
+    BinaryImageWriter::BinaryImageWriter( char const * m, Word v, Word num_sections )
+      : magic(m, sizeof(Word))
+      , version(v)
+      , sections(num_sections)
+    {
+      assert(num_sections >= FIRST_SECTION);
+    }
+
+
+    Word
+    BinaryImageWriter::addString( std::string const & s )
+    {
+      std::map< std::string, Word >::const_iterator it = string_ids.find(s);
+      if( it != string_ids.end() ) {
+        return it->second;
+      }
+      std::vector<Word> & offsets = sections[0];
+      if( offsets.empty() ) {
+        offsets.push_back(0);
+      }
+      Word id = static_cast<Word>(offsets.size() - 1);
+      string_bytes += s;
+      string_bytes += '\0';
+      offsets.push_back(static_cast<Word>(string_bytes.size()));
+      string_ids[s] = id;
+      return id;
+    }
+
+
+    Word
+    BinaryImageWriter::addKey( Key key )
+    {
+      return addString(key2str(key));
+    }
+
+
+    std::vector<Word> &
+    BinaryImageWriter::section( Word section )
+    {
+      assert(section >= FIRST_SECTION && section < sections.size());
+      return sections[section];
+    }
+
+
+    void
+    BinaryImageWriter::write( std::ostream & os ) const
+    {
+      std::vector<Word> offsets(sections[0]);
+      if( offsets.empty() ) {
+        offsets.push_back(0);
+      }
+      std::vector<Word> bytes;
+      toWords(string_bytes, bytes);
+
+      std::vector<Word> header(SECTION_TABLE + sections.size() + 1);
+      header[HEADER_MAGIC] = magicWord(magic.c_str());
+      header[HEADER_VERSION] = version;
+      header[HEADER_BYTE_ORDER] = BYTE_ORDER_MARK;
+      header[HEADER_NUM_SECTIONS] = static_cast<Word>(sections.size());
+
+      Word at = static_cast<Word>(header.size());
+      for( size_t i = 0 ; i < sections.size() ; i++ ) {
+        header[SECTION_TABLE + i] = at;
+        at += static_cast<Word>(i == 0 ? offsets.size()
+                                : i == 1 ? bytes.size()
+                                : sections[i].size());
+      }
+      header[SECTION_TABLE + sections.size()] = at;
+
+      os.write(reinterpret_cast<char const *>(&header[0]), header.size() * sizeof(Word));
+      for( size_t i = 0 ; i < sections.size() ; i++ ) {
+        std::vector<Word> const & words = (i == 0 ? offsets : i == 1 ? bytes : sections[i]);
+        if( !words.empty() ) {
+          os.write(reinterpret_cast<char const *>(&words[0]), words.size() * sizeof(Word));
+        }
+      }
+    }
+
+
+    BinaryImage::BinaryImage( std::string const & path, char const * magic, Word version )
+      : words(NULL)
+      , num_words(0)
+      , num_sections(0)
+      , mapped_bytes(0)
+    {
+#ifndef _WIN32
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if( fd < 0 ) {
+        throw BadImageException("cannot open " + path);
+      }
+      struct stat st;
+      if( ::fstat(fd, &st) == 0 && st.st_size > 0 ) {
+        void * p = ::mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if( p != MAP_FAILED ) {
+          words = static_cast<Word const *>(p);
+          mapped_bytes = st.st_size;
+          num_words = mapped_bytes / sizeof(Word);
+        }
+      }
+      ::close(fd);
+#endif
+      if( !words ) {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        if( !in ) {
+          throw BadImageException("cannot open " + path);
+        }
+        read(in);
+      }
+      try {
+        check(magic, version);
+      }
+      catch( ... ) {
+        unmap();
+        throw;
+      }
+    }
+
+
+    BinaryImage::BinaryImage( std::istream & is, char const * magic, Word version )
+      : words(NULL)
+      , num_words(0)
+      , num_sections(0)
+      , mapped_bytes(0)
+    {
+      read(is);
+      check(magic, version);
+    }
+
+
+    BinaryImage::~BinaryImage()
+    {
+      unmap();
+    }
+
+
+    void
+    BinaryImage::read( std::istream & is )
+    {
+      std::string bytes((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+      toWords(bytes, buffer);
+      words = buffer.empty() ? NULL : &buffer[0];
+      num_words = bytes.size() / sizeof(Word);
+    }
+
+
+    void
+    BinaryImage::unmap()
+    {
+#ifndef _WIN32
+      if( mapped_bytes ) {
+        ::munmap(const_cast<Word *>(words), mapped_bytes);
+        mapped_bytes = 0;
+        words = NULL;
+      }
+#endif
+    }
+
+
+    void
+    BinaryImage::check( char const * magic, Word version )
+    {
+      if( num_words < SECTION_TABLE || words[HEADER_MAGIC] != magicWord(magic) ) {
+        throw BadImageException(std::string("not a binary image of kind ")
+                                + std::string(magic, sizeof(Word)));
+      }
+      if( words[HEADER_BYTE_ORDER] != BYTE_ORDER_MARK ) {
+        throw BadImageException("binary image was written with a different byte order");
+      }
+      if( words[HEADER_VERSION] != version ) {
+        throw BadImageException("binary image has an unsupported version");
+      }
+
+      num_sections = words[HEADER_NUM_SECTIONS];
+      if( num_sections < BinaryImageWriter::FIRST_SECTION
+          || SECTION_TABLE + num_sections + 1 > num_words )
+      {
+        throw BadImageException("binary image is truncated");
+      }
+      Word const * table = words + SECTION_TABLE;
+      if( table[0] != SECTION_TABLE + num_sections + 1 || table[num_sections] != num_words ) {
+        throw BadImageException("binary image is truncated");
+      }
+      for( size_t i = 0 ; i < num_sections ; i++ ) {
+        if( table[i] > table[i + 1] ) {
+          throw BadImageException("binary image has a bad section table");
+        }
+      }
+
+      // Every string must end inside the character section, and the last
+      // one with a NUL, so that none runs off the end
+      size_t count = sectionSize(0);
+      Word const * offsets = section(0);
+      size_t bytes = sectionSize(1) * sizeof(Word);
+      if( count == 0 || offsets[0] != 0 ) {
+        throw BadImageException("binary image has a bad string table");
+      }
+      for( size_t i = 1 ; i < count ; i++ ) {
+        if( offsets[i] <= offsets[i - 1] || offsets[i] > bytes ) {
+          throw BadImageException("binary image has a bad string table");
+        }
+      }
+      if( count > 1
+          && reinterpret_cast<char const *>(section(1))[offsets[count - 1] - 1] != '\0' )
+      {
+        throw BadImageException("binary image has a bad string table");
+      }
+      keys.assign(count - 1, WALI_BAD_KEY);
+    }
+
+
+    Word const *
+    BinaryImage::section( Word section ) const
+    {
+      assert(section < num_sections);
+      return words + words[SECTION_TABLE + section];
+    }
+
+
+    size_t
+    BinaryImage::sectionSize( Word section ) const
+    {
+      assert(section < num_sections);
+      return words[SECTION_TABLE + section + 1] - words[SECTION_TABLE + section];
+    }
+
+
+    char const *
+    BinaryImage::string( Word id ) const
+    {
+      assert(id < numStrings());
+      return reinterpret_cast<char const *>(section(1)) + section(0)[id];
+    }
+
+
+    Key
+    BinaryImage::key( Word id ) const
+    {
+      assert(id < keys.size());
+      if( keys[id] == WALI_BAD_KEY ) {
+        keys[id] = getKey(string(id));
+      }
+      return keys[id];
+    }
+
+  }
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,142 @@
+#ifndef wali_util_BINARY_IMAGE_GUARD
+#define wali_util_BINARY_IMAGE_GUARD 1
+
+#include "wali/Common.hpp"
+
+#include <boost/cstdint.hpp>
+
+#include <iosfwd>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace wali
+{
+  namespace util
+  {
+    /**
+     * Thrown when a file is not a binary image of the expected kind: the
+     * magic number, version, or byte order differ, or it is truncated.
+     */
+    struct BadImageException : std::runtime_error
+    {
+      explicit BadImageException( std::string const & what )
+        : std::runtime_error(what)
+      {}
+    };
+
+
+    /**
+     * @class BinaryImageWriter
+     *
+     * Lays out a binary image: a header, a table of sections, and the
+     * sections themselves, each an array of 32-bit words. Sections 0 and
+     * 1 hold a string table (the offsets of the strings, then their
+     * NUL-terminated characters), which addString() fills in; the format
+     * built on top numbers its own sections from FIRST_SECTION on and
+     * refers to names by their index in the string table.
+     *
+     * Words are written in the byte order of the machine; a reader on a
+     * machine with the other byte order rejects the image.
+     *
+     * @see BinaryImage
+     */
+    class BinaryImageWriter
+    {
+      public:
+        typedef boost::uint32_t Word;
+
+        /// Section numbers below this one belong to the string table
+        static const Word FIRST_SECTION = 2;
+
+        /// 'magic' is four characters that tell formats apart
+        BinaryImageWriter( char const * magic, Word version, Word num_sections );
+
+        /// The index of 's' in the string table, adding it the first time
+        Word addString( std::string const & s );
+
+        /// The index of the name of 'key' in the string table
+        Word addKey( Key key );
+
+        /// The contents of section 'section' (which is at least
+        /// FIRST_SECTION), to fill in before write()
+        std::vector<Word> & section( Word section );
+
+        void write( std::ostream & os ) const;
+
+      private:
+        std::string magic;
+        Word version;
+        std::vector< std::vector<Word> > sections;
+        std::map< std::string, Word > string_ids;
+        std::string string_bytes;
+    };
+
+
+    /**
+     * @class BinaryImage
+     *
+     * A binary image written by BinaryImageWriter. The image is mapped
+     * into memory when it is read from a file on a POSIX system, so
+     * opening one reads only the pages that are then looked at; otherwise
+     * it is read into a buffer. The sections are used in place.
+     *
+     * Names are turned into Keys the first time key() is asked for them,
+     * and remembered, so a name that is never looked at is never interned.
+     * This makes a BinaryImage not thread safe.
+     */
+    class BinaryImage
+    {
+      public:
+        typedef BinaryImageWriter::Word Word;
+
+        /// Maps the file at 'path'
+        BinaryImage( std::string const & path, char const * magic, Word version );
+
+        /// Reads the rest of 'is'
+        BinaryImage( std::istream & is, char const * magic, Word version );
+
+        ~BinaryImage();
+
+        size_t numSections() const { return num_sections; }
+
+        /// The first word of section 'section', and its size in words
+        Word const * section( Word section ) const;
+        size_t sectionSize( Word section ) const;
+
+        size_t numStrings() const { return sectionSize(0) - 1; }
+        char const * string( Word id ) const;
+
+        /// The Key named by string 'id'
+        Key key( Word id ) const;
+
+        /// Whether the words come from a memory-mapped file
+        bool isMapped() const { return mapped_bytes != 0; }
+
+      private:
+        void read( std::istream & is );
+        void unmap();
+        void check( char const * magic, Word version );
+
+        BinaryImage( BinaryImage const & );
+        BinaryImage & operator=( BinaryImage const & );
+
+        Word const * words;
+        size_t num_words;
+        size_t num_sections;
+        std::vector<Word> buffer;         // when not mapped
+        size_t mapped_bytes;
+        mutable std::vector<Key> keys;    // WALI_BAD_KEY until interned
+    };
+
+  }
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif  // wali_util_BINARY_IMAGE_GUARD
@@ -0,0 +1,173 @@
+#ifndef wali_util_THREADS_GUARD
+#define wali_util_THREADS_GUARD 1
+
+/*
+ * Thin layer over the C++11 threading library.
+ *
+ * The multi-threaded solvers are only compiled when WALi is built with
+ * 'scons threads=1', which defines WALI_THREADS. Without it, the parallel
+ * entry points still exist but fall back to the sequential algorithms, so
+ * clients do not need to #ifdef their calls.
+ */
+
+#ifndef WALI_THREADS
+#  define WALI_THREADS 0
+#endif
+
+#include <cstddef>
+
+#if WALI_THREADS
+#  include <atomic>
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+#  include <vector>
+#endif
+
+namespace wali
+{
+  namespace util
+  {
+#if WALI_THREADS
+    typedef std::mutex Mutex;
+    typedef std::lock_guard<std::mutex> LockGuard;
+
+    /// std::atomic, plus a constructor that C++98 code can call
+    template<typename T>
+    class Atomic : public std::atomic<T>
+    {
+    public:
+      explicit Atomic( T t = T() ) : std::atomic<T>(t) {}
+
+    private:
+      Atomic( Atomic const & );
+      Atomic & operator=( Atomic const & );
+    };
+#else
+    /// Single-threaded stand-ins with the same interface as the C++11
+    /// types they replace. They do nothing (or the obvious thing).
+    class Mutex
+    {
+    public:
+      void lock() {}
+      void unlock() {}
+    };
+
+    class LockGuard
+    {
+    public:
+      explicit LockGuard( Mutex & ) {}
+    };
+
+    template<typename T>
+    class Atomic
+    {
+    public:
+      explicit Atomic( T t = T() ) : value(t) {}
+
+      T load() const { return value; }
+      void store( T t ) { value = t; }
+      T fetch_add( T d ) { T old = value; value += d; return old; }
+      T fetch_sub( T d ) { T old = value; value -= d; return old; }
+
+      bool compare_exchange_strong( T & expected, T desired )
+      {
+        if( value == expected ) {
+          value = desired;
+          return true;
+        }
+        expected = value;
+        return false;
+      }
+
+    private:
+      Atomic( Atomic const & );
+      Atomic & operator=( Atomic const & );
+
+      T value;
+    };
+#endif
+
+    /// Returns the number of threads that can usefully run at once, or 1
+    /// if WALi was built without thread support.
+    inline
+    unsigned
+    hardware_threads()
+    {
+#if WALI_THREADS
+      unsigned n = std::thread::hardware_concurrency();
+      return n == 0 ? 1 : n;
+#else
+      return 1;
+#endif
+    }
+
+    /// Clamps a requested thread count to something the build supports.
+    /// Zero means "as many as the hardware has".
+    inline
+    unsigned
+    effective_threads(unsigned requested)
+    {
+#if WALI_THREADS
+      return requested == 0 ? hardware_threads() : requested;
+#else
+      (void) requested;
+      return 1;
+#endif
+    }
+
+#if WALI_THREADS
+    namespace details
+    {
+      template<typename Body>
+      void parallel_for_worker( Atomic<size_t> * next, size_t count, Body * body )
+      {
+        for( size_t i = next->fetch_add(1) ; i < count ; i = next->fetch_add(1) ) {
+          (*body)(i);
+        }
+      }
+    }
+#endif
+
+    /// Calls body(i) for each i in [0, count), using up to 'threads'
+    /// threads (clamped as by effective_threads). Indices are handed out
+    /// one at a time, so uneven pieces of work balance out. Returns once
+    /// every call has finished. With one thread, or without thread
+    /// support, the calls are made in order on the calling thread.
+    template<typename Body>
+    void
+    parallel_for( unsigned threads, size_t count, Body & body )
+    {
+      unsigned n = effective_threads(threads);
+      if( n > count ) {
+        n = static_cast<unsigned>(count);
+      }
+#if WALI_THREADS
+      if( n > 1 ) {
+        Atomic<size_t> next(0);
+        std::vector<std::thread> workers;
+        for( unsigned i = 1 ; i < n ; ++i ) {
+          workers.push_back(std::thread(&details::parallel_for_worker<Body>,
+                                        &next, count, &body));
+        }
+        details::parallel_for_worker(&next, count, &body);
+        for( size_t i = 0 ; i < workers.size() ; ++i ) {
+          workers[i].join();
+        }
+        return;
+      }
+#endif
+      for( size_t i = 0 ; i < count ; ++i ) {
+        body(i);
+      }
+    }
+  }
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif // wali_util_THREADS_GUARD
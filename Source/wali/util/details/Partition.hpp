@@ -146,26 +146,28 @@ namespace details
       const int r2 = disjoint_sets_.find_set(v2);
       if (r1 == r2) 
 	return already_equiv;
-      root_set_map_t::const_iterator it1 = rootSetMap_.find(r1);
+      root_set_map_t::iterator it1 = rootSetMap_.find(r1);
       assert(it1 != rootSetMap_.end());
-      std::list<int> s1 = it1->second;
 
-      root_set_map_t::const_iterator  it2 = rootSetMap_.find(r2);
+      root_set_map_t::iterator it2 = rootSetMap_.find(r2);
       assert(it2 != rootSetMap_.end());
-      std::list<int> s2 = it2->second;
 
-      s1.splice(s1.begin(), s2); // union the related sets
+      // union the related sets in place; copying them made a chain of
+      // merges into one large set quadratic
+      it1->second.splice(it1->second.begin(), it2->second);
 
       disjoint_sets_.link(r1, r2); // union the disjoint sets
 
-      // associate the combined related set with the new root
+      // associate the combined related set with the new root (which
+      // link picks from r1 and r2)
       int const new_root = disjoint_sets_.find_set(v1);
       if (new_root != r1) {
+	assert(new_root == r2);
+	it2->second.swap(it1->second);
 	rootSetMap_.erase(it1);
       } else {
 	rootSetMap_.erase(it2);
       }
-      rootSetMap_[new_root] = s1;
       return !already_equiv;
     }
     
@@ -0,0 +1,368 @@
+#include "wali/util/details/PartitionRefinement.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace wali
+{
+namespace util
+{
+namespace details
+{
+  namespace
+  {
+    typedef unsigned int Index;
+
+    const Index NONE = ~0u;
+
+    /// The state of the Paige-Tarjan algorithm. The nodes of each (fine)
+    /// block are a contiguous range of 'elems'; splitting a block moves
+    /// the nodes being split off to the front of its range. The blocks
+    /// are grouped into compound blocks, and each node has a count of its
+    /// edges into each compound block it has edges into.
+    class Refiner
+    {
+    public:
+      Refiner(size_t num_nodes,
+              std::vector<RefinementEdge> const & edges,
+              std::vector<Index> const & initial_class);
+
+      void run();
+
+      std::vector<Index> classes() const;
+
+    private:
+      Index newBlock(Index b, Index e, Index compound);
+      Index newRecord();
+      void split(std::vector<Index> const & nodes);
+      void splitBy(Index splitter);
+
+      size_t size(Index block) const { return block_end[block] - block_begin[block]; }
+
+      // Nodes
+      std::vector<Index> elems;        // the nodes, block by block
+      std::vector<Index> loc;          // the position of each node in elems
+      std::vector<Index> block_of;
+
+      // Fine blocks
+      std::vector<Index> block_begin;
+      std::vector<Index> block_end;
+      std::vector<Index> marked;       // nodes moved to the front by split
+      std::vector<Index> compound_of;
+      std::vector<Index> next_in_compound;
+      std::vector<Index> prev_in_compound;
+
+      // Compound blocks
+      std::vector<Index> first_block;
+      std::vector<Index> num_blocks;
+      std::vector<Index> compound_worklist;  // those with two or more blocks
+      std::vector<bool> in_worklist;
+
+      // Edges, grouped by target
+      std::vector<Index> pred_begin;   // by node
+      std::vector<Index> edge_source;
+      std::vector<Index> edge_count;   // record of (source, compound of target)
+
+      // Counts of edges from a node into a compound block
+      std::vector<Index> count;
+      std::vector<Index> free_records;
+
+      // Scratch space for splitBy
+      std::vector<Index> splitter_record;  // by node, or NONE
+      std::vector<Index> compound_record;  // by node
+      std::vector<Index> touched;
+      std::vector<Index> only_splitter;
+      std::vector<Index> splitter_nodes;
+      std::vector<Index> touched_blocks;
+    };
+
+
+    Refiner::Refiner(size_t num_nodes,
+                     std::vector<RefinementEdge> const & edges,
+                     std::vector<Index> const & initial_class)
+      : elems(num_nodes)
+      , loc(num_nodes)
+      , block_of(num_nodes)
+      , pred_begin(num_nodes + 1, 0)
+      , edge_source(edges.size())
+      , edge_count(edges.size())
+      , splitter_record(num_nodes, NONE)
+      , compound_record(num_nodes)
+    {
+      assert(initial_class.size() == num_nodes);
+
+      // Group the edges by target
+      std::vector<Index> out_degree(num_nodes, 0);
+      for (size_t e = 0; e < edges.size(); ++e) {
+        pred_begin[edges[e].second + 1]++;
+        out_degree[edges[e].first]++;
+      }
+      for (size_t v = 0; v < num_nodes; ++v) {
+        pred_begin[v + 1] += pred_begin[v];
+      }
+      {
+        std::vector<Index> next(pred_begin.begin(), pred_begin.end() - 1);
+        for (size_t e = 0; e < edges.size(); ++e) {
+          edge_source[next[edges[e].second]++] = edges[e].first;
+        }
+      }
+
+      // The initial blocks: the initial classes, each split into the nodes
+      // that have edges and those that do not, so that the partition is
+      // stable with respect to the one compound block of all nodes
+      Index num_keys = 0;
+      std::vector<Index> key(num_nodes);
+      for (size_t v = 0; v < num_nodes; ++v) {
+        key[v] = 2 * initial_class[v] + (out_degree[v] > 0 ? 1 : 0);
+        num_keys = std::max(num_keys, key[v] + 1);
+      }
+      std::vector<Index> key_begin(num_keys + 1, 0);
+      for (size_t v = 0; v < num_nodes; ++v) {
+        key_begin[key[v] + 1]++;
+      }
+      for (Index k = 0; k < num_keys; ++k) {
+        key_begin[k + 1] += key_begin[k];
+      }
+      std::vector<Index> next(key_begin.begin(), key_begin.end() - 1);
+      for (size_t v = 0; v < num_nodes; ++v) {
+        Index pos = next[key[v]]++;
+        elems[pos] = static_cast<Index>(v);
+        loc[v] = pos;
+      }
+
+      first_block.push_back(NONE);
+      num_blocks.push_back(0);
+      in_worklist.push_back(false);
+      for (Index k = 0; k < num_keys; ++k) {
+        if (key_begin[k] != key_begin[k + 1]) {
+          newBlock(key_begin[k], key_begin[k + 1], 0);
+        }
+      }
+      if (num_blocks[0] >= 2) {
+        compound_worklist.push_back(0);
+        in_worklist[0] = true;
+      }
+
+      // Each node's count of edges into the compound block of all nodes
+      std::vector<Index> record(num_nodes, NONE);
+      for (size_t v = 0; v < num_nodes; ++v) {
+        if (out_degree[v] > 0) {
+          record[v] = newRecord();
+          count[record[v]] = out_degree[v];
+        }
+      }
+      for (size_t e = 0; e < edge_source.size(); ++e) {
+        edge_count[e] = record[edge_source[e]];
+      }
+    }
+
+
+    /// Makes a block of the nodes in elems[b, e), adding it to 'compound'
+    Index
+    Refiner::newBlock(Index b, Index e, Index compound)
+    {
+      Index block = static_cast<Index>(block_begin.size());
+      block_begin.push_back(b);
+      block_end.push_back(e);
+      marked.push_back(0);
+      compound_of.push_back(compound);
+      for (Index pos = b; pos < e; ++pos) {
+        block_of[elems[pos]] = block;
+      }
+
+      Index first = first_block[compound];
+      next_in_compound.push_back(first);
+      prev_in_compound.push_back(NONE);
+      if (first != NONE) {
+        prev_in_compound[first] = block;
+      }
+      first_block[compound] = block;
+      num_blocks[compound]++;
+      return block;
+    }
+
+
+    Index
+    Refiner::newRecord()
+    {
+      if (!free_records.empty()) {
+        Index r = free_records.back();
+        free_records.pop_back();
+        count[r] = 0;
+        return r;
+      }
+      count.push_back(0);
+      return static_cast<Index>(count.size() - 1);
+    }
+
+
+    /// Splits each block that has some but not all of its nodes in
+    /// 'nodes' (which must be distinct) into those nodes and the rest
+    void
+    Refiner::split(std::vector<Index> const & nodes)
+    {
+      for (std::vector<Index>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        Index x = *it;
+        Index b = block_of[x];
+        if (marked[b] == 0) {
+          touched_blocks.push_back(b);
+        }
+        Index pos = block_begin[b] + marked[b];
+        Index y = elems[pos];
+        elems[loc[x]] = y;
+        loc[y] = loc[x];
+        elems[pos] = x;
+        loc[x] = pos;
+        marked[b]++;
+      }
+
+      for (std::vector<Index>::const_iterator it = touched_blocks.begin(); it != touched_blocks.end(); ++it) {
+        Index b = *it;
+        Index m = marked[b];
+        marked[b] = 0;
+        if (m == size(b)) {
+          continue;
+        }
+        Index compound = compound_of[b];
+        Index begin = block_begin[b];
+        block_begin[b] += m;
+        newBlock(begin, begin + m, compound);
+        if (num_blocks[compound] >= 2 && !in_worklist[compound]) {
+          compound_worklist.push_back(compound);
+          in_worklist[compound] = true;
+        }
+      }
+      touched_blocks.clear();
+    }
+
+
+    /// Makes 'splitter' a compound block of its own, and splits the
+    /// blocks so that the partition is stable with respect to it and to
+    /// what remains of the compound block it came from
+    void
+    Refiner::splitBy(Index splitter)
+    {
+      splitter_nodes.assign(elems.begin() + block_begin[splitter], elems.begin() + block_end[splitter]);
+
+      // The count of each predecessor's edges into the splitter; its edges
+      // all still point at its count for the old compound block
+      touched.clear();
+      for (std::vector<Index>::const_iterator y = splitter_nodes.begin(); y != splitter_nodes.end(); ++y) {
+        for (Index e = pred_begin[*y]; e < pred_begin[*y + 1]; ++e) {
+          Index x = edge_source[e];
+          if (splitter_record[x] == NONE) {
+            splitter_record[x] = newRecord();
+            compound_record[x] = edge_count[e];
+            touched.push_back(x);
+          }
+          count[splitter_record[x]]++;
+        }
+      }
+
+      // Split off the predecessors of the splitter, and then those that
+      // have no edges into the rest of the old compound block
+      split(touched);
+      only_splitter.clear();
+      for (std::vector<Index>::const_iterator x = touched.begin(); x != touched.end(); ++x) {
+        if (count[splitter_record[*x]] == count[compound_record[*x]]) {
+          only_splitter.push_back(*x);
+        }
+      }
+      split(only_splitter);
+
+      // Move the edges into the splitter over to the new counts
+      for (std::vector<Index>::const_iterator y = splitter_nodes.begin(); y != splitter_nodes.end(); ++y) {
+        for (Index e = pred_begin[*y]; e < pred_begin[*y + 1]; ++e) {
+          Index old = edge_count[e];
+          if (--count[old] == 0) {
+            free_records.push_back(old);
+          }
+          edge_count[e] = splitter_record[edge_source[e]];
+        }
+      }
+      for (std::vector<Index>::const_iterator x = touched.begin(); x != touched.end(); ++x) {
+        splitter_record[*x] = NONE;
+      }
+    }
+
+
+    void
+    Refiner::run()
+    {
+      while (!compound_worklist.empty()) {
+        Index compound = compound_worklist.back();
+
+        // Take the smaller of two of its blocks out of it
+        Index b1 = first_block[compound];
+        Index b2 = next_in_compound[b1];
+        Index splitter = (size(b1) <= size(b2)) ? b1 : b2;
+
+        Index prev = prev_in_compound[splitter];
+        Index next = next_in_compound[splitter];
+        if (prev != NONE) {
+          next_in_compound[prev] = next;
+        }
+        else {
+          first_block[compound] = next;
+        }
+        if (next != NONE) {
+          prev_in_compound[next] = prev;
+        }
+        num_blocks[compound]--;
+        if (num_blocks[compound] < 2) {
+          compound_worklist.pop_back();
+          in_worklist[compound] = false;
+        }
+
+        Index own = static_cast<Index>(first_block.size());
+        first_block.push_back(splitter);
+        num_blocks.push_back(1);
+        in_worklist.push_back(false);
+        compound_of[splitter] = own;
+        next_in_compound[splitter] = NONE;
+        prev_in_compound[splitter] = NONE;
+
+        splitBy(splitter);
+      }
+    }
+
+
+    std::vector<Index>
+    Refiner::classes() const
+    {
+      std::vector<Index> number(block_begin.size(), NONE);
+      std::vector<Index> result(block_of.size());
+      Index next = 0;
+      for (size_t v = 0; v < block_of.size(); ++v) {
+        Index & n = number[block_of[v]];
+        if (n == NONE) {
+          n = next++;
+        }
+        result[v] = n;
+      }
+      return result;
+    }
+
+  }
+
+
+  std::vector<unsigned int>
+  coarsest_stable_partition(size_t num_nodes,
+                            std::vector<RefinementEdge> const & edges,
+                            std::vector<unsigned int> const & initial_class)
+  {
+    Refiner refiner(num_nodes, edges, initial_class);
+    refiner.run();
+    return refiner.classes();
+  }
+
+}
+}
+}
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,46 @@
+#ifndef WALI_UTIL_DETAILS_PARTITION_REFINEMENT_HPP
+#define WALI_UTIL_DETAILS_PARTITION_REFINEMENT_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace wali
+{
+namespace util
+{
+namespace details
+{
+  /// An edge (source, target) between nodes numbered from 0
+  typedef std::pair<unsigned int, unsigned int> RefinementEdge;
+
+  /// Computes the coarsest partition of the nodes 0..num_nodes-1 that
+  /// refines 'initial_class' (the class of each node) and is stable under
+  /// 'edges': two nodes in the same class have edges into the same
+  /// classes. This is the largest bisimulation that respects the initial
+  /// classes. Labeled transitions can be encoded by giving each (label,
+  /// target) pair a node of its own, in a class of its label.
+  ///
+  /// Uses the Paige-Tarjan algorithm, which always splits by the smaller
+  /// half of a block, in O(|edges| log num_nodes) time.
+  ///
+  /// Returns the class of each node. The classes are numbered densely in
+  /// order of their first node.
+  extern
+  std::vector<unsigned int>
+  coarsest_stable_partition(size_t num_nodes,
+                            std::vector<RefinementEdge> const & edges,
+                            std::vector<unsigned int> const & initial_class);
+
+}
+}
+}
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif
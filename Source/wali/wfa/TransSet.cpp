@@ -7,6 +7,8 @@
 #include "wali/wfa/TransSet.hpp"
 #include "wali/wfa/TransFunctor.hpp"
 
+#include <algorithm>
+
 #if IMPL_LIST
 #   define IMPLFIND( impl,t ) std::find<wali::wfa::TransSet::iterator,wali::wfa::ITransEq>(impl.begin(),impl.end(),t)
 #else
@@ -17,38 +19,231 @@ namespace wali {
 
   namespace wfa {
 
+    namespace {
+      /// A (from, stack, to) key to look up in a flat set
+      struct FlatKey
+      {
+        Key from;
+        Key stack;
+        Key to;
+      };
+
+      /// Orders positions in a flat set by the key stored there
+      struct FlatKeyLess
+      {
+        std::vector<Key> const & from;
+        std::vector<Key> const & stack;
+        std::vector<Key> const & to;
+
+        FlatKeyLess( std::vector<Key> const & f, std::vector<Key> const & s,
+                     std::vector<Key> const & t )
+          : from(f), stack(s), to(t) {}
+
+        bool operator()( size_t a, size_t b ) const {
+          if( from[a] != from[b] ) return from[a] < from[b];
+          if( stack[a] != stack[b] ) return stack[a] < stack[b];
+          return to[a] < to[b];
+        }
+
+        bool operator()( size_t a, FlatKey const & key ) const {
+          if( from[a] != key.from ) return from[a] < key.from;
+          if( stack[a] != key.stack ) return stack[a] < key.stack;
+          return to[a] < key.to;
+        }
+      };
+
+      /// Insertions past the sorted index before they are merged into it.
+      /// Sets no bigger than this are only ever scanned.
+      const size_t FLAT_UNSORTED_TAIL = 16;
+
+      const size_t NOT_FOUND = static_cast<size_t>(-1);
+    }
+
+    size_t TransSet::Flat::find( Key p, Key g, Key q ) const
+    {
+      if( sorted > 0 ) {
+        FlatKey key = { p, g, q };
+        std::vector<size_t>::const_iterator it =
+          std::lower_bound(order.begin(), order.end(), key, FlatKeyLess(from, stack, to));
+        if( it != order.end() && from[*it] == p && stack[*it] == g && to[*it] == q ) {
+          return *it;
+        }
+      }
+
+      // The unsorted tail. Keys are unique, so at most one position
+      // matches; the loop visits the whole tail rather than stopping at
+      // it, and so has no branch the compiler cannot turn into a select,
+      // which lets it compare several keys per instruction.
+      Key const * fs = from.empty() ? 0 : &from[0];
+      Key const * gs = stack.empty() ? 0 : &stack[0];
+      Key const * qs = to.empty() ? 0 : &to[0];
+      size_t n = size();
+      size_t match = 0;  // one past the matching position, or 0
+      for( size_t i = sorted ; i < n ; i++ ) {
+        bool same = ((fs[i] ^ p) | (gs[i] ^ g) | (qs[i] ^ q)) == 0;
+        match = same ? i + 1 : match;
+      }
+      return (match == 0) ? NOT_FOUND : match - 1;
+    }
+
+    void TransSet::Flat::push_back( ITrans* t )
+    {
+      if( trans.empty() ) {
+        // Most sets are small; skip the 1, 2, 4 reallocations
+        from.reserve(4);
+        stack.reserve(4);
+        to.reserve(4);
+        trans.reserve(4);
+      }
+      from.push_back(t->from());
+      stack.push_back(t->stack());
+      to.push_back(t->to());
+      trans.push_back(t);
+      if( size() - sorted > FLAT_UNSORTED_TAIL ) {
+        mergeTail();
+      }
+    }
+
+    void TransSet::Flat::mergeTail()
+    {
+      FlatKeyLess lt(from, stack, to);
+      size_t n = size();
+      for( size_t i = sorted ; i < n ; i++ ) {
+        order.push_back(i);
+      }
+      std::vector<size_t>::iterator middle = order.begin() + sorted;
+      std::sort(middle, order.end(), lt);
+      std::inplace_merge(order.begin(), middle, order.end(), lt);
+      sorted = n;
+    }
+
+    void TransSet::Flat::erase( size_t pos )
+    {
+      from.erase(from.begin() + pos);
+      stack.erase(stack.begin() + pos);
+      to.erase(to.begin() + pos);
+      trans.erase(trans.begin() + pos);
+
+      if( pos < sorted ) {
+        // Drop pos from the index and renumber everything after it
+        size_t out = 0;
+        for( size_t i = 0 ; i < order.size() ; i++ ) {
+          size_t p = order[i];
+          if( p != pos ) {
+            order[out++] = (p > pos) ? p - 1 : p;
+          }
+        }
+        order.resize(out);
+        sorted--;
+      }
+    }
+
+
+    TransSet::TransSet( Representation rep )
+      : flat( rep == FLAT ? new Flat() : 0 )
+    {
+    }
+
+    TransSet::TransSet( TransSet const & that )
+      : Printable()
+      , impl( that.impl )
+      , flat( that.flat ? new Flat(*that.flat) : 0 )
+    {
+    }
+
+    TransSet& TransSet::operator=( TransSet const & that )
+    {
+      if( this != &that ) {
+        Flat * copy = that.flat ? new Flat(*that.flat) : 0;
+        delete flat;
+        flat = copy;
+        impl = that.impl;
+      }
+      return *this;
+    }
+
+    TransSet::~TransSet()
+    {
+      delete flat;
+    }
+
+    void TransSet::setRepresentation( Representation rep )
+    {
+      if( rep == representation() ) {
+        return;
+      }
+      if( rep == FLAT ) {
+        flat = new Flat();
+        for( impl_t::const_iterator it = impl.begin() ; it != impl.end() ; it++ ) {
+          flat->push_back(*it);
+        }
+        impl_t tmp;
+        tmp.swap(impl);
+      }
+      else {
+        Flat * old = flat;
+        flat = 0;
+        for( size_t i = 0 ; i < old->size() ; i++ ) {
+          insert(old->trans[i]);
+        }
+        delete old;
+      }
+    }
+
     ITrans* TransSet::erase( ITrans* t ) {
       ITrans* tret = NULL;
       iterator it = find(t);
       if( it != end() ) {
         tret = *it;
-        impl.erase(it);
+        erase(it);
       }
       return tret;
     }
 
     ITrans* TransSet::erase( Key from, Key stack, Key to ) {
-      Trans terase(from,stack,to,0);
-      return erase(&terase);
+      ITrans* tret = NULL;
+      iterator it = find(from, stack, to);
+      if( it != end() ) {
+        tret = *it;
+        erase(it);
+      }
+      return tret;
+    }
+
+    TransSet::iterator TransSet::erase( iterator it ) {
+      if( flat ) {
+        flat->erase(it.pos);
+        return it;
+      }
+      impl_t::const_iterator next = it.tree_it;
+      ++next;
+      impl.erase(it.tree_it);
+      return iterator(next);
     }
 
     TransSet::iterator TransSet::find( Key from, Key stack, Key to ) {
-      Trans terase(from,stack,to,0);
-      ITrans* why = &terase;
-      return IMPLFIND(impl,why);
+      return static_cast<TransSet const *>(this)->find(from, stack, to);
     }
 
     TransSet::const_iterator TransSet::find( Key from, Key stack, Key to ) const {
+      if( flat ) {
+        size_t pos = flat->find(from, stack, to);
+        return (pos == NOT_FOUND) ? end() : iterator(flat, pos);
+      }
       Trans terase(from,stack,to,0);
       return find(&terase);
     }
 
     TransSet::iterator TransSet::find( ITrans* t ) {
-      return IMPLFIND(impl,t);
+      return static_cast<TransSet const *>(this)->find(t);
     }
 
     TransSet::const_iterator TransSet::find( ITrans* t ) const {
-      return IMPLFIND(impl,t);
+      if( flat ) {
+        size_t pos = flat->find(t->from(), t->stack(), t->to());
+        return (pos == NOT_FOUND) ? end() : iterator(flat, pos);
+      }
+      return iterator(IMPLFIND(impl,t));
     }
 
     namespace details {
@@ -71,7 +266,7 @@ namespace wali {
 
     void TransSet::each( ConstTransFunctor& tf ) const
     {
-      details::each(impl.begin(), impl.end(), tf);
+      details::each(begin(), end(), tf);
     }
         
     void TransSet::each( boost::function<void(ITrans * t)> & tf )
@@ -81,12 +276,23 @@ namespace wali {
 
     void TransSet::each( boost::function<void(ITrans const * t)> & tf ) const
     {
-      details::each(impl.begin(), impl.end(), tf);
+      details::each(begin(), end(), tf);
     }
 
     bool TransSet::insert( ITrans* t )
     {
       bool b = true;
+      if( flat ) {
+        b = (flat->find(t->from(), t->stack(), t->to()) == NOT_FOUND);
+        if( b ) {
+          flat->push_back(t);
+        }
+        else {
+          t->print( *waliErr << "\tERROR" ) << std::endl;
+          assert(b);
+        }
+        return b;
+      }
 #if IMPL_LIST
       impl.push_back(t);
 #else
@@ -117,7 +323,23 @@ namespace wali {
     }
 
     size_t TransSet::size() const {
-      return impl.size();
+      return flat ? flat->size() : impl.size();
+    }
+
+    void TransSet::clear() {
+      impl.clear();
+      if( flat ) {
+        *flat = Flat();
+      }
+    }
+
+    void TransSet::clearAndReleaseResources() {
+      impl_t tmp;
+      tmp.swap(impl);
+      if( flat ) {
+        delete flat;
+        flat = new Flat();
+      }
     }
 
   } // namespace wfa
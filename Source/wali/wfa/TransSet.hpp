@@ -18,6 +18,9 @@
 #else
 #   include <set>
 #endif
+#include <cstddef>
+#include <iterator>
+#include <vector>
 
 
 namespace wali
@@ -32,6 +35,23 @@ namespace wali
      *
      * This class basically wraps the std::set implementation
      * to provide a "wali::Key friendly" interface.
+     *
+     * A TransSet can instead use a FLAT representation, which keeps the
+     * from, stack, and to keys of the transitions in three contiguous
+     * arrays, with the ITrans pointers in a fourth. Lookups binary search
+     * a sorted index over the arrays and then scan the few most recent
+     * insertions, which are only merged into the index once there are
+     * enough of them. Small sets are just scanned. This is cheaper than
+     * chasing tree nodes for the small-to-medium sets a WFA usually has
+     * per (from, stack) pair.
+     *
+     * A FLAT set iterates in insertion order rather than key order.
+     * Inserting does not invalidate iterators (so a set can be walked
+     * while transitions are added to it, as in prestar), but erasing
+     * invalidates iterators to the erased element and everything after
+     * it; use the iterator returned by erase(iterator) to keep going.
+     *
+     * @see WFA::setTransSetRepresentation
      */
     class TransSet : public Printable
     {
@@ -41,13 +61,120 @@ namespace wali
 #else
         typedef std::set< ITrans*,ITransLT > impl_t;
 #endif
-        typedef impl_t::iterator iterator;
-        typedef impl_t::const_iterator const_iterator;
+
+        enum Representation { TREE, FLAT };
+
+        class iterator;
+        typedef iterator const_iterator;
+
+      private:
+        /// The transitions of a FLAT set, in insertion order. Each key
+        /// has a column of its own, so a scan compares keys without
+        /// loading the pointers in between.
+        struct Flat
+        {
+          std::vector< Key > from;
+          std::vector< Key > stack;
+          std::vector< Key > to;
+          std::vector< ITrans* > trans;
+
+          /// Positions [0, sorted) in (from, stack, to) order
+          std::vector< size_t > order;
+          size_t sorted;
+
+          Flat() : sorted(0) {}
+
+          size_t size() const { return trans.size(); }
+
+          size_t find( Key p, Key g, Key q ) const;
+          void push_back( ITrans* t );
+          void erase( size_t pos );
+          void mergeTail();
+        };
 
       public:
-        TransSet() {}
+        /// Iterator over either representation. Dereferences to an
+        /// ITrans*, as a std::set<ITrans*> iterator does.
+        class iterator
+        {
+          public:
+            typedef std::bidirectional_iterator_tag iterator_category;
+            typedef ITrans* value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef ITrans* const * pointer;
+            typedef ITrans* const & reference;
+
+            iterator() : flat(0), pos(0) {}
+
+            reference operator*() const {
+              return flat ? flat->trans[pos] : *tree_it;
+            }
+
+            pointer operator->() const {
+              return &operator*();
+            }
+
+            iterator& operator++() {
+              if( flat ) { ++pos; } else { ++tree_it; }
+              return *this;
+            }
+
+            iterator operator++(int) {
+              iterator old(*this);
+              ++*this;
+              return old;
+            }
+
+            iterator& operator--() {
+              if( flat ) { pos = position() - 1; } else { --tree_it; }
+              return *this;
+            }
+
+            iterator operator--(int) {
+              iterator old(*this);
+              --*this;
+              return old;
+            }
+
+            bool operator==( iterator const & that ) const {
+              return flat
+                ? (flat == that.flat && position() == that.position())
+                : (that.flat == 0 && tree_it == that.tree_it);
+            }
+
+            bool operator!=( iterator const & that ) const {
+              return !(*this == that);
+            }
+
+          private:
+            friend class TransSet;
+
+            explicit iterator( impl_t::const_iterator it )
+              : tree_it(it), flat(0), pos(0) {}
+
+            iterator( Flat const * f, size_t p )
+              : flat(f), pos(p) {}
+
+            // end() is taken as "one past the last element", whatever
+            // the size is now, so a saved end() survives inserts and
+            // erases.
+            size_t position() const {
+              return pos < flat->size() ? pos : flat->size();
+            }
+
+            impl_t::const_iterator tree_it;
+            Flat const * flat;
+            size_t pos;
+        };
 
-        ~TransSet() {}
+      public:
+        TransSet( Representation rep = TREE );
+
+        TransSet( TransSet const & that );
+
+        TransSet& operator=( TransSet const & that );
+
+        ~TransSet();
 
       public:
         ITrans* erase( ITrans* t );
@@ -74,44 +201,42 @@ namespace wali
 
         std::ostream& print( std::ostream& o ) const;
 
-        void erase( iterator it ) {
-          impl.erase( it );
-        }
+        /// Removes the transition at 'it' (but does not delete it)
+        /// @return an iterator to the transition after it
+        iterator erase( iterator it );
 
-        void clear() {
-          impl.clear();
-        }
+        void clear();
 
         bool empty() const {
-          return impl.empty();
+          return flat ? flat->trans.empty() : impl.empty();
         }
 
-        void clearAndReleaseResources() {
-          impl_t tmp;
-          tmp.swap(impl);
-        }
+        void clearAndReleaseResources();
 
-        iterator begin() {
-          return impl.begin();
+        iterator begin() const {
+          return flat ? iterator(flat, 0) : iterator(impl.begin());
         }
 
-        iterator end() {
-          return impl.end();
+        iterator end() const {
+          return flat ? iterator(flat, static_cast<size_t>(-1)) : iterator(impl.end());
         }
 
-        const_iterator begin() const {
-          return impl.begin();
-        }
+        size_t size() const;
 
-        const_iterator end() const {
-          return impl.end();
+        Representation representation() const {
+          return flat ? FLAT : TREE;
         }
 
-        size_t size() const;
+        /// Moves the transitions in this set to 'rep'.
+        /// Invalidates all iterators.
+        void setRepresentation( Representation rep );
 
       protected:
         impl_t impl;
 
+        /// Non-NULL iff the representation is FLAT
+        Flat * flat;
+
     }; // class TransSet
 
   } // namespace wfa
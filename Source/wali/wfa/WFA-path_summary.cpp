@@ -116,6 +116,28 @@ namespace wali
         // Tell predecessors we have changed
         std::vector<ITrans*> & incoming = incomingTransIt->second;
 
+        // If the weights have batch operations, extend the delta by all
+        // the incoming weights at once
+        std::vector<sem_elem_t> batch;
+        if (the_delta->hasBatchOperations() && !incoming.empty()) {
+          // (weight() may make a new weight, so hold on to them)
+          std::vector<sem_elem_t> weights;
+          std::vector<SemElem*> lhs, rhs;
+          for (size_t i = 0; i < incoming.size(); ++i) {
+            weights.push_back(incoming[i]->weight());
+            if (query == INORDER) {
+              lhs.push_back(weights.back().get_ptr());
+              rhs.push_back(the_delta.get_ptr());
+            }
+            else {
+              lhs.push_back(the_delta.get_ptr());
+              rhs.push_back(weights.back().get_ptr());
+            }
+          }
+          batch.resize(incoming.size());
+          the_delta->extendMany(&lhs[0], &rhs[0], incoming.size(), &batch[0]);
+        }
+
         std::vector<ITrans*>::iterator transit = incoming.begin();
         for ( ; transit != incoming.end() ; ++transit)
         {
@@ -133,7 +155,10 @@ namespace wali
           assert(t->to() == q->name());
 
           sem_elem_t extended;
-          if (query == INORDER) {
+          if (!batch.empty()) {
+            extended = batch[static_cast<size_t>(transit - incoming.begin())];
+          }
+          else if (query == INORDER) {
             extended = t->weight()->extend(the_delta);
           }
           else {
@@ -350,6 +375,7 @@ namespace wali
 #endif
 
       WFA ans;
+      ans.setTransSetRepresentation(transset_rep);
       pds.poststar(query, ans);
 
 #ifdef JAMDEBUG
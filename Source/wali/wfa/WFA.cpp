@@ -4,6 +4,7 @@
 
 #include "wali/Common.hpp"
 #include "wali/DefaultWorklist.hpp"
+#include "wali/WeightOpCache.hpp"
 #include "wali/wfa/WFA.hpp"
 #include "wali/wfa/State.hpp"
 #include "wali/wfa/TransFunctor.hpp"
@@ -66,6 +67,9 @@ namespace wali
         , progress(prog)
         , defaultPathSummaryImplementation(globalDefaultPathSummaryImplementation)
         , defaultPathSummaryFwpdsTopDown(globalDefaultPathSummaryFwpdsTopDown)
+        , use_arena(false)
+        , trans_arena(0)
+        , transset_rep(TransSet::TREE)
     {
       if( query == MAX ) {
         *waliErr << "[WARNING] Invalid WFA::query. Resetting to INORDER.\n";
@@ -73,7 +77,11 @@ namespace wali
       }
     }
 
-    WFA::WFA( const WFA & rhs ) : Printable()
+    WFA::WFA( const WFA & rhs )
+        : Printable()
+        , use_arena(false)
+        , trans_arena(0)
+        , transset_rep(TransSet::TREE)
     {
       operator=(rhs);
     }
@@ -83,6 +91,8 @@ namespace wali
       if( this != &rhs )
       {
         clear();
+        useArena( rhs.use_arena );
+        transset_rep = rhs.transset_rep;
 
         // Copy important state information
         init_state = rhs.init_state;
@@ -116,6 +126,86 @@ namespace wali
     WFA::~WFA()
     {
       clear();
+      delete trans_arena;
+    }
+
+    void WFA::useArena( bool enable )
+    {
+      use_arena = enable;
+      if( use_arena && trans_arena == 0 ) {
+        trans_arena = new util::Arena();
+      }
+    }
+
+    namespace details {
+      void destroyIn( util::Arena * arena, ITrans * t )
+      {
+        if( arena && arena->owns(dynamic_cast<void*>(t)) ) {
+          arena->destroy(t);
+        }
+        else {
+          delete t;
+        }
+      }
+
+      /// Like TransDeleter, for a WFA that resets its arena right after:
+      /// what came from the arena is only destructed, since its memory
+      /// is reclaimed with the whole region.
+      class ArenaTransDeleter : public TransFunctor
+      {
+        util::Arena * arena;
+
+      public:
+        explicit ArenaTransDeleter( util::Arena * arena ) : arena(arena) {}
+
+        virtual void operator()( ITrans * t ) {
+          if( arena->owns(dynamic_cast<void*>(t)) ) {
+            arena->destruct(t);
+          }
+          else {
+            delete t;
+          }
+        }
+      };
+    }
+
+    void WFA::destroyTrans( ITrans * t )
+    {
+      details::destroyIn(trans_arena, t);
+    }
+
+    void WFA::destroyState( State * s )
+    {
+      if( trans_arena && trans_arena->owns(s) ) {
+        trans_arena->destroy(s);
+      }
+      else {
+        delete s;
+      }
+    }
+
+    void WFA::destructState( State * s )
+    {
+      if( trans_arena && trans_arena->owns(s) ) {
+        trans_arena->destruct(s);
+      }
+      else {
+        delete s;
+      }
+    }
+
+    void WFA::setTransSetRepresentation( TransSet::Representation rep )
+    {
+      transset_rep = rep;
+      for( kp_map_t::iterator it = kpmap.begin() ; it != kpmap.end() ; it++ ) {
+        it->second.setRepresentation(rep);
+      }
+      for( eps_map_t::iterator it = eps_map.begin() ; it != eps_map.end() ; it++ ) {
+        it->second.setRepresentation(rep);
+      }
+      for( state_map_t::iterator it = state_map.begin() ; it != state_map.end() ; it++ ) {
+        it->second->transSet.setRepresentation(rep);
+      }
     }
 
     void WFA::clear()
@@ -123,8 +213,14 @@ namespace wali
       /* Must manually delete all Trans objects. If reference
        * counting is used this code can be removed
        */
-      TransDeleter td;
-      for_each(td);
+      if( trans_arena == 0 ) {
+        TransDeleter td;
+        for_each(td);
+      }
+      else {
+        details::ArenaTransDeleter td(trans_arena);
+        for_each(td);
+      }
 
 
       /* Must manually delete all State objects. If reference
@@ -134,14 +230,14 @@ namespace wali
       state_map_t::iterator itEND = state_map.end();
       for( ; it != itEND ; it++ )
       {
-        delete it->second;
+        destructState(it->second);
         it->second = 0;
       }
 
       for (std::set<State*>::const_iterator s = deleted_states.begin();
            s != deleted_states.end(); ++s)
       {
-        delete *s;
+        destructState(*s);
       }
       deleted_states.clear();
 
@@ -153,6 +249,13 @@ namespace wali
       F.clear();
       Q.clear();
       init_state = WALI_EPSILON;
+
+      // Every state and transition is gone, so the arena can be
+      // carved up afresh. Its blocks stay for the next transitions and
+      // go back to the heap when the WFA is destroyed.
+      if( trans_arena ) {
+        trans_arena->reset();
+      }
     }
 
     //!
@@ -296,7 +399,8 @@ namespace wali
         Key q,
         sem_elem_t se )
     {
-      addTrans( new Trans(p,g,q,se) );
+      util::Arena * a = arena();
+      addTrans( a ? new (*a) Trans(p,g,q,se) : new Trans(p,g,q,se) );
     }
 
     //!
@@ -352,7 +456,7 @@ namespace wali
       State* state = state_map.find(from)->second;
       state->eraseTrans(t);
 
-      delete t;
+      destroyTrans(t);
     }
 
     namespace details {
@@ -653,10 +757,6 @@ namespace wali
       }
       alphabet.insert(WALI_EPSILON);
 
-      // Siiiiiiiigh. (nc = non-const)
-      WFA * this_nc = const_cast<WFA*>(this);
-      WFA * fa_nc = const_cast<WFA*>(&fa);
-
       // Now start the actual intersection bit.
       std::vector<KeyPair> worklist;
 
@@ -676,15 +776,28 @@ namespace wali
         for (std::set<Key>::const_iterator sym_iter = alphabet.begin();
              sym_iter != alphabet.end(); ++sym_iter)
         {
-          TransSet
-            this_outgoing = this_nc->match(source_pair.first, *sym_iter),
-            fa_outgoing = fa_nc->match(source_pair.second, *sym_iter);
+          TransSet const
+            * this_outgoing = this->outgoingTransSet(source_pair.first, *sym_iter),
+            * fa_outgoing = fa.outgoingTransSet(source_pair.second, *sym_iter);
+
+          // Only the epsilon sets are copied, to add the no-motion
+          // transitions to; the rest are walked in place.
+          TransSet this_copy, fa_copy;
 
           ITrans
             * left_no_motion = NULL,
             * right_no_motion = NULL;
 
           if (*sym_iter == WALI_EPSILON) {
+            if (this_outgoing) {
+              this_copy = *this_outgoing;
+            }
+            if (fa_outgoing) {
+              fa_copy = *fa_outgoing;
+            }
+            this_outgoing = &this_copy;
+            fa_outgoing = &fa_copy;
+
             // One automaton or the other can not move
             left_no_motion = new Trans(source_pair.first, WALI_EPSILON,
                                        source_pair.first, this->getSomeWeight()->one());
@@ -693,18 +806,21 @@ namespace wali
 
             // Will fail if there is already an epsilon self
             // loop. (Non-trivial cycles should be OK.)
-            assert(this_outgoing.find(left_no_motion) == this_outgoing.end());
-            assert(fa_outgoing.find(right_no_motion) == fa_outgoing.end());
+            assert(this_copy.find(left_no_motion) == this_copy.end());
+            assert(fa_copy.find(right_no_motion) == fa_copy.end());
             
-            this_outgoing.insert(left_no_motion);
-            fa_outgoing.insert(right_no_motion);
+            this_copy.insert(left_no_motion);
+            fa_copy.insert(right_no_motion);
+          }
+          else if (this_outgoing == NULL || fa_outgoing == NULL) {
+            continue;
           }
 
-          for (TransSet::const_iterator this_trans_iter = this_outgoing.begin();
-               this_trans_iter != this_outgoing.end(); ++this_trans_iter)
+          for (TransSet::const_iterator this_trans_iter = this_outgoing->begin();
+               this_trans_iter != this_outgoing->end(); ++this_trans_iter)
           {
-            for (TransSet::const_iterator fa_trans_iter = fa_outgoing.begin();
-                 fa_trans_iter != fa_outgoing.end(); ++fa_trans_iter)
+            for (TransSet::const_iterator fa_trans_iter = fa_outgoing->begin();
+                 fa_trans_iter != fa_outgoing->end(); ++fa_trans_iter)
             {
               if (*sym_iter == WALI_EPSILON
                   && (*this_trans_iter)->from() == (*this_trans_iter)->to()
@@ -915,14 +1031,10 @@ namespace wali
         State* p = wl.get();
         TransSet& tSet = p->getTransSet();
         TransSet::iterator it = tSet.begin();
-        TransSet::iterator itEND = tSet.end();
-        TransSet::iterator eraseIt;
         // for each (p,_,q)
         // mark q reached
-        while( it != itEND ) {
+        while( it != tSet.end() ) {
           ITrans* t = *it;
-          eraseIt = it;
-          it++;
           State* q = getState(t->to());
           // A state that was backwards reachable from a final state
           // will have a tag of 1. Set tag to 2 to signify it is
@@ -930,6 +1042,7 @@ namespace wali
           if( q->tag == 1 ) {
             q->tag = 2;
             wl.put(q);
+            it++;
           }
           else if( q->tag == 0 ) {
             // A tag of 0 means the State is not backwards
@@ -946,8 +1059,11 @@ namespace wali
             // leftover
             eraseTransFromKpMap(t);
             eraseTransFromEpsMap(t);
-            tSet.erase(eraseIt);
-            delete t;
+            it = tSet.erase(it);
+            destroyTrans(t);
+          }
+          else {
+            it++;
           }
         }
       }
@@ -1193,6 +1309,7 @@ namespace wali
         {
           TransSet transSet;
           it = kpmap.insert(tnew->keypair(),transSet).first;
+          it->second.setRepresentation(transset_rep);
         }
         it->second.insert(tnew);
 
@@ -1220,6 +1337,7 @@ namespace wali
           if( epsit == eps_map.end() ) {
             TransSet transSet;
             epsit = eps_map.insert( tnew->to(),transSet ).first;
+            epsit->second.setRepresentation(transset_rep);
           }
           epsit->second.insert( tnew );
         }
@@ -1232,7 +1350,7 @@ namespace wali
           // combine new into old
 
           told->combineTrans( tnew );
-          delete tnew;
+          destroyTrans( tnew );
         }
         else {
           *waliErr << "[WARNING - WFA::insert]\n";
@@ -1254,7 +1372,9 @@ namespace wali
     void WFA::addState( Key key , sem_elem_t zero )
     {
       if( state_map.find( key ) == state_map.end() ) {
-        State* state = new State(key,zero);
+        util::Arena * a = arena();
+        State* state = a ? new (*a) State(key,zero) : new State(key,zero);
+        state->transSet.setRepresentation(transset_rep);
         state_map.insert( key , state );
         Q.insert(key);
       }
@@ -2406,6 +2526,7 @@ namespace wali
          << "    accepting states: " << getFinalStates().size() << "\n"
          << "             symbols: " << symbols.size() << "\n"
          << "         transitions: " << counter.getNumTrans() << "\n";
+      WeightOpCache::printAll(os);
     }
 
 
@@ -15,9 +15,11 @@
 #include "wali/Printable.hpp"
 #include "wali/SemElem.hpp"
 #include "wali/HashMap.hpp"
+#include "wali/OpenHashMap.hpp"
 #include "wali/KeyContainer.hpp"
 #include "wali/Progress.hpp"
 #include "wali/domains/SemElemSet.hpp"
+#include "wali/util/Arena.hpp"
 
 // ::wali::wfa
 #include "wali/wfa/WeightMaker.hpp"
@@ -113,9 +115,9 @@ namespace wali
         static PathSummaryImplementation globalDefaultPathSummaryImplementation;
         static bool globalDefaultPathSummaryFwpdsTopDown;
 
-        typedef wali::HashMap< KeyPair, TransSet > kp_map_t;
-        typedef wali::HashMap< Key , State * > state_map_t;
-        typedef wali::HashMap< Key , TransSet > eps_map_t;
+        typedef wali::HotHashMap< KeyPair, TransSet >::type kp_map_t;
+        typedef wali::HotHashMap< Key , State * >::type state_map_t;
+        typedef wali::HotHashMap< Key , TransSet >::type eps_map_t;
         typedef std::set< State*,State > StateSet_t;
         typedef wali::HashMap< Key,StateSet_t > PredHash_t;
         typedef wali::HashMap< Key, std::vector<ITrans*> > IncomingTransMap_t;
@@ -155,6 +157,54 @@ namespace wali
          */
         virtual void clear();
 
+        /**
+         * Allocate this WFA's states, and the transitions that the WFA
+         * or a WPDS query creates for it, from an arena owned by the WFA
+         * instead of one at a time from the heap. This gives better
+         * locality, and clear() reclaims the memory of all of them at
+         * once instead of freeing each object: the arena keeps its
+         * blocks for the transitions that come next, and the destructor
+         * gives them back to the heap. (Destructors still run, since
+         * transitions hold references to their weights.)
+         *
+         * The WFA destroys what came from its arena itself, so a
+         * transition of an arena-backed WFA must only be removed through
+         * the WFA (erase, eraseState, clear, ...), never with 'delete'.
+         * Transitions that clients create with a plain 'new' and insert
+         * still come from the heap, and the WFA deletes them as usual.
+         *
+         * Off by default, in which case nothing changes. Copies of a WFA
+         * inherit the setting.
+         */
+        void useArena( bool enable );
+
+        bool usesArena() const { return use_arena; }
+
+        /**
+         * @return the arena new transitions for this WFA should be
+         * allocated from, or NULL for the heap. Use as
+         * 'arena ? new (*arena) Trans(...) : new Trans(...)'.
+         */
+        util::Arena * arena() const { return use_arena ? trans_arena : 0; }
+
+        /**
+         * Selects how the sets of transitions this WFA indexes by
+         * (from, stack) pair, by epsilon target, and by source State are
+         * stored. TransSet::FLAT keeps them in contiguous columns, which
+         * makes lookups and walks over the sets (as in intersect, prune
+         * and path_summary) cheaper, but makes the sets iterate in
+         * insertion order. Existing transitions are moved over.
+         *
+         * TransSet::TREE by default. Copies of a WFA inherit the setting.
+         *
+         * @see TransSet
+         */
+        void setTransSetRepresentation( TransSet::Representation rep );
+
+        TransSet::Representation transSetRepresentation() const {
+          return transset_rep;
+        }
+
         /**
          * @brief set initial state
          *
@@ -693,6 +743,20 @@ namespace wali
         PathSummaryImplementation defaultPathSummaryImplementation;
         bool defaultPathSummaryFwpdsTopDown;
 
+        bool use_arena;             //! < See useArena
+        util::Arena * trans_arena;  //! < Created on first use; NULL before
+        TransSet::Representation transset_rep; //! < See setTransSetRepresentation
+
+        /// Deletes t, or gives it back to trans_arena if it came from there
+        void destroyTrans( ITrans * t );
+
+        /// Likewise for a State
+        void destroyState( State * s );
+
+        /// Like destroyState, but leaves arena memory to the
+        /// trans_arena->reset() that clear() ends with
+        void destructState( State * s );
+
       private:
 
 
@@ -854,7 +918,8 @@ namespace wali
         std::map<Key, std::map<Key, std::set<Key> > >
         next_states_no_eclose(WFA const & wfa, std::set<Key> const & froms);
 
-        //// Prints to 'os' statistics about this WFA. 
+        //// Prints to 'os' statistics about this WFA (and about the
+        //// WeightOpCaches, if any).
         void printStatistics(std::ostream & os) const;
 
 
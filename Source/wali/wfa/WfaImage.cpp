@@ -0,0 +1,233 @@
+#include "wali/wfa/WfaImage.hpp"
+#include "wali/wfa/WFA.hpp"
+#include "wali/wfa/State.hpp"
+#include "wali/wfa/ITrans.hpp"
+#include "wali/wfa/TransFunctor.hpp"
+#include "wali/WeightFactory.hpp"
+
+#include <cassert>
+#include <map>
+#include <sstream>
+#include <vector>
+
+namespace wali
+{
+  namespace wfa
+  {
+    using util::BadImageException;
+    using util::BinaryImageWriter;
+
+    typedef WfaImage::Index Index;
+
+    char const * const WfaImage::MAGIC = "WWFA";
+    const Index WfaImage::NONE;
+    const Index WfaImage::VERSION;
+
+    namespace
+    {
+      Index weightString( BinaryImageWriter & out, sem_elem_t const & w )
+      {
+        std::ostringstream ss;
+        w->marshall(ss);
+        return out.addString(ss.str());
+      }
+
+      /// Collects the transitions as (from, stack, to, weight)
+      class TransCollector : public ConstTransFunctor
+      {
+        public:
+          TransCollector( BinaryImageWriter & o, std::map< Key, Index > const & s )
+            : out(o)
+            , states(s)
+          {}
+
+          virtual void operator()( ITrans const * t )
+          {
+            trans.push_back(states.find(t->from())->second);
+            trans.push_back(out.addKey(t->stack()));
+            trans.push_back(states.find(t->to())->second);
+            trans.push_back(weightString(out, t->weight()));
+          }
+
+          BinaryImageWriter & out;
+          std::map< Key, Index > const & states;
+          std::vector<Index> trans;
+      };
+
+      void checkIndex( Index i, size_t n )
+      {
+        if( i >= n ) {
+          throw BadImageException("WFA image refers to a state or string it does not have");
+        }
+      }
+
+      /// The weight whose text is string 'id', made by 'weights' the first
+      /// time it is asked for
+      class ParsedWeights
+      {
+        public:
+          ParsedWeights( WeightFactory & w, size_t num_strings )
+            : weights(w)
+            , parsed(num_strings)
+          {}
+
+          sem_elem_t operator()( util::BinaryImage const & image, Index id )
+          {
+            checkIndex(id, parsed.size());
+            if( parsed[id].is_empty() ) {
+              parsed[id] = weights.getWeight(image.string(id));
+            }
+            return parsed[id];
+          }
+
+        private:
+          WeightFactory & weights;
+          std::vector<sem_elem_t> parsed;
+      };
+    }
+
+
+    void marshallBinary( WFA const & fa, std::ostream & o )
+    {
+      BinaryImageWriter out(WfaImage::MAGIC, WfaImage::VERSION, WfaImage::NUM_SECTIONS);
+
+      std::map< Key, Index > states;
+      std::vector<Index> & state_words = out.section(WfaImage::STATES);
+      std::set< Key > const & Q = fa.getStates();
+      for( std::set< Key >::const_iterator it = Q.begin(); it != Q.end(); ++it ) {
+        Index id = static_cast<Index>(states.size());
+        states[*it] = id;
+        state_words.push_back(out.addKey(*it));
+        state_words.push_back(weightString(out, fa.getState(*it)->weight()));
+      }
+
+      std::vector<Index> & header = out.section(WfaImage::HEADER);
+      header.resize(WfaImage::HEADER_SIZE);
+      header[WfaImage::QUERY] = fa.getQuery();
+      std::map< Key, Index >::const_iterator init = states.find(fa.getInitialState());
+      header[WfaImage::INITIAL] = (init == states.end()) ? WfaImage::NONE : init->second;
+
+      std::set< Key > const & F = fa.getFinalStates();
+      for( std::set< Key >::const_iterator it = F.begin(); it != F.end(); ++it ) {
+        out.section(WfaImage::FINAL).push_back(states[*it]);
+        out.section(WfaImage::FINAL).push_back(weightString(out, fa.getState(*it)->acceptWeight()));
+      }
+
+      TransCollector collect(out, states);
+      fa.for_each(collect);
+
+      // CSR by source state
+      size_t n = states.size();
+      std::vector<Index> & offsets = out.section(WfaImage::TRANS_OFFSETS);
+      std::vector<Index> & trans = out.section(WfaImage::TRANS);
+      offsets.assign(n + 1, 0);
+      for( size_t i = 0 ; i < collect.trans.size() ; i += 4 ) {
+        offsets[collect.trans[i] + 1]++;
+      }
+      for( size_t s = 0 ; s < n ; s++ ) {
+        offsets[s + 1] += offsets[s];
+      }
+      std::vector<Index> next(offsets.begin(), offsets.end() - 1);
+      trans.resize(collect.trans.size() / 4 * 3);
+      for( size_t i = 0 ; i < collect.trans.size() ; i += 4 ) {
+        Index at = next[collect.trans[i]]++;
+        std::copy(collect.trans.begin() + i + 1, collect.trans.begin() + i + 4,
+                  trans.begin() + 3 * at);
+      }
+
+      out.write(o);
+    }
+
+
+    WfaImage::WfaImage( std::string const & path )
+      : image(path, MAGIC, VERSION)
+    {
+      check();
+    }
+
+
+    WfaImage::WfaImage( std::istream & is )
+      : image(is, MAGIC, VERSION)
+    {
+      check();
+    }
+
+
+    void WfaImage::check() const
+    {
+      if( image.numSections() != NUM_SECTIONS
+          || image.sectionSize(HEADER) != HEADER_SIZE
+          || image.sectionSize(STATES) % 2 != 0
+          || image.sectionSize(FINAL) % 2 != 0
+          || image.sectionSize(TRANS) % 3 != 0 )
+      {
+        throw BadImageException("WFA image has malformed sections");
+      }
+      Index query = image.section(HEADER)[QUERY];
+      Index initial = image.section(HEADER)[INITIAL];
+      if( query > WFA::MAX || (initial != NONE && initial >= numStates()) ) {
+        throw BadImageException("WFA image has a bad header");
+      }
+
+      size_t n = numStates();
+      Index const * offsets = image.section(TRANS_OFFSETS);
+      if( image.sectionSize(TRANS_OFFSETS) != n + 1
+          || offsets[0] != 0 || offsets[n] != numTrans() )
+      {
+        throw BadImageException("WFA image has bad transition offsets");
+      }
+      for( size_t s = 0 ; s < n ; s++ ) {
+        if( offsets[s] > offsets[s + 1] ) {
+          throw BadImageException("WFA image has bad transition offsets");
+        }
+      }
+    }
+
+
+    void WfaImage::addTo( WFA & fa, WeightFactory & weights ) const
+    {
+      size_t n = numStates();
+      size_t num_strings = image.numStrings();
+
+      ParsedWeights weight(weights, num_strings);
+
+      Index const * state_words = image.section(STATES);
+      for( Index q = 0 ; q < n ; q++ ) {
+        checkIndex(state_words[2 * q], num_strings);
+        fa.addState(state(q), weight(image, state_words[2 * q + 1]));
+      }
+
+      Index initial = image.section(HEADER)[INITIAL];
+      if( initial != NONE ) {
+        fa.setInitialState(state(initial));
+      }
+      fa.setQuery(static_cast<WFA::query_t>(image.section(HEADER)[QUERY]));
+
+      Index const * final_words = image.section(FINAL);
+      for( size_t i = 0 ; i < image.sectionSize(FINAL) ; i += 2 ) {
+        checkIndex(final_words[i], n);
+        fa.addFinalState(state(final_words[i]), weight(image, final_words[i + 1]));
+      }
+
+      Index const * offsets = image.section(TRANS_OFFSETS);
+      Index const * trans = image.section(TRANS);
+      for( Index q = 0 ; q < n ; q++ ) {
+        for( Index t = offsets[q] ; t < offsets[q + 1] ; t++ ) {
+          Index const * tr = trans + 3 * t;
+          checkIndex(tr[0], num_strings);
+          checkIndex(tr[1], n);
+          fa.addTrans(state(q), image.key(tr[0]), state(tr[1]),
+                      weight(image, tr[2]));
+        }
+      }
+    }
+
+  } // namespace wfa
+
+} // namespace wali
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,99 @@
+#ifndef wali_wfa_WFA_IMAGE_GUARD
+#define wali_wfa_WFA_IMAGE_GUARD 1
+
+#include "wali/Common.hpp"
+#include "wali/SemElem.hpp"
+#include "wali/util/BinaryImage.hpp"
+
+#include <iosfwd>
+#include <string>
+
+namespace wali
+{
+  class WeightFactory;
+
+  namespace wfa
+  {
+    class WFA;
+
+    /**
+     * Writes 'fa' to 'o' in the binary format that WfaImage reads. Like
+     * WFA::marshall, it writes the query, the states with their weights,
+     * the final states, and the transitions; the weights are written as
+     * the text SemElem::marshall gives, once for each distinct text.
+     */
+    void marshallBinary( WFA const & fa, std::ostream & o );
+
+
+    /**
+     * @class WfaImage
+     *
+     * A WFA in the binary format of marshallBinary. The states are
+     * numbered densely, the names and weights are kept in a string table,
+     * and the transitions are in flat (CSR) arrays indexed by their source
+     * state. Opening an image from a file maps it into memory; names are
+     * turned into Keys only as they are needed.
+     *
+     * Like the BinaryImage it is built on, a WfaImage is not thread safe.
+     *
+     * @see wali::util::BinaryImage
+     */
+    class WfaImage
+    {
+      public:
+        typedef util::BinaryImage::Word Index;
+
+        /// Maps the file at 'path'. Throws util::BadImageException if it
+        /// is not a WFA image.
+        explicit WfaImage( std::string const & path );
+
+        /// Reads the rest of 'is'
+        explicit WfaImage( std::istream & is );
+
+        size_t numStates() const { return image.sectionSize(STATES) / 2; }
+        size_t numTrans() const { return image.sectionSize(TRANS) / 3; }
+
+        Key state( Index i ) const { return image.key(image.section(STATES)[2 * i]); }
+
+        /// Adds the states and transitions of the image to 'fa', and sets
+        /// its initial state and query. The weights are made by 'weights'
+        /// from their text, each distinct text once.
+        void addTo( WFA & fa, WeightFactory & weights ) const;
+
+        bool isMapped() const { return image.isMapped(); }
+
+        enum {
+          HEADER = util::BinaryImageWriter::FIRST_SECTION,
+          STATES,
+          FINAL,
+          TRANS_OFFSETS,
+          TRANS,
+          NUM_SECTIONS
+        };
+
+        /// The fields of HEADER
+        enum { QUERY, INITIAL, HEADER_SIZE };
+
+        /// INITIAL when the WFA has no initial state
+        static const Index NONE = ~0u;
+
+        static char const * const MAGIC;
+        static const Index VERSION = 1;
+
+      private:
+        void check() const;
+
+        util::BinaryImage image;
+    };
+
+  } // namespace wfa
+
+} // namespace wali
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif  // wali_wfa_WFA_IMAGE_GUARD
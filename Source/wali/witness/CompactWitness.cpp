@@ -0,0 +1,433 @@
+#include "wali/Common.hpp"
+#include "wali/wpds/ewpds/ERule.hpp"
+#include "wali/witness/CompactWitness.hpp"
+#include "wali/witness/WitnessExtend.hpp"
+#include "wali/witness/WitnessCombine.hpp"
+#include "wali/witness/WitnessMerge.hpp"
+#include "wali/witness/WitnessRule.hpp"
+#include "wali/witness/WitnessTrans.hpp"
+
+#include <map>
+#include <typeinfo>
+#include <utility>
+
+namespace wali
+{
+  namespace witness
+  {
+    //////////////////////////////////////////////////////////////////
+    // WitnessLog
+
+    WitnessLog::step_t const WitnessLog::ONE;
+    WitnessLog::step_t const WitnessLog::ZERO;
+
+    WitnessLog::WitnessLog()
+      : Countable()
+    {
+      append(KIND_ONE, 0, 0, 0);
+      append(KIND_ZERO, 0, 0, 0);
+    }
+
+    // The caller holds the lock
+    WitnessLog::step_t WitnessLog::append( Kind kind, step_t a, step_t b, unsigned int merge_fn )
+    {
+      Step step;
+      step.a = a;
+      step.b = b;
+      step.tag = (merge_fn << KIND_BITS) | kind;
+      step.refs = 0;
+      if( hasOperands(kind) ) {
+        steps[a].refs++;
+        steps[b].refs++;
+      }
+
+      if( free_steps.empty() ) {
+        steps.push_back(step);
+        return static_cast<step_t>(steps.size() - 1);
+      }
+      step_t s = free_steps.back();
+      free_steps.pop_back();
+      steps[s] = step;
+      return s;
+    }
+
+    WitnessLog::step_t WitnessLog::leaf( witness_t w )
+    {
+      util::LockGuard guard(lock);
+      leaves.push_back(w);
+      return append(KIND_LEAF, static_cast<step_t>(leaves.size() - 1), 0, 0);
+    }
+
+    WitnessLog::step_t WitnessLog::extend( step_t left, step_t right )
+    {
+      util::LockGuard guard(lock);
+      return append(KIND_EXTEND, left, right, 0);
+    }
+
+    WitnessLog::step_t WitnessLog::combine( step_t left, step_t right )
+    {
+      util::LockGuard guard(lock);
+      return append(KIND_COMBINE, left, right, 0);
+    }
+
+    size_t WitnessLog::addMergeFn( witness_merge_fn_t mf, witness_t rule )
+    {
+      util::LockGuard guard(lock);
+      MergeFnEntry entry;
+      entry.fn = mf;
+      entry.rule = rule;
+      merge_fns.push_back(entry);
+      return merge_fns.size() - 1;
+    }
+
+    WitnessLog::step_t WitnessLog::merge( size_t merge_fn, step_t caller, step_t callee )
+    {
+      util::LockGuard guard(lock);
+      return append(KIND_MERGE, caller, callee, static_cast<unsigned int>(merge_fn));
+    }
+
+    void WitnessLog::acquire( step_t s )
+    {
+      util::LockGuard guard(lock);
+      steps[s].refs++;
+    }
+
+    void WitnessLog::release( step_t s )
+    {
+      // Dropped leaves are destroyed after the lock is released
+      std::vector<witness_t> dropped;
+      util::LockGuard guard(lock);
+
+      assert(steps[s].refs > 0);
+      if( --steps[s].refs > 0 || s == ONE || s == ZERO ) {
+        return;
+      }
+      // Without recursion; the DAG can be very deep
+      std::vector<step_t> dead(1, s);
+      while( !dead.empty() ) {
+        step_t t = dead.back();
+        dead.pop_back();
+        Step & step = steps[t];
+        Kind kind = kindOf(step);
+        if( hasOperands(kind) ) {
+          step_t operands[] = { step.a, step.b };
+          for( size_t i = 0 ; i < 2 ; i++ ) {
+            step_t o = operands[i];
+            if( --steps[o].refs == 0 && o != ONE && o != ZERO ) {
+              dead.push_back(o);
+            }
+          }
+        }
+        else if( kind == KIND_LEAF ) {
+          // The slot in 'leaves' is not reused; leaves are rules and
+          // input transitions, so there are few of them.
+          dropped.push_back(leaves[step.a]);
+          leaves[step.a] = 0;
+        }
+        step.tag = KIND_FREE;
+        free_steps.push_back(t);
+      }
+    }
+
+    witness_t WitnessLog::getLeaf( step_t s ) const
+    {
+      util::LockGuard guard(lock);
+      assert(s < steps.size() && kindOf(steps[s]) == KIND_LEAF);
+      return leaves[steps[s].a];
+    }
+
+    witness_t WitnessLog::materialize( step_t s, sem_elem_t weight ) const
+    {
+      util::LockGuard guard(lock);
+      assert(s < steps.size() && kindOf(steps[s]) != KIND_FREE);
+
+      // A post-order walk (without recursion; the DAG can be very deep)
+      // that builds each step once
+      std::map<step_t, witness_t> built;
+      std::vector< std::pair<step_t, bool> > stack(1, std::make_pair(s, false));
+      witness_t anchor = new Witness(weight);
+      while( !stack.empty() ) {
+        step_t t = stack.back().first;
+        if( built.find(t) != built.end() ) {
+          stack.pop_back();
+          continue;
+        }
+        Step const & step = steps[t];
+        Kind kind = kindOf(step);
+        if( hasOperands(kind) && !stack.back().second ) {
+          // Build the operands first
+          stack.back().second = true;
+          stack.push_back(std::make_pair(step.b, false));
+          stack.push_back(std::make_pair(step.a, false));
+          continue;
+        }
+        stack.pop_back();
+
+        witness_t left, right;
+        if( hasOperands(kind) ) {
+          left = built[step.a];
+          right = built[step.b];
+        }
+
+        witness_t w;
+        switch( kind ) {
+          case KIND_ONE:
+            w = anchor->one();
+            break;
+          case KIND_ZERO:
+            w = anchor->zero();
+            break;
+          case KIND_LEAF:
+            w = leaves[step.a];
+            break;
+          case KIND_EXTEND:
+            w = new WitnessExtend(left->weight()->extend(right->weight()), left, right);
+            break;
+          case KIND_COMBINE:
+            {
+              WitnessCombine * wc = new WitnessCombine(left->weight()->combine(right->weight()));
+              wc->addChild(left);
+              wc->addChild(right);
+              w = wc;
+            }
+            break;
+          case KIND_MERGE:
+            {
+              MergeFnEntry const & mf = merge_fns[step.tag >> KIND_BITS];
+              sem_elem_t merged = mf.fn->get_user_merge()->apply_f(left->weight(), right->weight());
+              w = new WitnessMerge(merged, mf.fn, left, mf.rule, right);
+            }
+            break;
+          case KIND_FREE:
+            assert(0);
+            break;
+        }
+        built[t] = w;
+      }
+      return built[s];
+    }
+
+    size_t WitnessLog::size() const
+    {
+      util::LockGuard guard(lock);
+      return steps.size() - free_steps.size();
+    }
+
+    size_t WitnessLog::bytes() const
+    {
+      util::LockGuard guard(lock);
+      return steps.capacity() * sizeof(Step)
+        + free_steps.capacity() * sizeof(step_t)
+        + leaves.capacity() * sizeof(witness_t)
+        + merge_fns.capacity() * sizeof(MergeFnEntry);
+    }
+
+
+    //////////////////////////////////////////////////////////////////
+    // CompactWitness
+
+    CompactWitness::CompactWitness( sem_elem_t se, witness_log_t log, WitnessLog::step_t step )
+      : SemElem()
+      , user_se(se)
+      , the_log(log)
+      , at(step)
+    {
+      the_log->acquire(at);
+    }
+
+    CompactWitness::~CompactWitness()
+    {
+      the_log->release(at);
+    }
+
+    sem_elem_t CompactWitness::one() const
+    {
+      return new CompactWitness(user_se->one(), the_log, WitnessLog::ONE);
+    }
+
+    sem_elem_t CompactWitness::zero() const
+    {
+      return new CompactWitness(user_se->zero(), the_log, WitnessLog::ZERO);
+    }
+
+    sem_elem_t CompactWitness::extend( SemElem * se )
+    {
+      CompactWitness * that = down(se);
+      if( at == WitnessLog::ONE ) {
+        return that;
+      }
+      else if( that->at == WitnessLog::ONE ) {
+        return this;
+      }
+      return new CompactWitness(user_se->extend(that->user_se), the_log,
+                                the_log->extend(at, that->at));
+    }
+
+    sem_elem_t CompactWitness::combine( SemElem * se )
+    {
+      CompactWitness * that = down(se);
+      if( user_se->equal(user_se->zero()) ) {
+        return that;
+      }
+      else if( that->user_se->equal(that->user_se->zero()) ) {
+        return this;
+      }
+
+      sem_elem_t combined = user_se->combine(that->user_se);
+      if( combined->equal(that->user_se) ) {
+        return that;
+      }
+      else if( combined->equal(user_se) ) {
+        return this;
+      }
+      return new CompactWitness(combined, the_log, the_log->combine(at, that->at));
+    }
+
+    bool CompactWitness::equal( SemElem * se ) const
+    {
+      return user_se->equal(down(se)->user_se);
+    }
+
+    std::ostream& CompactWitness::print( std::ostream& o ) const
+    {
+      o << "CompactWitness(";
+      user_se->print(o);
+      o << ", step " << at << ")";
+      return o;
+    }
+
+    witness_t CompactWitness::witness() const
+    {
+      return the_log->materialize(at, user_se);
+    }
+
+    CompactWitness * CompactWitness::down( SemElem * se ) const
+    {
+      CompactWitness * that = dynamic_cast< CompactWitness * >(se);
+      if( 0 == that ) {
+        *waliErr << "SemElem is \"" << typeid(*se).name() << "\"\n";
+        assert( 0 );
+      }
+      assert( that->the_log == the_log );
+      return that;
+    }
+
+
+    //////////////////////////////////////////////////////////////////
+    // CompactWitnessMergeFn
+
+    CompactWitnessMergeFn::CompactWitnessMergeFn( witness_log_t the_log,
+                                                  size_t the_index,
+                                                  merge_fn_t the_user_merge )
+      : MergeFn()
+      , log(the_log)
+      , index(the_index)
+      , user_merge(the_user_merge)
+    {
+    }
+
+    CompactWitnessMergeFn::~CompactWitnessMergeFn()
+    {
+    }
+
+    sem_elem_t CompactWitnessMergeFn::apply_f( sem_elem_t a, sem_elem_t b )
+    {
+      CompactWitness * caller = dynamic_cast< CompactWitness* >(a.get_ptr());
+      CompactWitness * callee = dynamic_cast< CompactWitness* >(b.get_ptr());
+      if( caller == 0 || callee == 0 ) {
+        *waliErr << "[ERROR] Attempt to apply CompactWitnessMergeFn to non compact witness.\n";
+        assert(0);
+      }
+      sem_elem_t user_se = user_merge->apply_f(caller->weight(), callee->weight());
+      return new CompactWitness(user_se, log, log->merge(index, caller->step(), callee->step()));
+    }
+
+    std::ostream& CompactWitnessMergeFn::print( std::ostream& o ) const
+    {
+      o << "CompactWitnessMergeFn[ ";
+      user_merge->print(o) << "]";
+      return o;
+    }
+
+    bool CompactWitnessMergeFn::equal( merge_fn_t mf )
+    {
+      CompactWitnessMergeFn * that = static_cast< CompactWitnessMergeFn* >(mf.get_ptr());
+      return user_merge->equal(that->user_merge);
+    }
+
+    merge_fn_t CompactWitnessMergeFn::get_user_merge()
+    {
+      return user_merge;
+    }
+
+
+    //////////////////////////////////////////////////////////////////
+    // CompactWitnessWrapper
+
+    CompactWitnessWrapper::CompactWitnessWrapper()
+      : the_log(new WitnessLog())
+    {
+    }
+
+    CompactWitnessWrapper::~CompactWitnessWrapper()
+    {
+    }
+
+    sem_elem_t CompactWitnessWrapper::wrap( wfa::ITrans const & t )
+    {
+      return new CompactWitness(t.weight(), the_log, the_log->leaf(new WitnessTrans(t)));
+    }
+
+    sem_elem_t CompactWitnessWrapper::wrap( wpds::Rule const & r )
+    {
+      return new CompactWitness(r.weight(), the_log, the_log->leaf(new WitnessRule(r)));
+    }
+
+    // As for WitnessWrapper, r.weight() has already been wrapped
+    merge_fn_t CompactWitnessWrapper::wrap( wpds::ewpds::ERule const & r,
+                                            merge_fn_t user_merge )
+    {
+      sem_elem_t se = r.weight();
+      CompactWitness * cw = dynamic_cast< CompactWitness* >(se.get_ptr());
+      assert( cw != NULL );
+      witness_t rule = the_log->getLeaf(cw->step());
+      size_t index = the_log->addMergeFn(new WitnessMergeFn(rule, user_merge), rule);
+      return new CompactWitnessMergeFn(the_log, index, user_merge);
+    }
+
+    sem_elem_t CompactWitnessWrapper::unwrap( sem_elem_t se )
+    {
+      CompactWitness * cw = dynamic_cast< CompactWitness* >(se.get_ptr());
+      if( 0 != cw ) {
+        return cw->weight();
+      }
+      else {
+        *waliErr << "[ERROR] Unwrap called on non CompactWitness weight.\n";
+        assert(0);
+        return 0;
+      }
+    }
+
+    merge_fn_t CompactWitnessWrapper::unwrap( merge_fn_t mf )
+    {
+      CompactWitnessMergeFn * cmf = dynamic_cast< CompactWitnessMergeFn* >(mf.get_ptr());
+      if( 0 != cmf ) {
+        return cmf->get_user_merge();
+      }
+      else {
+        *waliErr << "[ERROR] Unwrap<merge_fn_t> called on non CompactWitnessMergeFn.\n";
+        mf->print( *waliErr << "   mf: " ) << std::endl;
+        assert(0);
+        return 0;
+      }
+    }
+
+  } // namespace witness
+
+} // namespace wali
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
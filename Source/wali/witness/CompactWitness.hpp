@@ -0,0 +1,262 @@
+#ifndef wali_witness_COMPACT_WITNESS_GUARD
+#define wali_witness_COMPACT_WITNESS_GUARD 1
+
+#include "wali/Common.hpp"
+#include "wali/Countable.hpp"
+#include "wali/ref_ptr.hpp"
+#include "wali/SemElem.hpp"
+#include "wali/MergeFn.hpp"
+#include "wali/util/Threads.hpp"
+#include "wali/wpds/Wrapper.hpp"
+#include "wali/witness/Witness.hpp"
+#include "wali/witness/WitnessMergeFn.hpp"
+
+#include <vector>
+
+namespace wali
+{
+  namespace witness
+  {
+    class WitnessLog;
+    typedef ref_ptr<WitnessLog> witness_log_t;
+
+    /**
+     * @class WitnessLog
+     *
+     * A flat table of how the weights of a saturation were computed. Each
+     * step is a few integers: a leaf (a rule or an input transition), or
+     * an extend, combine, or merge of two other steps, named by their
+     * positions in the table. Nothing else is kept for the intermediate
+     * weights -- in particular not the weights themselves, which the
+     * Witness DAG would keep alive.
+     *
+     * Saturation throws away most of the weights it computes, so steps
+     * are reference counted, like the nodes of the Witness DAG: a step
+     * lives while a CompactWitness or another step refers to it, and the
+     * slot of a dead step is reused.
+     *
+     * materialize() rebuilds the ordinary Witness DAG (WitnessExtend,
+     * WitnessCombine, WitnessRule, ...) below one step, recomputing the
+     * intermediate weights from the leaves, so the Visitors work on it
+     * unchanged.
+     *
+     * Under WALI_THREADS the table is locked, so several threads may
+     * use it.
+     *
+     * @see CompactWitness
+     * @see CompactWitnessWrapper
+     */
+    class WitnessLog : public Countable
+    {
+      public:
+        typedef unsigned int step_t;
+
+        /// Steps 0 and 1 are always the witnesses of one and zero
+        static step_t const ONE = 0;
+        static step_t const ZERO = 1;
+
+        WitnessLog();
+
+        /// Records a leaf, e.g. a WitnessRule or WitnessTrans
+        step_t leaf( witness_t w );
+
+        step_t extend( step_t left, step_t right );
+
+        step_t combine( step_t left, step_t right );
+
+        /// Records the merge function of an ERule, for merge()
+        size_t addMergeFn( witness_merge_fn_t mf, witness_t rule );
+
+        step_t merge( size_t merge_fn, step_t caller, step_t callee );
+
+        /// Adds a reference to step s. A new step has none.
+        void acquire( step_t s );
+
+        /// Drops a reference to step s, freeing it (and the steps below
+        /// it that are then unreferenced) when there are none left
+        void release( step_t s );
+
+        /// The leaf recorded at step s (which must be a leaf)
+        witness_t getLeaf( step_t s ) const;
+
+        /// Rebuilds the Witness DAG for step s. 'weight' is the user
+        /// weight computed at s; it gives the one and zero of the domain.
+        witness_t materialize( step_t s, sem_elem_t weight ) const;
+
+        /// The number of live steps
+        size_t size() const;
+
+        /// The memory used by the table, in bytes
+        size_t bytes() const;
+
+      private:
+        enum Kind { KIND_ONE, KIND_ZERO, KIND_LEAF, KIND_EXTEND, KIND_COMBINE, KIND_MERGE, KIND_FREE };
+
+        /// The operands of a step, and its Kind in the low KIND_BITS bits
+        /// of 'tag'; the rest of 'tag' is the merge function of a merge
+        struct Step
+        {
+          step_t a, b;
+          unsigned int tag;
+          unsigned int refs;
+        };
+
+        static unsigned int const KIND_BITS = 3;
+
+        static Kind kindOf( Step const & step ) {
+          return static_cast<Kind>(step.tag & ((1u << KIND_BITS) - 1));
+        }
+
+        static bool hasOperands( Kind kind ) {
+          return kind == KIND_EXTEND || kind == KIND_COMBINE || kind == KIND_MERGE;
+        }
+
+        struct MergeFnEntry
+        {
+          witness_merge_fn_t fn;
+          witness_t rule;
+        };
+
+        step_t append( Kind kind, step_t a, step_t b, unsigned int merge_fn );
+
+        std::vector<Step> steps;
+        std::vector<step_t> free_steps;
+        std::vector<witness_t> leaves;
+        std::vector<MergeFnEntry> merge_fns;
+
+        mutable util::Mutex lock;
+    };
+
+
+    /**
+     * @class CompactWitness
+     *
+     * A user weight and the step of a WitnessLog that computed it (which
+     * it holds a reference to). This is the weight that
+     * CompactWitnessWrapper puts on rules and transitions: extend and
+     * combine do the user's operation and add one step to the log, and
+     * the Witness DAG is only built, by witness(), for the weights a
+     * client asks about.
+     */
+    class CompactWitness : public SemElem
+    {
+      public:
+        CompactWitness( sem_elem_t user_se, witness_log_t log, WitnessLog::step_t step );
+
+        virtual ~CompactWitness();
+
+        virtual sem_elem_t one() const;
+
+        virtual sem_elem_t zero() const;
+
+        /// Extends the user weights and logs the extend, unless one side
+        /// is the witness of one (as Witness::extend does)
+        virtual sem_elem_t extend( SemElem * se );
+
+        /// Combines the user weights and logs the combine, unless the
+        /// result is one of the two sides (as Witness::combine does)
+        virtual sem_elem_t combine( SemElem * se );
+
+        virtual bool equal( SemElem * se ) const;
+
+        virtual std::ostream& print( std::ostream& o ) const;
+
+        //! The user weight
+        sem_elem_t weight() const { return user_se; }
+
+        //! The step of the log that computed this weight
+        WitnessLog::step_t step() const { return at; }
+
+        witness_log_t log() const { return the_log; }
+
+        //! Builds the Witness DAG for this weight
+        witness_t witness() const;
+
+      private:
+        // Not implemented; a copy would not hold its own reference
+        CompactWitness( CompactWitness const & );
+        CompactWitness & operator=( CompactWitness const & );
+
+        CompactWitness * down( SemElem * se ) const;
+
+        sem_elem_t user_se;
+        witness_log_t the_log;
+        WitnessLog::step_t at;
+
+    }; // class CompactWitness
+
+
+    /**
+     * @class CompactWitnessMergeFn
+     *
+     * Applies the user's merge function and logs the merge.
+     */
+    class CompactWitnessMergeFn : public MergeFn
+    {
+      public:
+        CompactWitnessMergeFn( witness_log_t log, size_t index, merge_fn_t user_merge );
+
+        virtual ~CompactWitnessMergeFn();
+
+        virtual sem_elem_t apply_f( sem_elem_t w1, sem_elem_t w2 );
+
+        virtual std::ostream& print( std::ostream& o ) const;
+
+        virtual bool equal( merge_fn_t mf );
+
+        merge_fn_t get_user_merge();
+
+      private:
+        witness_log_t log;
+        size_t index;
+        merge_fn_t user_merge;
+    };
+
+
+    /**
+     * @class CompactWitnessWrapper
+     *
+     * A Wrapper that gives the same witnesses as WitnessWrapper, but
+     * keeps only a WitnessLog during saturation; call
+     * CompactWitness::witness() on the weight of a transition to get its
+     * Witness DAG. Each live extend or combine then costs a 16-byte step,
+     * where WitnessWrapper keeps a Witness node and a weight for it.
+     *
+     * (Unlike Witness, CompactWitness does not track minimum lengths, so
+     * WitnessLengthWorklist cannot be used with it.)
+     */
+    class CompactWitnessWrapper : public ::wali::wpds::Wrapper
+    {
+      public:
+        CompactWitnessWrapper();
+
+        virtual ~CompactWitnessWrapper();
+
+        virtual sem_elem_t wrap( wfa::ITrans const & t );
+
+        virtual sem_elem_t wrap( wpds::Rule const & r );
+
+        virtual merge_fn_t wrap( wpds::ewpds::ERule const & r, merge_fn_t user_merge );
+
+        virtual sem_elem_t unwrap( sem_elem_t se );
+
+        virtual merge_fn_t unwrap( merge_fn_t mf );
+
+        witness_log_t log() const { return the_log; }
+
+      private:
+        witness_log_t the_log;
+
+    }; // class CompactWitnessWrapper
+
+  } // namespace witness
+
+} // namespace wali
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif  // wali_witness_COMPACT_WITNESS_GUARD
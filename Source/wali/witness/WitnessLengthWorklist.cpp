@@ -6,6 +6,8 @@
 #include "wali/witness/WitnessLengthWorklist.hpp"
 #include "wali/wfa/Trans.hpp"
 
+#include <climits>
+
 namespace wali
 {
   namespace witness
@@ -17,6 +19,26 @@ namespace wali
     WitnessLengthWorklist::~WitnessLengthWorklist()
     {
     }
+
+
+    int MinimumLengthRank::operator()( const wfa::ITrans* t ) const
+    {
+      Witness *wit = dynamic_cast<Witness*>(t->weight().get_ptr());
+      assert (wit && "Transition without witness used with WitnessLengthBucketWorklist");
+
+      unsigned long length = wit->getMinimumLength();
+      return length > INT_MAX ? INT_MAX : static_cast<int>(length);
+    }
+
+
+    WitnessLengthBucketWorklist::WitnessLengthBucketWorklist( int max_bucket )
+      : BucketWorklist<MinimumLengthRank>(max_bucket)
+    {
+    }
+
+    WitnessLengthBucketWorklist::~WitnessLengthBucketWorklist()
+    {
+    }
   }
 }
 
@@ -8,6 +8,7 @@
 #include "wali/Common.hpp"
 #include "wali/witness/Witness.hpp"
 #include "wali/PriorityWorklist.hpp"
+#include "wali/BucketWorklist.hpp"
 
 namespace wali
 {
@@ -40,6 +41,23 @@ namespace wali
         virtual ~WitnessLengthWorklist();
     }; // class WitnessLengthWorklist
 
+
+    /// Ranks a transition by the minimum length of its witness, clamped
+    /// to INT_MAX
+    struct MinimumLengthRank
+    {
+      int operator()( const wfa::ITrans* t ) const;
+    };
+
+    /// The order of WitnessLengthWorklist, kept in buckets by length
+    /// instead of in a heap. @see BucketWorklist
+    class WitnessLengthBucketWorklist : public BucketWorklist<MinimumLengthRank>
+    {
+      public:
+        explicit WitnessLengthBucketWorklist( int max_bucket = DEFAULT_MAX_BUCKET );
+        virtual ~WitnessLengthBucketWorklist();
+    }; // class WitnessLengthBucketWorklist
+
   } // namespace witness
 
 } // namespace wali
@@ -43,6 +43,8 @@ namespace wali
             rule_t & r,
             sem_elem_t delta);
 
+        virtual bool usesDefaultPostHandlers() const { return false; }
+
         virtual void update(
             Key from, Key stack, Key to, 
             sem_elem_t se, Config * cfg );
@@ -7,6 +7,7 @@
 
 #include "wali/Common.hpp"
 #include "wali/SemElem.hpp"
+#include "wali/WeightOpCache.hpp"
 #include "wali/Worklist.hpp"
 #include "wali/KeyPairSource.hpp"
 #include "wali/wfa/State.hpp"
@@ -19,8 +20,11 @@
 #include "wali/wpds/Wrapper.hpp"
 #include "wali/wpds/GenKeySource.hpp"
 #include "wali/DefaultWorklist.hpp"
+#include "wali/details/WorkStealingWorklist.hpp"
+#include "wali/util/Threads.hpp"
 #include <iostream>
 #include <cassert>
+#include <vector>
 
 //
 // TODO: 
@@ -40,17 +44,50 @@ namespace wali
 
     const std::string WPDS::XMLTag("WPDS");
 
+#if WALI_THREADS
+    /**
+     * State shared by the workers of a parallel saturation.
+     *
+     * 'lock' guards everything that is not a weight computation: the
+     * output WFA (and the transitions' weights and deltas), the Configs,
+     * and the KeySpace (through gen_state). It is one lock for all
+     * workers, not one per (from, stack) partition: a rule applied to a
+     * transition of one partition inserts into the WFA's shared maps
+     * transitions of another, so per-partition locks would not protect
+     * them. See setWorkerThreads for what this means for scaling.
+     */
+    struct WPDS::ParallelState
+    {
+      explicit ParallelState( unsigned workers )
+        : worklist( new details::WorkStealingWorklist(workers) )
+      {}
+
+      ref_ptr< details::WorkStealingWorklist > worklist;
+      std::mutex lock;
+    };
+#else
+    struct WPDS::ParallelState {};
+#endif
+
     WPDS::WPDS() :
       wrapper(0),
       worklist( new DefaultWorklist<wfa::ITrans>() ),
-      currentOutputWFA(0)
+      currentOutputWFA(0),
+      worker_threads(1),
+      parallel(0),
+      use_arena(false),
+      config_arena(0)
     {
     }
 
     WPDS::WPDS( ref_ptr<Wrapper> w ) :
       wrapper(w),
       worklist( new DefaultWorklist<wfa::ITrans>() ),
-      currentOutputWFA(0)
+      currentOutputWFA(0),
+      worker_threads(1),
+      parallel(0),
+      use_arena(false),
+      config_arena(0)
     {
     }
 
@@ -59,8 +96,13 @@ namespace wali
       wali::wfa::ConstTransFunctor(),
       wrapper(w.wrapper),
       worklist( new DefaultWorklist<wfa::ITrans>() ),
-      currentOutputWFA(0)
+      currentOutputWFA(0),
+      worker_threads(w.worker_threads),
+      parallel(0),
+      use_arena(false),
+      config_arena(0)
     {
+      useArena(w.use_arena);
       RuleCopier rc(*this,wrapper);
       w.for_each(rc);
     }
@@ -69,6 +111,15 @@ namespace wali
     {
       //*waliErr << "~WPDS()" << std::endl;
       clear();
+      delete config_arena;
+    }
+
+    void WPDS::useArena( bool enable )
+    {
+      use_arena = enable;
+      if( use_arena && config_arena == 0 ) {
+        config_arena = new util::Arena();
+      }
     }
 
     void WPDS::clear()
@@ -81,7 +132,12 @@ namespace wali
       {
         Config* c = cit->second;
         assert(c);
-        delete c;
+        if( config_arena && config_arena->owns(c) ) {
+          config_arena->destroy(c);
+        }
+        else {
+          delete c;
+        }
         cit->second = 0;
       }
 
@@ -100,6 +156,10 @@ namespace wali
 
       pds_states.clear();
       //*waliErr << "  5. Cleared pds_states()" << std::endl;
+
+      if( config_arena ) {
+        config_arena->release();
+      }
     }
 
     /**
@@ -114,6 +174,11 @@ namespace wali
       worklist = wl;
     }
 
+    void WPDS::setWorkerThreads( unsigned num_threads )
+    {
+      worker_threads = num_threads;
+    }
+
     bool WPDS::add_rule(
         Key from_state,
         Key from_stack,
@@ -298,6 +363,12 @@ namespace wali
 
     void WPDS::prestarComputeFixpoint( WFA& fa )
     {
+      if( util::effective_threads(worker_threads) > 1
+          && supportsParallelSaturation() )
+      {
+        parallelComputeFixpoint(fa, false);
+        return;
+      }
 
       wfa::ITrans * t;
 
@@ -385,6 +456,16 @@ namespace wali
     {
 
       sem_elem_t wrule_trans = r->weight()->extend( delta );
+      prestar_commit_trans( t, fa, r, wrule_trans );
+    }
+
+    void WPDS::prestar_commit_trans(
+        wfa::ITrans* t ,
+        WFA & fa   ,
+        rule_t & r,
+        sem_elem_t wrule_trans
+        )
+    {
       Key fstate = r->from()->state();
       Key fstack = r->from()->stack();
 
@@ -477,6 +558,13 @@ namespace wali
 
     void WPDS::poststarComputeFixpoint( WFA& fa )
     {
+      if( util::effective_threads(worker_threads) > 1
+          && supportsParallelSaturation() )
+      {
+        parallelComputeFixpoint(fa, true);
+        return;
+      }
+
       wfa::ITrans* t;
 
       while( get_from_worklist( t ) ) 
@@ -506,10 +594,17 @@ namespace wali
       // Apply rule to create new transition
       if( WALI_EPSILON != t->stack() )
       {
-        Config::iterator fwit = config->begin();
-        for( ; fwit != config->end() ; fwit++ ) {
-          rule_t & r = *fwit;
-          poststar_handle_trans( t,fa,r,dnew );
+        // Batching bypasses poststar_handle_trans, so only do it when
+        // the handlers are WPDS's own
+        if( dnew->hasBatchOperations() && usesDefaultPostHandlers() ) {
+          postBatched( t, fa, dnew );
+        }
+        else {
+          Config::iterator fwit = config->begin();
+          for( ; fwit != config->end() ; fwit++ ) {
+            rule_t & r = *fwit;
+            poststar_handle_trans( t,fa,r,dnew );
+          }
         }
       }
       else {
@@ -524,6 +619,40 @@ namespace wali
       }
     }
 
+    void WPDS::postBatched( wfa::ITrans* t, WFA& fa, sem_elem_t delta )
+    {
+      Config * config = t->getConfig();
+      std::vector<rule_t> rules;
+      std::vector<Key> gstates;
+      std::vector<SemElem*> lhs, rhs;
+      Config::iterator fwit = config->begin();
+      for( ; fwit != config->end() ; fwit++ ) {
+        rule_t & r = *fwit;
+        Key gstate = WALI_EPSILON;
+        if( r->to_stack2() != WALI_EPSILON ) {
+          gstate = gen_state( r->to_state(),r->to_stack1() );
+        }
+        rules.push_back(r);
+        gstates.push_back(gstate);
+        lhs.push_back(delta.get_ptr());
+        rhs.push_back(r->weight().get_ptr());
+      }
+      if( rules.empty() ) {
+        return;
+      }
+
+      std::vector<sem_elem_t> extended(rules.size());
+      delta->extendMany(&lhs[0], &rhs[0], rules.size(), &extended[0]);
+
+      // Committing a rule can change the existing weight a later rule
+      // sees, so look each one up just before committing it
+      for( size_t i = 0 ; i < rules.size() ; i++ ) {
+        sem_elem_t existing = poststar_existing_weight(t, rules[i], gstates[i]);
+        sem_elem_t wrule_trans = extended[i]->delta(existing).second;
+        poststar_commit_trans( t, fa, rules[i], gstates[i], delta, wrule_trans );
+      }
+    }
+
     void WPDS::poststar_handle_eps_trans(wfa::ITrans *teps, wfa::ITrans*tprime, sem_elem_t delta)
     {
       sem_elem_t wght = tprime->poststar_eps_closure( delta );
@@ -542,20 +671,52 @@ namespace wali
         rule_t & r,
         sem_elem_t delta
         )
+    {
+      // A rule 2 generates a state for the callee's entry
+      Key gstate = WALI_EPSILON;
+      if( r->to_stack2() != WALI_EPSILON ) {
+        gstate = gen_state( r->to_state(),r->to_stack1() );
+      }
+      sem_elem_t existing_weight = poststar_existing_weight( t, r, gstate );
+      sem_elem_t wrule_trans = delta->extendAndDiff(r->weight(), existing_weight);
+      poststar_commit_trans( t, fa, r, gstate, delta, wrule_trans );
+    }
+
+    sem_elem_t WPDS::poststar_existing_weight(
+        wfa::ITrans* t,
+        rule_t & r,
+        Key gstate
+        )
+    {
+      Trans existing;
+      bool found;
+      if( r->to_stack2() == WALI_EPSILON ) {
+        found = currentOutputWFA->find(r->to_state(), r->to_stack1(), t->to(), existing);
+      }
+      else {
+        found = currentOutputWFA->find(gstate, r->to_stack2(), t->to(), existing);
+      }
+      if (found) {
+        return existing.weight();
+      }
+      else {
+        return t->weight()->zero();
+      }
+    }
+
+    void WPDS::poststar_commit_trans(
+        wfa::ITrans* t, // t is a non-epsilon transition
+        WFA & fa,
+        rule_t & r,
+        Key gstate,
+        sem_elem_t delta,
+        sem_elem_t wrule_trans
+        )
     {
       Key rtstate = r->to_state();
       Key rtstack = r->to_stack1();
       
       if( r->to_stack2() == WALI_EPSILON ) {
-        Trans existing;
-        sem_elem_t existing_weight;
-        if (currentOutputWFA->find(rtstate, rtstack, t->to(), existing)) {
-          existing_weight = existing.weight();
-        }
-        else {
-          existing_weight = t->weight()->zero();
-        }
-        sem_elem_t wrule_trans = delta->extendAndDiff(r->weight(), existing_weight);
         // t must be a rule 1 (pop rules handled by poststar_handle_eps_trans)
         update( rtstate, rtstack, t->to(), wrule_trans, r->to() );
       }
@@ -563,18 +724,6 @@ namespace wali
 
         // Is a rule 2 so we must generate a state
         // and create 2 new transitions
-        Key gstate = gen_state( rtstate,rtstack );
-
-        Trans existing;
-        sem_elem_t existing_weight;
-        if (currentOutputWFA->find(gstate, r->to_stack2(), t->to(), existing)) {
-          existing_weight = existing.weight();
-        }
-        else {
-          existing_weight = t->weight()->zero();
-        }
-        sem_elem_t wrule_trans = delta->extendAndDiff(r->weight(), existing_weight);
-
         wfa::ITrans* tprime = 
           update_prime( gstate, t, r, delta, wrule_trans );
 
@@ -966,7 +1115,7 @@ namespace wali
     {
       Config *cf = find_config( state,stack );
       if( 0 == cf ) {
-        cf = new Config(state,stack);
+        cf = use_arena ? new (*config_arena) Config(state,stack) : new Config(state,stack);
         KeyPair kp(state,stack);
         config_map().insert( kp,cf );
       }
@@ -1108,6 +1257,206 @@ namespace wali
       }
     }
 
+#if WALI_THREADS
+    namespace
+    {
+      /// A rule application whose weight is computed outside the lock
+      struct PendingRule
+      {
+        PendingRule( rule_t const & r, Key g, sem_elem_t a, sem_elem_t b )
+          : rule(r), gstate(g), first(a), second(b)
+        {}
+
+        rule_t rule;
+        Key gstate;
+        sem_elem_t first;
+        sem_elem_t second;
+        sem_elem_t result;
+      };
+    }
+
+    void WPDS::parallelComputeFixpoint( WFA& fa, bool forward )
+    {
+      unsigned num_threads = util::effective_threads(worker_threads);
+      ParallelState state(num_threads);
+
+      // Everything setupOutput put on the worklist moves to the workers'
+      // deques; from here until the fixpoint is reached, update() puts to
+      // the work-stealing worklist.
+      ref_ptr< Worklist<wfa::ITrans> > saved = worklist;
+      wfa::ITrans * t;
+      while( get_from_worklist( t ) ) {
+        state.worklist->put( t );
+      }
+      worklist = state.worklist;
+      parallel = &state;
+
+      std::vector<std::thread> threads;
+      for( unsigned i = 1 ; i < num_threads ; ++i ) {
+        threads.push_back(std::thread(&WPDS::parallelWorker, this,
+                                      i, std::ref(fa), forward));
+      }
+      parallelWorker(0, fa, forward);
+      for( size_t i = 0 ; i < threads.size() ; ++i ) {
+        threads[i].join();
+      }
+
+      parallel = 0;
+      worklist = saved;
+    }
+
+    void WPDS::parallelWorker( unsigned id, WFA& fa, bool forward )
+    {
+      wfa::ITrans * t;
+      while( parallel->worklist->get( id, t ) ) {
+        if( forward ) {
+          parallelPost( t, fa );
+        }
+        else {
+          parallelPre( t, fa );
+        }
+        parallel->worklist->done();
+      }
+    }
+
+    void WPDS::parallelPost( wfa::ITrans* t, WFA& fa )
+    {
+      std::vector<PendingRule> pending;
+      sem_elem_t dnew;
+
+      // Phase 1: take t's delta and gather the operands for each rule
+      {
+        std::lock_guard<std::mutex> guard(parallel->lock);
+        if( fa.progress.is_valid() )
+            fa.progress->tick();
+
+        if( WALI_EPSILON == t->stack() ) {
+          // Epsilon transitions only come from pop rules and only need
+          // a single extend per matching transition.
+          post( t, fa );
+          return;
+        }
+
+        dnew = t->getDelta();
+        t->setDelta(fa.getSomeWeight()->zero());
+
+        Config * config = t->getConfig();
+        Config::iterator fwit = config->begin();
+        for( ; fwit != config->end() ; fwit++ ) {
+          rule_t & r = *fwit;
+          Key gstate = WALI_EPSILON;
+          if( r->to_stack2() != WALI_EPSILON ) {
+            gstate = gen_state( r->to_state(),r->to_stack1() );
+          }
+          pending.push_back(PendingRule(r, gstate, r->weight(),
+                                        poststar_existing_weight(t, r, gstate)));
+        }
+      }
+
+      // Phase 2: the expensive part, done concurrently
+      if( dnew->hasBatchOperations() && !pending.empty() ) {
+        std::vector<SemElem*> lhs(pending.size(), dnew.get_ptr());
+        std::vector<SemElem*> rhs;
+        for( size_t i = 0 ; i < pending.size() ; ++i ) {
+          rhs.push_back(pending[i].first.get_ptr());
+        }
+        std::vector<sem_elem_t> extended(pending.size());
+        dnew->extendMany(&lhs[0], &rhs[0], pending.size(), &extended[0]);
+        for( size_t i = 0 ; i < pending.size() ; ++i ) {
+          pending[i].result = extended[i]->delta(pending[i].second).second;
+        }
+      }
+      else {
+        for( size_t i = 0 ; i < pending.size() ; ++i ) {
+          pending[i].result = dnew->extendAndDiff(pending[i].first, pending[i].second);
+        }
+      }
+
+      // Phase 3: add the new transitions exactly as post() would have
+      {
+        std::lock_guard<std::mutex> guard(parallel->lock);
+        for( size_t i = 0 ; i < pending.size() ; ++i ) {
+          poststar_commit_trans( t, fa, pending[i].rule, pending[i].gstate,
+                                 dnew, pending[i].result );
+        }
+      }
+    }
+
+    void WPDS::parallelPre( wfa::ITrans* t, WFA& fa )
+    {
+      std::vector<PendingRule> backward;
+      std::vector<PendingRule> calls;
+      sem_elem_t dnew;
+
+      // Phase 1: take t's delta and gather the operands for each rule
+      {
+        std::lock_guard<std::mutex> guard(parallel->lock);
+        if( fa.progress.is_valid() )
+            fa.progress->tick();
+
+        Config * config = t->getConfig();
+        assert( config );
+
+        dnew = t->getDelta();
+        t->setDelta(dnew->zero());
+
+        Config::reverse_iterator bwit = config->rbegin();
+        for( ; bwit != config->rend() ; bwit++ ) {
+          rule_t & r = *bwit;
+          backward.push_back(PendingRule(r, WALI_EPSILON, r->weight(), dnew));
+        }
+
+        r2hash_t::iterator r2it = r2hash.find( t->stack() );
+        if( r2it != r2hash.end() ) {
+          std::list< rule_t > & ls = r2it->second;
+          std::list< rule_t >::iterator lsit;
+          for( lsit = ls.begin() ; lsit != ls.end() ; lsit++ ) {
+            rule_t & r = *lsit;
+            wfa::ITrans *tp = fa.find(r->to_state(),r->to_stack1(),t->from());
+            if( tp != 0 ) {
+              calls.push_back(PendingRule(r, WALI_EPSILON, r->weight(), tp->weight()));
+            }
+          }
+        }
+      }
+
+      // Phase 2: the expensive part, done concurrently
+      for( size_t i = 0 ; i < backward.size() ; ++i ) {
+        // f(r) * delta
+        backward[i].result = backward[i].first->extend( dnew );
+      }
+      for( size_t i = 0 ; i < calls.size() ; ++i ) {
+        // f(r) * t1 * delta
+        calls[i].result = calls[i].first->extend( calls[i].second )->extend( dnew );
+      }
+
+      // Phase 3: add the new transitions exactly as pre() would have
+      {
+        std::lock_guard<std::mutex> guard(parallel->lock);
+        for( size_t i = 0 ; i < backward.size() ; ++i ) {
+          prestar_commit_trans( t, fa, backward[i].rule, backward[i].result );
+        }
+        for( size_t i = 0 ; i < calls.size() ; ++i ) {
+          rule_t & r = calls[i].rule;
+          update( r->from()->state()
+              , r->from()->stack()
+              , t->to()
+              , calls[i].result
+              , r->from()
+              );
+        }
+      }
+    }
+#else
+    void WPDS::parallelComputeFixpoint( WFA& fa, bool forward )
+    {
+      // Not built with threads=1; effective_threads() never lets us get here
+      (void) fa;
+      (void) forward;
+      assert(false);
+    }
+#endif
+
     /**
      * @brief helper function to create and link a transition
      *
@@ -1120,7 +1469,9 @@ namespace wali
         Config * cfg
         )
     {
-      wfa::ITrans*t = currentOutputWFA->insert(new Trans(from,stack,to,se));
+      util::Arena * arena = currentOutputWFA->arena();
+      wfa::ITrans*t = currentOutputWFA->insert(
+          arena ? new (*arena) Trans(from,stack,to,se) : new Trans(from,stack,to,se));
       t->setConfig(cfg);
       if (t->modified()) {
         //t->print(std::cout << "Adding transition: ") << "\n";
@@ -1144,7 +1495,10 @@ namespace wali
         sem_elem_t wWithRule //<! delta \extends r->weight()
         )
     {
-      wfa::ITrans* tmp = new Trans(from,r->to_stack2(),call->to(),wWithRule);
+      util::Arena * arena = currentOutputWFA->arena();
+      wfa::ITrans* tmp = arena
+        ? new (*arena) Trans(from,r->to_stack2(),call->to(),wWithRule)
+        : new Trans(from,r->to_stack2(),call->to(),wWithRule);
       wfa::ITrans* t = currentOutputWFA->insert(tmp);
       return t;
     }
@@ -1198,6 +1552,7 @@ namespace wali
          << "   pushes: " << rules.pushRules.size() << "\n"
          << "   steps:  " << rules.stepRules.size() << "\n"
          << "   pops:   " << rules.popRules.size() << "\n";
+      WeightOpCache::printAll(os);
     }
 
     namespace details {
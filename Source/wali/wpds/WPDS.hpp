@@ -9,9 +9,11 @@
 #include "wali/Common.hpp"
 #include "wali/Printable.hpp"
 #include "wali/HashMap.hpp"
+#include "wali/OpenHashMap.hpp"
 #include "wali/KeyContainer.hpp"
 #include "wali/SemElem.hpp"
 #include "wali/Worklist.hpp"
+#include "wali/util/Arena.hpp"
 
 // ::wali::wfa
 #include "wali/wfa/WFA.hpp"
@@ -51,7 +53,7 @@ namespace wali
         static const std::string XMLTag;
 
       protected:
-        typedef HashMap< KeyPair,Config * > chash_t;
+        typedef HotHashMap< KeyPair,Config * >::type chash_t;
         typedef chash_t::iterator iterator;
         typedef chash_t::const_iterator const_iterator;
 
@@ -82,6 +84,51 @@ namespace wali
          */
         void setWorklist( ref_ptr< Worklist<wfa::ITrans> > wl );
 
+        /**
+         * Set the number of threads used to saturate the output automaton
+         * in pre and poststar queries. 1 (the default) runs the usual
+         * sequential fixpoint; 0 uses one thread per hardware thread.
+         *
+         * In parallel mode the output transitions are partitioned by their
+         * (from, stack) key among the workers, which steal from each other
+         * when they run out of work. The partition only decides which
+         * worker's deque a transition goes on: every change to the output
+         * WFA, the Configs, and the KeySpace is made under one lock shared
+         * by all workers. Only the extends and diffs of the weights run
+         * concurrently, so the speedup is bounded by the share of the
+         * time spent in the weight domain, and with cheap weights the
+         * workers mostly wait for the lock.
+         *
+         * The weight domain must be safe to use from several threads at
+         * once, and weights must be reference counted atomically
+         * (WALI_ATOMIC_REFCOUNT, which threads=1 turns on by default).
+         * The answer is the same as the sequential one.
+         *
+         * The setting (and the worklist set with setWorklist) is ignored
+         * when WALi is built without threads=1 and by subclasses that
+         * replace the saturation handlers (EWPDS, FWPDS). FWPDS instead
+         * uses it to solve independent parts of its InterGraph
+         * concurrently; see graph::InterGraph::setWorkerThreads.
+         */
+        void setWorkerThreads( unsigned num_threads );
+
+        /**
+         * @return the number of threads requested with setWorkerThreads
+         */
+        unsigned getWorkerThreads() const { return worker_threads; }
+
+        /**
+         * Allocate this WPDS's Configs from an arena owned by the WPDS,
+         * which clear() and the destructor give back in a few large
+         * blocks. Off by default; copies inherit the setting.
+         *
+         * Transitions created by pre* and post* come from the output
+         * WFA's arena instead; see WFA::useArena.
+         */
+        void useArena( bool enable );
+
+        bool usesArena() const { return use_arena; }
+
 
         /** 
          * @brief create rule with no r.h.s. stack symbols
@@ -313,6 +360,8 @@ namespace wali
 
         sem_elem_t get_theZero() {return theZero; }
 
+        /// Prints the size of this WPDS, and the statistics of any
+        /// WeightOpCaches, to 'os'
         void printStatistics(std::ostream & os) const;
         
         void toWfa(wfa::WFA & wfa) const;
@@ -400,6 +449,16 @@ namespace wali
             rule_t & r,
             sem_elem_t delta );
 
+        /**
+         * @brief Second half of prestar_handle_trans: creates the
+         * transitions for rule r given wrule_trans = f(r) * delta
+         */
+        void prestar_commit_trans(
+            wfa::ITrans * t,
+            wfa::WFA & ca,
+            rule_t & r,
+            sem_elem_t wrule_trans );
+
         /**
          * @brief Gets WPDS ready for fixpoint
          */
@@ -415,6 +474,14 @@ namespace wali
          */
         virtual void post( wfa::ITrans * t, wfa::WFA& fa );
 
+        /**
+         * @brief post for a non-epsilon t whose weights have batch
+         * operations (SemElem::hasBatchOperations): extends delta by the
+         * weights of all of t's rules with one extendMany, then commits
+         * them in order as poststar_handle_trans would
+         */
+        void postBatched( wfa::ITrans * t, wfa::WFA& fa, sem_elem_t delta );
+
         /**
          * @brief helper method for poststar
          */
@@ -426,6 +493,11 @@ namespace wali
 
         /**
          * @brief helper method for poststar
+         *
+         * post() skips this and goes through postBatched when the weights
+         * have batch operations and usesDefaultPostHandlers() is true. A
+         * subclass that overrides this must also override
+         * usesDefaultPostHandlers to return false.
          */
         virtual void poststar_handle_trans(
             wfa::ITrans * t ,
@@ -434,6 +506,66 @@ namespace wali
             sem_elem_t delta
             );
 
+        /**
+         * @brief Are poststar_handle_trans, update, and update_prime
+         * WPDS's own? If so, post() may batch the extends of a
+         * transition's rules (see postBatched).
+         */
+        virtual bool usesDefaultPostHandlers() const { return true; }
+
+        /**
+         * @brief Returns the weight of the transition that applying rule
+         * r to t would update, or zero if it does not exist yet. gstate is
+         * the generated state of a push rule (see gen_state) and is
+         * ignored for step rules.
+         */
+        sem_elem_t poststar_existing_weight(
+            wfa::ITrans * t,
+            rule_t & r,
+            Key gstate );
+
+        /**
+         * @brief Second half of poststar_handle_trans: creates the
+         * transitions for rule r given
+         * wrule_trans = delta->extendAndDiff(f(r), existing)
+         */
+        void poststar_commit_trans(
+            wfa::ITrans * t,
+            wfa::WFA & ca,
+            rule_t & r,
+            Key gstate,
+            sem_elem_t delta,
+            sem_elem_t wrule_trans );
+
+        /**
+         * @brief Can pre and poststar use the parallel fixpoint? Subclasses
+         * that override the saturation handlers return false.
+         */
+        virtual bool supportsParallelSaturation() const { return true; }
+
+        /**
+         * @brief Performs the fixpoint computation with worker_threads
+         * threads. 'forward' selects post (true) or pre (false).
+         */
+        void parallelComputeFixpoint( wfa::WFA& fa, bool forward );
+
+#if WALI_THREADS
+        /**
+         * @brief Body of one worker thread of parallelComputeFixpoint
+         */
+        void parallelWorker( unsigned id, wfa::WFA& fa, bool forward );
+
+        /**
+         * @brief Thread-safe version of post used by parallelWorker
+         */
+        void parallelPost( wfa::ITrans * t, wfa::WFA& fa );
+
+        /**
+         * @brief Thread-safe version of pre used by parallelWorker
+         */
+        void parallelPre( wfa::ITrans * t, wfa::WFA& fa );
+#endif
+
         /**
          * @brief create a new temp state from two existing states
          *
@@ -598,6 +730,19 @@ namespace wali
         sem_elem_t theZero; 
         std::set<wali::Key> pds_states; // set of PDS states
 
+        /// Number of threads to use for saturation. See setWorkerThreads.
+        unsigned worker_threads;
+
+        /**
+         * Opaque state shared by the worker threads during a parallel
+         * saturation (see WPDS.cpp). Is NULL all other times.
+         */
+        struct ParallelState;
+        ParallelState* parallel;
+
+        bool use_arena;             //! < See useArena
+        util::Arena * config_arena; //! < Created on first use; NULL before
+
       private:
 
     };
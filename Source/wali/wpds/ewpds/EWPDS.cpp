@@ -566,12 +566,16 @@ namespace wali
           )
       {
 
+        util::Arena * arena = currentOutputWFA->arena();
         wfa::ITrans *t;
         if(addEtrans) {
-          t = currentOutputWFA->insert(new ETrans(from, stack, to,
-                0, se, 0));
+          t = currentOutputWFA->insert(arena
+              ? new (*arena) ETrans(from, stack, to, 0, se, 0)
+              : new ETrans(from, stack, to, 0, se, 0));
         } else {
-          t = currentOutputWFA->insert(new wfa::Trans(from, stack, to, se));
+          t = currentOutputWFA->insert(arena
+              ? new (*arena) wfa::Trans(from, stack, to, se)
+              : new wfa::Trans(from, stack, to, se));
         }
 
         t->setConfig(cfg);
@@ -595,8 +599,12 @@ namespace wali
         // Changes here should be reflected there.
         //
         ERule* er = (ERule*)r.get_ptr();
-        wfa::ITrans* tmp = 
-          new ETrans(
+        util::Arena * arena = currentOutputWFA->arena();
+        wfa::ITrans* tmp = arena
+          ? new (*arena) ETrans(
+              from, r->to_stack2(), call->to(),
+              delta, wWithRule, er)
+          : new ETrans(
               from, r->to_stack2(), call->to(),
               delta, wWithRule, er);
         wfa::ITrans* t = currentOutputWFA->insert(tmp);
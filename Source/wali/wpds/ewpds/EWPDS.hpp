@@ -273,6 +273,14 @@ namespace wali
               sem_elem_t delta
               );
 
+          /**
+           * @brief The EWPDS handlers are not split into compute and
+           * commit phases, so saturation is always sequential
+           */
+          virtual bool supportsParallelSaturation() const { return false; }
+
+          virtual bool usesDefaultPostHandlers() const { return false; }
+
           virtual void update_etrans(
               Key from
               , Key stack
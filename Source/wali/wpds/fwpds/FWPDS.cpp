@@ -26,6 +26,7 @@
 #include "wali/wpds/Config.hpp"
 #include "wali/wpds/GenKeySource.hpp"
 #include "wali/wpds/Rule.hpp"
+#include "wali/wpds/RuleFunctor.hpp"
 
 // ::wali::wpds::ewpds
 #include "wali/wpds/ewpds/ERule.hpp"
@@ -39,6 +40,9 @@
 #include "wali/graph/RegExp.hpp"
 #include "wali/graph/InterGraph.hpp"
 
+#include <algorithm>
+#include <set>
+
 using namespace wali;
 using namespace wali::graph;
 using namespace wali::wpds;
@@ -49,19 +53,23 @@ using namespace wali::wpds::ewpds;
 
 const std::string FWPDS::XMLTag("FWPDS");
 
-FWPDS::FWPDS() : EWPDS(), interGr(NULL), checkingPhase(false), newton(false), topDown(true)
+FWPDS::FWPDS() : EWPDS(), interGr(NULL), checkingPhase(false), newton(false), topDown(true),
+  persistentActive(false), persistentPost(false), recordingLabels(false)
 {
 }
 
-FWPDS::FWPDS(ref_ptr<wpds::Wrapper> wr) : EWPDS(wr) , interGr(NULL), checkingPhase(false), newton(false), topDown(true)
+FWPDS::FWPDS(ref_ptr<wpds::Wrapper> wr) : EWPDS(wr) , interGr(NULL), checkingPhase(false), newton(false), topDown(true),
+  persistentActive(false), persistentPost(false), recordingLabels(false)
 {
 }
 
-FWPDS::FWPDS( const FWPDS& f ) : EWPDS(f),interGr(NULL),checkingPhase(false), newton(f.newton), topDown(f.topDown)
+FWPDS::FWPDS( const FWPDS& f ) : EWPDS(f),interGr(NULL),checkingPhase(false), newton(f.newton), topDown(f.topDown),
+  persistentActive(false), persistentPost(false), recordingLabels(false)
 {
 }
 
-FWPDS::FWPDS(bool _newton) : EWPDS(), newton(_newton), topDown(true)
+FWPDS::FWPDS(bool _newton) : EWPDS(), newton(_newton), topDown(true),
+  persistentActive(false), persistentPost(false), recordingLabels(false)
 {
 }
 
@@ -199,6 +207,7 @@ void FWPDS::prestar( wfa::WFA const & input, wfa::WFA& output )
   // (it only saves on debugging effort)
   interGr = new graph::InterGraph(theZero, true, true);
   interGr->dag->topDownEval(topDown);
+  interGr->setWorkerThreads(getWorkerThreads());
   interGrs.push_back(interGr);
 
   // Input transitions become source nodes in FWPDS
@@ -250,15 +259,17 @@ void FWPDS::prestar_handle_call(wfa::ITrans *t1,
 
   if(et1 != 0) {
     ERule *er = (ERule *)(r.get_ptr());
-    interGr->addEdge(Transition(*t2),
+    int e = interGr->addEdge(Transition(*t2),
                      Transition(*t1),
                      Transition(r->from()->state(), r->from()->stack(),t2->to()),
                      er->merge_fn().get_ptr() );
+    labelEdge(r.get_ptr(), EdgeLabel::HYPER_MERGE_FN, e);
   } else {
-    interGr->addEdge(Transition(*t2),
+    int e = interGr->addEdge(Transition(*t2),
                      Transition(*t1),
                      Transition(r->from()->state(), r->from()->stack(),t2->to()),
                      r->weight() );    
+    labelEdge(r.get_ptr(), EdgeLabel::HYPER, e);
   }
 
   // update
@@ -312,9 +323,10 @@ void FWPDS::prestar_handle_trans(
     LazyTrans *lt = static_cast<LazyTrans *> (t);
     ETrans *et = lt->getETrans();
 
-    interGr->addEdge(Transition(*t),
+    int e = interGr->addEdge(Transition(*t),
         Transition(fstate,fstack,t->to()),
         r->weight());
+    labelEdge(r.get_ptr(), EdgeLabel::INTRA, e);
     if(et != 0) {
       update_etrans( fstate, fstack, t->to(), wghtOne, r->from() );
     } else {
@@ -395,6 +407,7 @@ void FWPDS::poststarIGR( wfa::WFA const & input, wfa::WFA& output )
   // However, there is no cost benefit in using WPDS
   interGr = new graph::InterGraph(theZero, true, false);
   interGr->dag->topDownEval(topDown);
+  interGr->setWorkerThreads(getWorkerThreads());
   interGrs.push_back(interGr);
 
   // Input transitions become source nodes in FWPDS
@@ -455,10 +468,11 @@ void FWPDS::poststar_handle_eps_trans(wfa::ITrans* teps, wfa::ITrans* tprime, se
   ewpds::ETrans* etrans = lt->getETrans();
   if (0 != etrans) {
     erule_t r = etrans->getERule();
-    interGr->addEdge(Transition(*tprime),
+    int e = interGr->addEdge(Transition(*tprime),
         Transition(*teps),
         Transition(teps->from(),tprime->stack(),tprime->to()),
         etrans->getMergeFn());
+    labelEdge(r.get_ptr(), EdgeLabel::HYPER_MERGE_FN, e);
   } else {
     interGr->addEdge(Transition(*tprime),
         Transition(*teps),
@@ -489,9 +503,10 @@ void FWPDS::poststar_handle_trans(
 
   if( r->to_stack2() == WALI_EPSILON ) {
     update( rtstate, rtstack, t->to(), wghtOne, r->to() );
-    interGr->addEdge(Transition(*t),
+    int e = interGr->addEdge(Transition(*t),
         Transition(rtstate,rtstack,t->to()),
         r->weight());
+    labelEdge(r.get_ptr(), EdgeLabel::INTRA, e);
   }
   else {  // Push rule (p,g) -> (p,g',g2)
 
@@ -508,9 +523,10 @@ void FWPDS::poststar_handle_trans(
     // add edge (p,g,q) -> (p,g',(p,g'))
     interGr->addCallEdge(Transition(*t),Transition(rtstate,rtstack, gstate));
     // add call-ret edge (p,g,q) -> ((p,g'),rstk2,q)
-    interGr->addCallRetEdge(Transition(*t),
+    int ret = interGr->addCallRetEdge(Transition(*t),
         Transition(gstate, r->to_stack2(),t->to()),
         r->weight());
+    labelEdge(r.get_ptr(), EdgeLabel::CALL_RET, ret);
 
     if( tprime->modified() )
     {
@@ -533,6 +549,177 @@ void FWPDS::poststar_handle_trans(
   }
 }
 
+///////////////////////////////////////////////////////////////////
+// Persistent queries
+///////////////////////////////////////////////////////////////////
+
+namespace
+{
+  struct RuleCollector : public wali::wpds::RuleFunctor
+  {
+    std::vector<rule_t> rules;
+    virtual void operator()( rule_t & r ) {
+      rules.push_back(r);
+    }
+  };
+
+  merge_fn_t mergeFnOf( rule_t const & r )
+  {
+    ERule const * er = dynamic_cast<ERule const *>(r.get_ptr());
+    return (er != 0) ? er->merge_fn() : merge_fn_t(0);
+  }
+}
+
+void FWPDS::persistentPoststar( wfa::WFA const & input, wfa::WFA & output )
+{
+  persistentQuery(input, output, true);
+}
+
+void FWPDS::persistentPrestar( wfa::WFA const & input, wfa::WFA & output )
+{
+  persistentQuery(input, output, false);
+}
+
+void FWPDS::persistentQuery( wfa::WFA const & input, wfa::WFA & output, bool post )
+{
+  // input may be persistentInput itself (see resolve)
+  wfa::WFA query(input);
+  clearPersistentQuery();
+  persistentActive = true;
+  persistentPost = post;
+  persistentInput = query;
+
+  size_t before = interGrs.size();
+  recordingLabels = true;
+  if(post)
+    poststar(persistentInput, output);
+  else
+    prestar(persistentInput, output);
+  if(interGrs.size() > before)
+    persistentGr = interGrs.back();
+
+  // Remember every rule, including those that label no edge, so that
+  // resolve can tell which were added or erased since
+  RuleCollector collect;
+  for_each(collect);
+  for(size_t i = 0; i < collect.rules.size(); i++) {
+    rule_t & r = collect.rules[i];
+    RuleLabels & rl = ruleLabels[r.get_ptr()];
+    rl.rule = r;
+    rl.weight = r->weight();
+    rl.mf = mergeFnOf(r);
+
+    // prestar puts the weight of a pop rule on the output transition it
+    // adds (see WPDS::prestarSetupFixpoint), which is a source node
+    if(!post && persistentGr.is_valid() && r->to_stack1() == WALI_EPSILON) {
+      int n = persistentGr->sourceNode(
+          Transition(r->from_state(), r->from_stack(), r->to_state()));
+      if(n >= 0)
+        labelEdge(r.get_ptr(), EdgeLabel::SOURCE, n);
+    }
+  }
+  recordingLabels = false;
+}
+
+void FWPDS::labelEdge( Rule const * r, EdgeLabel::Kind kind, int index )
+{
+  if(!recordingLabels)
+    return;
+  EdgeLabel label(kind, index);
+  std::vector< Rule const * > & rules = edgeRules[label];
+  if(std::find(rules.begin(), rules.end(), r) == rules.end()) {
+    rules.push_back(r);
+    ruleLabels[r].labels.push_back(label);
+  }
+}
+
+bool FWPDS::resolve( wfa::WFA & output )
+{
+  assert(persistentActive);
+
+  RuleCollector collect;
+  for_each(collect);
+
+  bool incremental = persistentGr.is_valid() && !newton
+    && (collect.rules.size() == ruleLabels.size());
+  std::set<EdgeLabel> changed;
+  for(size_t i = 0; incremental && i < collect.rules.size(); i++) {
+    rule_t & r = collect.rules[i];
+    rule_labels_t::iterator it = ruleLabels.find(r.get_ptr());
+    if(it == ruleLabels.end()) {
+      incremental = false;
+      break;
+    }
+    RuleLabels & rl = it->second;
+    merge_fn_t mf = mergeFnOf(r);
+    if(!rl.weight->equal(r->weight()) || rl.mf != mf) {
+      rl.weight = r->weight();
+      rl.mf = mf;
+      changed.insert(rl.labels.begin(), rl.labels.end());
+    }
+  }
+
+  if(!incremental) {
+    persistentQuery(persistentInput, output, persistentPost);
+    return false;
+  }
+
+  std::set<EdgeLabel>::iterator lit;
+  for(lit = changed.begin(); lit != changed.end(); lit++) {
+    std::vector< Rule const * > & rules = edgeRules[*lit];
+    if(lit->kind == EdgeLabel::HYPER_MERGE_FN) {
+      persistentGr->setHyperEdgeMergeFn(lit->index, ruleLabels[rules.front()].mf);
+      continue;
+    }
+    // The edge weight is the combine of the weights of its rules
+    sem_elem_t w = ruleLabels[rules.front()].weight;
+    for(size_t i = 1; i < rules.size(); i++)
+      w = w->combine(ruleLabels[rules[i]].weight);
+    switch(lit->kind) {
+      case EdgeLabel::INTRA:
+        persistentGr->setEdgeWeight(lit->index, w);
+        break;
+      case EdgeLabel::HYPER:
+        persistentGr->setHyperEdgeWeight(lit->index, w);
+        break;
+      case EdgeLabel::CALL_RET:
+        persistentGr->setCallRetWeight(lit->index, w);
+        break;
+      case EdgeLabel::SOURCE:
+        {
+          // Combined with the query's own transition, if it has one
+          Rule const * r = rules.front();
+          wfa::Trans t;
+          if(persistentInput.find(r->from_state(), r->from_stack(), r->to_state(), t))
+            w = t.weight()->combine(w);
+          persistentGr->setSourceWeight(lit->index, w);
+        }
+        break;
+      default:
+        assert(0);
+    }
+  }
+  persistentGr->updateInterSolution();
+
+  FWPDSCopyBackFunctor copier( persistentGr );
+  output.for_each(copier);
+
+  interGr = persistentGr;
+  checkResults(persistentInput, persistentPost);
+  if(!persistentPost)
+    interGr = NULL;
+  return true;
+}
+
+void FWPDS::clearPersistentQuery()
+{
+  persistentActive = false;
+  persistentGr = NULL;
+  persistentInput = wfa::WFA();
+  ruleLabels.clear();
+  edgeRules.clear();
+}
+
 bool FWPDS::isOutputTensored()
 {
   if(interGr != NULL)
@@ -555,6 +742,8 @@ void FWPDS::update(
     return EWPDS::update(from, stack, to, se, cfg);
   }
 
+  // The LazyTrans deletes its delegate, so only the LazyTrans itself
+  // may come from the output WFA's arena
   wfa::ITrans *t;
   if(addEtrans) {
     t = new ETrans(from, stack, to, 0, se, 0);
@@ -563,7 +752,8 @@ void FWPDS::update(
   }
   t->setConfig(cfg);
 
-  LazyTrans * lt = new LazyTrans(t);
+  util::Arena * arena = currentOutputWFA->arena();
+  LazyTrans * lt = arena ? new (*arena) LazyTrans(t) : new LazyTrans(t);
   t = currentOutputWFA->insert(lt);
 
   if( t->modified() ) {
@@ -594,7 +784,8 @@ wfa::ITrans* FWPDS::update_prime(
     new ETrans(
         from, r->to_stack2(), call->to(),
         delta, wWithRule, er);
-  LazyTrans* lt = new LazyTrans(et);
+  util::Arena * arena = currentOutputWFA->arena();
+  LazyTrans* lt = arena ? new (*arena) LazyTrans(et) : new LazyTrans(et);
   wfa::ITrans* t = currentOutputWFA->insert(lt);
   return t;
 }
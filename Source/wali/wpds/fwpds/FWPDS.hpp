@@ -10,12 +10,18 @@
 #include "wali/Common.hpp"
 #include "wali/wpds/WPDS.hpp"
 #include "wali/wpds/Wrapper.hpp"
+#include "wali/wpds/Rule.hpp"
 
 #include "wali/wpds/ewpds/EWPDS.hpp"
 
 #include "wali/graph/GraphCommon.hpp"
 #include "wali/graph/InterGraph.hpp"
 
+#include "wali/wfa/WFA.hpp"
+
+#include <map>
+#include <vector>
+
 namespace wali {
 
   namespace wfa {
@@ -89,6 +95,40 @@ namespace wali {
 
           void poststarIGR( wfa::WFA const & input, wfa::WFA & output );
 
+          ///////////
+          // Persistent queries
+          ///////////
+
+          /**
+           * Like poststar (prestar), but the InterGraph and its regular
+           * expressions are kept so that, after rules are added with
+           * add_rule, re-weighted with replace_rule, or removed with
+           * erase_rule, resolve() can bring 'output' up to date. Starts a
+           * new persistent query, replacing any earlier one.
+           */
+          void persistentPoststar( wfa::WFA const & input, wfa::WFA & output );
+          void persistentPrestar( wfa::WFA const & input, wfa::WFA & output );
+
+          /**
+           * Updates 'output', the output WFA of the persistent query, for
+           * the rules as they are now.
+           *
+           * If only the weights (or merge functions) of rules have changed,
+           * the output has the same transitions, so only the edges those
+           * rules label are changed and graph::InterGraph::updateInterSolution
+           * re-solves the IntraGraphs that depend on them. Adding or
+           * erasing a rule can change the transitions of the output, and
+           * then the query is run again from scratch, as it is with Newton.
+           *
+           * @return true if the query was updated incrementally
+           */
+          bool resolve( wfa::WFA & output );
+
+          /// Forgets the persistent query. Its output stays valid.
+          void clearPersistentQuery();
+
+          bool hasPersistentQuery() const { return persistentActive; }
+
           ///////////////////////
           // FWPDS Settings
           //////////////////////
@@ -150,6 +190,34 @@ namespace wali {
           ///////////
           bool checkResults( wfa::WFA const & input, bool poststar );
 
+          /// An edge of the InterGraph whose weight comes from rules
+          struct EdgeLabel
+          {
+            enum Kind { INTRA, HYPER, HYPER_MERGE_FN, CALL_RET, SOURCE };
+            Kind kind;
+            int index; //!< Edge number, or node number for CALL_RET and SOURCE
+
+            EdgeLabel( Kind k, int i ) : kind(k), index(i) {}
+            bool operator<( EdgeLabel const & that ) const {
+              return (kind < that.kind) || (kind == that.kind && index < that.index);
+            }
+          };
+
+          /// A rule as it was when the persistent query was last solved
+          struct RuleLabels
+          {
+            rule_t rule; //!< Keeps an erased rule (and so its address) alive
+            sem_elem_t weight;
+            merge_fn_t mf;
+            std::vector<EdgeLabel> labels;
+          };
+
+          typedef std::map< Rule const *, RuleLabels > rule_labels_t;
+          typedef std::map< EdgeLabel, std::vector< Rule const * > > edge_rules_t;
+
+          void labelEdge( Rule const * r, EdgeLabel::Kind kind, int index );
+          void persistentQuery( wfa::WFA const & input, wfa::WFA & output, bool post );
+
 
         protected:
           sem_elem_t wghtOne;
@@ -159,6 +227,15 @@ namespace wali {
           bool newton;
           bool topDown;
 
+          // Persistent query. See persistentPoststar.
+          bool persistentActive;
+          bool persistentPost;
+          bool recordingLabels;
+          wfa::WFA persistentInput;
+          graph::InterGraphPtr persistentGr;
+          rule_labels_t ruleLabels;
+          edge_rules_t edgeRules;
+
       }; // class FWPDS
 
     } // namespace fwpds
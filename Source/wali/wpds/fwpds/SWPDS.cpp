@@ -116,8 +116,13 @@ namespace wali
         cout << "Entry points found: " << syms.entryPoints.size() << "\n";
         
         // Then run FWPDS post* on Agrow and get the InterGraph that it creates
+        // The SummaryGraph builds its regular expressions in the InterGraph's
+        // dag, so the IntraGraphs must not get dags of their own
+        unsigned threads = getWorkerThreads();
+        setWorkerThreads(1);
         wfa::WFA postAgrow;
         poststarIGR(Agrow, postAgrow);
+        setWorkerThreads(threads);
         interGr->update_all_weights();
         
         // Create SummaryGraph from the InterGraph
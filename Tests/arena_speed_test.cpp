@@ -0,0 +1,121 @@
+/*
+ * Times filling a WFA, emptying it with clear(), and destroying it, with
+ * its transitions and States on the heap and in the WFA's arena.
+ *
+ * Usage: arena_speed_test [states [out-degree [rounds]]]
+ */
+
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wfa/WFA.hpp"
+
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace wali;
+using namespace wali::wfa;
+
+namespace {
+
+  double seconds( clock_t start )
+  {
+    return static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+  }
+
+  void build( WFA & fa, std::vector<Key> const & states,
+              std::vector<Key> const & letters,
+              std::vector<sem_elem_t> const & weights, int degree )
+  {
+    int n = static_cast<int>(states.size());
+    sem_elem_t zero = weights[0]->zero();
+    for( int i = 0 ; i < n ; i++ ) {
+      fa.addState( states[i], zero );
+    }
+    for( int i = 0 ; i < n ; i++ ) {
+      for( int j = 0 ; j < degree ; j++ ) {
+        fa.addTrans( states[i], letters[j % letters.size()],
+                     states[(i + 1 + j * 7919) % n],
+                     weights[(i + j) % weights.size()] );
+      }
+    }
+  }
+
+  /// Builds and clears the same WFA 'rounds' times, then builds it once
+  /// more and times its destructor
+  void run( char const * name, bool arena,
+            std::vector<Key> const & states, std::vector<Key> const & letters,
+            int degree, int rounds )
+  {
+    std::vector<sem_elem_t> weights;
+    for( unsigned d = 1 ; d <= 5 ; d++ ) {
+      weights.push_back(new ShortestPathSemiring(d));
+    }
+
+    double filling = 0, clearing = 0, destroying = 0;
+    WFA * fa = new WFA();
+    fa->useArena( arena );
+    for( int r = 0 ; r < rounds ; r++ ) {
+      clock_t start = clock();
+      build( *fa, states, letters, weights, degree );
+      filling += seconds(start);
+
+      start = clock();
+      fa->clear();
+      clearing += seconds(start);
+    }
+    build( *fa, states, letters, weights, degree );
+    clock_t start = clock();
+    delete fa;
+    destroying += seconds(start);
+
+    std::cout << std::setw(6) << name << std::fixed << std::setprecision(3)
+              << std::setw(10) << filling
+              << std::setw(10) << clearing
+              << std::setw(10) << destroying
+              << "\n";
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  int states = 20000;
+  int degree = 15;
+  int rounds = 3;
+  if( argc > 1 )
+    std::istringstream(argv[1]) >> states;
+  if( argc > 2 )
+    std::istringstream(argv[2]) >> degree;
+  if( argc > 3 )
+    std::istringstream(argv[3]) >> rounds;
+
+  // Make the keys up front so that only the WFA is timed
+  std::vector<Key> state_keys, letters;
+  for( int i = 0 ; i < states ; i++ ) {
+    std::stringstream ss;
+    ss << "q" << i;
+    state_keys.push_back(getKey(ss.str()));
+  }
+  for( int j = 0 ; j < 8 ; j++ ) {
+    std::stringstream ss;
+    ss << "a" << j;
+    letters.push_back(getKey(ss.str()));
+  }
+
+  std::cout << states << " states x " << degree << " transitions, "
+            << rounds << " rounds (seconds)\n";
+  std::cout << std::setw(6) << "" << std::setw(10) << "build"
+            << std::setw(10) << "clear" << std::setw(10) << "destroy" << "\n";
+
+  run( "heap", false, state_keys, letters, degree, rounds );
+  run( "arena", true, state_keys, letters, degree, rounds );
+
+  return 0;
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
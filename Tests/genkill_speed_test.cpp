@@ -0,0 +1,206 @@
+/*
+ * Times FWPDS::poststar on a random liveness-style analysis, once with
+ * gen/kill sets kept in sorted std::sets (SortedContainerSetAdapter) and
+ * once with BitVectorSet, and checks that both give the same weights at
+ * the nodes of the main procedure.
+ *
+ * The program has a number of procedures, each a chain of nodes with a
+ * few branches that skip ahead. Each statement kills one variable and
+ * uses (gens) two; some nodes call a random later procedure (so that
+ * every procedure returns). As for liveness, the PDS follows the edges
+ * backwards, from the exit of main.
+ *
+ * Usage: genkill_speed_test [variables [procedures [nodes-per-procedure]]]
+ */
+
+#include "wali/wpds/fwpds/FWPDS.hpp"
+#include "wali/wfa/WFA.hpp"
+#include "wali/wfa/Trans.hpp"
+#include "wali/util/Timer.hpp"
+
+#include "wali/domains/genkill/GenKillXformerTemplate.hpp"
+#include "wali/domains/genkill/SortedContainerSetAdapter.hpp"
+#include "wali/domains/genkill/BitVectorSet.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <vector>
+
+using namespace wali;
+using namespace wali::domains::genkill;
+
+namespace {
+
+  typedef SortedContainerSetAdapter<std::set<int> > SortedSet;
+  typedef BitVectorSet<> Bits;
+
+  size_t pick( size_t n )
+  {
+    return static_cast<size_t>(rand()) % n;
+  }
+
+  /// One edge of the (backwards) control-flow graph: from node 'from'
+  /// to node 'to' of the same procedure, either a statement or a call
+  /// to 'callee' that returns to 'from'.
+  struct Edge
+  {
+    size_t proc, from, to;
+    bool is_call;
+    size_t callee;
+    std::vector<int> kill, gen;
+  };
+
+  struct Program
+  {
+    size_t num_procs, num_nodes;
+    std::vector<Edge> edges;
+  };
+
+  Program random_program( size_t num_vars, size_t num_procs, size_t num_nodes )
+  {
+    Program prog;
+    prog.num_procs = num_procs;
+    prog.num_nodes = num_nodes;
+    for( size_t p = 0 ; p < num_procs ; p++ ) {
+      for( size_t i = 0 ; i + 1 < num_nodes ; i++ ) {
+        // The chain, and every so often a branch that skips ahead
+        size_t targets[] = { i + 1, i + 2 + pick(8) };
+        size_t num_targets = (pick(5) == 0 && targets[1] < num_nodes) ? 2 : 1;
+        for( size_t t = 0 ; t < num_targets ; t++ ) {
+          Edge e;
+          e.proc = p;
+          e.from = targets[t];
+          e.to = i;
+          e.is_call = (t == 0 && p + 1 < num_procs && pick(10) == 0);
+          e.callee = e.is_call ? p + 1 + pick(num_procs - p - 1) : 0;
+          if( !e.is_call ) {
+            e.kill.push_back(static_cast<int>(pick(num_vars)));
+            e.gen.push_back(static_cast<int>(pick(num_vars)));
+            e.gen.push_back(static_cast<int>(pick(num_vars)));
+          }
+          prog.edges.push_back(e);
+        }
+      }
+    }
+    return prog;
+  }
+
+  Key node( size_t proc, size_t i )
+  {
+    std::stringstream ss;
+    ss << "p" << proc << "_n" << i;
+    return getKey(ss.str());
+  }
+
+  template<typename Set>
+  Set make_set( std::vector<int> const & elements )
+  {
+    Set s;
+    for( size_t i = 0 ; i < elements.size() ; i++ ) {
+      s.insert(elements[i]);
+    }
+    return s;
+  }
+
+  /// Runs the analysis with Set, and returns the weights at the nodes
+  /// of main, printed
+  template<typename Set>
+  std::vector<std::string>
+  run( char const * name, Program const & prog )
+  {
+    typedef GenKillTransformer_T<Set> Weight;
+    Key q = getKey("q");
+    Key acc = getKey("accept");
+
+    wpds::fwpds::FWPDS pds;
+    sem_elem_t one = Weight::MkOne();
+    for( size_t i = 0 ; i < prog.edges.size() ; i++ ) {
+      Edge const & e = prog.edges[i];
+      if( e.is_call ) {
+        pds.add_rule(q, node(e.proc, e.from),
+                     q, node(e.callee, prog.num_nodes - 1), node(e.proc, e.to),
+                     one);
+      }
+      else {
+        pds.add_rule(q, node(e.proc, e.from),
+                     q, node(e.proc, e.to),
+                     Weight::makeGenKillTransformer_T(make_set<Set>(e.kill),
+                                                      make_set<Set>(e.gen)));
+      }
+    }
+    for( size_t p = 0 ; p < prog.num_procs ; p++ ) {
+      pds.add_rule(q, node(p, 0), q, one);
+    }
+
+    wfa::WFA query;
+    query.addTrans(q, node(0, prog.num_nodes - 1), acc, one);
+    query.setInitialState(q);
+    query.addFinalState(acc);
+
+    long long start = util::details::now();
+    wfa::WFA answer = pds.poststar(query);
+    double secs = util::details::to_sec(util::details::now() - start);
+    std::cout << std::setw(14) << name
+              << std::setw(10) << std::fixed << std::setprecision(3) << secs << "\n";
+
+    std::vector<std::string> weights;
+    for( size_t i = 0 ; i < prog.num_nodes ; i++ ) {
+      wfa::Trans t;
+      if( answer.find(q, node(0, i), acc, t) ) {
+        weights.push_back(t.weight()->toString());
+      }
+      else {
+        weights.push_back("");
+      }
+    }
+    return weights;
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  size_t num_vars = 256;
+  size_t num_procs = 200;
+  size_t num_nodes = 100;
+  if( argc > 1 )
+    std::istringstream(argv[1]) >> num_vars;
+  if( argc > 2 )
+    std::istringstream(argv[2]) >> num_procs;
+  if( argc > 3 )
+    std::istringstream(argv[3]) >> num_nodes;
+  if( num_vars == 0 || num_procs == 0 || num_nodes < 2 ) {
+    std::cerr << "Need at least one variable, one procedure, and two nodes\n";
+    return 1;
+  }
+
+  // Both sets need the universe before any weight is made
+  Bits::setUniverseSize(num_vars);
+  for( size_t v = 0 ; v < num_vars ; v++ ) {
+    SortedSet::UniverseSet().insert(static_cast<int>(v));
+  }
+
+  srand(0);
+  Program prog = random_program(num_vars, num_procs, num_nodes);
+  std::cout << num_vars << " variables, " << num_procs << " procedures of "
+            << num_nodes << " nodes, " << prog.edges.size() << " edges\n";
+  std::cout << std::setw(14) << "sets" << std::setw(10) << "time(s)" << "\n";
+
+  std::vector<std::string> sorted = run<SortedSet>("std::set", prog);
+  std::vector<std::string> bits = run<Bits>("BitVectorSet", prog);
+
+  if( sorted != bits ) {
+    std::cerr << "The two analyses disagree\n";
+    return 1;
+  }
+  return 0;
+}
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
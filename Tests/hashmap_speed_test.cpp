@@ -0,0 +1,119 @@
+/*
+ * Compares wali::HashMap against wali::OpenHashMap on KeyPair-keyed
+ * workloads shaped like the ones in WPDS saturation: keys are pairs of
+ * small, densely allocated Keys (a state and a stack symbol), most
+ * lookups hit, and the tables grow without being rebuilt.
+ *
+ * Usage: hashmap_speed_test [pairs [rounds]]
+ */
+
+#include "wali/HashMap.hpp"
+#include "wali/OpenHashMap.hpp"
+#include "wali/KeyContainer.hpp"
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace wali;
+
+namespace {
+
+  /// Keys look like (state, stack): few states, many stack symbols
+  std::vector<KeyPair> makeKeys( size_t n )
+  {
+    std::vector<KeyPair> keys;
+    keys.reserve(n);
+    for( size_t i = 0 ; i < n ; i++ ) {
+      keys.push_back( KeyPair( static_cast<Key>(i % 61), static_cast<Key>(i) ) );
+    }
+    for( size_t i = n ; i > 1 ; i-- ) {
+      std::swap( keys[i-1], keys[static_cast<size_t>(rand()) % i] );
+    }
+    return keys;
+  }
+
+  double seconds( clock_t start )
+  {
+    return static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+  }
+
+  template< typename Map >
+  void run( char const * name, std::vector<KeyPair> const & keys, int rounds )
+  {
+    double insert = 0, hit = 0, miss = 0, erase = 0;
+    size_t checksum = 0;
+
+    for( int r = 0 ; r < rounds ; r++ ) {
+      Map map;
+      clock_t start = clock();
+      for( size_t i = 0 ; i < keys.size() ; i++ ) {
+        map.insert( keys[i], static_cast<int>(i) );
+      }
+      insert += seconds(start);
+
+      start = clock();
+      for( int pass = 0 ; pass < 4 ; pass++ ) {
+        for( size_t i = 0 ; i < keys.size() ; i++ ) {
+          checksum += static_cast<size_t>(map.find( keys[i] )->second);
+        }
+      }
+      hit += seconds(start);
+
+      start = clock();
+      for( size_t i = 0 ; i < keys.size() ; i++ ) {
+        KeyPair absent( keys[i].first + 1000, keys[i].second );
+        if( map.find( absent ) != map.end() )
+          checksum++;
+      }
+      miss += seconds(start);
+
+      start = clock();
+      for( size_t i = 0 ; i < keys.size() ; i++ ) {
+        map.erase( keys[i] );
+      }
+      erase += seconds(start);
+    }
+
+    std::cout << std::setw(12) << name
+              << std::setw(10) << std::fixed << std::setprecision(3) << insert
+              << std::setw(10) << hit
+              << std::setw(10) << miss
+              << std::setw(10) << erase
+              << "   (checksum " << checksum << ")\n";
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  size_t pairs = 200000;
+  int rounds = 5;
+  if( argc > 1 )
+    std::istringstream(argv[1]) >> pairs;
+  if( argc > 2 )
+    std::istringstream(argv[2]) >> rounds;
+
+  srand(0);
+  std::vector<KeyPair> keys = makeKeys(pairs);
+
+  std::cout << pairs << " KeyPairs, " << rounds << " rounds (seconds)\n";
+  std::cout << std::setw(12) << "map"
+            << std::setw(10) << "insert"
+            << std::setw(10) << "find-hit"
+            << std::setw(10) << "find-miss"
+            << std::setw(10) << "erase" << "\n";
+
+  run< HashMap<KeyPair,int> >( "chained", keys, rounds );
+  run< OpenHashMap<KeyPair,int> >( "open", keys, rounds );
+
+  return 0;
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
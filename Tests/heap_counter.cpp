@@ -0,0 +1,58 @@
+#include "heap_counter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+  size_t live_bytes = 0;
+  size_t peak_bytes = 0;
+}
+
+namespace heap_counter
+{
+  size_t liveBytes()
+  {
+    return live_bytes;
+  }
+
+  size_t peakBytes()
+  {
+    return peak_bytes;
+  }
+
+  void resetPeak()
+  {
+    peak_bytes = live_bytes;
+  }
+}
+
+// Each block is prefixed with its size (padded to keep the alignment
+// malloc gives), so operator delete knows how much to subtract.
+
+void * operator new( size_t bytes )
+{
+  size_t * p = static_cast<size_t*>(std::malloc(bytes + 16));
+  if( p == 0 )
+    throw std::bad_alloc();
+  *p = bytes;
+  live_bytes += bytes;
+  if( live_bytes > peak_bytes )
+    peak_bytes = live_bytes;
+  return reinterpret_cast<char*>(p) + 16;
+}
+
+void operator delete( void * ptr ) throw()
+{
+  if( ptr == 0 )
+    return;
+  size_t * p = reinterpret_cast<size_t*>(static_cast<char*>(ptr) - 16);
+  live_bytes -= *p;
+  std::free(p);
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,32 @@
+#ifndef wali_TESTS_HEAP_COUNTER_GUARD
+#define wali_TESTS_HEAP_COUNTER_GUARD 1
+
+/*
+ * For the speed tests: heap_counter.cpp replaces the global operator new
+ * and operator delete with ones that count the bytes live on the heap, so
+ * a test can measure the memory a data structure or a query takes without
+ * knowing how the standard containers lay out their nodes. Link it into
+ * the test program (see Tests/SConscript).
+ */
+
+#include <cstddef>
+
+namespace heap_counter
+{
+  /// Bytes allocated with operator new and not yet deleted
+  size_t liveBytes();
+
+  /// The most bytes that were live at once since the last resetPeak()
+  size_t peakBytes();
+
+  /// Starts measuring a new peak from the bytes live now
+  void resetPeak();
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
+
+#endif // wali_TESTS_HEAP_COUNTER_GUARD
@@ -0,0 +1,187 @@
+/*
+ * Times BoolMatrix extend, combine, equal, and star on random relations
+ * of growing dimension, against the same operations done directly on the
+ * ublas BackingMatrix (prod, +, element-wise comparison, and star by
+ * squaring, as SemElem::star does), and checks that both agree.
+ *
+ * Each relation relates every element to about 'degree' random others.
+ * The ublas product is cubic in the dimension, so it is only run up to
+ * 'ublas-limit'; above that only the bit-packed times are reported.
+ *
+ * Usage: matrix_speed_test [max-dimension [ublas-limit [degree]]]
+ */
+
+#include "wali/domains/matrix/Matrix.hpp"
+#include "wali/util/Timer.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+using namespace wali;
+using namespace wali::domains;
+
+namespace {
+
+  typedef BoolMatrix::BackingMatrix BackingMatrix;
+
+  size_t pick( size_t n )
+  {
+    return static_cast<size_t>(rand()) % n;
+  }
+
+  BackingMatrix random_relation( size_t n, size_t degree )
+  {
+    BackingMatrix m(n, n);
+    for( size_t r = 0 ; r < n ; r++ ) {
+      for( size_t c = 0 ; c < n ; c++ ) {
+        m(r, c) = false;
+      }
+      for( size_t i = 0 ; i < degree ; i++ ) {
+        m(r, pick(n)) = true;
+      }
+    }
+    return m;
+  }
+
+  BackingMatrix ublas_extend( BackingMatrix const & a, BackingMatrix const & b )
+  {
+    return boost::numeric::ublas::prod(a, b);
+  }
+
+  BackingMatrix ublas_combine( BackingMatrix const & a, BackingMatrix const & b )
+  {
+    return a + b;
+  }
+
+  bool ublas_equal( BackingMatrix const & a, BackingMatrix const & b )
+  {
+    for( size_t r = 0 ; r < a.size1() ; r++ ) {
+      for( size_t c = 0 ; c < a.size2() ; c++ ) {
+        if( a(r, c) != b(r, c) ) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  BackingMatrix ublas_star( BackingMatrix const & a )
+  {
+    BackingMatrix w = a + boost::numeric::ublas::identity_matrix<bool>(a.size1());
+    BackingMatrix wn = ublas_extend(w, w);
+    while( !ublas_equal(w, wn) ) {
+      w = wn;
+      wn = ublas_extend(wn, wn);
+    }
+    return wn;
+  }
+
+  double since( long long start )
+  {
+    return util::details::to_sec(util::details::now() - start);
+  }
+
+  void report( size_t n, char const * op, double ublas, bool ran_ublas, double packed )
+  {
+    std::cout << std::setw(6) << n << std::setw(10) << op
+              << std::fixed << std::setprecision(4);
+    if( ran_ublas ) {
+      std::cout << std::setw(12) << ublas;
+    }
+    else {
+      std::cout << std::setw(12) << "-";
+    }
+    std::cout << std::setw(12) << packed << "\n";
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  size_t max_dim = 4096;
+  size_t ublas_limit = 512;
+  size_t degree = 2;
+  if( argc > 1 )
+    std::istringstream(argv[1]) >> max_dim;
+  if( argc > 2 )
+    std::istringstream(argv[2]) >> ublas_limit;
+  if( argc > 3 )
+    std::istringstream(argv[3]) >> degree;
+
+  srand(0);
+  std::cout << std::setw(6) << "dim" << std::setw(10) << "op"
+            << std::setw(12) << "ublas(s)" << std::setw(12) << "packed(s)" << "\n";
+
+  bool agree = true;
+  for( size_t n = 64 ; n <= max_dim ; n *= 2 ) {
+    BackingMatrix a = random_relation(n, degree);
+    BackingMatrix b = random_relation(n, degree);
+    bool run_ublas = n <= ublas_limit;
+
+    long long start = util::details::now();
+    sem_elem_t pa = new BoolMatrix(a);
+    sem_elem_t pb = new BoolMatrix(b);
+    double packing = since(start);
+    std::cout << std::setw(6) << n << std::setw(10) << "pack"
+              << std::setw(12) << "-" << std::setw(12)
+              << std::fixed << std::setprecision(4) << packing << "\n";
+
+    BackingMatrix ue, uc, us;
+    double ue_t = 0, uc_t = 0, uq_t = 0, us_t = 0;
+    bool ueq = false;
+    if( run_ublas ) {
+      start = util::details::now();
+      ue = ublas_extend(a, b);
+      ue_t = since(start);
+      start = util::details::now();
+      uc = ublas_combine(a, b);
+      uc_t = since(start);
+      start = util::details::now();
+      ueq = ublas_equal(a, a);
+      uq_t = since(start);
+      start = util::details::now();
+      us = ublas_star(a);
+      us_t = since(start);
+    }
+
+    start = util::details::now();
+    sem_elem_t pe = pa->extend(pb);
+    double pe_t = since(start);
+    start = util::details::now();
+    sem_elem_t pc = pa->combine(pb);
+    double pc_t = since(start);
+    start = util::details::now();
+    bool peq = pa->equal(pa);
+    double pq_t = since(start);
+    start = util::details::now();
+    sem_elem_t ps = pa->star();
+    double ps_t = since(start);
+
+    report(n, "extend", ue_t, run_ublas, pe_t);
+    report(n, "combine", uc_t, run_ublas, pc_t);
+    report(n, "equal", uq_t, run_ublas, pq_t);
+    report(n, "star", us_t, run_ublas, ps_t);
+
+    if( run_ublas ) {
+      agree = agree
+        && ueq == peq
+        && pe->equal(new BoolMatrix(ue))
+        && pc->equal(new BoolMatrix(uc))
+        && ps->equal(new BoolMatrix(us));
+    }
+  }
+
+  if( !agree ) {
+    std::cerr << "ublas and the bit-packed matrices disagree\n";
+    return 1;
+  }
+  return 0;
+}
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
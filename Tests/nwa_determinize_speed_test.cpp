@@ -0,0 +1,155 @@
+/*
+ * Compares the two representations construct::determinize can use for the
+ * relations on states that make up the deterministic NWA's states:
+ * std::sets of pairs (RelationsAsSets) and bit matrices
+ * (RelationsAsBitMatrices), the latter on one thread and on several.
+ * Reports the time and peak heap memory of each, and checks that they
+ * build the same NWA.
+ *
+ * The NWAs are random, as in AddOns/RandomNwa (uniformly chosen states and
+ * symbols on each transition), with a few epsilon transitions. To compare
+ * against the BuDDy relations instead of the std::set ones, build this and
+ * the library with USE_BUDDY defined (the NWAs will then differ in their
+ * state keys, so only the sizes are compared).
+ *
+ * The time is wall-clock time, so that the threads are not counted twice.
+ * Without 'scons threads=1', the multi-threaded run uses one thread.
+ *
+ * Usage: nwa_determinize_speed_test [states [symbols [transitions-per-state [threads]]]]
+ */
+
+#include "opennwa/Nwa.hpp"
+#include "opennwa/construct/determinize.hpp"
+#include "wali/util/Timer.hpp"
+#include "wali/util/Threads.hpp"
+
+#include "heap_counter.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace opennwa;
+using namespace opennwa::construct;
+
+namespace {
+
+  template<typename T>
+  T pick( std::vector<T> const & v )
+  {
+    return v[static_cast<size_t>(rand()) % v.size()];
+  }
+
+  NwaRefPtr run( Nwa const & nwa, DeterminizeRelations how, unsigned threads )
+  {
+    size_t before = heap_counter::liveBytes();
+    heap_counter::resetPeak();
+    long long start = wali::util::details::now();
+    NwaRefPtr det = determinize(nwa, how, threads);
+    double secs = wali::util::details::to_sec(wali::util::details::now() - start);
+
+    std::stringstream name;
+    if( how == RelationsAsSets ) {
+      name << "sets";
+    }
+    else {
+      name << "bit matrices/" << threads;
+    }
+    std::cout << std::setw(18) << name.str()
+              << std::setw(10) << std::fixed << std::setprecision(3) << secs
+              << std::setw(14) << heap_counter::peakBytes() - before
+              << std::setw(10) << det->sizeStates()
+              << std::setw(12) << det->sizeTrans() << "\n";
+    return det;
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  size_t num_states = 10;
+  size_t num_symbols = 2;
+  size_t per_state = 2;
+  unsigned threads = wali::util::hardware_threads();
+  if( argc > 1 )
+    std::istringstream(argv[1]) >> num_states;
+  if( argc > 2 )
+    std::istringstream(argv[2]) >> num_symbols;
+  if( argc > 3 )
+    std::istringstream(argv[3]) >> per_state;
+  if( argc > 4 )
+    std::istringstream(argv[4]) >> threads;
+
+  srand(0);
+  std::vector<State> states;
+  for( size_t i = 0 ; i < num_states ; i++ ) {
+    std::stringstream ss;
+    ss << "s" << i;
+    states.push_back(getKey(ss.str()));
+  }
+  std::vector<Symbol> symbols;
+  for( size_t i = 0 ; i < num_symbols ; i++ ) {
+    std::stringstream ss;
+    ss << "a" << i;
+    symbols.push_back(getKey(ss.str()));
+  }
+
+  // Internals make up about half of the transitions, calls and returns a
+  // quarter each; one in eight internals is an epsilon transition.
+  Nwa nwa;
+  for( size_t i = 0 ; i < num_states ; i++ ) {
+    nwa.addState(states[i]);
+  }
+  nwa.addInitialState(states.front());
+  nwa.addFinalState(states.back());
+  for( size_t i = 0 ; i < num_states * per_state ; i++ ) {
+    switch( i % 8 ) {
+      case 0:
+      case 4:
+        nwa.addCallTrans(pick(states), pick(symbols), pick(states));
+        break;
+      case 1:
+      case 5:
+        nwa.addReturnTrans(pick(states), pick(states), pick(symbols), pick(states));
+        break;
+      case 2:
+        nwa.addInternalTrans(pick(states), EPSILON, pick(states));
+        break;
+      default:
+        nwa.addInternalTrans(pick(states), pick(symbols), pick(states));
+        break;
+    }
+  }
+
+  std::cout << num_states << " states, " << num_symbols << " symbols, "
+            << nwa.sizeTrans() << " transitions\n";
+  std::cout << std::setw(18) << "relations/threads"
+            << std::setw(10) << "time(s)"
+            << std::setw(14) << "peak bytes"
+            << std::setw(10) << "states"
+            << std::setw(12) << "transitions" << "\n";
+
+  NwaRefPtr bits = run(nwa, RelationsAsBitMatrices, 1);
+  NwaRefPtr parallel = run(nwa, RelationsAsBitMatrices, threads);
+  NwaRefPtr sets = run(nwa, RelationsAsSets, 1);
+
+#ifdef USE_BUDDY
+  bool same = (bits->sizeStates() == sets->sizeStates()
+               && bits->sizeTrans() == sets->sizeTrans());
+#else
+  bool same = (*bits == *sets);
+#endif
+  same = same && (*bits == *parallel);
+  if( !same ) {
+    std::cout << "the two representations disagree\n";
+    return 1;
+  }
+  return 0;
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,162 @@
+/*
+ * Compares the two ways opennwa::query answers languageIsEmpty and
+ * getSomeShortestAcceptedWord: the summary search on the NWA's own
+ * transitions (ReachabilityBySummaries), and the conversion to a WPDS
+ * followed by poststar (ReachabilityByPoststar). The NWAs are random, as
+ * in AddOns/RandomNwa (uniformly chosen states and symbols on each
+ * transition), with one initial and one final state. Reports the time and
+ * the peak heap memory of each query.
+ *
+ * The emptiness check runs twice: once as generated, and once with the
+ * final state replaced by one that nothing reaches, so that both searches
+ * have to explore everything.
+ *
+ * Usage: nwa_reachability_speed_test [states [transitions-per-state]]
+ */
+
+#include "opennwa/Nwa.hpp"
+#include "opennwa/query/language.hpp"
+
+#include "heap_counter.hpp"
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace opennwa;
+using namespace opennwa::query;
+
+namespace {
+
+  double seconds( clock_t start )
+  {
+    return static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+  }
+
+  State pick( std::vector<State> const & v )
+  {
+    return v[static_cast<size_t>(rand()) % v.size()];
+  }
+
+  void report( char const * query, ReachabilityAlgorithm how, double secs,
+               size_t bytes, std::string const & answer )
+  {
+    std::cout << std::setw(16) << query
+              << std::setw(12) << (how == ReachabilityBySummaries ? "summaries" : "poststar")
+              << std::setw(10) << std::fixed << std::setprecision(3) << secs
+              << std::setw(14) << bytes
+              << "  " << answer << "\n";
+  }
+
+  bool isEmpty( char const * query, Nwa const & nwa, ReachabilityAlgorithm how )
+  {
+    size_t before = heap_counter::liveBytes();
+    heap_counter::resetPeak();
+    clock_t start = clock();
+    bool empty = languageIsEmpty(nwa, how);
+    report(query, how, seconds(start), heap_counter::peakBytes() - before,
+           empty ? "empty" : "not empty");
+    return empty;
+  }
+
+  size_t shortest( Nwa const & nwa, ReachabilityAlgorithm how )
+  {
+    size_t before = heap_counter::liveBytes();
+    heap_counter::resetPeak();
+    clock_t start = clock();
+    NestedWordRefPtr word = getSomeShortestAcceptedWord(nwa, how);
+    double secs = seconds(start);
+    size_t bytes = heap_counter::peakBytes() - before;
+
+    std::stringstream answer;
+    if( word == NULL ) {
+      answer << "none";
+    }
+    else {
+      answer << "length " << word->size()
+             << (languageContains(nwa, *word) ? "" : " (NOT ACCEPTED)");
+    }
+    report("shortest word", how, secs, bytes, answer.str());
+    return word == NULL ? 0 : word->size();
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  size_t num_states = 200;
+  size_t per_state = 4;
+  if( argc > 1 )
+    std::istringstream(argv[1]) >> num_states;
+  if( argc > 2 )
+    std::istringstream(argv[2]) >> per_state;
+
+  srand(0);
+  std::vector<State> states;
+  for( size_t i = 0 ; i < num_states ; i++ ) {
+    std::stringstream ss;
+    ss << "s" << i;
+    states.push_back(getKey(ss.str()));
+  }
+  std::vector<Symbol> symbols;
+  for( int i = 0 ; i < 8 ; i++ ) {
+    std::stringstream ss;
+    ss << "a" << i;
+    symbols.push_back(getKey(ss.str()));
+  }
+
+  // Internals make up about half of the transitions, calls and returns a
+  // quarter each.
+  Nwa nwa;
+  nwa.addInitialState(states.front());
+  nwa.addFinalState(states.back());
+  for( size_t i = 0 ; i < num_states * per_state ; i++ ) {
+    switch( i % 4 ) {
+      case 0:
+        nwa.addCallTrans(pick(states), pick(symbols), pick(states));
+        break;
+      case 1:
+        nwa.addReturnTrans(pick(states), pick(states), pick(symbols), pick(states));
+        break;
+      default:
+        nwa.addInternalTrans(pick(states), pick(symbols), pick(states));
+        break;
+    }
+  }
+
+  // A final state with only an outgoing transition
+  Nwa unreachable = nwa;
+  State source = getKey("unreachable");
+  unreachable.removeFinalState(states.back());
+  unreachable.addInternalTrans(source, symbols.front(), states.front());
+  unreachable.addFinalState(source);
+
+  std::cout << num_states << " states, " << nwa.sizeTrans() << " transitions\n";
+  std::cout << std::setw(16) << "query"
+            << std::setw(12) << "algorithm"
+            << std::setw(10) << "time(s)"
+            << std::setw(14) << "peak bytes" << "\n";
+
+  // The poststar runs leave the heap fragmented, so they go last
+  std::vector<size_t> answers[2];
+  ReachabilityAlgorithm const algorithms[2] = { ReachabilityBySummaries, ReachabilityByPoststar };
+  for( int i = 0 ; i < 2 ; i++ ) {
+    answers[i].push_back(isEmpty("isEmpty", nwa, algorithms[i]));
+    answers[i].push_back(isEmpty("isEmpty (none)", unreachable, algorithms[i]));
+    answers[i].push_back(shortest(nwa, algorithms[i]));
+  }
+
+  if( answers[0] != answers[1] ) {
+    std::cout << "the two algorithms disagree\n";
+    return 1;
+  }
+  return 0;
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,158 @@
+/*
+ * Times construct::reduce on a large NWA made of many copies of a small
+ * random one, whose transitions lead into randomly chosen copies. The
+ * returns of every copy name call predecessors among a few call sites
+ * outside the copies (bisimulation only merges exits that return to the
+ * same call predecessors), so copies of a state are bisimilar, and the
+ * reduction should leave about one copy and the call sites.
+ * Reports the time to find the classes (reductionPartition) and the time
+ * of the whole reduction (which also builds the quotient NWA), and the
+ * number of states left.
+ *
+ * Usage: nwa_reduce_speed_test [states [copies [transitions-per-state]]]
+ */
+
+#include "opennwa/Nwa.hpp"
+#include "opennwa/construct/reduce.hpp"
+#include "wali/util/Timer.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace opennwa;
+using namespace opennwa::construct;
+
+namespace {
+
+  size_t pick( size_t n )
+  {
+    return static_cast<size_t>(rand()) % n;
+  }
+
+  void report( char const * what, double secs, size_t states )
+  {
+    std::cout << std::setw(22) << what
+              << std::setw(10) << std::fixed << std::setprecision(3) << secs
+              << std::setw(12) << states << "\n";
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  size_t num_states = 100000;
+  size_t num_copies = 1000;
+  size_t per_state = 3;
+  if( argc > 1 )
+    std::istringstream(argv[1]) >> num_states;
+  if( argc > 2 )
+    std::istringstream(argv[2]) >> num_copies;
+  if( argc > 3 )
+    std::istringstream(argv[3]) >> per_state;
+
+  size_t copy_size = num_states / num_copies;
+  if( copy_size == 0 ) {
+    std::cerr << "Need at least as many states as copies\n";
+    return 1;
+  }
+
+  srand(0);
+  std::vector<State> states;
+  for( size_t i = 0 ; i < copy_size * num_copies ; i++ ) {
+    std::stringstream ss;
+    ss << "s" << i;
+    states.push_back(getKey(ss.str()));
+  }
+  std::vector<State> sites;
+  for( size_t i = 0 ; i < copy_size ; i++ ) {
+    std::stringstream ss;
+    ss << "site" << i;
+    sites.push_back(getKey(ss.str()));
+  }
+  Symbol symbols[] = { getKey("a"), getKey("b"), getKey("c") };
+
+  // The transitions of one copy: (kind, from, pred, symbol, to), with
+  // states numbered within the copy. Calls and returns are a quarter of
+  // them each.
+  std::vector<std::vector<size_t> > pattern;
+  for( size_t i = 0 ; i < copy_size * per_state ; i++ ) {
+    std::vector<size_t> t(5);
+    t[0] = (i % 4 == 1) ? 1 : (i % 4 == 3) ? 2 : 0;
+    t[1] = pick(copy_size);
+    t[2] = pick(copy_size);
+    t[3] = pick(3);
+    t[4] = pick(copy_size);
+    pattern.push_back(t);
+  }
+
+  // Each copy's transitions go to a random copy of their target. Each
+  // call site calls state i of a random copy.
+  Nwa nwa;
+  for( size_t i = 0 ; i < copy_size ; i++ ) {
+    nwa.addCallTrans(sites[i], symbols[0], states[pick(num_copies) * copy_size + i]);
+  }
+  for( size_t c = 0 ; c < num_copies ; c++ ) {
+    for( size_t q = 0 ; q < copy_size ; q++ ) {
+      State st = states[c * copy_size + q];
+      nwa.addState(st);
+      if( q == 0 ) {
+        nwa.addInitialState(st);
+      }
+      if( q == copy_size - 1 ) {
+        nwa.addFinalState(st);
+      }
+    }
+    for( size_t i = 0 ; i < pattern.size() ; i++ ) {
+      std::vector<size_t> const & t = pattern[i];
+      State from = states[c * copy_size + t[1]];
+      State pred = sites[t[2]];
+      State to = states[pick(num_copies) * copy_size + t[4]];
+      switch( t[0] ) {
+        case 0:
+          nwa.addInternalTrans(from, symbols[t[3]], to);
+          break;
+        case 1:
+          nwa.addCallTrans(from, symbols[t[3]], to);
+          break;
+        default:
+          nwa.addReturnTrans(from, pred, symbols[t[3]], to);
+          break;
+      }
+    }
+  }
+
+  std::cout << nwa.sizeStates() << " states (" << num_copies << " copies), "
+            << nwa.sizeTrans() << " transitions\n";
+  std::cout << std::setw(22) << "step"
+            << std::setw(10) << "time(s)"
+            << std::setw(12) << "states" << "\n";
+
+  // Build the compact transitions outside the timings
+  nwa.getCompactTransitions();
+
+  long long start = wali::util::details::now();
+  wali::util::DisjointSets<State> classes = reductionPartition(nwa);
+  report("reductionPartition", wali::util::details::to_sec(wali::util::details::now() - start),
+         static_cast<size_t>(std::distance(classes.begin(), classes.end())));
+
+  start = wali::util::details::now();
+  NwaRefPtr reduced = reduce(nwa);
+  report("reduce", wali::util::details::to_sec(wali::util::details::now() - start),
+         reduced->sizeStates());
+
+  start = wali::util::details::now();
+  NwaRefPtr simulated = reduce(nwa, ReduceBySimulation);
+  report("reduce (simulation)", wali::util::details::to_sec(wali::util::details::now() - start),
+         simulated->sizeStates());
+
+  return 0;
+}
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
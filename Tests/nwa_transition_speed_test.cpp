@@ -0,0 +1,186 @@
+/*
+ * Compares opennwa::details::TransitionStorage against the
+ * CompactTransitionStorage built from it, on random NWAs generated the way
+ * AddOns/RandomNwa does (uniformly chosen states and symbols on each
+ * transition). Reports the heap memory each one takes, and how fast a
+ * traversal that follows every transition out of every state runs.
+ *
+ * Usage: nwa_transition_speed_test [states [transitions-per-state [rounds]]]
+ */
+
+#include "opennwa/Nwa.hpp"
+#include "opennwa/details/CompactTransitionStorage.hpp"
+
+#include "heap_counter.hpp"
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace opennwa;
+using opennwa::details::TransitionStorage;
+using opennwa::details::CompactTransitionStorage;
+
+namespace {
+
+  double seconds( clock_t start )
+  {
+    return static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+  }
+
+  State pick( std::vector<State> const & v )
+  {
+    return v[static_cast<size_t>(rand()) % v.size()];
+  }
+
+  /// Walks the internal, call, and return (by call predecessor)
+  /// transitions leaving each state; returns a checksum
+  size_t walk( TransitionStorage const & trans, std::vector<State> const & states )
+  {
+    typedef TransitionStorage::Info Info;
+    size_t sum = 0;
+    for( size_t i = 0 ; i < states.size() ; i++ ) {
+      Info::Internals const & ints = trans.getTransFrom(states[i]);
+      for( Info::InternalIterator it = ints.begin() ; it != ints.end() ; ++it ) {
+        sum += TransitionStorage::getTarget(*it);
+      }
+      Info::Calls const & calls = trans.getTransCall(states[i]);
+      for( Info::CallIterator it = calls.begin() ; it != calls.end() ; ++it ) {
+        sum += TransitionStorage::getEntry(*it);
+      }
+      Info::Returns const & rets = trans.getTransPred(states[i]);
+      for( Info::ReturnIterator it = rets.begin() ; it != rets.end() ; ++it ) {
+        sum += TransitionStorage::getReturnSite(*it);
+      }
+    }
+    return sum;
+  }
+
+  size_t walk( CompactTransitionStorage const & ct )
+  {
+    typedef CompactTransitionStorage CT;
+    size_t sum = 0;
+    for( CT::Index s = 0 ; s < ct.numStates() ; s++ ) {
+      CT::Edges ints = ct.internalsFrom(s);
+      for( CT::Edges::const_iterator it = ints.begin() ; it != ints.end() ; ++it ) {
+        sum += ct.state(it->target);
+      }
+      CT::Edges calls = ct.callsFrom(s);
+      for( CT::Edges::const_iterator it = calls.begin() ; it != calls.end() ; ++it ) {
+        sum += ct.state(it->target);
+      }
+      CT::Positions rets = ct.returnsFromPred(s);
+      for( CT::Positions::const_iterator it = rets.begin() ; it != rets.end() ; ++it ) {
+        sum += ct.state(ct.returnAt(*it).returnSite);
+      }
+    }
+    return sum;
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  size_t num_states = 20000;
+  size_t per_state = 8;
+  int rounds = 20;
+  if( argc > 1 )
+    std::istringstream(argv[1]) >> num_states;
+  if( argc > 2 )
+    std::istringstream(argv[2]) >> per_state;
+  if( argc > 3 )
+    std::istringstream(argv[3]) >> rounds;
+
+  srand(0);
+  std::vector<State> states;
+  for( size_t i = 0 ; i < num_states ; i++ ) {
+    std::stringstream ss;
+    ss << "s" << i;
+    states.push_back(getKey(ss.str()));
+  }
+  std::vector<Symbol> symbols;
+  for( int i = 0 ; i < 16 ; i++ ) {
+    std::stringstream ss;
+    ss << "a" << i;
+    symbols.push_back(getKey(ss.str()));
+  }
+
+  // Internals make up about half of the transitions, calls and returns a
+  // quarter each.
+  size_t before = heap_counter::liveBytes();
+  clock_t start = clock();
+  TransitionStorage trans;
+  for( size_t i = 0 ; i < num_states * per_state ; i++ ) {
+    switch( i % 4 ) {
+      case 0:
+        trans.addCall(pick(states), pick(symbols), pick(states));
+        break;
+      case 1:
+        trans.addReturn(pick(states), pick(states), pick(symbols), pick(states));
+        break;
+      default:
+        trans.addInternal(pick(states), pick(symbols), pick(states));
+        break;
+    }
+  }
+  double set_build = seconds(start);
+  size_t set_bytes = heap_counter::liveBytes() - before;
+
+  before = heap_counter::liveBytes();
+  start = clock();
+  CompactTransitionStorage ct(trans);
+  double compact_build = seconds(start);
+  size_t compact_bytes = heap_counter::liveBytes() - before;
+
+  size_t n = trans.size();
+  std::cout << num_states << " states, " << n << " transitions ("
+            << trans.sizeInternal() << " internal, " << trans.sizeCall() << " call, "
+            << trans.sizeReturn() << " return), " << rounds << " walks\n";
+  std::cout << std::setw(10) << "storage"
+            << std::setw(12) << "bytes"
+            << std::setw(12) << "bytes/tr"
+            << std::setw(10) << "build(s)"
+            << std::setw(10) << "walk(s)"
+            << std::setw(14) << "Mtrans/s" << "\n";
+
+  size_t set_sum = 0;
+  start = clock();
+  for( int r = 0 ; r < rounds ; r++ )
+    set_sum += walk(trans, states);
+  double set_walk = seconds(start);
+
+  size_t compact_sum = 0;
+  start = clock();
+  for( int r = 0 ; r < rounds ; r++ )
+    compact_sum += walk(ct);
+  double compact_walk = seconds(start);
+
+  std::cout << std::fixed << std::setprecision(3)
+            << std::setw(10) << "sets"
+            << std::setw(12) << set_bytes
+            << std::setw(12) << std::setprecision(1) << double(set_bytes) / double(n)
+            << std::setw(10) << std::setprecision(3) << set_build
+            << std::setw(10) << set_walk
+            << std::setw(14) << std::setprecision(1) << double(n) * rounds / set_walk / 1e6 << "\n";
+  std::cout << std::setprecision(3)
+            << std::setw(10) << "compact"
+            << std::setw(12) << compact_bytes
+            << std::setw(12) << std::setprecision(1) << double(compact_bytes) / double(n)
+            << std::setw(10) << std::setprecision(3) << compact_build
+            << std::setw(10) << compact_walk
+            << std::setw(14) << std::setprecision(1) << double(n) * rounds / compact_walk / 1e6 << "\n";
+
+  if( set_sum != compact_sum ) {
+    std::cout << "checksums differ: " << set_sum << " " << compact_sum << "\n";
+    return 1;
+  }
+  return 0;
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,120 @@
+/*
+ * Times WPDS::poststar with the Reach and ShortestPath semirings. Each
+ * extend and combine creates and drops several sem_elem_t references,
+ * so this measures what the reference-count policy costs. Build WALi
+ * with 'scons refcount=plain' and 'scons refcount=atomic' and compare.
+ *
+ * Usage: refcount_speed_test [procedures [nodes-per-procedure [rounds]]]
+ */
+
+#include "wali/Reach.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wfa/WFA.hpp"
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wfa;
+
+namespace {
+
+  Key node( int proc, int n )
+  {
+    std::stringstream ss;
+    ss << "p" << proc << "_n" << n;
+    return getKey(ss.str());
+  }
+
+  sem_elem_t reachWeight( int )
+  {
+    return new Reach(true);
+  }
+
+  sem_elem_t distanceWeight( int i )
+  {
+    return new ShortestPathSemiring( static_cast<unsigned>(1 + i % 7) );
+  }
+
+  /// Each procedure is a chain of nodes with a back edge, a call to a
+  /// later procedure every few nodes, and a return at the end.
+  void build( WPDS & pds, Key p, int procs, int nodes, sem_elem_t (*weight)(int) )
+  {
+    int w = 0;
+    for( int proc = 0 ; proc < procs ; proc++ ) {
+      for( int n = 0 ; n < nodes ; n++ ) {
+        if( n % 5 == 2 && proc + 1 < procs ) {
+          int callee = proc + 1 + (n * 7919) % (procs - proc - 1);
+          pds.add_rule( p, node(proc, n), p, node(callee, 0), node(proc, n+1), weight(w++) );
+        }
+        else {
+          pds.add_rule( p, node(proc, n), p, node(proc, n+1), weight(w++) );
+        }
+        if( n % 11 == 10 )
+          pds.add_rule( p, node(proc, n), p, node(proc, n-9), weight(w++) );
+      }
+      pds.add_rule( p, node(proc, nodes), p, weight(w++) );
+    }
+  }
+
+  void run( char const * name, int procs, int nodes, int rounds, sem_elem_t (*weight)(int) )
+  {
+    Key p = getKey("p");
+    Key accept = getKey("accept");
+    WPDS pds;
+    build( pds, p, procs, nodes, weight );
+
+    WFA query;
+    query.addState( p, weight(0)->zero() );
+    query.addState( accept, weight(0)->zero() );
+    query.setInitialState( p );
+    query.addFinalState( accept );
+    query.addTrans( p, node(0, 0), accept, weight(0)->one() );
+
+    double total = 0;
+    for( int r = 0 ; r < rounds ; r++ ) {
+      clock_t start = clock();
+      WFA answer = pds.poststar( query );
+      total += static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+    }
+
+    std::cout << std::setw(14) << name
+              << std::setw(10) << std::fixed << std::setprecision(3) << total
+              << "\n";
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  int procs = 1000;
+  int nodes = 100;
+  int rounds = 3;
+  if( argc > 1 )
+    std::istringstream(argv[1]) >> procs;
+  if( argc > 2 )
+    std::istringstream(argv[2]) >> nodes;
+  if( argc > 3 )
+    std::istringstream(argv[3]) >> rounds;
+
+  std::cout << "poststar, " << procs << " procedures x " << nodes << " nodes, "
+            << rounds << " rounds; reference count is "
+            << (WALI_ATOMIC_REFCOUNT ? "atomic" : "plain")
+            << (WALI_REF_PTR_HAS_MOVE ? " with" : " without")
+            << " move semantics (seconds)\n";
+
+  run( "Reach", procs, nodes, rounds, reachWeight );
+  run( "ShortestPath", procs, nodes, rounds, distanceWeight );
+
+  return 0;
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,118 @@
+/*
+ * Times WFA::intersect, WFA::prune and WFA::path_summary on the same
+ * automaton with TransSet::TREE and TransSet::FLAT transition sets.
+ *
+ * Usage: transset_speed_test [states [out-degree [rounds]]]
+ */
+
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wfa/WFA.hpp"
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+using namespace wali;
+using namespace wali::wfa;
+
+namespace {
+
+  Key state( char const * prefix, int n )
+  {
+    std::stringstream ss;
+    ss << prefix << n;
+    return getKey(ss.str());
+  }
+
+  /// 'states' states over a four-letter alphabet, each with 'degree'
+  /// outgoing transitions, and a dead state hanging off every tenth one
+  /// so prune has something to do.
+  void build( WFA & fa, int states, int degree )
+  {
+    sem_elem_t zero = ShortestPathSemiring(0).zero();
+    for( int i = 0 ; i < states ; i++ ) {
+      fa.addState( state("q", i), zero );
+    }
+    fa.setInitialState( state("q", 0) );
+    fa.addFinalState( state("q", states - 1) );
+
+    for( int i = 0 ; i < states ; i++ ) {
+      for( int j = 0 ; j < degree ; j++ ) {
+        int to = (i + 1 + (j * 7919) % states) % states;
+        fa.addTrans( state("q", i), state("a", j % 4), state("q", to),
+                     new ShortestPathSemiring( static_cast<unsigned>(1 + (i + j) % 5) ) );
+      }
+      if( i % 10 == 0 ) {
+        fa.addTrans( state("q", i), state("a", 0), state("dead", i),
+                     ShortestPathSemiring(0).one() );
+      }
+    }
+  }
+
+  double seconds( clock_t start )
+  {
+    return static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+  }
+
+  void run( char const * name, TransSet::Representation rep,
+            int states, int degree, int rounds )
+  {
+    double intersect = 0, prune = 0, summary = 0;
+    for( int r = 0 ; r < rounds ; r++ ) {
+      WFA fa;
+      fa.setTransSetRepresentation( rep );
+      build( fa, states, degree );
+
+      WFA product;
+      product.setTransSetRepresentation( rep );
+      clock_t start = clock();
+      fa.intersect( fa, product );
+      intersect += seconds(start);
+
+      start = clock();
+      fa.prune();
+      prune += seconds(start);
+
+      start = clock();
+      fa.path_summary();
+      summary += seconds(start);
+    }
+
+    std::cout << std::setw(6) << name << std::fixed << std::setprecision(3)
+              << std::setw(12) << intersect
+              << std::setw(12) << prune
+              << std::setw(14) << summary
+              << "\n";
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  int states = 300;
+  int degree = 12;
+  int rounds = 3;
+  if( argc > 1 )
+    std::istringstream(argv[1]) >> states;
+  if( argc > 2 )
+    std::istringstream(argv[2]) >> degree;
+  if( argc > 3 )
+    std::istringstream(argv[3]) >> rounds;
+
+  std::cout << states << " states x " << degree << " transitions, "
+            << rounds << " rounds (seconds)\n";
+  std::cout << std::setw(6) << "" << std::setw(12) << "intersect"
+            << std::setw(12) << "prune" << std::setw(14) << "path_summary" << "\n";
+
+  run( "tree", TransSet::TREE, states, degree, rounds );
+  run( "flat", TransSet::FLAT, states, degree, rounds );
+
+  return 0;
+}
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
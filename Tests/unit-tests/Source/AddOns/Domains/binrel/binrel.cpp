@@ -282,6 +282,29 @@ namespace{
     EXPECT_TRUE(se1->combine(se2.get_ptr())->equal((be1 | be2).get_ptr()));
   }
 
+  TEST_F(BinRelTestBool, batchTests){
+    bdd a;
+    a = brm->Assign("c", brm->And(brm->From("a"),brm->From("b")));
+    sem_elem_t se1 = new BinRel(brm.get_ptr(),a,false);
+    a = brm->Assume(brm->From("a"), brm->From("b"));
+    sem_elem_t se2 = new BinRel(brm.get_ptr(),a,false);
+    sem_elem_t one = se1->one();
+    sem_elem_t zero = se1->zero();
+
+    // The repeated right-hand side reuses its shifted BDD
+    SemElem * lhs[] = { se1.get_ptr(), se2.get_ptr(), zero.get_ptr(), se2.get_ptr() };
+    SemElem * rhs[] = { se2.get_ptr(), se2.get_ptr(), se1.get_ptr(), one.get_ptr() };
+    sem_elem_t out[4];
+    se1->extendMany(lhs, rhs, 4, out);
+    for(int i = 0; i < 4; ++i)
+      EXPECT_TRUE(out[i]->equal(lhs[i]->extend(rhs[i])));
+
+    SemElem * ses[] = { se2.get_ptr(), zero.get_ptr(), se1.get_ptr() };
+    EXPECT_TRUE(se1->hasBatchOperations());
+    EXPECT_TRUE(se1->combine(se2)->equal(se1->combineMany(ses, 3)));
+    EXPECT_TRUE(zero->combineMany(ses + 1, 1)->equal(zero));
+  }
+
   TEST_F(BinRelTestBool, transposeTests){
     stringstream ss;
     bdd a;
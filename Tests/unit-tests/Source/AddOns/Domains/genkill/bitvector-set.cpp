@@ -0,0 +1,238 @@
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <set>
+#include <sstream>
+
+#include "wali/domains/genkill/BitVectorSet.hpp"
+#include "wali/domains/genkill/SortedContainerSetAdapter.hpp"
+#include "wali/domains/genkill/GenKillXformerTemplate.hpp"
+
+namespace wali {
+namespace domains {
+namespace genkill {
+
+    // Each universe size gets its own tag
+    struct Tiny;   // 10 elements: inline
+    struct Edge;   // 256 elements: as many as fit inline
+    struct Large;  // 1000 elements: on the heap
+
+    typedef SortedContainerSetAdapter<std::set<int> > SortedSet;
+
+    template<typename Set>
+    static Set
+    random_set(size_t universe, std::set<int> & elements)
+    {
+        Set s;
+        elements.clear();
+        for (size_t i = 0; i < universe; ++i) {
+            if (rand() % 3 == 0) {
+                s.insert(i);
+                elements.insert(static_cast<int>(i));
+            }
+        }
+        return s;
+    }
+
+    template<typename Set>
+    static std::string
+    printed(Set const & s)
+    {
+        std::stringstream ss;
+        s.print(ss);
+        return ss.str();
+    }
+
+    template<typename Tag>
+    static void
+    expect_agrees_with_sorted_sets(size_t universe)
+    {
+        typedef BitVectorSet<Tag> Bits;
+        Bits::setUniverseSize(universe);
+        EXPECT_EQ(universe, Bits::UniverseSet().size());
+        EXPECT_TRUE(Bits::EmptySet().empty());
+
+        srand(1);
+        for (int i = 0; i < 50; ++i) {
+            std::set<int> xs, ys;
+            Bits x = random_set<Bits>(universe, xs);
+            Bits y = random_set<Bits>(universe, ys);
+            SortedSet sx(xs), sy(ys);
+
+            EXPECT_EQ(printed(SortedSet::Union(sx, sy)), printed(Bits::Union(x, y)));
+            EXPECT_EQ(printed(SortedSet::Diff(sx, sy)), printed(Bits::Diff(x, y)));
+            EXPECT_EQ(printed(SortedSet::Intersect(sx, sy)), printed(Bits::Intersect(x, y)));
+            EXPECT_EQ(xs == ys, Bits::Eq(x, y));
+            EXPECT_TRUE(Bits::Eq(x, Bits::Union(x, Bits::Intersect(x, y))));
+            EXPECT_TRUE(Bits::Eq(Bits::EmptySet(), Bits::Diff(x, Bits::UniverseSet())));
+            EXPECT_EQ(xs.size(), x.size());
+        }
+    }
+
+    TEST(wali$domains$genkill$BitVectorSet, agreesWithSortedSetsInline)
+    {
+        expect_agrees_with_sorted_sets<Tiny>(10);
+        expect_agrees_with_sorted_sets<Edge>(256);
+    }
+
+    TEST(wali$domains$genkill$BitVectorSet, agreesWithSortedSetsOnTheHeap)
+    {
+        expect_agrees_with_sorted_sets<Large>(1000);
+    }
+
+    TEST(wali$domains$genkill$BitVectorSet, copiesDoNotSeeLaterChanges)
+    {
+        typedef BitVectorSet<Large> Bits;
+        Bits::setUniverseSize(1000);
+
+        Bits a;
+        a.insert(3);
+        a.insert(999);
+        Bits b = a;
+        b.insert(500);
+        b.erase(3);
+
+        EXPECT_TRUE(a.contains(3));
+        EXPECT_FALSE(a.contains(500));
+        EXPECT_FALSE(b.contains(3));
+        EXPECT_TRUE(b.contains(500));
+        EXPECT_TRUE(b.contains(999));
+        EXPECT_EQ(std::string("{3, 999, }"), printed(a));
+
+        Bits u = Bits::UniverseSet();
+        u.erase(0);
+        EXPECT_EQ(1000u, Bits::UniverseSet().size());
+        EXPECT_EQ(999u, u.size());
+    }
+
+    TEST(wali$domains$genkill$BitVectorSet, givesTheSameTransformersAsSortedSets)
+    {
+        typedef BitVectorSet<Large> Bits;
+        Bits::setUniverseSize(1000);
+        typedef GenKillTransformer_T<Bits> BitsWeight;
+        typedef GenKillTransformer_T<SortedSet> SortedWeight;
+        if (SortedSet::UniverseSet().empty()) {
+            for (int i = 0; i < 1000; ++i) {
+                SortedSet::UniverseSet().insert(i);
+            }
+        }
+
+        srand(2);
+        std::vector<sem_elem_t> bits, sorted;
+        for (int i = 0; i < 8; ++i) {
+            std::set<int> ks, gs;
+            Bits k = random_set<Bits>(1000, ks);
+            Bits g = random_set<Bits>(1000, gs);
+            bits.push_back(BitsWeight::makeGenKillTransformer_T(k, g));
+            sorted.push_back(SortedWeight::makeGenKillTransformer_T(SortedSet(ks), SortedSet(gs)));
+        }
+        bits.push_back(bits[0]->one());
+        sorted.push_back(sorted[0]->one());
+        bits.push_back(bits[0]->zero());
+        sorted.push_back(sorted[0]->zero());
+
+        for (size_t i = 0; i < bits.size(); ++i) {
+            for (size_t j = 0; j < bits.size(); ++j) {
+                EXPECT_EQ(sorted[i]->extend(sorted[j])->toString(),
+                          bits[i]->extend(bits[j])->toString());
+                EXPECT_EQ(sorted[i]->combine(sorted[j])->toString(),
+                          bits[i]->combine(bits[j])->toString());
+                EXPECT_EQ(sorted[i]->diff(sorted[j])->toString(),
+                          bits[i]->diff(bits[j])->toString());
+                EXPECT_EQ(sorted[i]->equal(sorted[j]), bits[i]->equal(bits[j]));
+            }
+        }
+    }
+
+    TEST(wali$domains$genkill$GenKillTransformer_T, combineManyAgreesWithCombine)
+    {
+        typedef BitVectorSet<Large> Bits;
+        Bits::setUniverseSize(1000);
+        typedef GenKillTransformer_T<Bits> BitsWeight;
+
+        srand(3);
+        std::vector<sem_elem_t> ws;
+        ws.push_back(BitsWeight::makeGenKillTransformer_T(Bits(), Bits())->zero());
+        for (int i = 0; i < 6; ++i) {
+            std::set<int> ks, gs;
+            Bits k = random_set<Bits>(1000, ks);
+            Bits g = random_set<Bits>(1000, gs);
+            ws.push_back(BitsWeight::makeGenKillTransformer_T(k, g));
+        }
+        ws.push_back(ws[0]);
+
+        std::vector<SemElem*> ptrs;
+        sem_elem_t expected = ws[0];
+        for (size_t i = 0; i < ws.size(); ++i) {
+            ptrs.push_back(ws[i].get_ptr());
+            expected = expected->combine(ws[i]);
+        }
+
+        EXPECT_TRUE(ws[0]->hasBatchOperations());
+        EXPECT_TRUE(expected->equal(ws[0]->combineMany(&ptrs[0], ptrs.size())));
+        EXPECT_TRUE(ws[3]->equal(ws[0]->combineMany(&ptrs[3], 1)));
+
+        sem_elem_t one = ws[1]->one();
+        SemElem * with_one[] = { ws[1].get_ptr(), one.get_ptr() };
+        EXPECT_TRUE(ws[2]->combine(ws[1])->combine(one)
+                    ->equal(ws[2]->combineMany(with_one, 2)));
+    }
+
+    // A Set with the documented interface only: no copy assignment
+    struct UnassignableSet : SortedSet
+    {
+        UnassignableSet() {}
+        UnassignableSet(SortedSet const & s) : SortedSet(s) {}
+        UnassignableSet(UnassignableSet const & s) : SortedSet(s) {}
+
+        static bool Eq(UnassignableSet const & x, UnassignableSet const & y) {
+            return SortedSet::Eq(x, y);
+        }
+        static UnassignableSet Diff(UnassignableSet const & x, UnassignableSet const & y,
+                                    bool normalizing = false) {
+            return SortedSet::Diff(x, y, normalizing);
+        }
+        static UnassignableSet Union(UnassignableSet const & x, UnassignableSet const & y) {
+            return SortedSet::Union(x, y);
+        }
+        static UnassignableSet Intersect(UnassignableSet const & x, UnassignableSet const & y) {
+            return SortedSet::Intersect(x, y);
+        }
+        static UnassignableSet const & UniverseSet() {
+            static UnassignableSet u;
+            return u;
+        }
+        static UnassignableSet EmptySet() {
+            return UnassignableSet();
+        }
+
+    private:
+        UnassignableSet & operator=(UnassignableSet const &);
+    };
+
+    TEST(wali$domains$genkill$GenKillTransformer_T, combineManyNeedsNoSetAssignment)
+    {
+        typedef GenKillTransformer_T<UnassignableSet> Weight;
+
+        srand(4);
+        std::vector<sem_elem_t> ws;
+        for (int i = 0; i < 4; ++i) {
+            std::set<int> ks, gs;
+            SortedSet k = random_set<SortedSet>(50, ks);
+            SortedSet g = random_set<SortedSet>(50, gs);
+            ws.push_back(Weight::makeGenKillTransformer_T(k, g));
+        }
+
+        std::vector<SemElem*> ptrs;
+        sem_elem_t expected = ws[0];
+        for (size_t i = 0; i < ws.size(); ++i) {
+            ptrs.push_back(ws[i].get_ptr());
+            expected = expected->combine(ws[i]);
+        }
+
+        EXPECT_TRUE(expected->equal(ws[0]->combineMany(&ptrs[0], ptrs.size())));
+    }
+
+}
+}
+}
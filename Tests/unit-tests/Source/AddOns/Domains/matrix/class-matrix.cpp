@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 
+#include <cstdlib>
 #include <sstream>
 #include <boost/scoped_ptr.hpp>
 
@@ -175,6 +176,72 @@ TEST(wali$domains$matrix$BoolMatrix$$combine_raw, randomAndId)
 }
 
 
+TEST(wali$domains$matrix$BoolMatrix$$combineMany, agreesWithCombine)
+{
+    RandomMatrix1_3x3 f1;
+    RandomMatrix2_3x3 f2;
+    IdBackingMatrix_3x3 f3;
+
+    sem_elem_t m1 = new BoolMatrix(f1.mat);
+    sem_elem_t m2 = new BoolMatrix(f2.mat);
+    sem_elem_t m3 = new BoolMatrix(f3.mat);
+    SemElem * ses[] = { m2.get_ptr(), m3.get_ptr() };
+
+    EXPECT_TRUE(m1->hasBatchOperations());
+    EXPECT_TRUE(m1->combine(m2)->combine(m3)->equal(m1->combineMany(ses, 2)));
+    EXPECT_TRUE(m1->equal(m1->combineMany(ses, 0)));
+}
+
+
+static BoolMatrix::BackingMatrix
+random_matrix(size_t rows, size_t cols, int one_in)
+{
+    BoolMatrix::BackingMatrix m(rows, cols);
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+            m(i, j) = (rand() % one_in == 0);
+        }
+    }
+    return m;
+}
+
+
+TEST(wali$domains$matrix$BoolMatrix$$extend_raw, agreesWithUblasAcrossWordBoundaries)
+{
+    srand(4);
+    // Fewer and more rows than it takes to use the Four Russians tables,
+    // and column counts that are not a multiple of 64 (or of 8)
+    size_t dims[][3] = { {5, 70, 3}, {70, 45, 130}, {100, 129, 64}, {64, 64, 64} };
+    for (size_t d = 0; d < sizeof(dims)/sizeof(dims[0]); ++d) {
+        BoolMatrix::BackingMatrix a = random_matrix(dims[d][0], dims[d][1], 9);
+        BoolMatrix::BackingMatrix b = random_matrix(dims[d][1], dims[d][2], 9);
+        BoolMatrix::BackingMatrix expected = prod(a, b);
+
+        BoolMatrix ma(a), mb(b), mexpected(expected);
+        boost::scoped_ptr<BoolMatrix> result(ma.extend_raw(&mb));
+
+        EXPECT_EQ(expected, result->matrix());
+        EXPECT_TRUE(mexpected.equal(result.get()));
+    }
+}
+
+
+TEST(wali$domains$matrix$BoolMatrix$$star, agreesWithRepeatedSquaring)
+{
+    srand(5);
+    size_t dims[] = { 3, 40, 100 };
+    for (size_t d = 0; d < sizeof(dims)/sizeof(dims[0]); ++d) {
+        sem_elem_t m = new BoolMatrix(random_matrix(dims[d], dims[d], 2 * dims[d]));
+
+        sem_elem_t closure = m->star();
+
+        EXPECT_TRUE(m->SemElem::star()->equal(closure));
+        EXPECT_TRUE(closure->equal(closure->extend(closure)));
+        EXPECT_TRUE(closure->equal(closure->combine(m->one())));
+    }
+}
+
+
 TEST(wali$domains$matrix$BoolMatrix$$print, random)
 {
     RandomMatrix1_3x3 f;
@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+
+#include "opennwa/Nwa.hpp"
+
+#include <set>
+
+using namespace opennwa;
+using namespace opennwa::details;
+
+namespace {
+    typedef CompactTransitionStorage::Index Index;
+
+    struct SmallNwa
+    {
+        State a, b, c, d;
+        Symbol x, y;
+        Nwa nwa;
+
+        SmallNwa()
+            : a(getKey("compact_a")), b(getKey("compact_b"))
+            , c(getKey("compact_c")), d(getKey("compact_d"))
+            , x(getKey("compact_x")), y(getKey("compact_y"))
+        {
+            nwa.addInternalTrans(a, x, b);
+            nwa.addInternalTrans(a, y, c);
+            nwa.addInternalTrans(c, x, b);
+            nwa.addCallTrans(b, x, c);
+            nwa.addReturnTrans(c, b, y, d);
+            nwa.addReturnTrans(d, a, x, d);
+        }
+    };
+}
+
+
+TEST(opennwa$Nwa$$getCompactTransitions, indexesEveryTransitionBySourceAndTarget)
+{
+    SmallNwa small;
+    CompactTransitionStorageRefPtr ct = small.nwa.getCompactTransitions();
+
+    EXPECT_EQ(4u, ct->numStates());
+    EXPECT_EQ(2u, ct->numSymbols());
+    EXPECT_EQ(3u, ct->sizeInternal());
+    EXPECT_EQ(1u, ct->sizeCall());
+    EXPECT_EQ(2u, ct->sizeReturn());
+    EXPECT_EQ(CompactTransitionStorage::NONE, ct->stateIndex(getKey("compact_unused")));
+
+    Index a = ct->stateIndex(small.a), b = ct->stateIndex(small.b);
+    Index c = ct->stateIndex(small.c), d = ct->stateIndex(small.d);
+    EXPECT_EQ(small.c, ct->state(c));
+
+    // a -x-> b, a -y-> c
+    CompactTransitionStorage::Edges from_a = ct->internalsFrom(a);
+    ASSERT_EQ(2u, from_a.size());
+    std::set<State> targets;
+    for (CompactTransitionStorage::Edges::const_iterator it = from_a.begin(); it != from_a.end(); ++it) {
+        EXPECT_EQ(a, it->source);
+        targets.insert(ct->state(it->target));
+    }
+    EXPECT_EQ(2u, targets.size());
+    EXPECT_EQ(1u, targets.count(small.c));
+
+    // a -x-> b and c -x-> b
+    CompactTransitionStorage::Positions to_b = ct->internalsTo(b);
+    ASSERT_EQ(2u, to_b.size());
+    for (CompactTransitionStorage::Positions::const_iterator it = to_b.begin(); it != to_b.end(); ++it) {
+        EXPECT_EQ(b, ct->internalAt(*it).target);
+        EXPECT_EQ(small.x, ct->symbol(ct->internalAt(*it).symbol));
+    }
+    EXPECT_TRUE(ct->internalsFrom(d).empty());
+
+    ASSERT_EQ(1u, ct->callsFrom(b).size());
+    EXPECT_EQ(c, ct->callsFrom(b).begin()->target);
+    ASSERT_EQ(1u, ct->callsTo(c).size());
+    EXPECT_EQ(b, ct->callAt(*ct->callsTo(c).begin()).source);
+
+    // (c, b) -y-> d is found by its exit, call predecessor, and return site
+    ASSERT_EQ(1u, ct->returnsFromExit(c).size());
+    EXPECT_EQ(b, ct->returnsFromExit(c).begin()->pred);
+    ASSERT_EQ(1u, ct->returnsFromPred(b).size());
+    EXPECT_EQ(c, ct->returnAt(*ct->returnsFromPred(b).begin()).exit);
+    EXPECT_EQ(2u, ct->returnsTo(d).size());
+    EXPECT_TRUE(ct->returnsFromPred(c).empty());
+
+    EXPECT_LT(0u, ct->memoryUsage());
+}
+
+TEST(opennwa$Nwa$$getCompactTransitions, isRebuiltAfterTheTransitionsChange)
+{
+    SmallNwa small;
+    CompactTransitionStorageRefPtr before = small.nwa.getCompactTransitions();
+    EXPECT_EQ(before.get_ptr(), small.nwa.getCompactTransitions().get_ptr());
+
+    // Adding a transition that is already there changes nothing
+    small.nwa.addInternalTrans(small.a, small.x, small.b);
+    EXPECT_EQ(before.get_ptr(), small.nwa.getCompactTransitions().get_ptr());
+
+    small.nwa.removeInternalTrans(small.a, small.x, small.b);
+    CompactTransitionStorageRefPtr after = small.nwa.getCompactTransitions();
+    EXPECT_NE(before.get_ptr(), after.get_ptr());
+    EXPECT_EQ(3u, before->sizeInternal());
+    EXPECT_EQ(2u, after->sizeInternal());
+
+    Nwa copy = small.nwa;
+    EXPECT_EQ(2u, copy.getCompactTransitions()->sizeInternal());
+
+    small.nwa.clear();
+    EXPECT_EQ(0u, small.nwa.getCompactTransitions()->size());
+    EXPECT_EQ(0u, small.nwa.getCompactTransitions()->numStates());
+}
@@ -41,7 +41,9 @@ static const unsigned num_nwas = NUM_ELEMENTS(nwas);
 // WARNING: the order of the rows and columns in this table must be
 //          consistent with the order of 'nwas' above.
 //
-// "What is the union of the row and column?"
+// "What is the concatenation of the row and column?" (NULL where none of
+// the NWAs has that language: e.g. a right NWA followed by a left one has
+// no word like ")(", which 'maybe full' accepts.)
 static const Nwa * const expected_answers[][num_nwas] = {
     /*                    empty   balanced       strict left   maybe left    strict right   maybe right    maybe full */
     /* empty        */  { &empty, &empty,        &empty,       &empty,       &empty,        &empty,        &empty      },
@@ -49,7 +51,7 @@ static const Nwa * const expected_answers[][num_nwas] = {
     /* strict left  */  { &empty, &strict_left,  &strict_left, &strict_left, NULL,          NULL,          NULL,       },
     /* maybe left   */  { &empty, &maybe_left,   &strict_left, &maybe_left,  NULL,          &maybe_full,   &maybe_full },
     /* strict right */  { &empty, &strict_right, NULL,         NULL,         &strict_right, &strict_right, NULL,       },
-    /* maybe right  */  { &empty, &maybe_right,  NULL,         &maybe_full,  &strict_right, &maybe_right,  &maybe_full },
+    /* maybe right  */  { &empty, &maybe_right,  NULL,         NULL,         &strict_right, &maybe_right,  &maybe_full },
     /* maybe full   */  { &empty, &maybe_full,   NULL,         &maybe_full,  NULL,          &maybe_full,   &maybe_full }
 };
 
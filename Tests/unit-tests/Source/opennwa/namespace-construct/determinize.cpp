@@ -137,6 +137,128 @@ namespace opennwa {
             }
             
 
+
+
+            static Nwa const nwas[] = {
+                Nwa(),
+                AcceptsBalancedOnly().nwa,
+                AcceptsStrictlyUnbalancedLeft().nwa,
+                AcceptsPossiblyUnbalancedLeft().nwa,
+                AcceptsStrictlyUnbalancedRight().nwa,
+                AcceptsPossiblyUnbalancedRight().nwa,
+                AcceptsPositionallyConsistentString().nwa
+            };
+
+            static const unsigned num_nwas = sizeof(nwas)/sizeof(nwas[0]);
+
+
+            TEST(opennwa$construct$$determinize, bitMatricesGiveTheSameNwaAsSets)
+            {
+                for (unsigned nwa = 0 ; nwa < num_nwas ; ++nwa) {
+                    std::stringstream ss;
+                    ss << "NWA number " << nwa;
+                    SCOPED_TRACE(ss.str());
+
+                    NwaRefPtr sets = determinize(nwas[nwa], RelationsAsSets);
+                    NwaRefPtr bits = determinize(nwas[nwa], RelationsAsBitMatrices);
+                    NwaRefPtr chosen = determinize(nwas[nwa]);
+                    NwaRefPtr parallel = determinize(nwas[nwa], RelationsAsBitMatrices, 4);
+
+                    EXPECT_EQ(*sets, *bits);
+                    EXPECT_EQ(*sets, *chosen);
+                    EXPECT_EQ(*sets, *parallel);
+                }
+            }
+
+
+            TEST(opennwa$construct$$determinize, bitMatricesHandleEpsilonAndWild)
+            {
+                SomeElements e;
+                Nwa nwa;
+                Symbol other = getKey("other");
+
+                //         *          symbol (as call)         wild
+                // state -----> state2 ----------------> state3 ----> ((state4))
+                //  ^                                                     |
+                //  |_____________________________________________________|
+                //                  other (as return)/state2
+
+                nwa.addInitialState(e.state);
+                nwa.addFinalState(e.state4);
+                nwa.addSymbol(other);
+
+                nwa.addInternalTrans(e.state, EPSILON, e.state2);
+                nwa.addCallTrans(e.state2, e.symbol, e.state3);
+                nwa.addInternalTrans(e.state3, WILD, e.state4);
+                nwa.addReturnTrans(e.state4, e.state2, other, e.state);
+
+                NwaRefPtr sets = determinize(nwa, RelationsAsSets);
+                NwaRefPtr bits = determinize(nwa, RelationsAsBitMatrices);
+
+                EXPECT_EQ(*sets, *bits);
+
+                NestedWord word;
+                word.appendCall(e.symbol);
+                word.appendInternal(other);
+                word.appendReturn(other);
+                word.appendCall(e.symbol);
+                word.appendInternal(e.symbol);
+                EXPECT_TRUE(query::languageContains(*bits, word));
+            }
+
+
+            /// Labels each state of the deterministic NWA with the
+            /// number of pairs in its relation
+            struct RelationSizeNwa : Nwa
+            {
+                void label(BinaryRelation const & rel, ClientInfoRefPtr & resCI) {
+                    resCI = new IntClientInfo(static_cast<int>(rel.size()));
+                }
+
+                virtual void mergeClientInfo(Nwa const &, BinaryRelation const & binRel,
+                                             State, ClientInfoRefPtr & resCI) {
+                    label(binRel, resCI);
+                }
+
+                virtual void mergeClientInfoCall(Nwa const &, BinaryRelation const &,
+                                                 BinaryRelation const & binRelEntry,
+                                                 State, Symbol, State, ClientInfoRefPtr & resCI) {
+                    label(binRelEntry, resCI);
+                }
+
+                virtual void mergeClientInfoInternal(Nwa const &, BinaryRelation const &,
+                                                     BinaryRelation const & binRelTarget,
+                                                     State, Symbol, State, ClientInfoRefPtr & resCI) {
+                    label(binRelTarget, resCI);
+                }
+
+                virtual void mergeClientInfoReturn(Nwa const &, BinaryRelation const &,
+                                                   BinaryRelation const &,
+                                                   BinaryRelation const & binRelReturn,
+                                                   State, State, Symbol, State, ClientInfoRefPtr & resCI) {
+                    label(binRelReturn, resCI);
+                }
+            };
+
+
+            TEST(opennwa$construct$$determinize, bitMatricesCallTheClientInfoCallbacks)
+            {
+                Nwa const & nwa = AcceptsPositionallyConsistentString().nwa;
+
+                RelationSizeNwa sets, bits;
+                determinize(sets, nwa, RelationsAsSets);
+                determinize(bits, nwa, RelationsAsBitMatrices);
+
+                EXPECT_EQ(static_cast<Nwa const &>(sets), static_cast<Nwa const &>(bits));
+                for (Nwa::StateIterator st = bits.beginStates(); st != bits.endStates(); ++st) {
+                    ClientInfoRefPtr setInfo = sets.getClientInfo(*st);
+                    ClientInfoRefPtr bitInfo = bits.getClientInfo(*st);
+                    ASSERT_TRUE(setInfo != NULL);
+                    ASSERT_TRUE(bitInfo != NULL);
+                    EXPECT_EQ(dynamic_cast<IntClientInfo*>(setInfo.get_ptr())->n,
+                              dynamic_cast<IntClientInfo*>(bitInfo.get_ptr())->n);
+                }
+            }
         }
 }
 
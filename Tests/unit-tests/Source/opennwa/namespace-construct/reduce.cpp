@@ -0,0 +1,161 @@
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+#include "opennwa/Nwa.hpp"
+#include "opennwa/construct/reduce.hpp"
+#include "opennwa/query/language.hpp"
+
+#include "Tests/unit-tests/Source/opennwa/fixtures.hpp"
+#include "Tests/unit-tests/Source/opennwa/class-NWA/supporting.hpp"
+
+using wali::getKey;
+
+namespace opennwa {
+        namespace construct {
+
+            static Nwa const nwas[] = {
+                Nwa(),
+                AcceptsBalancedOnly().nwa,
+                AcceptsStrictlyUnbalancedLeft().nwa,
+                AcceptsPossiblyUnbalancedLeft().nwa,
+                AcceptsStrictlyUnbalancedRight().nwa,
+                AcceptsPossiblyUnbalancedRight().nwa,
+                AcceptsPositionallyConsistentString().nwa
+            };
+
+            static const unsigned num_nwas = sizeof(nwas)/sizeof(nwas[0]);
+
+
+            TEST(opennwa$construct$$reduce, preservesTheLanguageOfFixtures)
+            {
+                for (unsigned nwa = 0 ; nwa < num_nwas ; ++nwa) {
+                    std::stringstream ss;
+                    ss << "NWA number " << nwa;
+                    SCOPED_TRACE(ss.str());
+
+                    NwaRefPtr bisim = reduce(nwas[nwa]);
+                    NwaRefPtr sim = reduce(nwas[nwa], ReduceBySimulation);
+
+                    EXPECT_TRUE(query::languageEquals(nwas[nwa], *bisim));
+                    EXPECT_TRUE(query::languageEquals(nwas[nwa], *sim));
+                    EXPECT_LE(bisim->sizeStates(), nwas[nwa].sizeStates());
+                    EXPECT_LE(sim->sizeStates(), bisim->sizeStates());
+                }
+            }
+
+
+            TEST(opennwa$construct$$reduce, mergesDuplicateBranches)
+            {
+                State start = getKey("reduce_start"), p1 = getKey("reduce_p1"), p2 = getKey("reduce_p2");
+                State e1 = getKey("reduce_e1"), e2 = getKey("reduce_e2");
+                State x1 = getKey("reduce_x1"), x2 = getKey("reduce_x2"), accept = getKey("reduce_accept");
+                State lonely1 = getKey("reduce_lonely1"), lonely2 = getKey("reduce_lonely2");
+                Symbol a = getKey("reduce_a"), call = getKey("reduce_call"), ret = getKey("reduce_ret");
+                Nwa nwa;
+
+                // start goes to p1 or p2 on a; each of those calls e1 and
+                // e2, which step to x1 and x2, which return to either
+                nwa.addInitialState(start);
+                nwa.addFinalState(accept);
+                nwa.addInternalTrans(start, a, p1);
+                nwa.addInternalTrans(start, a, p2);
+                nwa.addCallTrans(p1, call, e1);
+                nwa.addCallTrans(p1, call, e2);
+                nwa.addCallTrans(p2, call, e1);
+                nwa.addCallTrans(p2, call, e2);
+                nwa.addInternalTrans(e1, a, x1);
+                nwa.addInternalTrans(e2, a, x2);
+                nwa.addReturnTrans(x1, p1, ret, accept);
+                nwa.addReturnTrans(x1, p2, ret, accept);
+                nwa.addReturnTrans(x2, p1, ret, accept);
+                nwa.addReturnTrans(x2, p2, ret, accept);
+                nwa.addState(lonely1);
+                nwa.addState(lonely2);
+
+                wali::util::DisjointSets<State> partition = reductionPartition(nwa);
+                EXPECT_EQ(partition.representative(p1), partition.representative(p2));
+                EXPECT_EQ(partition.representative(e1), partition.representative(e2));
+                EXPECT_EQ(partition.representative(x1), partition.representative(x2));
+                EXPECT_EQ(partition.representative(lonely1), partition.representative(lonely2));
+                EXPECT_NE(partition.representative(start), partition.representative(p1));
+                EXPECT_NE(partition.representative(e1), partition.representative(x1));
+
+                NwaRefPtr reduced = reduce(nwa);
+                EXPECT_EQ(6u, reduced->sizeStates());
+                EXPECT_EQ(2u, reduced->sizeInternalTrans());
+                EXPECT_EQ(1u, reduced->sizeCallTrans());
+                EXPECT_EQ(1u, reduced->sizeReturnTrans());
+                EXPECT_TRUE(query::languageEquals(nwa, *reduced));
+            }
+
+
+            TEST(opennwa$construct$$reduce, keepsReturnsMatchedToTheirCallPredecessor)
+            {
+                State start = getKey("reduce_start"), c1 = getKey("reduce_c1"), c2 = getKey("reduce_c2");
+                State e1 = getKey("reduce_e1"), e2 = getKey("reduce_e2"), accept = getKey("reduce_accept");
+                Symbol a = getKey("reduce_a"), b = getKey("reduce_b");
+                Symbol x = getKey("reduce_x"), y = getKey("reduce_y"), ret = getKey("reduce_ret");
+                Nwa nwa;
+
+                // c1 and c2 call both e1 and e2, but can only return from
+                // the one they call on x. Merging e1 with e2 and c1 with c2
+                // would accept "a y ret".
+                nwa.addInitialState(start);
+                nwa.addFinalState(accept);
+                nwa.addInternalTrans(start, a, c1);
+                nwa.addInternalTrans(start, b, c2);
+                nwa.addCallTrans(c1, x, e1);
+                nwa.addCallTrans(c1, y, e2);
+                nwa.addCallTrans(c2, x, e2);
+                nwa.addCallTrans(c2, y, e1);
+                nwa.addReturnTrans(e1, c1, ret, accept);
+                nwa.addReturnTrans(e2, c2, ret, accept);
+
+                wali::util::DisjointSets<State> partition = reductionPartition(nwa, ReduceBySimulation);
+                EXPECT_NE(partition.representative(c1), partition.representative(c2));
+                EXPECT_NE(partition.representative(e1), partition.representative(e2));
+
+                EXPECT_TRUE(query::languageEquals(nwa, *reduce(nwa)));
+                EXPECT_TRUE(query::languageEquals(nwa, *reduce(nwa, ReduceBySimulation)));
+            }
+
+
+            TEST(opennwa$construct$$reduce, simulationMergesMoreThanBisimulation)
+            {
+                State start = getKey("reduce_start"), s1 = getKey("reduce_s1"), s2 = getKey("reduce_s2");
+                State live = getKey("reduce_live"), dead = getKey("reduce_dead"), accept = getKey("reduce_accept");
+                Symbol a = getKey("reduce_a"), b = getKey("reduce_b"), c = getKey("reduce_c");
+                Nwa nwa;
+
+                //             b           a
+                //  --> start ---> s1 --------> dead
+                //          \       \  a            b
+                //           \       ---------> live ---> ((accept))
+                //            \ c          a    /
+                //             ---> s2 --------
+                nwa.addInitialState(start);
+                nwa.addFinalState(accept);
+                nwa.addInternalTrans(start, b, s1);
+                nwa.addInternalTrans(start, c, s2);
+                nwa.addInternalTrans(s1, a, dead);
+                nwa.addInternalTrans(s1, a, live);
+                nwa.addInternalTrans(s2, a, live);
+                nwa.addInternalTrans(live, b, accept);
+
+                // s1 has a move to 'dead' that s2 does not, but 'live'
+                // simulates 'dead', so s1 and s2 simulate each other
+                wali::util::DisjointSets<State> bisim = reductionPartition(nwa);
+                EXPECT_NE(bisim.representative(s1), bisim.representative(s2));
+
+                wali::util::DisjointSets<State> sim = reductionPartition(nwa, ReduceBySimulation);
+                EXPECT_EQ(sim.representative(s1), sim.representative(s2));
+                EXPECT_NE(sim.representative(dead), sim.representative(live));
+
+                NwaRefPtr reduced = reduce(nwa, ReduceBySimulation);
+                EXPECT_EQ(5u, reduced->sizeStates());
+                EXPECT_TRUE(query::languageEquals(nwa, *reduced));
+            }
+
+        }
+}
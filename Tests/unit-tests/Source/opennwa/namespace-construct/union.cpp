@@ -41,15 +41,18 @@ static const unsigned num_nwas = NUM_ELEMENTS(nwas);
 // WARNING: the order of the rows and columns in this table must be
 //          consistent with the order of 'nwas' above.
 //
-// "What is the union of the row and column?"
+// "What is the union of the row and column?" (NULL where none of the NWAs
+// has that language: e.g. 'maybe full' has words with both pending returns
+// and pending calls, such as ")(", which a union of a left and a right NWA
+// does not.)
 static const Nwa * const expected_answers[][num_nwas] = {
     /*                    empty          balanced      strict left   maybe left   strict right   maybe right   maybe full */
     /* empty        */  { &empty,        &balanced,    &strict_left, &maybe_left, &strict_right, &maybe_right, &maybe_full },
     /* balanced     */  { &balanced,     &balanced,    &maybe_left,  &maybe_left, &maybe_right,  &maybe_right, &maybe_full },
-    /* strict left  */  { &strict_left,  &maybe_left,  &strict_left, &maybe_left, NULL,          &maybe_full,  &maybe_full },
-    /* maybe left   */  { &maybe_left,   &maybe_left,  &maybe_left,  &maybe_left, &maybe_full,   &maybe_full,  &maybe_full },
-    /* strict right */  { &strict_right, &maybe_right, NULL,         &maybe_full, &strict_right, &maybe_right, &maybe_full },
-    /* maybe right  */  { &maybe_right,  &maybe_right, &maybe_full,  &maybe_full, &maybe_right,  &maybe_right, &maybe_full },
+    /* strict left  */  { &strict_left,  &maybe_left,  &strict_left, &maybe_left, NULL,          NULL,         &maybe_full },
+    /* maybe left   */  { &maybe_left,   &maybe_left,  &maybe_left,  &maybe_left, NULL,          NULL,         &maybe_full },
+    /* strict right */  { &strict_right, &maybe_right, NULL,         NULL,        &strict_right, &maybe_right, &maybe_full },
+    /* maybe right  */  { &maybe_right,  &maybe_right, NULL,         NULL,        &maybe_right,  &maybe_right, &maybe_full },
     /* maybe full   */  { &maybe_full,   &maybe_full,  &maybe_full,  &maybe_full, &maybe_full,   &maybe_full,  &maybe_full }
 };
 
@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+
+#include "opennwa/Nwa.hpp"
+#include "opennwa/query/calls.hpp"
+#include "opennwa/query/internals.hpp"
+#include "opennwa/query/returns.hpp"
+
+using namespace opennwa;
+using namespace opennwa::query;
+
+namespace {
+    struct IndexedNwa
+    {
+        State a, b, c, d;
+        Symbol x, y;
+        Nwa nwa;
+
+        IndexedNwa()
+            : a(getKey("indexed_a")), b(getKey("indexed_b"))
+            , c(getKey("indexed_c")), d(getKey("indexed_d"))
+            , x(getKey("indexed_x")), y(getKey("indexed_y"))
+        {
+            nwa.addInternalTrans(a, x, b);
+            nwa.addInternalTrans(c, y, d);
+            nwa.addCallTrans(a, x, c);
+            nwa.addCallTrans(b, y, d);
+            nwa.addReturnTrans(c, a, x, b);
+            nwa.addReturnTrans(c, a, y, d);
+            nwa.addReturnTrans(c, b, x, a);
+            nwa.addReturnTrans(d, a, x, a);
+        }
+    };
+}
+
+
+TEST(opennwa$query$$indexedLookups, symbolQueriesOnlySeeTransitionsWithThatSymbol)
+{
+    IndexedNwa n;
+
+    StateSet sources = getSources_Sym(n.nwa, n.x);
+    ASSERT_EQ(1u, sources.size());
+    EXPECT_EQ(1u, sources.count(n.a));
+    EXPECT_EQ(1u, getTargets_Sym(n.nwa, n.y).count(n.d));
+
+    EXPECT_EQ(1u, getCallSites_Sym(n.nwa, n.y).size());
+    EXPECT_EQ(1u, getEntries_Sym(n.nwa, n.x).count(n.c));
+
+    StateSet exits = getExits_Sym(n.nwa, n.x);
+    EXPECT_EQ(2u, exits.size());
+    EXPECT_EQ(2u, getCalls_Sym(n.nwa, n.x).size());
+    EXPECT_EQ(1u, getReturns_Sym(n.nwa, n.y).size());
+
+    EXPECT_TRUE(getSources_Sym(n.nwa, getKey("indexed_unused")).empty());
+    EXPECT_TRUE(getExits_Sym(n.nwa, getKey("indexed_unused")).empty());
+}
+
+TEST(opennwa$query$$indexedLookups, exitCallQueriesOnlySeeThatPair)
+{
+    IndexedNwa n;
+
+    // (c, a) -x-> b and (c, a) -y-> d, but not (c, b) -x-> a
+    std::set<std::pair<Symbol,State> > rets = getReturns(n.nwa, n.c, n.a);
+    EXPECT_EQ(2u, rets.size());
+    EXPECT_EQ(1u, rets.count(std::make_pair(n.x, n.b)));
+    EXPECT_EQ(1u, rets.count(std::make_pair(n.y, n.d)));
+
+    EXPECT_EQ(2u, getReturnSym_ExitCall(n.nwa, n.c, n.a).size());
+    EXPECT_EQ(1u, getReturnSym(n.nwa, n.c, n.a, n.d).count(n.y));
+    EXPECT_TRUE(getReturnSym(n.nwa, n.c, n.a, n.a).empty());
+
+    StateSet sites = getReturns(n.nwa, n.c, n.b, n.x);
+    ASSERT_EQ(1u, sites.size());
+    EXPECT_EQ(1u, sites.count(n.a));
+    EXPECT_TRUE(getReturns(n.nwa, n.d, n.b).empty());
+}
+
+TEST(opennwa$query$$indexedLookups, indexesFollowRemovalsAndCopies)
+{
+    IndexedNwa n;
+
+    n.nwa.removeReturnTrans(n.c, n.a, n.x, n.b);
+    EXPECT_EQ(1u, getReturns(n.nwa, n.c, n.a).size());
+    EXPECT_EQ(1u, getReturns_Sym(n.nwa, n.x).size());
+
+    n.nwa.removeInternalTrans(n.a, n.x, n.b);
+    EXPECT_TRUE(getSources_Sym(n.nwa, n.x).empty());
+
+    Nwa copy = n.nwa;
+    n.nwa.removeSymbol(n.x);
+    EXPECT_TRUE(getCallSites_Sym(n.nwa, n.x).empty());
+    EXPECT_TRUE(getExits_Sym(n.nwa, n.x).empty());
+    EXPECT_EQ(1u, getCallSites_Sym(n.nwa, n.y).size());
+    EXPECT_EQ(1u, getReturnSym_ExitCall(n.nwa, n.c, n.a).size());
+
+    // The copy still has the transitions on x
+    EXPECT_EQ(1u, getCallSites_Sym(copy, n.x).count(n.a));
+    EXPECT_EQ(2u, getExits_Sym(copy, n.x).size());
+
+    n.nwa.clear();
+    EXPECT_TRUE(getCallSites_Sym(n.nwa, n.y).empty());
+    EXPECT_TRUE(getReturns(n.nwa, n.c, n.a).empty());
+}
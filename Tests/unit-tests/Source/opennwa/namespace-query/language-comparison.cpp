@@ -55,15 +55,111 @@ namespace opennwa {
 
                         if (expected_answers[left][right]) {
                             EXPECT_TRUE(languageSubsetEq(nwas[left], nwas[right]));
+                            EXPECT_TRUE(languageSubsetEq(nwas[left], nwas[right], InclusionByComplement));
                         }
                         else {
                             EXPECT_FALSE(languageSubsetEq(nwas[left], nwas[right]));
+                            EXPECT_FALSE(languageSubsetEq(nwas[left], nwas[right], InclusionByComplement));
                         }
                     }
                 }
             }
 
 
+            TEST(opennwa$query$$getSomeWordInDifference, testBatteryOfVariouslyBalancedNwas)
+            {
+                for (unsigned left = 0 ; left < num_nwas ; ++left) {
+                    for (unsigned right = 0 ; right < num_nwas ; ++right) {
+                        std::stringstream ss;
+                        ss << "Testing Nwa " << left << " \\ " << right;
+                        SCOPED_TRACE(ss.str());
+
+                        NestedWordRefPtr word = getSomeWordInDifference(nwas[left], nwas[right]);
+                        if (expected_answers[left][right]) {
+                            EXPECT_TRUE(word == NULL);
+                        }
+                        else {
+                            ASSERT_TRUE(word != NULL);
+                            EXPECT_TRUE(languageContains(nwas[left], *word));
+                            EXPECT_FALSE(languageContains(nwas[right], *word));
+                        }
+                    }
+                }
+            }
+
+
+            // Words over {a, b} whose k-th symbol from the end is a: the
+            // determinized automaton has 2^k states, but the antichain
+            // search never builds it
+            static void
+            kthFromTheEnd(Nwa & nwa, std::string const & prefix, int k)
+            {
+                Symbol a = getKey("a"), b = getKey("b");
+                State first = getKey(prefix + "0");
+                State last = first;
+                nwa.addInitialState(first);
+                nwa.addInternalTrans(first, a, first);
+                nwa.addInternalTrans(first, b, first);
+                for (int i = 1 ; i <= k ; ++i) {
+                    std::stringstream ss;
+                    ss << prefix << i;
+                    State next = getKey(ss.str());
+                    nwa.addInternalTrans(last, a, next);
+                    if (i > 1) {
+                        nwa.addInternalTrans(last, b, next);
+                    }
+                    last = next;
+                }
+                nwa.addFinalState(last);
+            }
+
+            TEST(opennwa$query$$languageEquals, antichainsAvoidDeterminizing)
+            {
+                Nwa left, right, shorter;
+                kthFromTheEnd(left, "kth_left_", 16);
+                kthFromTheEnd(right, "kth_right_", 16);
+                kthFromTheEnd(shorter, "kth_shorter_", 15);
+
+                EXPECT_TRUE(languageEquals(left, right));
+
+                NestedWordRefPtr word = getSomeWordInDifference(left, shorter);
+                ASSERT_TRUE(word != NULL);
+                EXPECT_TRUE(languageContains(left, *word));
+                EXPECT_FALSE(languageContains(shorter, *word));
+            }
+
+
+            // The right NWA has a call to a final state, but only from a
+            // state it cannot reach, so it accepts nothing; the left one
+            // accepts the word that is one pending call
+            TEST(opennwa$query$$getSomeWordInDifference, pendingCallFromUnreachableState)
+            {
+                Symbol b = getKey("b");
+                Nwa left, right;
+                left.addInitialState(getKey("pc_left_q0"));
+                left.addFinalState(getKey("pc_left_q1"));
+                left.addCallTrans(getKey("pc_left_q0"), b, getKey("pc_left_q1"));
+
+                right.addInitialState(getKey("pc_right_q0"));
+                right.addFinalState(getKey("pc_right_f"));
+                right.addCallTrans(getKey("pc_right_r"), b, getKey("pc_right_f"));
+
+                NestedWord pending;
+                pending.appendCall(b);
+                ASSERT_TRUE(languageContains(left, pending));
+                ASSERT_FALSE(languageContains(right, pending));
+
+                NestedWordRefPtr word = getSomeWordInDifference(left, right);
+                ASSERT_TRUE(word != NULL);
+                EXPECT_TRUE(languageContains(left, *word));
+                EXPECT_FALSE(languageContains(right, *word));
+
+                EXPECT_FALSE(languageSubsetEq(left, right));
+                EXPECT_FALSE(languageEquals(left, right));
+                EXPECT_TRUE(languageSubsetEq(right, left));
+            }
+
+
             TEST(opennwa$query$$languageEquals, testBatteryOfVariouslyBalancedNwas)
             {
                 for (unsigned left = 0 ; left < num_nwas ; ++left) {
@@ -77,9 +173,11 @@ namespace opennwa {
                         if (expected_answers[left][right]
                             && expected_answers[right][left]) {
                             EXPECT_TRUE(languageEquals(nwas[left], nwas[right]));
+                            EXPECT_TRUE(languageEquals(nwas[left], nwas[right], InclusionByComplement));
                         }
                         else {
                             EXPECT_FALSE(languageEquals(nwas[left], nwas[right]));
+                            EXPECT_FALSE(languageEquals(nwas[left], nwas[right], InclusionByComplement));
                         }
                     }
                 }
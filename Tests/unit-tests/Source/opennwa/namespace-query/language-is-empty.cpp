@@ -2,6 +2,7 @@
 
 #include "opennwa/Nwa.hpp"
 #include "opennwa/query/language.hpp"
+#include "opennwa/construct/intersect.hpp"
 
 #include "Tests/unit-tests/Source/opennwa/fixtures.hpp"
 #include "Tests/unit-tests/Source/opennwa/class-NWA/supporting.hpp"
@@ -315,7 +316,160 @@ namespace opennwa {
 
                 EXPECT_EQ(expected, *word);
             }
-            
+
+
+            TEST(opennwa$query$$languageIntersectionIsEmpty, testBatteryOfVariouslyBalancedNwas)
+            {
+                for (unsigned first = 0 ; first < num_nwas ; ++first) {
+                    for (unsigned second = 0 ; second < num_nwas ; ++second) {
+                        std::stringstream ss;
+                        ss << "Testing NWA " << first << " & " << second;
+                        SCOPED_TRACE(ss.str());
+
+                        bool empty = languageIsEmpty(*construct::intersect(nwas[first], nwas[second]));
+                        EXPECT_EQ(empty, languageIntersectionIsEmpty(nwas[first], nwas[second]));
+
+                        NestedWordRefPtr word = getSomeWordInIntersection(nwas[first], nwas[second]);
+                        if (empty) {
+                            EXPECT_TRUE(word == NULL);
+                        }
+                        else {
+                            ASSERT_TRUE(word != NULL);
+                            EXPECT_TRUE(languageContains(nwas[first], *word));
+                            EXPECT_TRUE(languageContains(nwas[second], *word));
+                        }
+                    }
+                }
+            }
+
+
+            TEST(opennwa$query$$getSomeWordInIntersection, testMatchedCallAgainstWild)
+            {
+                //              (a            b             a)/p0
+                //  --> (p0) ----> (p1) ----> (p2) ----> ((p3))
+                //
+                //              (*         * (loop)         *)/q0
+                //  --> (q0) ----> (q1) ----> (q1) ----> ((q2))
+                Nwa first, second;
+                State p0 = getKey("isect_p0"), p1 = getKey("isect_p1");
+                State p2 = getKey("isect_p2"), p3 = getKey("isect_p3");
+                State q0 = getKey("isect_q0"), q1 = getKey("isect_q1"), q2 = getKey("isect_q2");
+                Symbol a = getKey("a"), b = getKey("b");
+
+                first.addInitialState(p0);
+                first.addCallTrans(p0, a, p1);
+                first.addInternalTrans(p1, b, p2);
+                first.addReturnTrans(p2, p0, a, p3);
+                first.addFinalState(p3);
+
+                second.addInitialState(q0);
+                second.addCallTrans(q0, WILD, q1);
+                second.addInternalTrans(q1, WILD, q1);
+                second.addReturnTrans(q1, q0, WILD, q2);
+                second.addFinalState(q2);
+
+                EXPECT_FALSE(languageIntersectionIsEmpty(first, second));
+
+                NestedWord expected;
+                expected.appendCall(a);
+                expected.appendInternal(b);
+                expected.appendReturn(a);
+
+                NestedWordRefPtr word = getSomeWordInIntersection(first, second);
+                ASSERT_TRUE(word != NULL);
+                EXPECT_EQ(expected, *word);
+
+                // Without the internal b, 'first' has no word in common
+                first.removeInternalTrans(p1, b, p2);
+                first.addInternalTrans(p1, a, p1);
+                EXPECT_TRUE(languageIntersectionIsEmpty(first, second));
+                EXPECT_TRUE(getSomeWordInIntersection(first, second) == NULL);
+            }
+
+
+            TEST(opennwa$query$$languageIsEmpty, summariesAgreeWithPoststar)
+            {
+                for (unsigned nwa = 0 ; nwa < num_nwas ; ++nwa) {
+                    std::stringstream ss;
+                    ss << "Testing NWA " << nwa;
+                    SCOPED_TRACE(ss.str());
+
+                    EXPECT_EQ(languageIsEmpty(nwas[nwa], ReachabilityByPoststar),
+                              languageIsEmpty(nwas[nwa], ReachabilityBySummaries));
+
+                    NestedWordRefPtr word = getSomeShortestAcceptedWord(nwas[nwa], ReachabilityBySummaries);
+                    NestedWordRefPtr old_word = getSomeShortestAcceptedWord(nwas[nwa], ReachabilityByPoststar);
+                    ASSERT_EQ(old_word == NULL, word == NULL);
+                    if (word != NULL) {
+                        EXPECT_EQ(old_word->size(), word->size());
+                    }
+                }
+            }
+
+
+            TEST(opennwa$query$$getSomeShortestAcceptedWord, testPendingCallIsShorter)
+            {
+                //               a              a              a
+                //  --> (state) ----> (state2) ----> (state3) ---> ((state4))
+                //         |                                           ^
+                //         +-------------------------------------------+
+                //                             (b
+                Nwa nwa;
+                SomeElements e;
+                State state4 = getKey("state4");
+                Symbol b = getKey("b");
+
+                nwa.addInitialState(e.state);
+                nwa.addInternalTrans(e.state, e.symbol, e.state2);
+                nwa.addInternalTrans(e.state2, e.symbol, e.state3);
+                nwa.addInternalTrans(e.state3, e.symbol, state4);
+                nwa.addCallTrans(e.state, b, state4);
+                nwa.addFinalState(state4);
+
+                NestedWord expected;
+                expected.appendCall(b);
+
+                NestedWordRefPtr word = getSomeShortestAcceptedWord(nwa);
+                ASSERT_TRUE(word != NULL);
+                EXPECT_EQ(expected, *word);
+            }
+
+
+            TEST(opennwa$query$$getSomeAcceptedWord, testDeeplyNestedWord)
+            {
+                // (a (a ... (a  a) a) ... a), 2000 deep: longer than the
+                // recursion the word reconstruction could afford
+                Nwa nwa;
+                Symbol a = getKey("a");
+                const int depth = 2000;
+                std::vector<State> calls, returns;
+                for (int i = 0 ; i <= depth ; ++i) {
+                    std::stringstream ss;
+                    ss << "deep_" << i;
+                    calls.push_back(getKey(ss.str() + "_call"));
+                    returns.push_back(getKey(ss.str() + "_return"));
+                }
+                nwa.addInitialState(calls[0]);
+                for (int i = 0 ; i < depth ; ++i) {
+                    nwa.addCallTrans(calls[i], a, calls[i + 1]);
+                    // The innermost exit is the last call's entry
+                    State exit = (i + 1 == depth) ? calls[depth] : returns[i + 1];
+                    nwa.addReturnTrans(exit, calls[i], a, returns[i]);
+                }
+                nwa.addFinalState(returns[0]);
+
+                EXPECT_FALSE(languageIsEmpty(nwa));
+
+                NestedWordRefPtr word = getSomeAcceptedWord(nwa);
+                ASSERT_TRUE(word != NULL);
+                EXPECT_EQ(2u * depth, word->size());
+                EXPECT_TRUE(languageContains(nwa, *word));
+
+                NestedWordRefPtr shortest_word = getSomeShortestAcceptedWord(nwa);
+                ASSERT_TRUE(shortest_word != NULL);
+                EXPECT_EQ(*word, *shortest_word);
+            }
+
     }
 }
 
@@ -0,0 +1,150 @@
+#include "gtest/gtest.h"
+
+#include "opennwa/Nwa.hpp"
+#include "opennwa/query/WordRunner.hpp"
+
+#include "Tests/unit-tests/Source/opennwa/fixtures.hpp"
+#include "Tests/unit-tests/Source/opennwa/class-NWA/supporting.hpp"
+
+using namespace opennwa;
+using namespace opennwa::query;
+
+#define NUM_ELEMENTS(array)  (sizeof(array)/sizeof((array)[0]))
+
+static Nwa const nwas[] = {
+    Nwa(),
+    AcceptsBalancedOnly().nwa,
+    AcceptsStrictlyUnbalancedLeft().nwa,
+    AcceptsPossiblyUnbalancedLeft().nwa,
+    AcceptsStrictlyUnbalancedRight().nwa,
+    AcceptsPossiblyUnbalancedRight().nwa,
+    AcceptsPositionallyConsistentString().nwa
+};
+
+static const unsigned num_nwas = NUM_ELEMENTS(nwas);
+
+static NestedWord const words[] = {
+    WordCollection().empty,
+    WordCollection().balanced,
+    WordCollection().balanced0,
+    WordCollection().unbalancedLeft,
+    WordCollection().unbalancedLeft0,
+    WordCollection().unbalancedRight,
+    WordCollection().unbalancedRight0,
+    WordCollection().fullyUnbalanced,
+    WordCollection().fullyUnbalanced0
+};
+
+static const unsigned num_words = NUM_ELEMENTS(words);
+
+
+TEST(opennwa$query$WordRunner, agreesWithLanguageContainsOnEveryPrefix)
+{
+    for (unsigned word = 0 ; word < num_words ; ++word) {
+        for (unsigned nwa = 0 ; nwa < num_nwas ; ++nwa) {
+            std::stringstream ss;
+            ss << "NWA number " << nwa << " and word number " << word;
+            SCOPED_TRACE(ss.str());
+
+            WordRunner runner(nwas[nwa]);
+            NestedWord prefix;
+            EXPECT_EQ(nwas[nwa].isMemberNondet(prefix), runner.accepting());
+
+            for (NestedWord::const_iterator pos = words[word].begin();
+                 pos != words[word].end(); ++pos)
+            {
+                switch (pos->type) {
+                    case NestedWord::Position::InternalType:
+                        runner.feedInternal(pos->symbol);
+                        prefix.appendInternal(pos->symbol);
+                        break;
+                    case NestedWord::Position::CallType:
+                        runner.feedCall(pos->symbol);
+                        prefix.appendCall(pos->symbol);
+                        break;
+                    case NestedWord::Position::ReturnType:
+                        runner.feedReturn(pos->symbol);
+                        prefix.appendReturn(pos->symbol);
+                        break;
+                }
+                EXPECT_EQ(nwas[nwa].isMemberNondet(prefix), runner.accepting());
+            }
+
+            runner.reset();
+            runner.feed(words[word]);
+            EXPECT_EQ(nwas[nwa].isMemberNondet(words[word]), runner.accepting());
+        }
+    }
+}
+
+
+TEST(opennwa$query$WordRunner, deepStacksShareNodesAndAreReclaimed)
+{
+    // p --(c--> p, p --i--> p, p --i--> q, and (p, p) --r)--> p and
+    // (q, p) --r)--> p: after each internal the runner is in both p and
+    // q, on the same stack.
+    Nwa nwa;
+    State p = getKey("runner_p"), q = getKey("runner_q");
+    Symbol c = getKey("c"), i = getKey("i"), r = getKey("r");
+    nwa.addInitialState(p);
+    nwa.addFinalState(p);
+    nwa.addCallTrans(p, c, p);
+    nwa.addInternalTrans(p, i, p);
+    nwa.addInternalTrans(p, i, q);
+    nwa.addReturnTrans(p, p, r, p);
+    nwa.addReturnTrans(q, p, r, p);
+
+    WordRunner runner(nwa);
+    const int depth = 100000;
+    for (int k = 0 ; k < depth ; ++k) {
+        runner.feedCall(c);
+        runner.feedInternal(i);
+    }
+    EXPECT_EQ(2u, runner.numConfigurations());
+    EXPECT_EQ(size_t(depth), runner.numStackNodes());
+    EXPECT_TRUE(runner.accepting());
+
+    for (int k = 0 ; k < depth ; ++k) {
+        runner.feedReturn(r);
+    }
+    EXPECT_EQ(1u, runner.numConfigurations());
+    EXPECT_EQ(0u, runner.numStackNodes());
+    EXPECT_TRUE(runner.accepting());
+
+    // A pending return: the call predecessor must be initial (p is)
+    runner.feedReturn(r);
+    EXPECT_TRUE(runner.accepting());
+    EXPECT_FALSE(runner.stuck());
+
+    // There is no transition on i) at all
+    runner.feedReturn(i);
+    EXPECT_FALSE(runner.accepting());
+    EXPECT_TRUE(runner.stuck());
+
+    runner.reset();
+    EXPECT_TRUE(runner.accepting());
+    EXPECT_FALSE(runner.stuck());
+}
+
+
+TEST(opennwa$query$WordRunner, epsilonClosureAfterEachPosition)
+{
+    Nwa nwa;
+    SomeElements e;
+
+    //              *           symbol          *
+    //  --> state ----->  state2 ----> state3 -----> ((state4))
+    State state4 = getKey("state4");
+    nwa.addInitialState(e.state);
+    nwa.addFinalState(state4);
+    nwa.addInternalTrans(e.state, EPSILON, e.state2);
+    nwa.addInternalTrans(e.state2, e.symbol, e.state3);
+    nwa.addInternalTrans(e.state3, EPSILON, state4);
+
+    WordRunner runner(nwa);
+    EXPECT_FALSE(runner.accepting());
+    runner.feedInternal(e.symbol);
+    EXPECT_TRUE(runner.accepting());
+    runner.feedInternal(e.symbol);
+    EXPECT_TRUE(runner.stuck());
+}
@@ -0,0 +1,191 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+#include "opennwa/Nwa.hpp"
+#include "opennwa/NwaParser.hpp"
+#include "opennwa/NwaBinary.hpp"
+#include "wali/KeySpace.hpp"
+
+#include "Tests/unit-tests/Source/opennwa/fixtures.hpp"
+#include "Tests/unit-tests/Source/opennwa/class-NWA/supporting.hpp"
+
+using namespace opennwa;
+using wali::getKey;
+
+#define NUM_ELEMENTS(array)  (sizeof(array)/sizeof((array)[0]))
+
+namespace opennwa {
+
+        void
+        expect_binary_matches_text(Nwa const & nwa)
+        {
+            std::stringstream text;
+            nwa.print(text);
+            NwaRefPtr from_text = read_nwa(text);
+
+            std::stringstream binary;
+            write_nwa_binary(nwa, binary);
+            NwaRefPtr from_binary = read_nwa_binary(binary);
+
+            EXPECT_EQ(*from_text, *from_binary);
+            EXPECT_EQ(nwa, *from_binary);
+        }
+
+        TEST(opennwa$$write_nwa_binary$and$read_nwa_binary, agreeWithPrintAndRead_nwa)
+        {
+            Nwa const nwas[] = {
+                Nwa(),
+                AcceptsBalancedOnly().nwa,
+                AcceptsStrictlyUnbalancedLeft().nwa,
+                AcceptsPossiblyUnbalancedLeft().nwa,
+                AcceptsStrictlyUnbalancedRight().nwa,
+                AcceptsPossiblyUnbalancedRight().nwa,
+                AcceptsPositionallyConsistentString().nwa
+            };
+
+            const unsigned num_nwas = NUM_ELEMENTS(nwas);
+
+            for (unsigned nwa = 0; nwa < num_nwas; ++nwa) {
+                std::stringstream ss;
+                ss << "Testing NWA " << nwa;
+                SCOPED_TRACE(ss.str());
+
+                expect_binary_matches_text(nwas[nwa]);
+            }
+        }
+
+        TEST(opennwa$$write_nwa_binary$and$read_nwa_binary, keepEpsilonWildAndIsolatedStates)
+        {
+            Nwa nwa;
+            State q0 = getKey("binary_q0"), q1 = getKey("binary_q1"), q2 = getKey("binary_q2");
+            State lonely = getKey("binary_lonely");
+            Symbol a = getKey("binary_a");
+
+            nwa.addInitialState(q0);
+            nwa.addFinalState(q2);
+            nwa.addState(lonely);
+            nwa.addSymbol(getKey("binary_unused_symbol"));
+            nwa.addInternalTrans(q0, EPSILON, q1);
+            nwa.addCallTrans(q1, WILD, q0);
+            nwa.addReturnTrans(q0, q1, a, q2);
+            nwa.addReturnTrans(q0, q1, WILD, q1);
+
+            expect_binary_matches_text(nwa);
+        }
+
+        TEST(opennwa$$NwaImage, exposesTheCsrArrays)
+        {
+            AcceptsBalancedOnly fixture;
+
+            std::stringstream binary;
+            write_nwa_binary(fixture.nwa, binary);
+            NwaImage image(binary);
+
+            EXPECT_EQ(fixture.nwa.sizeStates(), image.numStates());
+            EXPECT_EQ(fixture.nwa.sizeInitialStates(), image.initialStates().size());
+            EXPECT_EQ(fixture.nwa.sizeFinalStates(), image.finalStates().size());
+
+            // Rebuild the NWA from the arrays
+            Nwa rebuilt;
+            NwaImage::Range<NwaImage::Index> initial = image.initialStates();
+            for (NwaImage::Range<NwaImage::Index>::const_iterator it = initial.begin(); it != initial.end(); ++it) {
+                rebuilt.addInitialState(image.state(*it));
+            }
+            NwaImage::Range<NwaImage::Index> final = image.finalStates();
+            for (NwaImage::Range<NwaImage::Index>::const_iterator it = final.begin(); it != final.end(); ++it) {
+                rebuilt.addFinalState(image.state(*it));
+            }
+            for (NwaImage::Index s = 0; s < image.numSymbols(); ++s) {
+                rebuilt.addSymbol(image.symbol(s));
+            }
+            for (NwaImage::Index q = 0; q < image.numStates(); ++q) {
+                State st = image.state(q);
+                EXPECT_EQ(wali::key2str(st), image.stateName(q));
+                rebuilt.addState(st);
+
+                NwaImage::Range<NwaImage::Edge> out = image.internalsFrom(q);
+                for (NwaImage::Range<NwaImage::Edge>::const_iterator it = out.begin(); it != out.end(); ++it) {
+                    rebuilt.addInternalTrans(st, image.symbol(it->symbol), image.state(it->target));
+                }
+                out = image.callsFrom(q);
+                for (NwaImage::Range<NwaImage::Edge>::const_iterator it = out.begin(); it != out.end(); ++it) {
+                    rebuilt.addCallTrans(st, image.symbol(it->symbol), image.state(it->target));
+                }
+                NwaImage::Range<NwaImage::ReturnEdge> rets = image.returnsFromExit(q);
+                for (NwaImage::Range<NwaImage::ReturnEdge>::const_iterator it = rets.begin(); it != rets.end(); ++it) {
+                    rebuilt.addReturnTrans(st, image.state(it->pred), image.symbol(it->symbol),
+                                           image.state(it->returnSite));
+                }
+            }
+            EXPECT_EQ(fixture.nwa, rebuilt);
+        }
+
+        TEST(opennwa$$NwaImage, mapsFilesAndInternsNamesLazily)
+        {
+            // An image of (start) --tick--> (end), laid out by hand so that
+            // none of its names are in the key space yet
+            wali::util::BinaryImageWriter writer(NwaImage::MAGIC, NwaImage::VERSION, NwaImage::NUM_SECTIONS);
+            writer.section(NwaImage::STATES).push_back(writer.addString("binary_lazy_start"));
+            writer.section(NwaImage::STATES).push_back(writer.addString("binary_lazy_end"));
+            writer.section(NwaImage::SYMBOLS).push_back(writer.addString("binary_lazy_tick"));
+            writer.section(NwaImage::INITIAL).push_back(0);
+            writer.section(NwaImage::FINAL).push_back(1);
+            NwaImage::Index internal_offsets[] = { 0, 1, 1 };
+            NwaImage::Index internals[] = { 0, 1 };
+            NwaImage::Index no_offsets[] = { 0, 0, 0 };
+            writer.section(NwaImage::INTERNAL_OFFSETS).assign(internal_offsets, internal_offsets + 3);
+            writer.section(NwaImage::INTERNALS).assign(internals, internals + 2);
+            writer.section(NwaImage::CALL_OFFSETS).assign(no_offsets, no_offsets + 3);
+            writer.section(NwaImage::RETURN_OFFSETS).assign(no_offsets, no_offsets + 3);
+
+            char const * path = "nwa-binary-unit-test.bin";
+            {
+                std::ofstream out(path, std::ios::binary);
+                writer.write(out);
+            }
+
+            {
+                size_t keys_before = wali::getKeySpace()->size();
+                NwaImage image(path);
+#ifndef _WIN32
+                EXPECT_TRUE(image.isMapped());
+#endif
+                ASSERT_EQ(2u, image.numStates());
+                EXPECT_EQ(std::string("binary_lazy_end"), image.stateName(1));
+                EXPECT_EQ(1u, image.internalsFrom(0).size());
+                EXPECT_EQ(keys_before, wali::getKeySpace()->size());
+
+                EXPECT_EQ(getKey("binary_lazy_start"), image.state(0));
+                EXPECT_EQ(keys_before + 1, wali::getKeySpace()->size());
+
+                Nwa expected;
+                expected.addInitialState(getKey("binary_lazy_start"));
+                expected.addFinalState(getKey("binary_lazy_end"));
+                expected.addInternalTrans(getKey("binary_lazy_start"), getKey("binary_lazy_tick"),
+                                          getKey("binary_lazy_end"));
+                EXPECT_EQ(expected, *image.toNwa());
+            }
+            std::remove(path);
+        }
+
+        TEST(opennwa$$NwaImage, rejectsOtherInput)
+        {
+            std::stringstream text;
+            AcceptsBalancedOnly().nwa.print(text);
+            EXPECT_THROW(NwaImage image(text), wali::util::BadImageException);
+
+            std::stringstream binary;
+            write_nwa_binary(AcceptsBalancedOnly().nwa, binary);
+            std::string bytes = binary.str();
+
+            std::stringstream truncated(bytes.substr(0, bytes.size() - 4));
+            EXPECT_THROW(NwaImage image(truncated), wali::util::BadImageException);
+
+            std::stringstream empty;
+            EXPECT_THROW(NwaImage image(empty), wali::util::BadImageException);
+        }
+
+}
@@ -0,0 +1,212 @@
+#include "gtest/gtest.h"
+
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wpds/fwpds/FWPDS.hpp"
+#include "wali/wfa/Trans.hpp"
+#include "wali/wfa/State.hpp"
+
+#include "wali/wpds/fixtures.hpp"
+
+#include <climits>
+#include <vector>
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wfa;
+
+namespace {
+
+    /// Shortest paths again (printed the same way, so answers can be
+    /// compared), but advertising batch operations and counting how
+    /// often the solvers use them
+    class BatchedDistance : public SemElem
+    {
+    public:
+        static unsigned extend_batches;
+        static unsigned combine_batches;
+
+        explicit BatchedDistance(unsigned d) : d(d) {}
+
+        sem_elem_t one() const { return new BatchedDistance(0); }
+        sem_elem_t zero() const { return new BatchedDistance(UINT_MAX); }
+
+        sem_elem_t extend(SemElem * se) {
+            unsigned e = down(se);
+            if (d == UINT_MAX || e == UINT_MAX) {
+                return zero();
+            }
+            return new BatchedDistance(d + e);
+        }
+
+        sem_elem_t combine(SemElem * se) {
+            return new BatchedDistance(std::min(d, down(se)));
+        }
+
+        bool equal(SemElem * se) const {
+            return d == down(se);
+        }
+
+        std::ostream & print(std::ostream & os) const {
+            return os << "ShortestPathSemiring(" << d << ")";
+        }
+
+        bool hasBatchOperations() const {
+            return true;
+        }
+
+        void extendMany(SemElem * const * lhs, SemElem * const * rhs,
+                        size_t n, sem_elem_t * out)
+        {
+            ++extend_batches;
+            SemElem::extendMany(lhs, rhs, n, out);
+        }
+
+        sem_elem_t combineMany(SemElem * const * ses, size_t n) {
+            ++combine_batches;
+            unsigned m = d;
+            for (size_t i = 0; i < n; ++i) {
+                m = std::min(m, down(ses[i]));
+            }
+            return new BatchedDistance(m);
+        }
+
+    private:
+        static unsigned down(SemElem const * se) {
+            return dynamic_cast<BatchedDistance const *>(se)->d;
+        }
+
+        unsigned d;
+    };
+
+    unsigned BatchedDistance::extend_batches = 0;
+    unsigned BatchedDistance::combine_batches = 0;
+
+
+    /// A WPDS that hooks poststar_handle_trans, as a client might
+    class HandlerCountingWPDS : public WPDS
+    {
+    public:
+        static unsigned handled;
+
+    protected:
+        virtual void poststar_handle_trans(ITrans * t, WFA & ca, rule_t & r,
+                                           sem_elem_t delta)
+        {
+            ++handled;
+            WPDS::poststar_handle_trans(t, ca, r, delta);
+        }
+
+        virtual bool usesDefaultPostHandlers() const { return false; }
+    };
+
+    unsigned HandlerCountingWPDS::handled = 0;
+
+
+    sem_elem_t batched(unsigned d)
+    {
+        return new BatchedDistance(d);
+    }
+
+    sem_elem_t plain(unsigned d)
+    {
+        return new ShortestPathSemiring(d);
+    }
+
+    /// Poststar on Program, with an extra shortcut in main
+    template<typename Pds>
+    WFA poststar(sem_elem_t (*dist)(unsigned))
+    {
+        Program<Pds> program(dist);
+        program.pds.add_rule(program.p, programNode("main", 2),
+                             program.p, programNode("main", 4), dist(7));
+        return program.pds.poststar(program.query("main", 0));
+    }
+
+    /// The weights of the (p, main_i, accept) transitions, printed
+    std::vector<std::string> mainWeights(WFA const & answer)
+    {
+        std::vector<std::string> weights;
+        for (int i = 0; i <= 6; ++i) {
+            Trans t;
+            if (answer.find(getKey("p"), programNode("main", i), getKey("accept"), t)) {
+                weights.push_back(t.weight()->toString());
+            }
+            else {
+                weights.push_back("none");
+            }
+        }
+        return weights;
+    }
+}
+
+
+TEST(wali$SemElem$extendMany, defaultLoopsOverExtend)
+{
+    sem_elem_t a = plain(1), b = plain(2), c = plain(5);
+    SemElem * lhs[] = { a.get_ptr(), b.get_ptr(), c.get_ptr() };
+    SemElem * rhs[] = { c.get_ptr(), a.get_ptr(), c.get_ptr() };
+    sem_elem_t out[3];
+
+    a->extendMany(lhs, rhs, 3, out);
+
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(out[i]->equal(lhs[i]->extend(rhs[i])));
+    }
+    EXPECT_FALSE(a->hasBatchOperations());
+}
+
+TEST(wali$SemElem$combineMany, defaultLoopsOverCombine)
+{
+    sem_elem_t a = plain(4), b = plain(2), c = plain(5);
+    SemElem * ses[] = { b.get_ptr(), c.get_ptr() };
+
+    EXPECT_TRUE(a->combineMany(ses, 2)->equal(plain(2)));
+    EXPECT_TRUE(a->combineMany(ses, 0)->equal(a));
+}
+
+TEST(wali$wpds$WPDS$poststar, batchedWeightsGiveTheSameAnswer)
+{
+    BatchedDistance::extend_batches = 0;
+    WFA with_batches = poststar<WPDS>(batched);
+    WFA without = poststar<WPDS>(plain);
+
+    EXPECT_EQ(mainWeights(without), mainWeights(with_batches));
+    EXPECT_GT(BatchedDistance::extend_batches, 0u);
+}
+
+TEST(wali$wpds$fwpds$FWPDS$poststar, batchedWeightsGiveTheSameAnswer)
+{
+    BatchedDistance::combine_batches = 0;
+    WFA with_batches = poststar<fwpds::FWPDS>(batched);
+    WFA without = poststar<fwpds::FWPDS>(plain);
+
+    EXPECT_EQ(mainWeights(without), mainWeights(with_batches));
+    EXPECT_GT(BatchedDistance::combine_batches, 0u);
+}
+
+TEST(wali$wpds$WPDS$poststar, overriddenHandlersAreNotBypassedByBatching)
+{
+    HandlerCountingWPDS::handled = 0;
+    BatchedDistance::extend_batches = 0;
+    WFA with_batches = poststar<HandlerCountingWPDS>(batched);
+    WFA without = poststar<WPDS>(plain);
+
+    EXPECT_EQ(mainWeights(without), mainWeights(with_batches));
+    EXPECT_GT(HandlerCountingWPDS::handled, 0u);
+    EXPECT_EQ(0u, BatchedDistance::extend_batches);
+}
+
+TEST(wali$wfa$WFA$path_summary_iterative_original, batchedWeightsGiveTheSameAnswer)
+{
+    WFA with_batches = poststar<WPDS>(batched);
+    WFA without = poststar<WPDS>(plain);
+
+    BatchedDistance::extend_batches = 0;
+    with_batches.path_summary_iterative_original();
+    without.path_summary_iterative_original();
+
+    EXPECT_EQ(without.getState(getKey("p"))->weight()->toString(),
+              with_batches.getState(getKey("p"))->weight()->toString());
+    EXPECT_GT(BatchedDistance::extend_batches, 0u);
+}
@@ -0,0 +1,128 @@
+#include "gtest/gtest.h"
+
+#include "wali/ShortestPathWorklist.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wfa/Trans.hpp"
+
+#include <sstream>
+#include <vector>
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wfa;
+
+namespace {
+    Key node(int n)
+    {
+        std::stringstream ss;
+        ss << "bucketwl_n" << n;
+        return getKey(ss.str());
+    }
+
+    unsigned distance(ITrans const * t)
+    {
+        return dynamic_cast<ShortestPathSemiring*>(t->weight().get_ptr())->getNum();
+    }
+
+    WFA poststar(ref_ptr<Worklist<ITrans> > worklist)
+    {
+        Key p = getKey("p");
+        Key accept = getKey("accept");
+
+        // A diamond with a cheap and an expensive side, a loop, and a call
+        WPDS pds;
+        if (worklist.is_valid()) {
+            pds.setWorklist(worklist);
+        }
+        pds.add_rule(p, node(0), p, node(1), new ShortestPathSemiring(5));
+        pds.add_rule(p, node(0), p, node(2), new ShortestPathSemiring(1));
+        pds.add_rule(p, node(1), p, node(3), new ShortestPathSemiring(1));
+        pds.add_rule(p, node(2), p, node(3), new ShortestPathSemiring(2));
+        pds.add_rule(p, node(3), p, node(2), new ShortestPathSemiring(1));
+        pds.add_rule(p, node(3), p, node(10), node(4), new ShortestPathSemiring(3));
+        pds.add_rule(p, node(10), p, node(11), new ShortestPathSemiring(4));
+        pds.add_rule(p, node(11), p, new ShortestPathSemiring(0));
+
+        WFA query;
+        query.addTrans(p, node(0), accept, new ShortestPathSemiring(0));
+        query.setInitialState(p);
+        query.addFinalState(accept);
+        return pds.poststar(query);
+    }
+
+    std::string weightOf(WFA const & fa, int n)
+    {
+        Trans t;
+        if (fa.find(getKey("p"), node(n), getKey("accept"), t)) {
+            return t.weight()->toString();
+        }
+        return "none";
+    }
+}
+
+
+TEST(wali$BucketWorklist, getsInOrderOfRank)
+{
+    // Ranks 6 and up go to the overflow map
+    ShortestPathBucketWorklist wl(6);
+    unsigned dists[] = { 5, 1, 3, 1, 9, 0, 7, 3 };
+    std::vector<Trans*> ts;
+    for (size_t i = 0; i < sizeof(dists)/sizeof(dists[0]); ++i) {
+        ts.push_back(new Trans(getKey("p"), node(i), getKey("q"),
+                               new ShortestPathSemiring(dists[i])));
+        EXPECT_TRUE(wl.put(ts.back()));
+    }
+    EXPECT_FALSE(wl.put(ts[0]));
+    EXPECT_EQ(ts.size(), wl.size());
+
+    std::vector<unsigned> got;
+    got.push_back(distance(wl.get()));
+    got.push_back(distance(wl.get()));
+    got.push_back(distance(wl.get()));
+
+    // Behind the cursor
+    EXPECT_TRUE(wl.put(ts[5]));
+
+    while (!wl.empty()) {
+        got.push_back(distance(wl.get()));
+    }
+
+    unsigned expected[] = { 0, 1, 1, 0, 3, 3, 5, 7, 9 };
+    EXPECT_EQ(std::vector<unsigned>(expected, expected + 9), got);
+
+    for (size_t i = 0; i < ts.size(); ++i) {
+        EXPECT_FALSE(ts[i]->marked());
+        delete ts[i];
+    }
+}
+
+
+TEST(wali$BucketWorklist, clearUnmarksEverything)
+{
+    ShortestPathBucketWorklist wl(4);
+    Trans a(getKey("p"), node(0), getKey("q"), new ShortestPathSemiring(2));
+    Trans b(getKey("p"), node(1), getKey("q"), new ShortestPathSemiring(100));
+
+    wl.put(&a);
+    wl.put(&b);
+    wl.clear();
+
+    EXPECT_TRUE(wl.empty());
+    EXPECT_FALSE(a.marked());
+    EXPECT_FALSE(b.marked());
+}
+
+
+TEST(wali$wpds$WPDS$poststar, shortestPathBucketWorklistGivesTheSameAnswer)
+{
+    WFA plain = poststar(NULL);
+    WFA ranked = poststar(new ShortestPathWorklist());
+    WFA bucketed = poststar(new ShortestPathBucketWorklist());
+
+    for (int n = 0; n <= 11; ++n) {
+        EXPECT_EQ(weightOf(plain, n), weightOf(bucketed, n));
+        EXPECT_EQ(weightOf(ranked, n), weightOf(bucketed, n));
+    }
+    EXPECT_EQ("ShortestPathSemiring(3)", weightOf(bucketed, 3));
+}
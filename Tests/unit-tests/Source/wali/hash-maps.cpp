@@ -0,0 +1,124 @@
+#include "gtest/gtest.h"
+
+#include "wali/HashMap.hpp"
+#include "wali/OpenHashMap.hpp"
+#include "wali/KeyContainer.hpp"
+
+#include <map>
+
+using namespace wali;
+
+namespace {
+    template<typename Map>
+    class HashMapTest : public ::testing::Test {};
+
+    typedef ::testing::Types<
+        HashMap<KeyPair, int>,
+        OpenHashMap<KeyPair, int>
+    > MapTypes;
+
+    TYPED_TEST_CASE(HashMapTest, MapTypes);
+
+    KeyPair kp(int i)
+    {
+        return KeyPair(static_cast<Key>(i % 97), static_cast<Key>(i));
+    }
+}
+
+
+TYPED_TEST(HashMapTest, insertFindAndEraseAgreeWithStdMap)
+{
+    TypeParam map;
+    std::map<KeyPair, int> expected;
+
+    for (int i = 0; i < 2000; ++i) {
+        bool fresh = map.insert(kp(i * 7 % 1500), i).second;
+        bool expected_fresh = expected.insert(std::make_pair(kp(i * 7 % 1500), i)).second;
+        EXPECT_EQ(expected_fresh, fresh);
+    }
+    for (int i = 0; i < 1500; i += 3) {
+        map.erase(kp(i));
+        expected.erase(kp(i));
+    }
+
+    ASSERT_EQ(expected.size(), map.size());
+    for (int i = 0; i < 1600; ++i) {
+        typename TypeParam::iterator it = map.find(kp(i));
+        std::map<KeyPair, int>::iterator eit = expected.find(kp(i));
+        if (eit == expected.end()) {
+            EXPECT_TRUE(it == map.end());
+        }
+        else {
+            ASSERT_TRUE(it != map.end());
+            EXPECT_EQ(eit->second, it->second);
+        }
+    }
+
+    size_t count = 0;
+    for (typename TypeParam::const_iterator it = map.begin(); it != map.end(); ++it) {
+        EXPECT_EQ(expected[it->first], it->second);
+        ++count;
+    }
+    EXPECT_EQ(expected.size(), count);
+}
+
+
+TYPED_TEST(HashMapTest, eraseShrinksTheTable)
+{
+    TypeParam map;
+    size_t initial = map.capacity();
+
+    for (int i = 0; i < 5000; ++i) {
+        map.insert(kp(i), i);
+    }
+    size_t grown = map.capacity();
+    EXPECT_LT(initial, grown);
+
+    for (int i = 0; i < 4990; ++i) {
+        map.erase(kp(i));
+    }
+    EXPECT_EQ(10u, map.size());
+    EXPECT_GT(grown, map.capacity());
+    EXPECT_LE(initial, map.capacity());
+
+    for (int i = 4990; i < 5000; ++i) {
+        ASSERT_TRUE(map.find(kp(i)) != map.end());
+        EXPECT_EQ(i, map.find(kp(i))->second);
+    }
+}
+
+
+TYPED_TEST(HashMapTest, copiesAreIndependent)
+{
+    TypeParam map;
+    for (int i = 0; i < 100; ++i) {
+        map[kp(i)] = i;
+    }
+
+    TypeParam copy(map);
+    copy[kp(0)] = -1;
+    copy.erase(kp(1));
+
+    EXPECT_EQ(100u, map.size());
+    EXPECT_EQ(99u, copy.size());
+    EXPECT_EQ(0, map[kp(0)]);
+    EXPECT_EQ(-1, copy[kp(0)]);
+
+    map = copy;
+    EXPECT_EQ(99u, map.size());
+    EXPECT_TRUE(map.find(kp(1)) == map.end());
+}
+
+
+TEST(wali$OpenHashMap, referencesSurviveRehashing)
+{
+    OpenHashMap<KeyPair, int> map;
+    int & first = map[kp(0)];
+    first = 42;
+
+    for (int i = 1; i < 10000; ++i) {
+        map[kp(i)] = i;
+    }
+    EXPECT_EQ(&first, &(map.find(kp(0))->second));
+    EXPECT_EQ(42, first);
+}
@@ -0,0 +1,132 @@
+#include "gtest/gtest.h"
+
+#include "wali/Countable.hpp"
+#include "wali/ref_ptr.hpp"
+#include "wali/util/Threads.hpp"
+
+#include <vector>
+
+using namespace wali;
+
+namespace {
+    struct Tracked : public Countable
+    {
+        bool * deleted;
+        explicit Tracked(bool * d) : deleted(d) { *deleted = false; }
+        ~Tracked() { *deleted = true; }
+    };
+
+    struct Derived : public Tracked
+    {
+        explicit Derived(bool * d) : Tracked(d) {}
+    };
+
+    unsigned count(Tracked * t)
+    {
+        return t->count;
+    }
+}
+
+
+TEST(wali$ref_ptr, copiesShareAndLastReleaseDeletes)
+{
+    bool deleted;
+    Tracked * t = new Tracked(&deleted);
+    {
+        ref_ptr<Tracked> a(t);
+        EXPECT_EQ(1u, count(t));
+        {
+            ref_ptr<Tracked> b = a;
+            EXPECT_EQ(2u, count(t));
+        }
+        EXPECT_EQ(1u, count(t));
+        EXPECT_FALSE(deleted);
+    }
+    EXPECT_TRUE(deleted);
+}
+
+TEST(wali$ref_ptr, assigningReleasesTheOldObject)
+{
+    bool first_deleted, second_deleted;
+    ref_ptr<Tracked> p = new Tracked(&first_deleted);
+    p = new Tracked(&second_deleted);
+    EXPECT_TRUE(first_deleted);
+    EXPECT_FALSE(second_deleted);
+    p = 0;
+    EXPECT_TRUE(second_deleted);
+}
+
+TEST(wali$ref_ptr, assigningTheCountPinsTheObject)
+{
+    // As GenKillTransformer_T does for its one, zero, and bottom
+    bool deleted;
+    Tracked * t = new Tracked(&deleted);
+    t->count = 100;
+    {
+        ref_ptr<Tracked> a(t);
+        EXPECT_EQ(101u, count(t));
+    }
+    EXPECT_EQ(100u, count(t));
+    EXPECT_FALSE(deleted);
+
+    t->count = 0;
+    delete t;
+    EXPECT_TRUE(deleted);
+}
+
+#if WALI_REF_PTR_HAS_MOVE
+
+TEST(wali$ref_ptr, moveTransfersTheReference)
+{
+    bool deleted;
+    Tracked * t = new Tracked(&deleted);
+    ref_ptr<Tracked> a(t);
+
+    ref_ptr<Tracked> b(std::move(a));
+    EXPECT_TRUE(a.is_empty());
+    EXPECT_EQ(t, b.get_ptr());
+    EXPECT_EQ(1u, count(t));
+
+    ref_ptr<Tracked> c;
+    c = std::move(b);
+    EXPECT_TRUE(b.is_empty());
+    EXPECT_EQ(1u, count(t));
+
+    bool other_deleted;
+    ref_ptr<Derived> d = new Derived(&other_deleted);
+    ref_ptr<Tracked> e(std::move(d));
+    EXPECT_TRUE(d.is_empty());
+    EXPECT_EQ(1u, count(e.get_ptr()));
+
+    c = std::move(e);
+    EXPECT_TRUE(deleted);
+    EXPECT_FALSE(other_deleted);
+}
+
+#endif
+
+#if WALI_THREADS && WALI_ATOMIC_REFCOUNT
+
+TEST(wali$ref_ptr, concurrentCopiesKeepTheCount)
+{
+    bool deleted;
+    ref_ptr<Tracked> shared = new Tracked(&deleted);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.push_back(std::thread([&shared] {
+            for (int j = 0; j < 100000; ++j) {
+                ref_ptr<Tracked> copy = shared;
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+
+    EXPECT_EQ(1u, count(shared.get_ptr()));
+    shared = 0;
+    EXPECT_TRUE(deleted);
+}
+
+#endif
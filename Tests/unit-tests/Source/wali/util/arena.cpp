@@ -0,0 +1,173 @@
+#include "gtest/gtest.h"
+
+#include "wali/util/Arena.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wfa/Trans.hpp"
+#include "wali/wfa/TransFunctor.hpp"
+
+#include <sstream>
+
+using namespace wali;
+using namespace wali::util;
+using namespace wali::wpds;
+using namespace wali::wfa;
+
+namespace {
+    struct Counted
+    {
+        static int live;
+        int payload[5];
+        Counted() { ++live; }
+        virtual ~Counted() { --live; }
+    };
+    int Counted::live = 0;
+
+    Key node(int n)
+    {
+        std::stringstream ss;
+        ss << "arena_n" << n;
+        return getKey(ss.str());
+    }
+}
+
+
+TEST(wali$util$Arena, recyclesDeallocatedPiecesOfTheSameSize)
+{
+    Arena arena(1024);
+    void * a = arena.allocate(40);
+    void * b = arena.allocate(40);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(0u, reinterpret_cast<size_t>(a) % Arena::ALIGNMENT);
+    EXPECT_TRUE(arena.owns(a));
+    EXPECT_TRUE(arena.owns(static_cast<char*>(b) + 39));
+
+    arena.deallocate(a);
+    EXPECT_EQ(a, arena.allocate(40));
+
+    // A piece of another size does not reuse it
+    arena.deallocate(a);
+    EXPECT_NE(a, arena.allocate(24));
+
+    size_t reserved = arena.reserved();
+    void * big = arena.allocate(4096);
+    EXPECT_LT(reserved, arena.reserved());
+    EXPECT_TRUE(arena.owns(big));
+
+    arena.release();
+    EXPECT_EQ(0u, arena.reserved());
+    EXPECT_FALSE(arena.owns(a));
+}
+
+TEST(wali$util$Arena, resetKeepsSmallBlocksForPiecesOfAnySize)
+{
+    Arena arena(1000);
+    void * a = arena.allocate(40);
+    void * big = arena.allocate(4096);
+    EXPECT_EQ(1024u + 4096u, arena.reserved());
+
+    arena.reset();
+    EXPECT_EQ(1024u, arena.reserved());
+    EXPECT_FALSE(arena.owns(big));
+
+    // The kept block is carved up again, here for another piece size
+    EXPECT_EQ(a, arena.allocate(16));
+    EXPECT_EQ(1024u, arena.reserved());
+    EXPECT_FALSE(arena.owns(static_cast<char*>(a) + 1024));
+}
+
+TEST(wali$util$Arena, destroyRunsTheDestructorAndReusesThePiece)
+{
+    Arena arena;
+    Counted * on_heap = new Counted();
+    Counted * in_arena = new (arena) Counted();
+    EXPECT_EQ(2, Counted::live);
+    EXPECT_LT(0u, arena.reserved());
+    EXPECT_FALSE(arena.owns(on_heap));
+    EXPECT_TRUE(arena.owns(in_arena));
+
+    delete on_heap;
+    arena.destroy(in_arena);
+    EXPECT_EQ(0, Counted::live);
+
+    Counted * again = new (arena) Counted();
+    EXPECT_EQ(in_arena, again);
+    arena.destroy(again);
+}
+
+TEST(wali$wfa$WFA, clearKeepsTheArenaForTheNextTransitions)
+{
+    sem_elem_t one = ShortestPathSemiring(0).one();
+    WFA fa;
+    fa.useArena(true);
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 200; ++i) {
+            fa.addTrans(node(i), node(0), node(i+1), one);
+        }
+    }
+    // A transition from the heap is still deleted as usual
+    fa.addTrans(new Trans(node(300), node(1), node(301), one));
+    size_t reserved = fa.arena()->reserved();
+    EXPECT_LT(0u, reserved);
+
+    fa.clear();
+    EXPECT_EQ(reserved, fa.arena()->reserved());
+
+    for (int i = 0; i < 200; ++i) {
+        fa.addTrans(node(i), node(0), node(i+1), one);
+    }
+    TransCounter counter;
+    fa.for_each(counter);
+    EXPECT_EQ(200, counter.getNumTrans());
+    EXPECT_EQ(reserved, fa.arena()->reserved());
+}
+
+TEST(wali$wpds$WPDS$poststar, arenaAllocatedOutputMatchesHeapAllocatedOutput)
+{
+    Key p = getKey("p");
+    Key accept = getKey("accept");
+    sem_elem_t one = ShortestPathSemiring(0).one();
+    sem_elem_t zero = ShortestPathSemiring(0).zero();
+
+    WPDS heap_pds, arena_pds;
+    arena_pds.useArena(true);
+    EXPECT_FALSE(heap_pds.usesArena());
+    EXPECT_TRUE(arena_pds.usesArena());
+
+    for (int i = 0; i < 20; ++i) {
+        sem_elem_t w = new ShortestPathSemiring(1 + i % 3);
+        heap_pds.add_rule(p, node(i), p, node(i+1), w);
+        arena_pds.add_rule(p, node(i), p, node(i+1), w);
+        if (i % 4 == 1) {
+            heap_pds.add_rule(p, node(i), p, node(i+2), node(i+1), w);
+            arena_pds.add_rule(p, node(i), p, node(i+2), node(i+1), w);
+        }
+    }
+    heap_pds.add_rule(p, node(20), p, one);
+    arena_pds.add_rule(p, node(20), p, one);
+
+    WFA query;
+    query.addState(p, zero);
+    query.addState(accept, zero);
+    query.setInitialState(p);
+    query.addFinalState(accept);
+    query.addTrans(p, node(0), accept, one);
+
+    WFA heap_answer, arena_answer;
+    arena_answer.useArena(true);
+    EXPECT_TRUE(arena_answer.arena() != 0);
+    EXPECT_TRUE(heap_answer.arena() == 0);
+
+    heap_pds.poststar(query, heap_answer);
+    arena_pds.poststar(query, arena_answer);
+
+    TransCounter counter;
+    arena_answer.for_each(counter);
+    EXPECT_LT(20, counter.getNumTrans());
+    EXPECT_TRUE(heap_answer.equal(arena_answer));
+
+    WFA copy = arena_answer;
+    EXPECT_TRUE(copy.usesArena());
+    arena_answer.clear();
+    EXPECT_TRUE(heap_answer.equal(copy));
+}
@@ -2,8 +2,15 @@
 
 #include "wali/Key.hpp"
 #include "wali/Common.hpp"
+#include "wali/StringSource.hpp"
+#include "wali/IntSource.hpp"
+#include "wali/KeyPairSource.hpp"
+#include "wali/util/Threads.hpp"
 #include "opennwa/NwaFwd.hpp"
 
+#include <sstream>
+#include <vector>
+
 namespace wali {
 
     struct KeyFixture {
@@ -57,6 +64,71 @@ namespace wali {
     }
 
 
+    TEST(wali$getKey, keySourceOverloadAgreesWithRawValues)
+    {
+        KeyFixture keys;
+
+        EXPECT_EQ(keys.string_key, getKey(new StringSource("string")));
+        EXPECT_EQ(keys.int_key, getKey(new IntSource(12)));
+        EXPECT_EQ(keys.pair_key, getKey(new KeyPairSource(keys.string_key, keys.int_key)));
+
+        Key fresh = getKey(new StringSource("only made through a source"));
+        EXPECT_EQ(fresh, getKey("only made through a source"));
+    }
+
+
+    TEST(wali$getKey, stringsWithEmbeddedNulsAreDistinct)
+    {
+        std::string a_nul_b("a\0b", 3);
+        std::string a_nul_c("a\0c", 3);
+
+        Key k = getKey(a_nul_b);
+        EXPECT_NE(getKey("a"), k);
+        EXPECT_NE(getKey(a_nul_c), k);
+        EXPECT_EQ(k, getKey(std::string("a\0b", 3)));
+        EXPECT_EQ(k, getKey(new StringSource(a_nul_b)));
+        EXPECT_EQ(a_nul_b, key2str(k));
+    }
+
+#if WALI_THREADS
+    namespace {
+        void internStrings(int thread, std::vector<Key> * out)
+        {
+            for (int i = 0; i < 1000; ++i) {
+                std::stringstream ss;
+                // Half of the strings are shared between the threads
+                ss << "interned " << (i % 2 == 0 ? -1 : thread) << " " << i;
+                out->push_back(getKey(ss.str()));
+            }
+        }
+    }
+
+    TEST(wali$getKey, concurrentCallsAgree)
+    {
+        std::vector<Key> results[4];
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.push_back(std::thread(internStrings, t, &results[t]));
+        }
+        for (int t = 0; t < 4; ++t) {
+            threads[t].join();
+        }
+
+        for (int t = 0; t < 4; ++t) {
+            std::vector<Key> again;
+            internStrings(t, &again);
+            EXPECT_EQ(again, results[t]);
+            for (size_t i = 0; i < again.size(); i += 2) {
+                EXPECT_EQ(results[0][i], results[t][i]);
+            }
+        }
+        std::stringstream ss;
+        ss << "interned " << 3 << " " << 999;
+        EXPECT_EQ(ss.str(), key2str(results[3][999]));
+    }
+#endif
+
+
     TEST(wali$key2str, getStringRepresentation)
     {
         KeyFixture keys;
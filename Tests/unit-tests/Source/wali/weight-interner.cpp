@@ -0,0 +1,132 @@
+#include "gtest/gtest.h"
+
+#include "wali/WeightInterner.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wfa/TransFunctor.hpp"
+
+#include <sstream>
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wfa;
+
+namespace {
+    typedef InternedWeight<ShortestPathSemiring> Dist;
+
+    sem_elem_t dist(unsigned d)
+    {
+        return Dist::make(ShortestPathSemiring(d));
+    }
+
+    Key node(int n)
+    {
+        std::stringstream ss;
+        ss << "interner_n" << n;
+        return getKey(ss.str());
+    }
+}
+
+
+TEST(wali$WeightInterner, internReturnsTheFirstEqualWeight)
+{
+    WeightInterner table(sizeof(ShortestPathSemiring));
+    sem_elem_t a = new ShortestPathSemiring(3);
+    sem_elem_t b = new ShortestPathSemiring(3);
+    sem_elem_t c = new ShortestPathSemiring(4);
+
+    EXPECT_EQ(a.get_ptr(), table.intern(a).get_ptr());
+    EXPECT_EQ(a.get_ptr(), table.intern(b).get_ptr());
+    EXPECT_EQ(c.get_ptr(), table.intern(c).get_ptr());
+
+    EXPECT_EQ(2u, table.size());
+    EXPECT_EQ(3u, table.lookups());
+    EXPECT_EQ(1u, table.hits());
+    EXPECT_EQ(sizeof(ShortestPathSemiring), table.bytesSaved());
+    EXPECT_DOUBLE_EQ(1.0 / 3.0, table.hitRate());
+
+    // Only 'c' is still referenced from outside the table
+    a = b = NULL;
+    EXPECT_EQ(1u, table.purge());
+    EXPECT_EQ(1u, table.size());
+}
+
+TEST(wali$InternedWeight, equalResultsAreTheSameObject)
+{
+    sem_elem_t three = dist(3);
+    sem_elem_t sum = dist(1)->extend(dist(2));
+    EXPECT_EQ(three.get_ptr(), sum.get_ptr());
+    EXPECT_EQ(three.get_ptr(), three->combine(dist(7)).get_ptr());
+    EXPECT_EQ(three->zero().get_ptr(), dist(9)->zero().get_ptr());
+
+    EXPECT_TRUE(three->equal(sum));
+    EXPECT_FALSE(three->equal(dist(4)));
+
+    // Weights of the underlying domain still compare by value
+    sem_elem_t plain = new ShortestPathSemiring(3);
+    EXPECT_TRUE(three->equal(plain));
+    EXPECT_TRUE(plain->equal(three));
+    EXPECT_EQ(three.get_ptr(), Dist::canonicalize(plain).get_ptr());
+    EXPECT_EQ(three.get_ptr(), three->extend(plain->one()).get_ptr());
+
+    // A result that is already in the table is not copied
+    size_t copies = Dist::interner().copies();
+    sem_elem_t five = dist(5);
+    EXPECT_EQ(five.get_ptr(), dist(2)->extend(three).get_ptr());
+    EXPECT_EQ(copies, Dist::interner().copies());
+    dist(1000)->extend(five);
+    EXPECT_EQ(copies + 1, Dist::interner().copies());
+}
+
+TEST(wali$wpds$WPDS$poststar, internedWeightsMatchPlainWeights)
+{
+    Key p = getKey("p");
+    Key accept = getKey("accept");
+
+    WPDS plain_pds, interned_pds;
+    for (int i = 0; i < 20; ++i) {
+        unsigned d = 1 + i % 3;
+        plain_pds.add_rule(p, node(i), p, node(i+1), new ShortestPathSemiring(d));
+        interned_pds.add_rule(p, node(i), p, node(i+1), dist(d));
+        if (i % 4 == 1) {
+            plain_pds.add_rule(p, node(i), p, node(i+2), node(i+1), new ShortestPathSemiring(d));
+            interned_pds.add_rule(p, node(i), p, node(i+2), node(i+1), dist(d));
+        }
+    }
+    plain_pds.add_rule(p, node(20), p, new ShortestPathSemiring(0));
+    interned_pds.add_rule(p, node(20), p, dist(0));
+
+    WFA plain_query, interned_query;
+    plain_query.addState(p, ShortestPathSemiring(0).zero());
+    plain_query.addState(accept, ShortestPathSemiring(0).zero());
+    plain_query.setInitialState(p);
+    plain_query.addFinalState(accept);
+    plain_query.addTrans(p, node(0), accept, new ShortestPathSemiring(0));
+
+    interned_query.addState(p, dist(0)->zero());
+    interned_query.addState(accept, dist(0)->zero());
+    interned_query.setInitialState(p);
+    interned_query.addFinalState(accept);
+    interned_query.addTrans(p, node(0), accept, dist(0));
+
+    size_t lookups = Dist::interner().lookups();
+    size_t hits = Dist::interner().hits();
+
+    WFA plain_answer, interned_answer;
+    plain_pds.poststar(plain_query, plain_answer);
+    interned_pds.poststar(interned_query, interned_answer);
+
+    TransCounter counter;
+    interned_answer.for_each(counter);
+    EXPECT_LT(20, counter.getNumTrans());
+    EXPECT_TRUE(plain_answer.equal(interned_answer));
+
+    // Saturation recomputes the same few distances over and over
+    EXPECT_LT(lookups, Dist::interner().lookups());
+    EXPECT_LT(2 * (Dist::interner().lookups() - lookups),
+              3 * (Dist::interner().hits() - hits));
+
+    std::stringstream ss;
+    Dist::interner().print_stats(ss);
+    EXPECT_NE(std::string::npos, ss.str().find("bytes saved"));
+}
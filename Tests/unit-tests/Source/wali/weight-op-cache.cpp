@@ -0,0 +1,123 @@
+#include "gtest/gtest.h"
+
+#include "wali/WeightOpCache.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wpds/fwpds/FWPDS.hpp"
+
+#include <sstream>
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wpds::fwpds;
+using namespace wali::wfa;
+
+namespace {
+    typedef MemoizedWeight<ShortestPathSemiring> Dist;
+
+    sem_elem_t dist(unsigned d)
+    {
+        return Dist::make(ShortestPathSemiring(d));
+    }
+
+    Key node(int n)
+    {
+        std::stringstream ss;
+        ss << "opcache_n" << n;
+        return getKey(ss.str());
+    }
+}
+
+
+TEST(wali$WeightOpCache, clockEvictsEntriesThatWereNotUsed)
+{
+    WeightOpCache cache(2);
+    sem_elem_t a = new ShortestPathSemiring(1);
+    sem_elem_t b = new ShortestPathSemiring(2);
+    sem_elem_t r;
+
+    EXPECT_FALSE(cache.find(WeightOpCache::EXTEND, a.get_ptr(), b.get_ptr(), r));
+    cache.insert(WeightOpCache::EXTEND, a.get_ptr(), b.get_ptr(), a->extend(b));
+    cache.insert(WeightOpCache::COMBINE, a.get_ptr(), b.get_ptr(), a->combine(b));
+
+    EXPECT_TRUE(cache.find(WeightOpCache::EXTEND, a.get_ptr(), b.get_ptr(), r));
+    EXPECT_TRUE(r->equal(new ShortestPathSemiring(3)));
+
+    // The combine entry has not been used since it was added
+    cache.insert(WeightOpCache::EXTEND, b.get_ptr(), a.get_ptr(), b->extend(a));
+    EXPECT_EQ(2u, cache.size());
+    EXPECT_EQ(1u, cache.evictions());
+    EXPECT_TRUE(cache.find(WeightOpCache::EXTEND, a.get_ptr(), b.get_ptr(), r));
+    EXPECT_FALSE(cache.find(WeightOpCache::COMBINE, a.get_ptr(), b.get_ptr(), r));
+
+    EXPECT_EQ(2u, cache.hits());
+    EXPECT_EQ(2u, cache.misses());
+    EXPECT_DOUBLE_EQ(0.5, cache.hitRate());
+
+    // Weights that are not reference counted are not cached
+    ShortestPathSemiring on_stack(5);
+    cache.insert(WeightOpCache::EXTEND, &on_stack, a.get_ptr(), a);
+    EXPECT_FALSE(cache.find(WeightOpCache::EXTEND, &on_stack, a.get_ptr(), r));
+
+    cache.setCapacity(0);
+    cache.insert(WeightOpCache::COMBINE, a.get_ptr(), b.get_ptr(), a);
+    EXPECT_EQ(0u, cache.size());
+}
+
+TEST(wali$MemoizedWeight, repeatedOperationsHitTheCache)
+{
+    sem_elem_t two = dist(2), three = dist(3);
+    size_t hits = Dist::cache().hits();
+
+    sem_elem_t first = two->extend(three);
+    sem_elem_t second = two->extend(three);
+    EXPECT_EQ(first.get_ptr(), second.get_ptr());
+    EXPECT_EQ(hits + 1, Dist::cache().hits());
+    EXPECT_TRUE(first->equal(dist(5)));
+
+    // Results are memoized weights too
+    sem_elem_t sum = first->combine(three);
+    EXPECT_EQ(sum.get_ptr(), first->combine(three).get_ptr());
+    EXPECT_TRUE(sum->equal(three));
+    EXPECT_TRUE(dynamic_cast<Dist*>(two->one().get_ptr()) != 0);
+}
+
+TEST(wali$wpds$fwpds$FWPDS$poststar, memoizedWeightsMatchPlainWeights)
+{
+    Key p = getKey("p");
+    Key accept = getKey("accept");
+
+    FWPDS plain_pds, memo_pds;
+    for (int i = 0; i < 20; ++i) {
+        unsigned d = 1 + i % 3;
+        plain_pds.add_rule(p, node(i), p, node(i+1), new ShortestPathSemiring(d));
+        memo_pds.add_rule(p, node(i), p, node(i+1), dist(d));
+        if (i % 4 == 1) {
+            plain_pds.add_rule(p, node(i), p, node(i+2), node(i+1), new ShortestPathSemiring(d));
+            memo_pds.add_rule(p, node(i), p, node(i+2), node(i+1), dist(d));
+        }
+    }
+    plain_pds.add_rule(p, node(20), p, new ShortestPathSemiring(0));
+    memo_pds.add_rule(p, node(20), p, dist(0));
+
+    WFA plain_query, memo_query;
+    plain_query.addState(p, ShortestPathSemiring(0).zero());
+    plain_query.addState(accept, ShortestPathSemiring(0).zero());
+    plain_query.setInitialState(p);
+    plain_query.addFinalState(accept);
+    plain_query.addTrans(p, node(0), accept, new ShortestPathSemiring(0));
+
+    memo_query.addState(p, dist(0)->zero());
+    memo_query.addState(accept, dist(0)->zero());
+    memo_query.setInitialState(p);
+    memo_query.addFinalState(accept);
+    memo_query.addTrans(p, node(0), accept, dist(0));
+
+    WFA plain_answer, memo_answer;
+    plain_pds.poststar(plain_query, plain_answer);
+    memo_pds.poststar(memo_query, memo_answer);
+    EXPECT_TRUE(plain_answer.equal(memo_answer));
+
+    std::stringstream ss;
+    memo_pds.printStatistics(ss);
+    EXPECT_NE(std::string::npos, ss.str().find("WeightOpCache"));
+}
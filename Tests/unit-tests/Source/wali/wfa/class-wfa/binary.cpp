@@ -0,0 +1,130 @@
+#include <sstream>
+#include <cstdlib>
+
+#include "gtest/gtest.h"
+#include "wali/wfa/WFA.hpp"
+#include "wali/wfa/WfaImage.hpp"
+#include "wali/wfa/State.hpp"
+#include "wali/WeightFactory.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+
+#include "fixtures.hpp"
+
+using namespace testing;
+
+namespace wali {
+    namespace wfa {
+
+        struct ReachFactory : WeightFactory
+        {
+            int made;
+            ReachFactory() : made(0) {}
+
+            sem_elem_t getWeight(std::string s) {
+                ++made;
+                return new Reach(s == "ONE");
+            }
+        };
+
+        struct DistanceFactory : WeightFactory
+        {
+            sem_elem_t getWeight(std::string s) {
+                // "ShortestPathSemiring(<n>)"
+                std::string digits = s.substr(s.find('(') + 1);
+                return new ShortestPathSemiring(std::strtoul(digits.c_str(), NULL, 10));
+            }
+        };
+
+        static std::string
+        marshalled(WFA const & wfa)
+        {
+            std::stringstream ss;
+            wfa.marshall(ss);
+            return ss.str();
+        }
+
+        static void
+        expect_binary_matches_marshall(WFA const & wfa, WeightFactory & weights)
+        {
+            std::stringstream binary;
+            marshallBinary(wfa, binary);
+
+            WFA again;
+            WfaImage(binary).addTo(again, weights);
+
+            EXPECT_EQ(marshalled(wfa), marshalled(again));
+        }
+
+        TEST(wali$wfa$$marshallBinary, agreesWithMarshallOnFixtures)
+        {
+            ReachFactory reach;
+            {
+                SCOPED_TRACE("LoopReject");
+                expect_binary_matches_marshall(LoopReject().wfa, reach);
+            }
+            {
+                SCOPED_TRACE("LoopAccept");
+                expect_binary_matches_marshall(LoopAccept().wfa, reach);
+            }
+            {
+                SCOPED_TRACE("EvenAsEvenBs");
+                expect_binary_matches_marshall(EvenAsEvenBs().wfa, reach);
+            }
+            {
+                SCOPED_TRACE("EpsilonTransitionToAccepting");
+                expect_binary_matches_marshall(EpsilonTransitionToAccepting().wfa, reach);
+            }
+        }
+
+        TEST(wali$wfa$$marshallBinary, keepsWeightsQueryAndAcceptWeights)
+        {
+            sem_elem_t zero = ShortestPathSemiring().zero();
+            Letters l;
+            Key p = getKey("binary_p"), q = getKey("binary_q");
+
+            WFA wfa(WFA::REVERSE);
+            wfa.addState(p, zero);
+            wfa.addState(q, zero);
+            wfa.setInitialState(p);
+            wfa.addFinalState(q, new ShortestPathSemiring(7));
+            wfa.addTrans(p, l.a, q, new ShortestPathSemiring(3));
+            wfa.addTrans(p, l.b, q, new ShortestPathSemiring(5));
+            wfa.addTrans(q, l.a, p, new ShortestPathSemiring(3));
+
+            DistanceFactory distances;
+            expect_binary_matches_marshall(wfa, distances);
+
+            std::stringstream binary;
+            marshallBinary(wfa, binary);
+            WFA again;
+            WfaImage(binary).addTo(again, distances);
+
+            EXPECT_EQ(WFA::REVERSE, again.getQuery());
+            EXPECT_TRUE(again.getState(q)->acceptWeight()->equal(new ShortestPathSemiring(7)));
+        }
+
+        TEST(wali$wfa$WfaImage, parsesEachDistinctWeightOnce)
+        {
+            EvenAsEvenBs fixture;
+
+            std::stringstream binary;
+            marshallBinary(fixture.wfa, binary);
+            WfaImage image(binary);
+            EXPECT_EQ(4u, image.numStates());
+            EXPECT_EQ(8u, image.numTrans());
+
+            // Just ONE and ZERO
+            ReachFactory reach;
+            WFA again;
+            image.addTo(again, reach);
+            EXPECT_EQ(2, reach.made);
+        }
+
+        TEST(wali$wfa$WfaImage, rejectsOtherInput)
+        {
+            std::stringstream xml(marshalled(LoopReject().wfa));
+            EXPECT_THROW(WfaImage image(xml), util::BadImageException);
+        }
+
+    }
+}
@@ -0,0 +1,204 @@
+#include "gtest/gtest.h"
+#include "wali/wfa/WFA.hpp"
+#include "wali/wfa/State.hpp"
+#include "wali/wfa/Trans.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wpds/WPDS.hpp"
+
+#include <sstream>
+#include <vector>
+
+namespace wali {
+    namespace wfa {
+
+        namespace {
+            Key ts_key(char const * prefix, int n)
+            {
+                std::stringstream ss;
+                ss << prefix << n;
+                return getKey(ss.str());
+            }
+
+            /// A WFA with a few hundred transitions, many sharing a
+            /// (from, stack) pair, plus some dead states for prune
+            void build(WFA & wfa, int states)
+            {
+                sem_elem_t zero = ShortestPathSemiring(0).zero();
+                for (int i = 0; i < states; ++i) {
+                    wfa.addState(ts_key("ts_q", i), zero);
+                }
+                wfa.setInitialState(ts_key("ts_q", 0));
+                wfa.addFinalState(ts_key("ts_q", states - 1));
+                for (int i = 0; i < states; ++i) {
+                    for (int j = 0; j < 5; ++j) {
+                        int to = (i * 7 + j * 13 + 1) % states;
+                        sem_elem_t w = new ShortestPathSemiring(1 + (i + j) % 4);
+                        wfa.addTrans(ts_key("ts_q", i), ts_key("ts_s", j % 2),
+                                     ts_key("ts_q", to), w);
+                    }
+                    wfa.addTrans(ts_key("ts_q", i), ts_key("ts_s", 0),
+                                 ts_key("ts_dead", i),
+                                 ShortestPathSemiring(0).one());
+                }
+            }
+        }
+
+
+        TEST(wali$wfa$TransSet$flat, findsAndErasesAcrossTheSortedIndex)
+        {
+            TransSet tree;
+            TransSet flat(TransSet::FLAT);
+            EXPECT_EQ(TransSet::TREE, tree.representation());
+            EXPECT_EQ(TransSet::FLAT, flat.representation());
+
+            std::vector<Trans*> trans;
+            Key p = getKey("ts_p");
+            for (int i = 0; i < 100; ++i) {
+                // Out of key order, so both the index and the tail matter
+                Key stack = ts_key("ts_g", (i * 37) % 100);
+                trans.push_back(new Trans(p, stack, p, 0));
+                EXPECT_TRUE(tree.insert(trans.back()));
+                EXPECT_TRUE(flat.insert(trans.back()));
+            }
+            EXPECT_EQ(100u, flat.size());
+
+            for (int i = 0; i < 100; ++i) {
+                Key stack = ts_key("ts_g", i);
+                TransSet::const_iterator it = flat.find(p, stack, p);
+                ASSERT_TRUE(it != flat.end());
+                EXPECT_EQ(*tree.find(p, stack, p), *it);
+            }
+            EXPECT_TRUE(flat.find(p, p, p) == flat.end());
+
+            // Insertion order is kept
+            int n = 0;
+            for (TransSet::iterator it = flat.begin(); it != flat.end(); ++it) {
+                EXPECT_EQ(trans[n++], *it);
+            }
+
+            // Erase every third one, including from the middle of a walk
+            TransSet::iterator it = flat.begin();
+            for (int i = 0; it != flat.end(); ++i) {
+                if (i % 3 == 0) {
+                    it = flat.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+            EXPECT_EQ(66u, flat.size());
+            for (int i = 0; i < 100; ++i) {
+                Key stack = trans[i]->stack();
+                EXPECT_EQ(i % 3 != 0, flat.find(p, stack, p) != flat.end());
+            }
+
+            flat.setRepresentation(TransSet::TREE);
+            EXPECT_EQ(TransSet::TREE, flat.representation());
+            EXPECT_EQ(66u, flat.size());
+            EXPECT_TRUE(flat.find(trans[1]) != flat.end());
+
+            for (size_t i = 0; i < trans.size(); ++i) {
+                delete trans[i];
+            }
+        }
+
+        TEST(wali$wfa$TransSet$flat, iteratorsSurviveInsertion)
+        {
+            TransSet flat(TransSet::FLAT);
+            std::vector<Trans*> trans;
+            Key p = getKey("ts_p");
+            trans.push_back(new Trans(p, ts_key("ts_g", 0), p, 0));
+            flat.insert(trans.back());
+
+            TransSet::iterator end = flat.end();
+            int seen = 0;
+            for (TransSet::iterator it = flat.begin(); it != end; ++it) {
+                ++seen;
+                if (trans.size() < 50) {
+                    trans.push_back(new Trans(p, ts_key("ts_g", trans.size()), p, 0));
+                    flat.insert(trans.back());
+                }
+            }
+            EXPECT_EQ(50, seen);
+
+            for (size_t i = 0; i < trans.size(); ++i) {
+                delete trans[i];
+            }
+        }
+
+        TEST(wali$wfa$WFA$setTransSetRepresentation, flatWfaGivesTheSameAnswers)
+        {
+            WFA tree, flat;
+            flat.setTransSetRepresentation(TransSet::FLAT);
+            build(tree, 60);
+            build(flat, 60);
+
+            WFA converted;
+            build(converted, 60);
+            converted.setTransSetRepresentation(TransSet::FLAT);
+            EXPECT_EQ(TransSet::FLAT, converted.transSetRepresentation());
+            EXPECT_TRUE(tree.equal(flat));
+            EXPECT_TRUE(tree.equal(converted));
+
+            WFA copy = flat;
+            EXPECT_EQ(TransSet::FLAT, copy.transSetRepresentation());
+
+            WFA tree_product, flat_product;
+            flat_product.setTransSetRepresentation(TransSet::FLAT);
+            tree.intersect(tree, tree_product);
+            flat.intersect(flat, flat_product);
+            EXPECT_TRUE(tree_product.equal(flat_product));
+
+            tree.prune();
+            flat.prune();
+            EXPECT_TRUE(tree.equal(flat));
+            EXPECT_EQ(0, flat.getState(ts_key("ts_dead", 3)));
+
+            tree.path_summary();
+            flat.path_summary();
+            Key init = tree.getInitialState();
+            EXPECT_TRUE(tree.getState(init)->weight()->equal(
+                            flat.getState(init)->weight()));
+        }
+
+        TEST(wali$wfa$WFA$setTransSetRepresentation, flatSaturationGivesTheSameAnswers)
+        {
+            Key p = getKey("ts_p");
+            Key accept = getKey("ts_accept");
+            sem_elem_t one = ShortestPathSemiring(0).one();
+            sem_elem_t zero = ShortestPathSemiring(0).zero();
+
+            wpds::WPDS pds;
+            for (int i = 0; i < 30; ++i) {
+                sem_elem_t w = new ShortestPathSemiring(1 + i % 3);
+                pds.add_rule(p, ts_key("ts_n", i), p, ts_key("ts_n", i+1), w);
+                if (i % 4 == 1) {
+                    pds.add_rule(p, ts_key("ts_n", i), p, ts_key("ts_n", i+2),
+                                 ts_key("ts_n", i+1), w);
+                }
+            }
+            pds.add_rule(p, ts_key("ts_n", 30), p, one);
+
+            WFA query;
+            query.addState(p, zero);
+            query.addState(accept, zero);
+            query.setInitialState(p);
+            query.addFinalState(accept);
+            query.addTrans(p, ts_key("ts_n", 0), accept, one);
+            query.addTrans(p, ts_key("ts_n", 30), accept, one);
+
+            WFA tree_post, flat_post, tree_pre, flat_pre;
+            flat_post.setTransSetRepresentation(TransSet::FLAT);
+            flat_pre.setTransSetRepresentation(TransSet::FLAT);
+
+            pds.poststar(query, tree_post);
+            pds.poststar(query, flat_post);
+            EXPECT_TRUE(tree_post.equal(flat_post));
+
+            pds.prestar(query, tree_pre);
+            pds.prestar(query, flat_pre);
+            EXPECT_TRUE(tree_pre.equal(flat_pre));
+        }
+
+    }
+}
@@ -0,0 +1,210 @@
+#include "gtest/gtest.h"
+
+#include "wali/Key.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wfa/WFA.hpp"
+#include "wali/wfa/Trans.hpp"
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wpds/ewpds/EWPDS.hpp"
+#include "wali/witness/Witness.hpp"
+#include "wali/witness/WitnessWrapper.hpp"
+#include "wali/witness/CompactWitness.hpp"
+#include "wali/witness/WitnessExtend.hpp"
+#include "wali/witness/WitnessCombine.hpp"
+#include "wali/witness/WitnessMerge.hpp"
+#include "wali/witness/WitnessRule.hpp"
+#include "wali/witness/WitnessTrans.hpp"
+#include "wali/witness/Visitor.hpp"
+
+#include <sstream>
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wfa;
+using namespace wali::witness;
+using wali::wpds::ewpds::EWPDS;
+
+namespace {
+    Key node(int n)
+    {
+        std::stringstream ss;
+        ss << "compactw_n" << n;
+        return getKey(ss.str());
+    }
+
+    /// Writes a witness tree in prefix form, with the weight of each node
+    struct Shape : public wali::witness::Visitor
+    {
+        std::stringstream out;
+
+        void node(char const * kind, Witness * w)
+        {
+            out << kind << "[" << w->weight()->toString() << "] ";
+        }
+
+        virtual bool visit( Witness * w )               { node("W", w); return true; }
+        virtual bool visitExtend( WitnessExtend * w )   { node("E", w); return true; }
+        virtual bool visitMerge( WitnessMerge * w )     { node("M", w); return true; }
+
+        virtual bool visitCombine( WitnessCombine * w )
+        {
+            out << w->children().size();
+            node("C", w);
+            return true;
+        }
+
+        virtual bool visitRule( WitnessRule * w )
+        {
+            out << key2str(w->getRuleStub().from_stack()) << "->"
+                << key2str(w->getRuleStub().to_stack1()) << " ";
+            node("R", w);
+            return true;
+        }
+
+        virtual bool visitTrans( WitnessTrans * w )
+        {
+            out << key2str(w->getTrans().stack()) << " ";
+            node("T", w);
+            return true;
+        }
+    };
+
+    std::string shapeOf(witness_t w)
+    {
+        Shape shape;
+        w->accept(shape);
+        return shape.out.str();
+    }
+
+    /// Adds a diamond with a cheap and an expensive side, a loop, and a
+    /// call (with a merge function, if epds is given; it must be pds)
+    void addRules(WPDS & pds, EWPDS * epds)
+    {
+        Key p = getKey("p");
+        pds.add_rule(p, node(0), p, node(1), new ShortestPathSemiring(5));
+        pds.add_rule(p, node(0), p, node(2), new ShortestPathSemiring(1));
+        pds.add_rule(p, node(1), p, node(3), new ShortestPathSemiring(1));
+        pds.add_rule(p, node(2), p, node(3), new ShortestPathSemiring(2));
+        pds.add_rule(p, node(3), p, node(2), new ShortestPathSemiring(1));
+        if (epds != NULL) {
+            sem_elem_t one = new ShortestPathSemiring(0);
+            epds->add_rule(p, node(3), p, node(10), node(4), new ShortestPathSemiring(3),
+                           new MergeFn(one));
+        }
+        else {
+            pds.add_rule(p, node(3), p, node(10), node(4), new ShortestPathSemiring(3));
+        }
+        pds.add_rule(p, node(10), p, node(11), new ShortestPathSemiring(4));
+        pds.add_rule(p, node(11), p, new ShortestPathSemiring(0));
+    }
+
+    WFA poststar(WPDS & pds)
+    {
+        Key p = getKey("p");
+        Key accept = getKey("accept");
+        WFA query;
+        query.addTrans(p, node(0), accept, new ShortestPathSemiring(0));
+        query.setInitialState(p);
+        query.addFinalState(accept);
+        return pds.poststar(query);
+    }
+
+    witness_t witnessOf(WFA const & fa, int n)
+    {
+        Trans t;
+        if (!fa.find(getKey("p"), node(n), getKey("accept"), t)) {
+            return NULL;
+        }
+        CompactWitness * compact = dynamic_cast<CompactWitness*>(t.weight().get_ptr());
+        if (compact != NULL) {
+            return compact->witness();
+        }
+        return dynamic_cast<Witness*>(t.weight().get_ptr());
+    }
+
+    void expectSameWitnesses(WFA const & eager, WFA const & compact)
+    {
+        for (int n = 0; n <= 11; ++n) {
+            witness_t e = witnessOf(eager, n);
+            witness_t c = witnessOf(compact, n);
+            ASSERT_EQ(e.is_valid(), c.is_valid());
+            if (e.is_valid()) {
+                EXPECT_TRUE(e->weight()->equal(c->weight()));
+                EXPECT_EQ(shapeOf(e), shapeOf(c));
+            }
+        }
+    }
+}
+
+
+TEST(wali$witness$CompactWitness, wpdsPoststarGivesTheSameWitnesses)
+{
+    WPDS eagerPds(new WitnessWrapper());
+    addRules(eagerPds, NULL);
+    WFA eager = poststar(eagerPds);
+
+    ref_ptr<CompactWitnessWrapper> wrapper = new CompactWitnessWrapper();
+    WPDS compactPds(wrapper);
+    addRules(compactPds, NULL);
+    WFA compact = poststar(compactPds);
+
+    expectSameWitnesses(eager, compact);
+    EXPECT_EQ("ShortestPathSemiring(3)", witnessOf(compact, 3)->weight()->toString());
+    EXPECT_GT(wrapper->log()->size(), 2u);
+}
+
+
+TEST(wali$witness$CompactWitness, ewpdsPoststarGivesTheSameWitnesses)
+{
+    EWPDS eagerPds(new WitnessWrapper());
+    addRules(eagerPds, &eagerPds);
+    WFA eager = poststar(eagerPds);
+
+    EWPDS compactPds(new CompactWitnessWrapper());
+    addRules(compactPds, &compactPds);
+    WFA compact = poststar(compactPds);
+
+    expectSameWitnesses(eager, compact);
+    // The return to node 4 goes through the merge
+    EXPECT_NE(std::string::npos, shapeOf(witnessOf(compact, 4)).find("M["));
+}
+
+
+TEST(wali$witness$CompactWitness, oneAndZeroAreNotLogged)
+{
+    witness_log_t log = new WitnessLog();
+    sem_elem_t user_five = new ShortestPathSemiring(5);
+    sem_elem_t five = new CompactWitness(user_five, log, log->leaf(new Witness(user_five)));
+    sem_elem_t one = five->one();
+    sem_elem_t zero = five->zero();
+
+    EXPECT_EQ(five.get_ptr(), five->extend(one).get_ptr());
+    EXPECT_EQ(five.get_ptr(), one->extend(five).get_ptr());
+    EXPECT_EQ(five.get_ptr(), five->combine(zero).get_ptr());
+    EXPECT_EQ(five.get_ptr(), zero->combine(five).get_ptr());
+    EXPECT_EQ(3u, log->size());
+}
+
+
+TEST(wali$witness$CompactWitness, deadStepsAreFreedAndReused)
+{
+    witness_log_t log = new WitnessLog();
+    sem_elem_t user_five = new ShortestPathSemiring(5);
+    sem_elem_t five = new CompactWitness(user_five, log, log->leaf(new Witness(user_five)));
+    {
+        sem_elem_t ten = five->extend(five);
+        sem_elem_t twenty = ten->extend(ten);
+        EXPECT_EQ(5u, log->size());
+    }
+    EXPECT_EQ(3u, log->size());
+
+    size_t bytes = log->bytes();
+    sem_elem_t ten = five->extend(five);
+    EXPECT_EQ(bytes, log->bytes());
+    EXPECT_EQ("ShortestPathSemiring(10)",
+              dynamic_cast<CompactWitness*>(ten.get_ptr())->witness()->weight()->toString());
+
+    five = NULL;
+    ten = NULL;
+    EXPECT_EQ(2u, log->size());
+}
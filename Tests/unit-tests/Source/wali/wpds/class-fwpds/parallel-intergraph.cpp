@@ -0,0 +1,107 @@
+#include "gtest/gtest.h"
+
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/graph/InterGraph.hpp"
+#include "wali/wpds/fwpds/FWPDS.hpp"
+#include "wali/wfa/TransFunctor.hpp"
+
+#include <sstream>
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wpds::fwpds;
+using namespace wali::wfa;
+
+namespace {
+    Key node(int proc, int n)
+    {
+        std::stringstream ss;
+        ss << "igr_p" << proc << "_" << n;
+        return getKey(ss.str());
+    }
+
+    sem_elem_t dist(unsigned d)
+    {
+        return new ShortestPathSemiring(d);
+    }
+
+    /// Procedure 0 calls 1 and 2, which both call 3 and 4, and so on, so
+    /// that several procedures (and so several SCCs of the InterGraph)
+    /// can be solved at the same time. Procedure 5 is recursive.
+    struct Program
+    {
+        enum { PROCS = 8 };
+
+        Key p, accept;
+        FWPDS fwpds;
+
+        Program()
+            : p(getKey("p"))
+            , accept(getKey("accept"))
+        {
+            for (int proc = 0; proc < PROCS; ++proc) {
+                for (int i = 0; i < 6; ++i) {
+                    int callee = 2 * proc + 1 + i % 2;
+                    if (i % 3 == 1 && callee < PROCS) {
+                        fwpds.add_rule(p, node(proc, i), p, node(callee, 0), node(proc, i+1), dist(1 + i));
+                    }
+                    else {
+                        fwpds.add_rule(p, node(proc, i), p, node(proc, i+1), dist(1 + (proc + i) % 4));
+                    }
+                }
+                fwpds.add_rule(p, node(proc, 4), p, node(proc, 2), dist(3));
+                fwpds.add_rule(p, node(proc, 6), p, dist(0));
+            }
+            fwpds.add_rule(p, node(5, 3), p, node(5, 0), node(5, 4), dist(2));
+        }
+
+        WFA query(int proc, int n) const
+        {
+            WFA q;
+            q.addState(p, dist(0)->zero());
+            q.addState(accept, dist(0)->zero());
+            q.setInitialState(p);
+            q.addFinalState(accept);
+            q.addTrans(p, node(proc, n), accept, dist(0));
+            return q;
+        }
+    };
+}
+
+TEST(wali$graph$InterGraph$setWorkerThreads, defaultsToSequential)
+{
+    graph::InterGraph igr(dist(0), false, false);
+    EXPECT_EQ(1u, igr.getWorkerThreads());
+    igr.setWorkerThreads(3);
+    EXPECT_EQ(3u, igr.getWorkerThreads());
+}
+
+TEST(wali$wpds$fwpds$FWPDS$poststar, parallelInterGraphMatchesSequential)
+{
+    Program sequential, parallel;
+    parallel.fwpds.setWorkerThreads(4);
+
+    WFA expected, actual;
+    sequential.fwpds.poststar(sequential.query(0, 0), expected);
+    parallel.fwpds.poststar(parallel.query(0, 0), actual);
+
+    TransCounter counter;
+    actual.for_each(counter);
+    EXPECT_LT(int(Program::PROCS), counter.getNumTrans());
+    EXPECT_TRUE(expected.equal(actual));
+}
+
+TEST(wali$wpds$fwpds$FWPDS$prestar, parallelInterGraphMatchesSequential)
+{
+    Program sequential, parallel;
+    parallel.fwpds.setWorkerThreads(4);
+
+    WFA expected, actual;
+    sequential.fwpds.prestar(sequential.query(0, 6), expected);
+    parallel.fwpds.prestar(parallel.query(0, 6), actual);
+
+    TransCounter counter;
+    actual.for_each(counter);
+    EXPECT_LT(int(Program::PROCS), counter.getNumTrans());
+    EXPECT_TRUE(expected.equal(actual));
+}
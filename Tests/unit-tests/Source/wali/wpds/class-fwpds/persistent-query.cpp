@@ -0,0 +1,145 @@
+#include "gtest/gtest.h"
+
+#include "wali/wfa/Trans.hpp"
+#include "wali/wpds/fwpds/FWPDS.hpp"
+
+#include "wali/wpds/fixtures.hpp"
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wpds::fwpds;
+using namespace wali::wfa;
+
+TEST(wali$wpds$fwpds$FWPDS$persistentPoststar, weightChangesAreResolvedIncrementally)
+{
+    Program<FWPDS> persistent(shortestPath, 5, 3, 2);
+    WFA output;
+    persistent.pds.persistentPoststar(persistent.query("main", 0), output);
+    EXPECT_TRUE(persistent.pds.hasPersistentQuery());
+
+    // Both cheaper and more expensive weights
+    unsigned const weights[][3] = { {1, 3, 2}, {7, 1, 9}, {7, 1, 9}, {2, 6, 0} };
+    for (size_t i = 0; i < sizeof(weights) / sizeof(weights[0]); ++i) {
+        persistent.reweight(weights[i][0], weights[i][1], weights[i][2]);
+        EXPECT_TRUE(persistent.pds.resolve(output));
+
+        Program<FWPDS> fresh(shortestPath, weights[i][0], weights[i][1], weights[i][2]);
+        WFA expected;
+        fresh.pds.poststar(fresh.query("main", 0), expected);
+        EXPECT_TRUE(expected.equal(output));
+    }
+}
+
+TEST(wali$wpds$fwpds$FWPDS$persistentPoststar, weightChangesAreResolvedOnWorkerThreads)
+{
+    // With threads, each IntraGraph has its own RegExpDag
+    Program<FWPDS> persistent(shortestPath, 5, 3, 2);
+    persistent.pds.setWorkerThreads(4);
+    WFA output;
+    persistent.pds.persistentPoststar(persistent.query("main", 0), output);
+
+    persistent.reweight(7, 1, 9);
+    EXPECT_TRUE(persistent.pds.resolve(output));
+
+    Program<FWPDS> fresh(shortestPath, 7, 1, 9);
+    WFA expected;
+    fresh.pds.poststar(fresh.query("main", 0), expected);
+    EXPECT_TRUE(expected.equal(output));
+}
+
+TEST(wali$wpds$fwpds$FWPDS$persistentPrestar, weightChangesAreResolvedIncrementally)
+{
+    Program<FWPDS> persistent(shortestPath, 5, 3, 2);
+    WFA output;
+    persistent.pds.persistentPrestar(persistent.query("main", 6), output);
+
+    persistent.reweight(1, 8, 4);
+    EXPECT_TRUE(persistent.pds.resolve(output));
+
+    Program<FWPDS> fresh(shortestPath, 1, 8, 4);
+    WFA expected;
+    fresh.pds.prestar(fresh.query("main", 6), expected);
+    EXPECT_TRUE(expected.equal(output));
+}
+
+TEST(wali$wpds$fwpds$FWPDS$persistentPoststar, addedAndErasedRulesAreSolvedAgain)
+{
+    Program<FWPDS> persistent(shortestPath, 5, 3, 2);
+    WFA output;
+    persistent.pds.persistentPoststar(persistent.query("main", 0), output);
+
+    Program<FWPDS> fresh(shortestPath, 5, 3, 2);
+    Key p = fresh.p;
+    persistent.pds.add_rule(p, programNode("f", 1), p, programNode("f", 4), shortestPath(1));
+    fresh.pds.add_rule(p, programNode("f", 1), p, programNode("f", 4), shortestPath(1));
+    EXPECT_FALSE(persistent.pds.resolve(output));
+
+    WFA expected;
+    fresh.pds.poststar(fresh.query("main", 0), expected);
+    EXPECT_TRUE(expected.equal(output));
+
+    // The query is still persistent after solving it again
+    persistent.pds.erase_rule(p, programNode("f", 1), p, programNode("f", 4), WALI_EPSILON);
+    persistent.reweight(2, 2, 2);
+    EXPECT_FALSE(persistent.pds.resolve(output));
+    persistent.reweight(1, 1, 1);
+    EXPECT_TRUE(persistent.pds.resolve(output));
+
+    Program<FWPDS> fresh2(shortestPath, 1, 1, 1);
+    fresh2.pds.poststar(fresh2.query("main", 0), expected);
+    EXPECT_TRUE(expected.equal(output));
+
+    persistent.pds.clearPersistentQuery();
+    EXPECT_FALSE(persistent.pds.hasPersistentQuery());
+}
+
+static sem_elem_t
+weightOf(WFA const & fa, Key p, Key g, Key q)
+{
+    Trans t;
+    EXPECT_TRUE(fa.find(p, g, q, t));
+    return t.weight();
+}
+
+TEST(wali$wpds$fwpds$FWPDS$persistentPrestar, popRuleWeightChangesAreResolved)
+{
+    // In prestar, a pop rule's weight is on the source node of its
+    // transition rather than on an edge
+    Key p = getKey("p"), accept = getKey("accept");
+    Key a = getKey("pop_a"), b = getKey("pop_b"), c = getKey("pop_c");
+    Key d = getKey("pop_d"), e = getKey("pop_e");
+    FWPDS pds;
+    pds.add_rule(p, a, p, b, shortestPath(1));
+    pds.add_rule(p, b, p, c, d, shortestPath(2));
+    pds.add_rule(p, c, p, shortestPath(5));
+    pds.add_rule(p, d, p, e, shortestPath(3));
+
+    WFA query;
+    query.addState(p, shortestPath(0)->zero());
+    query.addState(accept, shortestPath(0)->zero());
+    query.setInitialState(p);
+    query.addFinalState(accept);
+    query.addTrans(p, e, accept, shortestPath(0));
+
+    WFA output;
+    pds.persistentPrestar(query, output);
+    EXPECT_TRUE(weightOf(output, p, a, accept)->equal(shortestPath(11)));
+
+    pds.replace_rule(p, c, p, shortestPath(100));
+    EXPECT_TRUE(pds.resolve(output));
+    EXPECT_TRUE(weightOf(output, p, c, p)->equal(shortestPath(100)));
+    EXPECT_TRUE(weightOf(output, p, b, accept)->equal(shortestPath(105)));
+    EXPECT_TRUE(weightOf(output, p, a, accept)->equal(shortestPath(106)));
+
+    pds.replace_rule(p, c, p, shortestPath(4));
+    EXPECT_TRUE(pds.resolve(output));
+
+    FWPDS fresh;
+    fresh.add_rule(p, a, p, b, shortestPath(1));
+    fresh.add_rule(p, b, p, c, d, shortestPath(2));
+    fresh.add_rule(p, c, p, shortestPath(4));
+    fresh.add_rule(p, d, p, e, shortestPath(3));
+    WFA expected;
+    fresh.prestar(query, expected);
+    EXPECT_TRUE(expected.equal(output));
+}
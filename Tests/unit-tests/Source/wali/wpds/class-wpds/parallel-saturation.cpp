@@ -0,0 +1,46 @@
+#include "gtest/gtest.h"
+
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wfa/TransFunctor.hpp"
+
+#include "wali/wpds/fixtures.hpp"
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wfa;
+
+TEST(wali$wpds$WPDS$setWorkerThreads, defaultsToSequential)
+{
+    WPDS wpds;
+    EXPECT_EQ(1u, wpds.getWorkerThreads());
+    wpds.setWorkerThreads(4);
+    EXPECT_EQ(4u, wpds.getWorkerThreads());
+}
+
+TEST(wali$wpds$WPDS$poststar, parallelSaturationMatchesSequential)
+{
+    Program<WPDS> sequential, parallel;
+    parallel.pds.setWorkerThreads(4);
+
+    WFA expected = sequential.pds.poststar(sequential.query("main", 0));
+    WFA actual = parallel.pds.poststar(parallel.query("main", 0));
+
+    TransCounter counter;
+    actual.for_each(counter);
+    EXPECT_LT(1, counter.getNumTrans());
+    EXPECT_TRUE(expected.equal(actual));
+}
+
+TEST(wali$wpds$WPDS$prestar, parallelSaturationMatchesSequential)
+{
+    Program<WPDS> sequential, parallel;
+    parallel.pds.setWorkerThreads(4);
+
+    WFA expected = sequential.pds.prestar(sequential.query("main", 6));
+    WFA actual = parallel.pds.prestar(parallel.query("main", 6));
+
+    TransCounter counter;
+    actual.for_each(counter);
+    EXPECT_LT(1, counter.getNumTrans());
+    EXPECT_TRUE(expected.equal(actual));
+}
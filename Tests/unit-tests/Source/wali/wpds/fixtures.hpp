@@ -0,0 +1,103 @@
+#ifndef WALI_TESTS_WALI_WPDS_FIXTURES_HPP
+#define WALI_TESTS_WALI_WPDS_FIXTURES_HPP
+
+#include "wali/Key.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wfa/WFA.hpp"
+
+#include <sstream>
+
+namespace wali {
+  namespace wpds {
+
+    inline sem_elem_t shortestPath(unsigned d)
+    {
+      return new ShortestPathSemiring(d);
+    }
+
+    /// The stack symbol 'proc_n' of Program
+    inline Key programNode(char const * proc, int n)
+    {
+      std::stringstream ss;
+      ss << proc << "_" << n;
+      return getKey(ss.str());
+    }
+
+
+    /// A small program: main calls f twice; f loops and calls g; g is
+    /// recursive. Edge weights vary so the answer is not trivial; the
+    /// weights of the loop in f, of the call to g, and of g's recursive
+    /// call are parameters. Pds is WPDS or a subclass, and 'dist' makes
+    /// the weights.
+    template<typename Pds>
+    struct Program
+    {
+      typedef sem_elem_t (*Distance)(unsigned);
+
+      Key p, accept;
+      Distance dist;
+      Pds pds;
+
+      explicit Program(Distance dist = shortestPath,
+                       unsigned loop = 5, unsigned call = 3, unsigned rec = 2)
+        : p(getKey("p"))
+        , accept(getKey("accept"))
+        , dist(dist)
+      {
+        for (int i = 0; i < 6; ++i) {
+          pds.add_rule(p, node("main", i), p, node("main", i+1), dist(1 + i % 3));
+        }
+        pds.add_rule(p, node("main", 2), p, node("f", 0), node("main", 3), dist(2));
+        pds.add_rule(p, node("main", 4), p, node("f", 0), node("main", 5), dist(1));
+
+        for (int i = 0; i < 4; ++i) {
+          pds.add_rule(p, node("f", i), p, node("f", i+1), dist(i + 1));
+        }
+        pds.add_rule(p, node("f", 3), p, node("f", 1), dist(loop));
+        pds.add_rule(p, node("f", 2), p, node("g", 0), node("f", 3), dist(call));
+        pds.add_rule(p, node("f", 4), p, dist(0));
+
+        pds.add_rule(p, node("g", 0), p, node("g", 1), dist(1));
+        pds.add_rule(p, node("g", 0), p, node("g", 2), dist(4));
+        pds.add_rule(p, node("g", 1), p, node("g", 0), node("g", 2), dist(rec));
+        pds.add_rule(p, node("g", 2), p, dist(0));
+      }
+
+      static Key node(char const * proc, int n)
+      {
+        return programNode(proc, n);
+      }
+
+      void reweight(unsigned loop, unsigned call, unsigned rec)
+      {
+        pds.replace_rule(p, node("f", 3), p, node("f", 1), dist(loop));
+        pds.replace_rule(p, node("f", 2), p, node("g", 0), node("f", 3), dist(call));
+        pds.replace_rule(p, node("g", 1), p, node("g", 0), node("g", 2), dist(rec));
+      }
+
+      /// The query automaton for the configuration <p, proc_n>
+      wfa::WFA query(char const * proc, int n) const
+      {
+        wfa::WFA q;
+        q.addState(p, dist(0)->zero());
+        q.addState(accept, dist(0)->zero());
+        q.setInitialState(p);
+        q.addFinalState(accept);
+        q.addTrans(p, node(proc, n), accept, dist(0));
+        return q;
+      }
+    };
+
+  }
+}
+
+
+// Yo emacs!
+// Local Variables:
+//     c-file-style: "ellemtel"
+//     c-basic-offset: 2
+//     indent-tabs-mode: nil
+// End:
+
+
+#endif
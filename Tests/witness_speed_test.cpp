@@ -0,0 +1,148 @@
+/*
+ * Times WPDS::poststar with ShortestPathSemiring weights on a random
+ * program from RandomPdsGen (AddOns/RandomFWPDS), once without
+ * witnesses, once with WitnessWrapper, and once with
+ * CompactWitnessWrapper, and reports how many Witness nodes each leaves
+ * alive. For the compact run it also times materializing the witnesses
+ * of every transition of the answer, and checks that their weights are
+ * the answer's weights.
+ *
+ * Usage: witness_speed_test [procedures [max-weight [seed]]]
+ */
+
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wfa/WFA.hpp"
+#include "wali/wfa/TransFunctor.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/witness/Witness.hpp"
+#include "wali/witness/WitnessWrapper.hpp"
+#include "wali/witness/CompactWitness.hpp"
+#include "wali/util/Timer.hpp"
+
+#include "generateRandomFWPDS.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::witness;
+
+namespace {
+
+  class DistanceGen : public RandomPdsGen::WtGen
+  {
+    public:
+      explicit DistanceGen( unsigned max_weight ) : max_weight(max_weight) {}
+
+      virtual sem_elem_t operator () ()
+      {
+        return new ShortestPathSemiring(static_cast<unsigned>(rand()) % (max_weight + 1));
+      }
+
+    private:
+      unsigned max_weight;
+  };
+
+  /// Materializes the witness of each transition
+  class Materializer : public wfa::ConstTransFunctor
+  {
+    public:
+      Materializer() : mismatches(0) {}
+
+      virtual void operator()( wfa::ITrans const * t )
+      {
+        CompactWitness * cw = dynamic_cast<CompactWitness*>(t->weight().get_ptr());
+        witness_t w = cw->witness();
+        if( !w->weight()->equal(cw->weight()) ) {
+          mismatches++;
+        }
+      }
+
+      int mismatches;
+  };
+
+  /// Runs poststar with 'wrapper' (which may be NULL) on the program
+  /// from 'seed', and returns the answer
+  wfa::WFA run( char const * name, ref_ptr<Wrapper> wrapper,
+                int procs, unsigned max_weight, unsigned seed )
+  {
+    srand(seed);
+    RandomPdsGen gen(new DistanceGen(max_weight),
+                     procs, 10 * procs, procs, 5 * procs, 0, 0.45, 0.45, seed);
+    RandomPdsGen::Names names;
+    WPDS pds(wrapper);
+    gen.get(pds, names);
+
+    Key acc = getKey("__accept");
+    wfa::WFA query;
+    query.addTrans(names.pdsState, names.entries[0], acc, new ShortestPathSemiring(0));
+    query.setInitialState(names.pdsState);
+    query.addFinalState(acc);
+
+    int witnesses = Witness::COUNT;
+    long long start = util::details::now();
+    wfa::WFA answer = pds.poststar(query);
+    double secs = util::details::to_sec(util::details::now() - start);
+    std::cout << std::setw(16) << name
+              << std::setw(10) << std::fixed << std::setprecision(3) << secs
+              << std::setw(12) << answer.numTransitions()
+              << std::setw(12) << (Witness::COUNT - witnesses) << "\n";
+    return answer;
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  int procs = 200;
+  unsigned max_weight = 10;
+  // RandomPdsGen picks a seed from the clock if given 0
+  unsigned seed = 1;
+  if( argc > 1 )
+    std::istringstream(argv[1]) >> procs;
+  if( argc > 2 )
+    std::istringstream(argv[2]) >> max_weight;
+  if( argc > 3 )
+    std::istringstream(argv[3]) >> seed;
+  if( procs < 1 || seed == 0 ) {
+    std::cerr << "Need at least one procedure, and a nonzero seed\n";
+    return 1;
+  }
+
+  std::cout << procs << " procedures, weights in [0, " << max_weight << "]\n";
+  std::cout << std::setw(16) << "witnesses" << std::setw(10) << "time(s)"
+            << std::setw(12) << "transitions" << std::setw(12) << "Witnesses" << "\n";
+
+  wfa::WFA plain = run("none", NULL, procs, max_weight, seed);
+  wfa::WFA eager = run("WitnessWrapper", new WitnessWrapper(), procs, max_weight, seed);
+
+  ref_ptr<CompactWitnessWrapper> wrapper = new CompactWitnessWrapper();
+  wfa::WFA compact = run("Compact", wrapper, procs, max_weight, seed);
+  std::cout << "log: " << wrapper->log()->size() << " steps, "
+            << wrapper->log()->bytes() << " bytes\n";
+
+  Materializer materializer;
+  long long start = util::details::now();
+  compact.for_each(materializer);
+  double secs = util::details::to_sec(util::details::now() - start);
+  std::cout << "materializing every witness: " << std::fixed << std::setprecision(3)
+            << secs << "s\n";
+
+  if( materializer.mismatches != 0
+      || plain.numTransitions() != eager.numTransitions()
+      || plain.numTransitions() != compact.numTransitions() )
+  {
+    std::cerr << "The witnesses do not match the answer\n";
+    return 1;
+  }
+  return 0;
+}
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End:
@@ -0,0 +1,136 @@
+/*
+ * Times WPDS::poststar with ShortestPathSemiring weights on a random
+ * program from RandomPdsGen (AddOns/RandomFWPDS), once with each of the
+ * default (unordered) worklist, ShortestPathWorklist (a multimap by
+ * distance), and ShortestPathBucketWorklist (buckets by distance), and
+ * checks that all three give the same automaton.
+ *
+ * Rule weights are random distances in [0, max-weight].
+ *
+ * Usage: worklist_speed_test [procedures [max-weight [seed]]]
+ */
+
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wfa/WFA.hpp"
+#include "wali/wfa/TransFunctor.hpp"
+#include "wali/DefaultWorklist.hpp"
+#include "wali/ShortestPathWorklist.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/util/Timer.hpp"
+
+#include "generateRandomFWPDS.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <string>
+
+using namespace wali;
+using namespace wali::wpds;
+
+namespace {
+
+  class DistanceGen : public RandomPdsGen::WtGen
+  {
+    public:
+      explicit DistanceGen( unsigned max_weight ) : max_weight(max_weight) {}
+
+      virtual sem_elem_t operator () ()
+      {
+        return new ShortestPathSemiring(static_cast<unsigned>(rand()) % (max_weight + 1));
+      }
+
+    private:
+      unsigned max_weight;
+  };
+
+  /// Collects the printed transitions (which, unlike the printed WFA,
+  /// do not mention addresses)
+  class Printer : public wfa::ConstTransFunctor
+  {
+    public:
+      virtual void operator()( wfa::ITrans const * t )
+      {
+        std::stringstream ss;
+        t->print(ss);
+        printed.insert(ss.str());
+      }
+
+      std::set<std::string> printed;
+  };
+
+  /// Runs poststar with worklist wl on the program from 'seed', and
+  /// returns the answer's transitions, printed
+  std::set<std::string> run( char const * name, Worklist<wfa::ITrans> * wl,
+                   int procs, unsigned max_weight, unsigned seed )
+  {
+    srand(seed);
+    RandomPdsGen gen(new DistanceGen(max_weight),
+                     procs, 10 * procs, procs, 5 * procs, 0, 0.45, 0.45, seed);
+    RandomPdsGen::Names names;
+    WPDS pds;
+    gen.get(pds, names);
+    pds.setWorklist(wl);
+
+    Key acc = getKey("__accept");
+    wfa::WFA query;
+    query.addTrans(names.pdsState, names.entries[0], acc, new ShortestPathSemiring(0));
+    query.setInitialState(names.pdsState);
+    query.addFinalState(acc);
+
+    long long start = util::details::now();
+    wfa::WFA answer = pds.poststar(query);
+    double secs = util::details::to_sec(util::details::now() - start);
+    std::cout << std::setw(16) << name
+              << std::setw(10) << std::fixed << std::setprecision(3) << secs
+              << std::setw(12) << answer.numTransitions() << "\n";
+
+    Printer printer;
+    answer.for_each(printer);
+    return printer.printed;
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  int procs = 200;
+  unsigned max_weight = 10;
+  // RandomPdsGen picks a seed from the clock if given 0
+  unsigned seed = 1;
+  if( argc > 1 )
+    std::istringstream(argv[1]) >> procs;
+  if( argc > 2 )
+    std::istringstream(argv[2]) >> max_weight;
+  if( argc > 3 )
+    std::istringstream(argv[3]) >> seed;
+  if( procs < 1 || seed == 0 ) {
+    std::cerr << "Need at least one procedure, and a nonzero seed\n";
+    return 1;
+  }
+
+  std::cout << procs << " procedures, weights in [0, " << max_weight << "]\n";
+  std::cout << std::setw(16) << "worklist" << std::setw(10) << "time(s)"
+            << std::setw(12) << "transitions" << "\n";
+
+  std::set<std::string> unordered = run("default", new DefaultWorklist<wfa::ITrans>(),
+                              procs, max_weight, seed);
+  std::set<std::string> ranked = run("multimap", new ShortestPathWorklist(),
+                           procs, max_weight, seed);
+  std::set<std::string> bucketed = run("buckets", new ShortestPathBucketWorklist(),
+                             procs, max_weight, seed);
+
+  if( unordered != bucketed || ranked != bucketed ) {
+    std::cerr << "The worklists give different answers\n";
+    return 1;
+  }
+  return 0;
+}
+
+
+// Yo, Emacs!
+// Local Variables:
+//   c-file-style: "ellemtel"
+//   c-basic-offset: 2
+// End: